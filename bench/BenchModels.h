@@ -0,0 +1,204 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef BENCHMODELS_H
+#define BENCHMODELS_H
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <Dataset.h>
+#include <WeightFunctions.h>
+#include <JoinFunctions.h>
+#include <TransferFunctions.h>
+#include "BenchUtils.h"
+
+/**
+ *
+ * \brief Helpers used by the benchmarks to build and to measure the models.
+ *
+*/
+namespace neuroc_bench{
+
+/**
+* It returns a sigmoid layer with the given dimensions
+*
+**/
+inline neuroc::DenseLayer MakeSigmoidLayer(unsigned int inputSize, unsigned int outputSize){
+ return neuroc::DenseLayer(inputSize, outputSize, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::Sigmoid, neuroc::TransferFunctions::SigmoidDerivative);
+}
+
+/**
+* It returns a network of sigmoid layers.
+*
+* @param sizes the size of the input followed by the size of each layer
+**/
+inline neuroc::Network MakeSigmoidNetwork(const std::vector<unsigned int>& sizes){
+ neuroc::Network net;
+ if(sizes.size() > 1) net.ReserveLayers(sizes.size() - 1);
+ for(unsigned int i=1; i<sizes.size(); i++) net.AddLayer(MakeSigmoidLayer(sizes[i-1], sizes[i]));
+ return net;
+}
+
+/**
+* It returns a network of sigmoid hidden layers and a Softmax output
+* layer, to be trained with LossFunctions::CrossEntropy.
+*
+* @param sizes the size of the input followed by the size of each layer
+**/
+inline neuroc::Network MakeSoftmaxNetwork(const std::vector<unsigned int>& sizes){
+ neuroc::Network net;
+ if(sizes.size() > 1) net.ReserveLayers(sizes.size() - 1);
+ for(unsigned int i=1; i<sizes.size(); i++){
+  if(i == sizes.size()-1) net.EmplaceLayer(sizes[i-1], sizes[i], neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::Softmax, neuroc::TransferFunctions::SoftmaxDerivative);
+  else net.AddLayer(MakeSigmoidLayer(sizes[i-1], sizes[i]));
+ }
+ return net;
+}
+
+/**
+* It draws new weights and bias for all the layers of the network.
+* The DenseLayer constructor seeds the generator with the current time,
+* calling this function after the construction makes the runs repeatable.
+*
+* @param seed the seed of the random generator
+**/
+inline void RandomizeNetwork(neuroc::Network& net, unsigned int seed){
+ std::srand(seed);
+ for(unsigned int i=0; i<net.Size(); i++){
+  const Eigen::MatrixXd& weight_matrix = net[i].GetWeightMatrix();
+  net[i].SetWeightMatrix(Eigen::MatrixXd::Random(weight_matrix.rows(), weight_matrix.cols()));
+  net[i].SetBiasVector(Eigen::VectorXd::Random(weight_matrix.rows()));
+ }
+}
+
+/**
+* It returns a network with HardLimit hidden layers in the binarized mode
+* and a sigmoid output layer in double precision, with random weights.
+*
+* @param sizes the size of the input followed by the size of each layer
+* @param seed the seed of the random generator
+**/
+inline neuroc::Network MakeBinarizedNetwork(const std::vector<unsigned int>& sizes, unsigned int seed){
+ neuroc::Network net;
+ if(sizes.size() > 1) net.ReserveLayers(sizes.size() - 1);
+ for(unsigned int i=1; i<sizes.size(); i++){
+  if(i == sizes.size()-1) net.AddLayer(MakeSigmoidLayer(sizes[i-1], sizes[i]));
+  else net.EmplaceLayer(sizes[i-1], sizes[i], neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::HardLimit, neuroc::TransferFunctions::HardLimitDerivative);
+ }
+ RandomizeNetwork(net, seed);
+ for(unsigned int i=0; i+1<net.Size(); i++) net[i].SetBinarized(true);
+ return net;
+}
+
+/**
+* It returns a network of depth square sigmoid layers
+*
+**/
+inline neuroc::Network MakeSigmoidNetwork(unsigned int width, unsigned int depth){
+ return MakeSigmoidNetwork(std::vector<unsigned int>(depth+1, width));
+}
+
+/**
+* It returns the fraction of samples whose output, once
+* multiplied by ten and rounded, is equal to the digit.
+**/
+template<typename Model>
+double DigitAccuracy(Model& model, neuroc::Dataset& inputDataset, neuroc::Dataset& targetDataset){
+ unsigned int correct = 0;
+ for(unsigned int i=0; i<inputDataset.ReturnNumberOfElements(); i++){
+  const Eigen::VectorXd& output_vector = model.Compute(inputDataset[i]);
+  if(std::lround(output_vector[0] * 10.0) == std::lround(targetDataset[i][0] * 10.0)) correct++;
+ }
+ return (double) correct / inputDataset.ReturnNumberOfElements();
+}
+
+/**
+* It returns the samples per second of the model on the inputs
+**/
+template<typename Model>
+double Throughput(Model& model, const std::vector<Eigen::VectorXd>& inputs, unsigned int repetitions){
+ for(unsigned int i=0; i<inputs.size(); i++) DoNotOptimize(model.Compute(inputs[i]).data());
+ double start = NowNanoseconds();
+ for(unsigned int r=0; r<repetitions; r++){
+  for(unsigned int i=0; i<inputs.size(); i++) DoNotOptimize(model.Compute(inputs[i]).data());
+ }
+ double seconds = (NowNanoseconds() - start) * 1e-9;
+ return (double) repetitions * inputs.size() / seconds;
+}
+
+/**
+* It returns the largest difference between the outputs of the two models
+**/
+template<typename Model>
+double MaxDifference(neuroc::Network& net, Model& model, const std::vector<Eigen::VectorXd>& inputs){
+ double difference = 0.0;
+ for(unsigned int i=0; i<inputs.size(); i++){
+  Eigen::VectorXd output_vector = net.Compute(inputs[i]);
+  difference = std::max(difference, (output_vector - model.Compute(inputs[i])).cwiseAbs().maxCoeff());
+ }
+ return difference;
+}
+
+/**
+* It returns the samples of the dataset as a vector of inputs
+**/
+inline std::vector<Eigen::VectorXd> ReturnInputs(neuroc::Dataset& inputDataset){
+ std::vector<Eigen::VectorXd> inputs;
+ inputs.reserve(inputDataset.ReturnNumberOfElements());
+ for(unsigned int i=0; i<inputDataset.ReturnNumberOfElements(); i++) inputs.push_back(inputDataset[i]);
+ return inputs;
+}
+
+/**
+* It returns the bytes of the weights and of the bias of the layer in
+* double precision. The weights of a sparse layer are counted as they
+* are stored, in the compressed row format.
+**/
+inline std::size_t WeightBytes(neuroc::DenseLayer& layer){
+ std::size_t bytes = sizeof(double) * layer.GetBiasVector().size();
+ if(layer.IsSparse() == false) return bytes + sizeof(double) * layer.GetWeightMatrix().size();
+ const Eigen::SparseMatrix<double, Eigen::RowMajor>& sparse_matrix = layer.GetSparseWeightMatrix();
+ return bytes + sparse_matrix.nonZeros() * (sizeof(double) + sizeof(int)) + (sparse_matrix.outerSize() + 1) * sizeof(int);
+}
+
+inline std::size_t WeightBytes(neuroc::Network& net){
+ std::size_t bytes = 0;
+ for(unsigned int i=0; i<net.Size(); i++) bytes += WeightBytes(net[i]);
+ return bytes;
+}
+
+/**
+* It returns true if the two networks have the same weights, bit by bit
+**/
+inline bool SameWeights(neuroc::Network& first, neuroc::Network& second){
+ if(first.Size() != second.Size()) return false;
+ for(unsigned int i=0; i<first.Size(); i++){
+  if(first[i].GetWeightMatrix() != second[i].GetWeightMatrix()) return false;
+  if(first[i].GetBiasVector() != second[i].GetBiasVector()) return false;
+ }
+ return true;
+}
+
+} //namespace
+
+#endif // BENCHMODELS_H
@@ -0,0 +1,252 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef BENCHUTILS_H
+#define BENCHUTILS_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+
+/**
+ *
+ * \brief Small header-only harness shared by the neuroc benchmarks.
+ *
+ * Every case is run a number of warmup times (not measured) and then
+ * a number of repetitions, each one timed on its own. The statistics
+ * (min, median, p99, mean) are computed over the repetitions and can
+ * be printed as a table or saved as JSON for comparing two runs.
+ *
+*/
+namespace neuroc_bench{
+
+/**
+* It prevents the compiler from removing a computation whose
+* result is never used.
+*
+* @param value the value to keep alive
+**/
+template <typename T>
+inline void DoNotOptimize(const T& value){
+ asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+* It returns a monotonic timestamp in nanoseconds.
+*
+**/
+inline double NowNanoseconds(){
+ return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+typedef std::vector<std::pair<std::string, long> > Parameters;
+
+/**
+* \struct BenchResult
+* \brief Statistics collected for a single benchmark case
+*/
+struct BenchResult {
+ std::string name;
+ Parameters params;
+ unsigned int repetitions;
+ unsigned long items; //items processed by a single repetition
+ double minNs;
+ double medianNs;
+ double p99Ns;
+ double meanNs;
+ double itemsPerSecond;
+};
+
+/**
+* \class BenchRunner
+* \brief It runs the benchmark cases and collects the results
+*/
+class BenchRunner {
+
+public:
+
+//At least one repetition is measured, the statistics need a sample
+BenchRunner(unsigned int warmup, unsigned int repetitions) : mWarmup(warmup), mRepetitions(repetitions > 0 ? repetitions : 1) {}
+
+/**
+* It sets a filter, only the cases whose name contains
+* the filter are executed.
+*
+* @param filter substring to look for
+**/
+void SetFilter(std::string filter){ mFilter = filter; }
+
+/**
+* It returns true if the case with the given name is going to be executed.
+*
+* @param name the name of the case
+**/
+bool IsEnabled(const std::string& name){
+ return mFilter.empty() || name.find(mFilter) != std::string::npos;
+}
+
+/**
+* It runs a benchmark case. The setup function is called before every
+* repetition and it is not measured, the body function is measured.
+*
+* @param name name of the case
+* @param params the parameters of the case (width, depth, batch...)
+* @param items the number of items processed by one call of the body
+* @param setup function called before each repetition (not measured)
+* @param body function to measure
+**/
+void Run(std::string name, Parameters params, unsigned long items, std::function<void()> setup, std::function<void()> body){
+ if(IsEnabled(name) == false) return;
+
+ for(unsigned int i=0; i<mWarmup; i++){
+  setup();
+  body();
+ }
+
+ std::vector<double> samples;
+ samples.reserve(mRepetitions);
+ for(unsigned int i=0; i<mRepetitions; i++){
+  setup();
+  double start = NowNanoseconds();
+  body();
+  double end = NowNanoseconds();
+  samples.push_back(end - start);
+ }
+ std::sort(samples.begin(), samples.end());
+
+ BenchResult result;
+ result.name = name;
+ result.params = params;
+ result.repetitions = mRepetitions;
+ result.items = items;
+ result.minNs = samples.front();
+ result.medianNs = Percentile(samples, 0.50);
+ result.p99Ns = Percentile(samples, 0.99);
+ double sum = 0;
+ for(unsigned int i=0; i<samples.size(); i++) sum += samples[i];
+ result.meanNs = sum / samples.size();
+ result.itemsPerSecond = (result.medianNs > 0) ? (items * 1e9) / result.medianNs : 0;
+ mResults.push_back(result);
+ PrintResult(result);
+}
+
+/**
+* It runs a benchmark case without setup function.
+*
+**/
+void Run(std::string name, Parameters params, unsigned long items, std::function<void()> body){
+ Run(name, params, items, [](){}, body);
+}
+
+/**
+* It prints a single result as a row of the table
+*
+**/
+void PrintResult(const BenchResult& result){
+ std::ostringstream params_stream;
+ for(unsigned int i=0; i<result.params.size(); i++){
+  if(i!=0) params_stream << " ";
+  params_stream << result.params[i].first << "=" << result.params[i].second;
+ }
+ std::cout << std::left << std::setw(42) << result.name
+           << std::setw(34) << params_stream.str()
+           << std::right << std::fixed << std::setprecision(1)
+           << " median " << std::setw(13) << result.medianNs << " ns"
+           << " p99 " << std::setw(13) << result.p99Ns << " ns"
+           << std::setprecision(0) << " " << std::setw(12) << result.itemsPerSecond << " items/s"
+           << std::endl;
+}
+
+/**
+* It saves all the results as a JSON document.
+*
+* @param filePath the path to the output file
+* @param suite the name of the suite
+**/
+bool SaveAsJSON(std::string filePath, std::string suite){
+ std::ofstream file_stream(filePath);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return false;
+ }
+ file_stream << std::setprecision(12);
+ file_stream << "{\n";
+ file_stream << " \"suite\": \"" << suite << "\",\n";
+ file_stream << " \"timestamp\": " << (long) std::time(0) << ",\n";
+ file_stream << " \"warmup\": " << mWarmup << ",\n";
+ file_stream << " \"repetitions\": " << mRepetitions << ",\n";
+ file_stream << " \"results\": [\n";
+ for(unsigned int i=0; i<mResults.size(); i++){
+  const BenchResult& r = mResults[i];
+  file_stream << "  {\"name\": \"" << r.name << "\", \"params\": {";
+  for(unsigned int j=0; j<r.params.size(); j++){
+   if(j!=0) file_stream << ", ";
+   file_stream << "\"" << r.params[j].first << "\": " << r.params[j].second;
+  }
+  file_stream << "}, \"repetitions\": " << r.repetitions
+              << ", \"items\": " << r.items
+              << ", \"min_ns\": " << r.minNs
+              << ", \"median_ns\": " << r.medianNs
+              << ", \"p99_ns\": " << r.p99Ns
+              << ", \"mean_ns\": " << r.meanNs
+              << ", \"items_per_sec\": " << r.itemsPerSecond << "}";
+  if(i != mResults.size()-1) file_stream << ",";
+  file_stream << "\n";
+ }
+ file_stream << " ]\n";
+ file_stream << "}\n";
+ file_stream.close();
+ return true;
+}
+
+const std::vector<BenchResult>& GetResults(){ return mResults; }
+
+private:
+
+/**
+* Nearest-rank percentile of a sorted vector
+*
+**/
+static double Percentile(const std::vector<double>& sorted, double fraction){
+ if(sorted.empty()) return 0;
+ unsigned int rank = (unsigned int) std::ceil(fraction * sorted.size());
+ if(rank < 1) rank = 1;
+ if(rank > sorted.size()) rank = sorted.size();
+ return sorted[rank-1];
+}
+
+unsigned int mWarmup;
+unsigned int mRepetitions;
+std::string mFilter;
+std::vector<BenchResult> mResults;
+
+};
+
+} //namespace
+
+#endif // BENCHUTILS_H
@@ -0,0 +1,260 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Zero-allocation regression check. It is linked with the allocation
+ * hooks (bin/obj/AllocationHooks.o) and it counts the heap allocations
+ * of the hot paths after a warmup. The designated hot paths must not
+ * allocate, if one of them does the program returns an error.
+ * The other paths are only reported, together with the memory
+ * footprint of layers, networks and datasets.
+ *
+ * Usage:
+ * ./alloccheck [--data-dir DIR]
+ *
+*/
+
+#include <cstdlib>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <LossFunctions.h>
+#include <Dataset.h>
+#include <Executor.h>
+#include <MemoryStats.h>
+#include <TrainingWorkspace.h>
+#include <QuantizedNetwork.h>
+#include <BinaryNetwork.h>
+#include <LowRankFactorization.h>
+#include <WeightClustering.h>
+#include <ClusteredNetwork.h>
+#include <StaticNetwork.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+const unsigned int kWarmup = 5;
+const unsigned int kIterations = 100;
+const unsigned int kBatchSize = 32;
+
+/**
+* It counts the allocations of the function after a warmup and prints them.
+*
+* @param designated if true the function must not allocate
+* @return it returns false if a designated function allocated
+**/
+bool Check(std::string name, bool designated, std::function<void()> function){
+ for(unsigned int i=0; i<kWarmup; i++) function();
+ neuroc::MemoryStats::AllocationScope scope;
+ for(unsigned int i=0; i<kIterations; i++) function();
+ neuroc::MemoryStats::AllocationCounters counters = scope.Elapsed();
+ double allocations = (double) counters.allocations / kIterations;
+ double bytes = (double) counters.allocatedBytes / kIterations;
+ bool passed = (designated == false) || (counters.allocations == 0);
+ std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(1)
+           << std::setw(10) << allocations << " allocs/call " << std::setw(12) << bytes << " bytes/call  "
+           << (designated ? (passed ? "PASS" : "FAIL") : "(reported)") << std::endl;
+ return passed;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR]" << std::endl;
+   return 1;
+  }
+ }
+
+ if(neuroc::MemoryStats::IsCountingEnabled() == false){
+  std::cerr << "Error: the allocation hooks are not linked, the allocations cannot be counted." << std::endl;
+  return 1;
+ }
+
+ bool passed = true;
+ std::vector<std::vector<unsigned int> > topologies = {{16, 10, 1}, {256, 256, 256, 10}};
+
+ std::cout << "=== Allocations after warmup ===" << std::endl;
+ for(unsigned int t=0; t<topologies.size(); t++){
+  std::vector<unsigned int>& sizes = topologies[t];
+  std::ostringstream topology_stream;
+  for(unsigned int i=0; i<sizes.size(); i++) topology_stream << (i ? "-" : "") << sizes[i];
+  std::string topology = " [" + topology_stream.str() + "]";
+
+  neuroc::Network net = neuroc_bench::MakeSigmoidNetwork(sizes);
+  neuroc::DenseLayer layer = net[0];
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(0.01);
+  Eigen::VectorXd input_vector = Eigen::VectorXd::Random(sizes.front());
+  Eigen::VectorXd target_vector = Eigen::VectorXd::Random(sizes.back());
+
+  Eigen::MatrixXd input_matrix = Eigen::MatrixXd::Random(sizes.front(), kBatchSize);
+  Eigen::MatrixXd target_matrix = Eigen::MatrixXd::Random(sizes.back(), kBatchSize);
+
+  //Designated hot paths
+  passed &= Check("DenseLayer::Compute" + topology, true, [&](){ layer.Compute(input_vector); });
+  passed &= Check("Network::Compute" + topology, true, [&](){ net.Compute(input_vector); });
+  passed &= Check("Network::ComputeDerivative" + topology, true, [&](){ net.ComputeDerivative(input_vector); });
+  neuroc::Dataset calibration_dataset;
+  calibration_dataset.PushBackData(input_vector);
+  neuroc::QuantizedNetwork quantized_net;
+  quantized_net.Quantize(net, calibration_dataset);
+  passed &= Check("QuantizedNetwork::Compute" + topology, true, [&](){ quantized_net.Compute(input_vector); });
+  neuroc::Network binarized_net = neuroc_bench::MakeBinarizedNetwork(sizes, 42);
+  neuroc::BinaryNetwork binary_net;
+  binary_net.Binarize(binarized_net);
+  passed &= Check("BinaryNetwork::Compute" + topology, true, [&](){ binary_net.Compute(input_vector); });
+  neuroc::Network sparse_net = net;
+  for(unsigned int i=0; i<sparse_net.Size(); i++) sparse_net[i].Prune(0.9);
+  passed &= Check("Network::Compute sparse 90%" + topology, true, [&](){ sparse_net.Compute(input_vector); });
+  passed &= Check("SingleStepOnlineLearning sparse 90%" + topology, true, [&](){ learning.SingleStepOnlineLearning(&sparse_net, input_vector, target_vector, false); });
+  neuroc::Network factorized_net = net;
+  for(unsigned int i=0; i<factorized_net.Size(); i++){
+   unsigned int rank = neuroc::LowRankFactorization::ReturnMaximumRank(factorized_net[i]) / 2;
+   if(rank > 0) neuroc::LowRankFactorization::Factorize(factorized_net[i], rank);
+  }
+  passed &= Check("Network::Compute factorized" + topology, true, [&](){ factorized_net.Compute(input_vector); });
+  passed &= Check("SingleStepOnlineLearning factorized" + topology, true, [&](){ learning.SingleStepOnlineLearning(&factorized_net, input_vector, target_vector, false); });
+  neuroc::Network clustered_net = net;
+  neuroc::WeightClustering clustering;
+  clustering.Cluster(clustered_net, 4);
+  neuroc::ClusteredNetwork compressed_net;
+  compressed_net.Compress(clustered_net);
+  passed &= Check("ClusteredNetwork::Compute" + topology, true, [&](){ compressed_net.Compute(input_vector); });
+  passed &= Check("SingleStepOnlineLearning clustered" + topology, true, [&](){ learning.SingleStepOnlineLearning(&clustered_net, input_vector, target_vector, false); });
+  passed &= Check("SingleStepOnlineLearning" + topology, true, [&](){ learning.SingleStepOnlineLearning(&net, input_vector, target_vector, false); });
+  neuroc::BackpropagationLearning regularized_learning;
+  regularized_learning.SetLearningRate(0.01);
+  regularized_learning.SetWeightDecay(0.0001);
+  regularized_learning.SetGradientClipping(1.0);
+  passed &= Check("SingleStepOnlineLearning decay+clip" + topology, true, [&](){ regularized_learning.SingleStepOnlineLearning(&net, input_vector, target_vector, false); });
+  neuroc::Network softmax_net = neuroc_bench::MakeSoftmaxNetwork(sizes);
+  neuroc::BackpropagationLearning softmax_learning;
+  softmax_learning.SetLearningRate(0.01);
+  softmax_learning.SetLoss(neuroc::LossFunctions::CrossEntropy);
+  passed &= Check("SingleStepOnlineLearning cross entropy" + topology, true, [&](){ softmax_learning.SingleStepOnlineLearning(&softmax_net, input_vector, target_vector, false); });
+
+  //Reported paths
+  Check("SingleStepBatchLearning" + topology + " batch " + std::to_string(kBatchSize), false, [&](){ learning.SingleStepBatchLearning(&net, input_matrix, target_matrix); });
+  Check("SingleStepBatchLearning sparse 90%" + topology, false, [&](){ learning.SingleStepBatchLearning(&sparse_net, input_matrix, target_matrix); });
+  Check("SingleStepBatchLearning factorized" + topology, false, [&](){ learning.SingleStepBatchLearning(&factorized_net, input_matrix, target_matrix); });
+  Check("SingleStepBatchLearning clustered" + topology, false, [&](){ learning.SingleStepBatchLearning(&clustered_net, input_matrix, target_matrix); });
+  Check("SingleStepBatchLearning cross entropy" + topology, false, [&](){ softmax_learning.SingleStepBatchLearning(&softmax_net, input_matrix, target_matrix); });
+  neuroc::Network mixed_net = net;
+  neuroc::BackpropagationLearning mixed_learning;
+  mixed_learning.SetLearningRate(0.01);
+  mixed_learning.SetMixedPrecision(true, 1024.0);
+  Check("SingleStepBatchLearning mixed precision" + topology, false, [&](){ mixed_learning.SingleStepBatchLearning(&mixed_net, input_matrix, target_matrix); });
+  //Every product split among the threads of the Executor, the workers start in the warmup
+  neuroc::Executor& executor = neuroc::Executor::ReturnInstance();
+  unsigned int threads = executor.GetNumberOfThreads();
+  std::size_t threshold = executor.GetThreshold();
+  executor.SetNumberOfThreads(4);
+  executor.SetThreshold(1);
+  passed &= Check("Network::Compute Executor 4 threads" + topology, true, [&](){ net.Compute(input_vector); });
+  passed &= Check("SingleStepOnlineLearning Executor 4 threads" + topology, true, [&](){ learning.SingleStepOnlineLearning(&net, input_vector, target_vector, false); });
+  executor.SetNumberOfThreads(threads);
+  executor.SetThreshold(threshold);
+ }
+
+ //Moving a model or a dataset must not copy the weights or the data
+ std::cout << std::endl << "=== Ownership transfer ===" << std::endl;
+ {
+  neuroc::Network first = neuroc_bench::MakeSigmoidNetwork(topologies.back());
+  neuroc::Network second;
+  passed &= Check("Network move", true, [&](){ second = std::move(first); first = std::move(second); });
+  neuroc::DenseLayer first_layer = neuroc_bench::MakeSigmoidLayer(256, 256);
+  neuroc::DenseLayer second_layer = neuroc_bench::MakeSigmoidLayer(1, 1);
+  passed &= Check("DenseLayer move", true, [&](){ second_layer = std::move(first_layer); first_layer = std::move(second_layer); });
+  neuroc::Dataset first_dataset;
+  for(unsigned int i=0; i<1000; i++) first_dataset.PushBackData(Eigen::VectorXd::Random(16));
+  neuroc::Dataset second_dataset;
+  passed &= Check("Dataset move", true, [&](){ second_dataset = std::move(first_dataset); first_dataset = std::move(second_dataset); });
+  Eigen::VectorXd data_vector = Eigen::VectorXd::Random(4096);
+  neuroc::Dataset pushed_dataset(kWarmup + kIterations);
+  passed &= Check("Dataset::PushBackData(&&)", true, [&](){ pushed_dataset.PushBackData(std::move(data_vector)); data_vector = std::move(pushed_dataset[pushed_dataset.ReturnNumberOfElements()-1]); });
+ }
+
+ //The static network keeps the weights and the outputs in fixed-size members
+ std::cout << std::endl << "=== Static network ===" << std::endl;
+ {
+  neuroc::Network net = neuroc_bench::MakeSigmoidNetwork(topologies.front());
+  neuroc::StaticNetwork<neuroc::StaticDenseLayer<16, 10, neuroc::Activations::Sigmoid>,
+                        neuroc::StaticDenseLayer<10, 1, neuroc::Activations::Sigmoid> > static_net;
+  passed &= static_net.Load(net);
+  Eigen::Matrix<double, 16, 1> input_vector = Eigen::Matrix<double, 16, 1>::Random();
+  passed &= Check("StaticNetwork::Compute [16-10-1]", true, [&](){ static_net.Compute(input_vector); });
+ }
+
+ //The copies of a network share the weights until they write them
+ std::cout << std::endl << "=== Shared weights ===" << std::endl;
+ {
+  const unsigned int kReplicas = 100;
+  neuroc::Network model = neuroc_bench::MakeSigmoidNetwork(topologies.back());
+  std::size_t weight_bytes = 0;
+  for(unsigned int i=0; i<model.Size(); i++) weight_bytes += sizeof(double) * (model[i].GetWeightMatrix().size() + model[i].GetBiasVector().size());
+  std::vector<neuroc::Network> replicas;
+  replicas.reserve(kReplicas);
+  neuroc::MemoryStats::AllocationScope scope;
+  for(unsigned int r=0; r<kReplicas; r++) replicas.push_back(model);
+  std::size_t copy_bytes = scope.Elapsed().allocatedBytes;
+  std::cout << "Weights of the model: " << weight_bytes << " bytes, " << kReplicas << " copies: " << copy_bytes << " bytes" << std::endl;
+
+  bool shared = true;
+  for(unsigned int r=0; r<kReplicas; r++) for(unsigned int i=0; i<model.Size(); i++) shared &= replicas[r][i].IsSharingWeights();
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(0.01);
+  Eigen::VectorXd input_vector = Eigen::VectorXd::Random(topologies.back().front());
+  Eigen::VectorXd target_vector = Eigen::VectorXd::Random(topologies.back().back());
+  //The first step duplicates the weights of the written copy only, the following do not allocate
+  passed &= Check("SingleStepOnlineLearning on a copy", true, [&](){ learning.SingleStepOnlineLearning(&replicas[0], input_vector, target_vector, false); });
+  for(unsigned int i=0; i<model.Size(); i++) shared &= (replicas[0][i].IsSharingWeights() == false) && replicas[1][i].IsSharingWeights();
+  std::cout << std::left << std::setw(48) << "Weights shared until the first write" << std::right << (shared ? "PASS" : "FAIL") << std::endl;
+  passed &= shared;
+ }
+
+ std::cout << std::endl << "=== Memory footprint ===" << std::endl;
+ neuroc::Network net = neuroc_bench::MakeSigmoidNetwork(topologies.back());
+ for(unsigned int i=0; i<net.Size(); i++){
+  std::cout << "DenseLayer[" << i << "] " << net[i].GetWeightMatrix().cols() << "x" << net[i].GetWeightMatrix().rows()
+            << ": " << net[i].ReturnMemoryFootprint() << " bytes" << std::endl;
+ }
+ std::cout << "Network: " << net.ReturnMemoryFootprint() << " bytes" << std::endl;
+ neuroc::TrainingWorkspace workspace;
+ workspace.Reserve(net, kBatchSize);
+ std::cout << "TrainingWorkspace batch " << kBatchSize << ": " << workspace.ReturnMemoryFootprint() << " bytes" << std::endl;
+ neuroc::Dataset input_dataset;
+ if(input_dataset.LoadFromCSV(data_dir + "/pendigits.tra")){
+  neuroc::Dataset target_dataset = input_dataset.Split(16);
+  std::cout << "Dataset pendigits.tra input: " << input_dataset.ReturnMemoryFootprint() << " bytes, target: "
+            << target_dataset.ReturnMemoryFootprint() << " bytes" << std::endl;
+ }
+
+ std::cout << std::endl << (passed ? "PASSED: the designated hot paths do not allocate" : "FAILED: a designated hot path allocates") << std::endl;
+ return passed ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Binarized network benchmark. A network with a HardLimit hidden layer
+ * in the binarized mode and a sigmoid output layer is trained on
+ * pendigits.tes (shadow weights and straight-through estimator), packed
+ * in a BinaryNetwork and tested on pendigits.tra together with the same
+ * topology trained in double precision with sigmoid layers. It reports
+ * the accuracy, the samples where the binarized layers and the packed
+ * network disagree, the memory of the weights and the throughput, also
+ * on a wide random network.
+ *
+ * Usage:
+ * ./binbench [--data-dir DIR] [--hidden N] [--epochs N] [--learning-rate X]
+ *            [--width N] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BinaryNetwork.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* It returns the number of inputs where the outputs of the two models are
+* different. They can disagree only when a sum of the first layer is zero
+* and the rounding gives it a sign.
+**/
+template<typename Model>
+unsigned int CountDifferences(neuroc::Network& net, Model& model, const std::vector<Eigen::VectorXd>& inputs){
+ unsigned int differences = 0;
+ for(unsigned int i=0; i<inputs.size(); i++){
+  Eigen::VectorXd output_vector = net.Compute(inputs[i]);
+  if((output_vector - model.Compute(inputs[i])).cwiseAbs().maxCoeff() > 1e-9) differences++;
+ }
+ return differences;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 256;
+ unsigned int epochs = 30;
+ double learning_rate = 0.05;
+ unsigned int width = 1024;
+ unsigned int seed = 42;
+ std::string json_path = "./binbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--learning-rate X]"
+             << " [--width N] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+ std::vector<Eigen::VectorXd> test_inputs = neuroc_bench::ReturnInputs(test_input);
+
+ std::cout << "=== neuroc binarized network (popcnt: " << (neuroc::BinaryNetwork::IsUsingPopcountInstruction() ? "yes" : "no") << ") ===" << std::endl;
+
+ //pendigits: double sigmoid network against the binarized one
+ neuroc::Network double_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(double_net, seed);
+ neuroc::BackpropagationLearning double_learning;
+ double_learning.SetLearningRate(0.35);
+ double_learning.StartOnlineLearning(&double_net, train_input, train_target, epochs, false);
+
+ neuroc::Network binarized_net = neuroc_bench::MakeBinarizedNetwork({16, hidden, 1}, seed);
+ neuroc::BackpropagationLearning binarized_learning;
+ binarized_learning.SetLearningRate(learning_rate);
+ binarized_learning.StartOnlineLearning(&binarized_net, train_input, train_target, epochs, false);
+ neuroc::BinaryNetwork binary_net;
+ if(binary_net.Binarize(binarized_net) == false) return 1;
+
+ double double_accuracy = neuroc_bench::DigitAccuracy(double_net, test_input, test_target);
+ double binarized_accuracy = neuroc_bench::DigitAccuracy(binarized_net, test_input, test_target);
+ double binary_accuracy = neuroc_bench::DigitAccuracy(binary_net, test_input, test_target);
+ unsigned int digits_differences = CountDifferences(binarized_net, binary_net, test_inputs);
+ double double_digits_rate = neuroc_bench::Throughput(double_net, test_inputs, 20);
+ double binary_digits_rate = neuroc_bench::Throughput(binary_net, test_inputs, 20);
+
+ std::cout << std::fixed << std::setprecision(5);
+ std::cout << "pendigits 16-" << hidden << "-1, " << epochs << " epochs" << std::endl;
+ std::cout << "double         accuracy " << double_accuracy << "  weights " << neuroc_bench::WeightBytes(double_net) << " bytes  "
+           << std::setprecision(0) << double_digits_rate << " samples/s" << std::setprecision(5) << std::endl;
+ std::cout << "binarized      accuracy " << binarized_accuracy << std::endl;
+ std::cout << "BinaryNetwork  accuracy " << binary_accuracy << "  model " << binary_net.ReturnMemoryFootprint() << " bytes  "
+           << std::setprecision(0) << binary_digits_rate << " samples/s" << std::setprecision(5) << std::endl;
+ std::cout << "delta          accuracy " << (binary_accuracy - double_accuracy) << std::endl;
+ std::cout << "binarized and packed outputs differ on " << digits_differences << " of " << test_inputs.size() << " samples" << std::endl;
+
+ //Wide network: the throughput when the weights do not fit the caches
+ neuroc::Network wide_net = neuroc_bench::MakeBinarizedNetwork({width, width, width, 10}, seed);
+ neuroc::BinaryNetwork wide_binary;
+ if(wide_binary.Binarize(wide_net) == false) return 1;
+ std::srand(seed);
+ std::vector<Eigen::VectorXd> wide_inputs;
+ for(unsigned int i=0; i<256; i++) wide_inputs.push_back(Eigen::VectorXd::Random(width));
+ unsigned int wide_differences = CountDifferences(wide_net, wide_binary, wide_inputs);
+ double double_wide_rate = neuroc_bench::Throughput(wide_net, wide_inputs, 5);
+ double binary_wide_rate = neuroc_bench::Throughput(wide_binary, wide_inputs, 5);
+ std::cout << std::endl << "random " << width << "-" << width << "-" << width << "-10, outputs differ on " << wide_differences << " of " << wide_inputs.size() << " samples" << std::endl;
+ std::cout << std::setprecision(0);
+ std::cout << "binarized      " << double_wide_rate << " samples/s  weights " << neuroc_bench::WeightBytes(wide_net) << " bytes" << std::endl;
+ std::cout << "BinaryNetwork  " << binary_wide_rate << " samples/s  model " << wide_binary.ReturnMemoryFootprint() << " bytes" << std::endl;
+ std::cout << std::setprecision(2) << "speedup " << binary_wide_rate / double_wide_rate << "x, memory "
+           << (double) neuroc_bench::WeightBytes(wide_net) / wide_binary.ReturnMemoryFootprint() << "x smaller" << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"binbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"popcnt\": " << (neuroc::BinaryNetwork::IsUsingPopcountInstruction() ? "true" : "false") << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"epochs\": " << epochs
+             << ", \"double_accuracy\": " << double_accuracy << ", \"binarized_accuracy\": " << binarized_accuracy
+             << ", \"binary_accuracy\": " << binary_accuracy << ", \"accuracy_delta\": " << binary_accuracy - double_accuracy
+             << ", \"differences\": " << digits_differences
+             << ", \"double_samples_per_sec\": " << double_digits_rate << ", \"binary_samples_per_sec\": " << binary_digits_rate << "},\n"
+             << " \"wide\": {\"width\": " << width << ", \"differences\": " << wide_differences
+             << ", \"double_samples_per_sec\": " << double_wide_rate << ", \"binary_samples_per_sec\": " << binary_wide_rate
+             << ", \"double_weight_bytes\": " << neuroc_bench::WeightBytes(wide_net) << ", \"binary_bytes\": " << wide_binary.ReturnMemoryFootprint() << "}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Checkpoint benchmark. A network is trained on pendigits.tes without
+ * interruptions, then the same training is started in a child process with
+ * the checkpoints enabled and the child is killed halfway. The training is
+ * resumed from the last checkpoint and the final weights must be the same
+ * as the ones of the training without interruptions, for the online and
+ * the batch learning, in the file order, in the shuffle order, with
+ * the importance sampling and in mixed precision, where the resumed
+ * training has to keep the loss scale. A completed checkpoint must not
+ * train again and a network with a factorized layer must be refused. It reports the time of the training without checkpoints,
+ * with synchronous checkpoints and with asynchronous checkpoints.
+ *
+ * Usage:
+ * ./checkpointbench [--data-dir DIR] [--hidden N] [--epochs N] [--interval N]
+ *                   [--batch N] [--seed N] [--dir DIR] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <csignal>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <thread>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <LowRankFactorization.h>
+#include <SampleOrder.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* \struct Setup
+* \brief A training checked by the benchmark
+*/
+struct Setup {
+ std::string name;
+ unsigned int batchSize; //zero for the online learning
+ neuroc::SampleOrder::Mode order;
+ double lossScale; //zero for the double precision
+};
+
+/**
+* It sets the order of the samples and the precision of the setup
+**/
+void SetUp(neuroc::BackpropagationLearning& learning, const Setup& setup, unsigned int seed){
+ if(setup.order == neuroc::SampleOrder::SHUFFLE) learning.SetShuffle(seed);
+ else if(setup.order == neuroc::SampleOrder::IMPORTANCE_SAMPLING) learning.SetImportanceSampling(seed);
+ if(setup.lossScale > 0.0) learning.SetMixedPrecision(true, setup.lossScale);
+}
+
+/**
+* It trains the network, a zero batch size selects the online learning.
+* It returns the seconds of the training.
+**/
+double Train(neuroc::BackpropagationLearning& learning, neuroc::Network& net, neuroc::Dataset& inputDataset,
+             neuroc::Dataset& targetDataset, unsigned int epochs, unsigned int batchSize){
+ double start = neuroc_bench::NowNanoseconds();
+ if(batchSize == 0) learning.StartOnlineLearning(&net, inputDataset, targetDataset, epochs, false);
+ else learning.StartBatchLearning(&net, inputDataset, targetDataset, epochs, batchSize, false);
+ return (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+}
+
+/**
+* It starts the training with checkpoints in a child process and it kills
+* the child after the delay, then it resumes the training from the last
+* checkpoint. It returns false if the child ended before the kill.
+**/
+bool TrainAndKill(neuroc::Network& net, neuroc::Dataset& inputDataset, neuroc::Dataset& targetDataset,
+                  unsigned int epochs, const Setup& setup, unsigned int seed, unsigned int interval, double delay,
+                  const std::string& path, double learningRate){
+ std::remove(path.c_str());
+ pid_t child = fork();
+ if(child < 0) return false;
+ if(child == 0){
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(learningRate);
+  learning.SetCheckpoint(path, interval, true);
+  SetUp(learning, setup, seed);
+  Train(learning, net, inputDataset, targetDataset, epochs, setup.batchSize);
+  _exit(0);
+ }
+ std::this_thread::sleep_for(std::chrono::microseconds((long long) (delay * 1e6)));
+ //The child is killed after its first checkpoint
+ while(access(path.c_str(), F_OK) != 0 && waitpid(child, nullptr, WNOHANG) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+ kill(child, SIGKILL);
+ int status = 0;
+ waitpid(child, &status, 0);
+ if(WIFSIGNALED(status) == false) return false;
+
+ neuroc::BackpropagationLearning learning;
+ if(learning.ResumeFromCheckpoint(&net, path) == false) return false;
+ learning.SetCheckpoint(path, interval, true);
+ Train(learning, net, inputDataset, targetDataset, epochs, setup.batchSize);
+ return true;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 40;
+ unsigned int interval = 1000;
+ unsigned int batch = 32;
+ unsigned int seed = 42;
+ std::string dir = ".";
+ std::string json_path = "./checkpointbench.json";
+ const double learning_rate = 0.35;
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--interval" && i+1<argc) interval = std::atoi(argv[++i]);
+  else if(arg == "--batch" && i+1<argc) batch = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--dir" && i+1<argc) dir = argv[++i];
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--interval N]"
+             << " [--batch N] [--seed N] [--dir DIR] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ const std::string path = dir + "/checkpointbench.nrc";
+
+ std::cout << "=== neuroc checkpoints ===" << std::endl;
+ std::cout << "pendigits 16-" << hidden << "-1, " << epochs << " epochs, a checkpoint every " << interval << " steps" << std::endl;
+ bool all_passed = true;
+ const std::string batch_name = "batch " + std::to_string(batch);
+ const std::vector<Setup> setups = {
+  {"online", 0, neuroc::SampleOrder::FILE_ORDER},
+  {batch_name, batch, neuroc::SampleOrder::FILE_ORDER},
+  {"online shuffle", 0, neuroc::SampleOrder::SHUFFLE},
+  {batch_name + " shuffle", batch, neuroc::SampleOrder::SHUFFLE},
+  {"online importance sampling", 0, neuroc::SampleOrder::IMPORTANCE_SAMPLING},
+  //The largest scale overflows the single precision, the resumed training has to keep the halved scale and the growth counter
+  {batch_name + " mixed precision", batch, neuroc::SampleOrder::FILE_ORDER, std::ldexp(1.0, 135)}
+ };
+ std::vector<std::vector<double>> seconds(setups.size(), std::vector<double>(3, 0.0));
+ const char* mode_names[3] = {"none", "synchronous", "asynchronous"};
+
+ for(unsigned int m=0; m<setups.size(); m++){
+  const unsigned int batch_size = setups[m].batchSize;
+  const std::string& learning_name = setups[m].name;
+
+  //The reference training and the cost of the checkpoints
+  neuroc::Network reference_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+  neuroc_bench::RandomizeNetwork(reference_net, seed);
+  const neuroc::Network initial_net = reference_net;
+  for(unsigned int c=0; c<3; c++){
+   neuroc::Network net = initial_net;
+   neuroc::BackpropagationLearning learning;
+   learning.SetLearningRate(learning_rate);
+   if(c > 0) learning.SetCheckpoint(path, interval, c == 2);
+   SetUp(learning, setups[m], seed);
+   seconds[m][c] = Train(learning, net, train_input, train_target, epochs, batch_size);
+   if(c == 0) reference_net = net;
+   else if(neuroc_bench::SameWeights(net, reference_net) == false){
+    std::cout << "FAILED: the checkpoints changed the " << learning_name << " training" << std::endl;
+    all_passed = false;
+   }
+  }
+
+  //The training killed halfway and resumed
+  neuroc::Network resumed_net = initial_net;
+  bool killed = TrainAndKill(resumed_net, train_input, train_target, epochs, setups[m], seed, interval, seconds[m][2] * 0.5, path, learning_rate);
+  bool exact = killed && neuroc_bench::SameWeights(resumed_net, reference_net);
+  std::cout << learning_name << ": killed halfway and resumed, " << (exact ? "same weights" : "FAILED") << std::endl;
+  all_passed = all_passed && exact;
+
+  //The checkpoint of a completed training does not train again
+  neuroc::Network completed_net = initial_net;
+  neuroc::BackpropagationLearning learning;
+  bool skipped = learning.ResumeFromCheckpoint(&completed_net, path);
+  Train(learning, completed_net, train_input, train_target, epochs, batch_size);
+  skipped = skipped && neuroc_bench::SameWeights(completed_net, reference_net);
+  std::cout << learning_name << ": completed checkpoint resumed, " << (skipped ? "no training" : "FAILED") << std::endl;
+  all_passed = all_passed && skipped;
+
+  std::cout << std::fixed << std::setprecision(3);
+  for(unsigned int c=0; c<3; c++){
+   std::cout << "  " << std::left << std::setw(13) << mode_names[c] << std::right << seconds[m][c] << " s";
+   if(c > 0) std::cout << "  (" << std::setprecision(1) << 100.0 * (seconds[m][c] / seconds[m][0] - 1.0) << "%)" << std::setprecision(3);
+   std::cout << std::endl;
+  }
+ }
+ std::remove(path.c_str());
+
+ //A factorized layer cannot be saved in a checkpoint, the training is refused
+ neuroc::Network factorized_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(factorized_net, seed);
+ neuroc::LowRankFactorization::Factorize(factorized_net[0], 4);
+ neuroc::Network factorized_initial = factorized_net;
+ neuroc::BackpropagationLearning factorized_learning;
+ factorized_learning.SetLearningRate(learning_rate);
+ factorized_learning.SetCheckpoint(path, interval, false);
+ Train(factorized_learning, factorized_net, train_input, train_target, 1, batch);
+ bool refused = neuroc_bench::SameWeights(factorized_net, factorized_initial) && access(path.c_str(), F_OK) != 0;
+ std::cout << "factorized layer: " << (refused ? "training with checkpoints refused" : "FAILED") << std::endl;
+ all_passed = all_passed && refused;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"checkpointbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"interval\": " << interval << ", \"batch\": " << batch << ",\n"
+             << " \"passed\": " << (all_passed ? "true" : "false") << ",\n";
+ for(unsigned int m=0; m<setups.size(); m++){
+  file_stream << " \"" << setups[m].name << "\": {\"none_sec\": " << seconds[m][0]
+              << ", \"synchronous_sec\": " << seconds[m][1] << ", \"asynchronous_sec\": " << seconds[m][2] << "}" << (m+1 < setups.size() ? ",\n" : "\n");
+ }
+ file_stream << "}\n";
+ std::cout << (all_passed ? "All the checks passed" : "Some checks FAILED") << std::endl;
+ std::cout << "Results saved in " << json_path << std::endl;
+ return all_passed ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Weight clustering benchmark. A network is trained on pendigits.tes, its
+ * weights are clustered with the k-means for several sizes of the codebook,
+ * the centroids are fine-tuned and the network is compressed in a
+ * ClusteredNetwork, tested on pendigits.tra. It reports the accuracy after
+ * the clustering and after the fine-tuning, the samples where the clustered
+ * network and the compressed one disagree and the memory of the weights.
+ * The throughput is measured on a wide random network with 4-bit and 8-bit
+ * indices. A binarized network is compressed last, its outputs must not
+ * change.
+ *
+ * Usage:
+ * ./clusterbench [--data-dir DIR] [--hidden N] [--epochs N] [--finetune N] [--learning-rate X]
+ *                [--finetune-rate X] [--width N] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <WeightClustering.h>
+#include <ClusteredNetwork.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 100;
+ unsigned int finetune_epochs = 10;
+ double learning_rate = 0.1;
+ double finetune_rate = 0.001;
+ unsigned int width = 1024;
+ unsigned int seed = 42;
+ std::string json_path = "./clusterbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--finetune" && i+1<argc) finetune_epochs = std::atoi(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--finetune-rate" && i+1<argc) finetune_rate = std::atof(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--finetune N] [--learning-rate X]"
+             << " [--finetune-rate X] [--width N] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+ std::vector<Eigen::VectorXd> test_inputs = neuroc_bench::ReturnInputs(test_input);
+
+ std::cout << "=== neuroc weight clustering (SIMD: " << (neuroc::ClusteredNetwork::IsUsingSIMD() ? "AVX-512" : "none") << ") ===" << std::endl;
+
+ //pendigits: codebooks of different size, before and after the fine-tuning of the centroids
+ neuroc::Network net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(learning_rate);
+ learning.StartOnlineLearning(&net, train_input, train_target, epochs, false);
+ double double_accuracy = neuroc_bench::DigitAccuracy(net, test_input, test_target);
+
+ std::cout << std::fixed;
+ std::cout << "pendigits 16-" << hidden << "-1, " << epochs << " epochs, fine-tuning " << finetune_epochs << " epochs at " << finetune_rate << std::endl;
+ std::cout << "centroids  clustered  fine-tuned  max difference   model bytes  weight bytes" << std::endl;
+ std::cout << std::setw(9) << "double" << std::setprecision(5) << std::setw(11) << double_accuracy << std::setw(12) << double_accuracy
+           << std::setw(16) << "-" << std::setw(14) << "-" << std::setw(14) << neuroc_bench::WeightBytes(net) << std::endl;
+ std::ostringstream json_cases;
+ neuroc::WeightClustering clustering;
+ neuroc::BackpropagationLearning finetune_learning;
+ finetune_learning.SetLearningRate(finetune_rate);
+ std::vector<unsigned int> bits_vector = {8, 5, 4, 3, 2};
+ for(unsigned int b=0; b<bits_vector.size(); b++){
+  neuroc::Network clustered_net = net;
+  if(clustering.Cluster(clustered_net, bits_vector[b]) == false) return 1;
+  double clustered_accuracy = neuroc_bench::DigitAccuracy(clustered_net, test_input, test_target);
+  finetune_learning.StartOnlineLearning(&clustered_net, train_input, train_target, finetune_epochs, false);
+  double tuned_accuracy = neuroc_bench::DigitAccuracy(clustered_net, test_input, test_target);
+  neuroc::ClusteredNetwork compressed_net;
+  if(compressed_net.Compress(clustered_net) == false) return 1;
+  double max_difference = neuroc_bench::MaxDifference(clustered_net, compressed_net, test_inputs);
+  std::cout << std::setw(9) << (1u << bits_vector[b]) << std::setprecision(5) << std::setw(11) << clustered_accuracy << std::setw(12) << tuned_accuracy
+            << std::scientific << std::setprecision(2) << std::setw(16) << max_difference << std::fixed
+            << std::setw(14) << compressed_net.ReturnMemoryFootprint() << std::setw(14) << neuroc::WeightClustering::ReturnClusteredWeightBytes(clustered_net) << std::endl;
+  json_cases << (b ? ",\n" : "") << "  {\"bits\": " << bits_vector[b] << ", \"clustered_accuracy\": " << clustered_accuracy
+             << ", \"finetuned_accuracy\": " << tuned_accuracy << ", \"max_output_difference\": " << max_difference
+             << ", \"model_bytes\": " << compressed_net.ReturnMemoryFootprint()
+             << ", \"weight_bytes\": " << neuroc::WeightClustering::ReturnClusteredWeightBytes(clustered_net) << "}";
+ }
+
+ //Wide network: the throughput when the weights do not fit the caches
+ neuroc::Network wide_net = neuroc_bench::MakeSigmoidNetwork({width, width, width, 10});
+ neuroc_bench::RandomizeNetwork(wide_net, seed);
+ std::srand(seed);
+ std::vector<Eigen::VectorXd> wide_inputs;
+ for(unsigned int i=0; i<64; i++) wide_inputs.push_back(Eigen::VectorXd::Random(width));
+ double double_wide_rate = neuroc_bench::Throughput(wide_net, wide_inputs, 5);
+ std::cout << std::endl << "random " << width << "-" << width << "-" << width << "-10" << std::endl;
+ std::cout << "indices   samples/s   speedup   model bytes   max difference" << std::endl;
+ std::cout << std::setw(7) << "double" << std::setprecision(0) << std::setw(12) << double_wide_rate << std::setw(10) << "-"
+           << std::setw(14) << neuroc_bench::WeightBytes(wide_net) << std::setw(17) << "-" << std::endl;
+ std::ostringstream json_wide;
+ std::vector<unsigned int> wide_bits_vector = {8, 4};
+ for(unsigned int b=0; b<wide_bits_vector.size(); b++){
+  neuroc::Network clustered_net = wide_net;
+  if(clustering.Cluster(clustered_net, wide_bits_vector[b]) == false) return 1;
+  neuroc::ClusteredNetwork compressed_net;
+  if(compressed_net.Compress(clustered_net) == false) return 1;
+  double max_difference = neuroc_bench::MaxDifference(clustered_net, compressed_net, wide_inputs);
+  double rate = neuroc_bench::Throughput(compressed_net, wide_inputs, 5);
+  std::cout << std::setw(5) << wide_bits_vector[b] << "-bit" << std::setprecision(0) << std::setw(12) << rate
+            << std::setprecision(2) << std::setw(9) << rate / double_wide_rate << "x" << std::setw(14) << compressed_net.ReturnMemoryFootprint()
+            << std::scientific << std::setw(17) << max_difference << std::fixed << std::endl;
+  json_wide << (b ? ",\n" : "") << "  {\"bits\": " << wide_bits_vector[b] << ", \"samples_per_sec\": " << rate
+            << ", \"model_bytes\": " << compressed_net.ReturnMemoryFootprint() << ", \"max_output_difference\": " << max_difference << "}";
+ }
+
+ //Binarized network: the layers that are not clustered keep the weights used by the computation,
+ //alpha * sign(W), and not the shadow weights
+ neuroc::Network binarized_net = neuroc_bench::MakeBinarizedNetwork({64, 64, 64, 10}, seed);
+ std::vector<Eigen::VectorXd> binarized_inputs;
+ for(unsigned int i=0; i<64; i++) binarized_inputs.push_back(Eigen::VectorXd::Random(64));
+ neuroc::ClusteredNetwork binarized_compressed;
+ if(binarized_compressed.Compress(binarized_net) == false) return 1;
+ double binarized_difference = neuroc_bench::MaxDifference(binarized_net, binarized_compressed, binarized_inputs);
+ bool binarized_passed = binarized_difference < 1e-9;
+ std::cout << std::endl << "binarized 64-64-64-10, max difference " << std::scientific << binarized_difference << std::fixed
+           << (binarized_passed ? "  PASS" : "  FAIL") << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"clusterbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"simd\": " << (neuroc::ClusteredNetwork::IsUsingSIMD() ? "true" : "false") << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"finetune_epochs\": " << finetune_epochs
+             << ", \"finetune_rate\": " << finetune_rate << ", \"double_accuracy\": " << double_accuracy << ", \"weight_bytes\": " << neuroc_bench::WeightBytes(net)
+             << ",\n \"cases\": [\n" << json_cases.str() << "]},\n"
+             << " \"wide\": {\"width\": " << width << ", \"double_samples_per_sec\": " << double_wide_rate << ", \"weight_bytes\": " << neuroc_bench::WeightBytes(wide_net)
+             << ",\n \"cases\": [\n" << json_wide.str() << "]},\n"
+             << " \"binarized\": {\"max_output_difference\": " << binarized_difference << ", \"passed\": " << (binarized_passed ? "true" : "false") << "}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return binarized_passed ? 0 : 1;
+}
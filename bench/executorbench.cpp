@@ -0,0 +1,256 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Executor benchmark. It checks that the kernels split by the shared
+ * thread pool (Compute, ComputeBatch, the propagation of the error, the
+ * batch learning step in double and in mixed precision, Dataset::DivideBy)
+ * give the results of the serial kernels, with every range split among the
+ * threads, and it measures them on a wide random network with one thread and
+ * with the given number of threads. The speedup depends on the cores of the
+ * machine: with a single core the pool can only add its overhead.
+ *
+ * Usage:
+ * ./executorbench [--width N] [--batch N] [--threads N] [--steps N]
+ *                 [--pinning] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Executor.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* It returns the largest difference between the weights of the networks,
+* relative to the largest weight
+**/
+double WeightDifference(neuroc::Network& first, neuroc::Network& second){
+ double difference = 0.0;
+ for(unsigned int i=0; i<first.Size(); i++){
+  const Eigen::MatrixXd& weight_matrix = first[i].GetWeightMatrix();
+  double scale = std::max(1.0, weight_matrix.cwiseAbs().maxCoeff());
+  difference = std::max(difference, (weight_matrix - second[i].GetWeightMatrix()).cwiseAbs().maxCoeff() / scale);
+  difference = std::max(difference, (first[i].GetBiasVector() - second[i].GetBiasVector()).cwiseAbs().maxCoeff());
+ }
+ return difference;
+}
+
+/**
+* It returns the median of the seconds taken by the function
+**/
+template<typename Function>
+double MedianSeconds(unsigned int runs, const Function& function){
+ function();
+ std::vector<double> seconds;
+ for(unsigned int i=0; i<runs; i++){
+  double start = neuroc_bench::NowNanoseconds();
+  function();
+  seconds.push_back((neuroc_bench::NowNanoseconds() - start) * 1e-9);
+ }
+ std::sort(seconds.begin(), seconds.end());
+ return seconds[seconds.size() / 2];
+}
+
+/**
+* \struct Timings
+* \brief The seconds of the kernels with a number of threads
+*/
+struct Timings {
+ double compute;
+ double batch;
+ double step;
+};
+
+Timings MeasureKernels(neuroc::Network& net, const Eigen::MatrixXd& inputMatrix, const Eigen::MatrixXd& targetMatrix, unsigned int steps){
+ Timings timings;
+ Eigen::VectorXd input_vector = inputMatrix.col(0);
+ timings.compute = MedianSeconds(steps * 10, [&](){ neuroc_bench::DoNotOptimize(net.Compute(input_vector).data()); });
+ neuroc::DenseLayer& layer = net[0];
+ Eigen::MatrixXd output_matrix(layer.ReturnNumberOfNeurons(), inputMatrix.cols());
+ Eigen::MatrixXd derivative_matrix(layer.ReturnNumberOfNeurons(), inputMatrix.cols());
+ timings.batch = MedianSeconds(steps, [&](){
+  layer.ComputeBatch(inputMatrix, output_matrix, derivative_matrix);
+  neuroc_bench::DoNotOptimize(output_matrix.data());
+ });
+ neuroc::Network step_net = net;
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(0.01);
+ timings.step = MedianSeconds(steps, [&](){ neuroc_bench::DoNotOptimize(learning.SingleStepBatchLearning(&step_net, inputMatrix, targetMatrix)); });
+ return timings;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ unsigned int width = 4096;
+ unsigned int batch = 64;
+ unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+ unsigned int steps = 10;
+ bool pinning = false;
+ unsigned int seed = 42;
+ std::string json_path = "./executorbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--batch" && i+1<argc) batch = std::atoi(argv[++i]);
+  else if(arg == "--threads" && i+1<argc) threads = std::atoi(argv[++i]);
+  else if(arg == "--steps" && i+1<argc) steps = std::atoi(argv[++i]);
+  else if(arg == "--pinning") pinning = true;
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--width N] [--batch N] [--threads N] [--steps N]"
+             << " [--pinning] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Executor& executor = neuroc::Executor::ReturnInstance();
+ const std::size_t default_threshold = executor.GetThreshold();
+ std::cout << "=== neuroc executor ===" << std::endl;
+ std::cout << "random " << width << "-" << width << "-10, batch " << batch << ", "
+           << std::thread::hardware_concurrency() << " cores" << std::endl;
+ bool passed = true;
+
+ neuroc::Network net = neuroc_bench::MakeSigmoidNetwork({width, width, 10});
+ neuroc_bench::RandomizeNetwork(net, seed);
+ std::srand(seed);
+ Eigen::MatrixXd input_matrix = Eigen::MatrixXd::Random(width, batch);
+ Eigen::MatrixXd target_matrix = (Eigen::MatrixXd::Random(10, batch).array() + 1.0) * 0.5;
+ Eigen::VectorXd input_vector = input_matrix.col(0);
+ neuroc::DenseLayer& layer = net[0];
+ Eigen::MatrixXd error_matrix = Eigen::MatrixXd::Random(width, batch);
+
+ //Serial results
+ executor.SetNumberOfThreads(1);
+ Eigen::VectorXd serial_output = net.Compute(input_vector);
+ Eigen::MatrixXd serial_batch(width, batch), serial_derivative(width, batch), serial_input_error(width, batch);
+ layer.ComputeBatch(input_matrix, serial_batch, serial_derivative);
+ layer.ComputeInputError(error_matrix, serial_input_error);
+ neuroc::Network serial_net = net;
+ neuroc::BackpropagationLearning serial_learning;
+ serial_learning.SetLearningRate(0.01);
+ serial_learning.SingleStepBatchLearning(&serial_net, input_matrix, target_matrix);
+ neuroc::Network serial_mixed_net = net;
+ neuroc::BackpropagationLearning serial_mixed_learning;
+ serial_mixed_learning.SetLearningRate(0.01);
+ serial_mixed_learning.SetMixedPrecision(true);
+ serial_mixed_learning.SingleStepBatchLearning(&serial_mixed_net, input_matrix, target_matrix);
+ neuroc::Dataset serial_dataset;
+ for(unsigned int i=0; i<batch; i++) serial_dataset.PushBackData(input_matrix.col(i));
+ neuroc::Dataset parallel_dataset = serial_dataset;
+ serial_dataset.DivideBy(3.0);
+
+ //Every range split among the threads, more threads than cores if needed
+ executor.SetNumberOfThreads(std::max(4u, threads));
+ executor.SetPinning(pinning);
+ executor.SetThreshold(0);
+ unsigned long long check_blocks = executor.ReturnNumberOfBlocks();
+ double compute_difference = (net.Compute(input_vector) - serial_output).cwiseAbs().maxCoeff();
+ Eigen::MatrixXd parallel_batch(width, batch), parallel_derivative(width, batch), parallel_input_error(width, batch);
+ layer.ComputeBatch(input_matrix, parallel_batch, parallel_derivative);
+ layer.ComputeInputError(error_matrix, parallel_input_error);
+ double batch_difference = std::max((parallel_batch - serial_batch).cwiseAbs().maxCoeff(), (parallel_derivative - serial_derivative).cwiseAbs().maxCoeff());
+ double input_error_difference = (parallel_input_error - serial_input_error).cwiseAbs().maxCoeff();
+ neuroc::Network parallel_net = net;
+ neuroc::BackpropagationLearning parallel_learning;
+ parallel_learning.SetLearningRate(0.01);
+ parallel_learning.SingleStepBatchLearning(&parallel_net, input_matrix, target_matrix);
+ double step_difference = WeightDifference(serial_net, parallel_net);
+ neuroc::Network parallel_mixed_net = net;
+ neuroc::BackpropagationLearning parallel_mixed_learning;
+ parallel_mixed_learning.SetLearningRate(0.01);
+ parallel_mixed_learning.SetMixedPrecision(true);
+ parallel_mixed_learning.SingleStepBatchLearning(&parallel_mixed_net, input_matrix, target_matrix);
+ double mixed_difference = WeightDifference(serial_mixed_net, parallel_mixed_net);
+ parallel_dataset.DivideBy(3.0);
+ double dataset_difference = 0.0;
+ for(unsigned int i=0; i<batch; i++) dataset_difference = std::max(dataset_difference, (parallel_dataset[i] - serial_dataset[i]).cwiseAbs().maxCoeff());
+ check_blocks = executor.ReturnNumberOfBlocks() - check_blocks;
+
+ std::cout << std::scientific << std::setprecision(2);
+ std::cout << executor.GetNumberOfThreads() << " threads, threshold 0, " << check_blocks << " blocks, largest difference from the serial kernels:" << std::endl;
+ std::cout << "Compute " << compute_difference << ", ComputeBatch " << batch_difference << ", ComputeInputError " << input_error_difference
+           << ", batch step " << step_difference << ", mixed step " << mixed_difference << ", DivideBy " << dataset_difference << std::endl;
+ if(check_blocks == 0 || compute_difference > 1e-12 || batch_difference > 1e-12 || input_error_difference > 1e-12 || step_difference > 1e-12 || dataset_difference != 0.0){
+  std::cout << "FAIL: the parallel kernels do not match the serial ones" << std::endl;
+  passed = false;
+ }
+ //The single precision products are rounded in a different order
+ if(mixed_difference > 1e-5){
+  std::cout << "FAIL: the parallel mixed precision step does not match the serial one" << std::endl;
+  passed = false;
+ }
+
+ //Timings with one thread and with the pool, default threshold
+ executor.SetThreshold(default_threshold);
+ executor.SetNumberOfThreads(1);
+ Timings serial_timings = MeasureKernels(net, input_matrix, target_matrix, steps);
+ executor.SetNumberOfThreads(threads);
+ unsigned long long blocks = executor.ReturnNumberOfBlocks();
+ unsigned long long steals = executor.ReturnNumberOfSteals();
+ Timings parallel_timings = MeasureKernels(net, input_matrix, target_matrix, steps);
+ blocks = executor.ReturnNumberOfBlocks() - blocks;
+ steals = executor.ReturnNumberOfSteals() - steals;
+
+ std::cout << std::fixed << std::setprecision(3);
+ std::cout << "threads          1          " << threads << std::endl;
+ std::cout << "Compute      " << serial_timings.compute * 1e3 << " ms   " << parallel_timings.compute * 1e3 << " ms   "
+           << std::setprecision(2) << serial_timings.compute / parallel_timings.compute << "x" << std::setprecision(3) << std::endl;
+ std::cout << "ComputeBatch " << serial_timings.batch * 1e3 << " ms   " << parallel_timings.batch * 1e3 << " ms   "
+           << std::setprecision(2) << serial_timings.batch / parallel_timings.batch << "x" << std::setprecision(3) << std::endl;
+ std::cout << "batch step   " << serial_timings.step * 1e3 << " ms   " << parallel_timings.step * 1e3 << " ms   "
+           << std::setprecision(2) << serial_timings.step / parallel_timings.step << "x" << std::endl;
+ std::cout << blocks << " blocks, " << steals << " stolen" << std::endl;
+ if(threads > std::thread::hardware_concurrency()) std::cout << "note: more threads than cores, the speedup is not meaningful" << std::endl;
+ std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"executorbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"cores\": " << std::thread::hardware_concurrency() << ", \"threads\": " << threads << ", \"width\": " << width << ", \"batch\": " << batch << ",\n"
+             << " \"differences\": {\"compute\": " << compute_difference << ", \"batch\": " << batch_difference << ", \"input_error\": " << input_error_difference
+             << ", \"step\": " << step_difference << ", \"mixed_step\": " << mixed_difference << ", \"dataset\": " << dataset_difference << "},\n"
+             << " \"serial_ms\": {\"compute\": " << serial_timings.compute * 1e3 << ", \"batch\": " << serial_timings.batch * 1e3 << ", \"step\": " << serial_timings.step * 1e3 << "},\n"
+             << " \"parallel_ms\": {\"compute\": " << parallel_timings.compute * 1e3 << ", \"batch\": " << parallel_timings.batch * 1e3 << ", \"step\": " << parallel_timings.step * 1e3 << "},\n"
+             << " \"blocks\": " << blocks << ", \"steals\": " << steals << ",\n"
+             << " \"passed\": " << (passed ? "true" : "false") << "\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return passed ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Code generation benchmark. It is built in two steps by make exportbench:
+ * the first build trains a sigmoid network on pendigits.tes and builds a
+ * random network with other transfer and join functions, then it exports
+ * them with Network::ExportCpp() in the folder given by --export-dir. The
+ * second build defines NEUROC_EXPORTED_MODELS and includes the generated
+ * headers, it builds the same networks (the training is repeatable) and
+ * compares the output of Predict() with Network::Compute() on the samples
+ * of pendigits.tra. It reports the largest difference, the samples with a
+ * bit-exact output, the allocations and the throughput of the two paths.
+ * It fails if the outputs differ more than the tolerance.
+ *
+ * Usage:
+ * ./exportbench [--data-dir DIR] [--hidden N] [--epochs N] [--seed N]
+ *               [--tolerance X] [--export-dir DIR] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <MemoryStats.h>
+#include <WeightFunctions.h>
+#include <JoinFunctions.h>
+#include <TransferFunctions.h>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+#ifdef NEUROC_EXPORTED_MODELS
+#include "pendigits_model.h"
+#include "mixed_model.h"
+#endif
+
+namespace {
+
+/**
+* It returns a 16-64-32-10 network with random weights, whose layers
+* use the Tanh, FastSigmoid and SaturatedLinear transfer functions and
+* the Sum and Product join functions.
+**/
+neuroc::Network MakeMixedNetwork(unsigned int seed){
+ neuroc::Network net;
+ net.EmplaceLayer(16, 64, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::Tanh, neuroc::TransferFunctions::TanhDerivative);
+ net.EmplaceLayer(64, 32, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Product, neuroc::TransferFunctions::FastSigmoid, neuroc::TransferFunctions::Linear);
+ net.EmplaceLayer(32, 10, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::SaturatedLinear, neuroc::TransferFunctions::Linear);
+ neuroc_bench::RandomizeNetwork(net, seed);
+ return net;
+}
+
+#ifdef NEUROC_EXPORTED_MODELS
+
+/**
+* \struct Comparison
+* \brief Agreement and speed of a generated model and its network
+*/
+struct Comparison {
+ double maxDifference;
+ unsigned int exactSamples;
+ unsigned long long networkAllocations;
+ unsigned long long predictAllocations;
+ double networkRate;
+ double predictRate;
+};
+
+/**
+* It compares the output of Predict() with the output of the network on
+* the inputs, then it measures the samples per second of the two paths.
+**/
+template<typename InputVector, typename PredictFunction>
+Comparison Compare(neuroc::Network& net, PredictFunction predict, const std::vector<Eigen::VectorXd>& inputs, unsigned int repetitions){
+ std::vector<InputVector, Eigen::aligned_allocator<InputVector> > fixed_inputs;
+ for(unsigned int i=0; i<inputs.size(); i++) fixed_inputs.push_back(inputs[i]);
+
+ Comparison comparison = Comparison();
+ for(unsigned int i=0; i<inputs.size(); i++){
+  const Eigen::VectorXd& output_vector = net.Compute(inputs[i]);
+  Eigen::VectorXd predicted_vector = predict(fixed_inputs[i]);
+  comparison.maxDifference = std::max(comparison.maxDifference, (output_vector - predicted_vector).cwiseAbs().maxCoeff());
+  if(output_vector == predicted_vector) comparison.exactSamples++;
+ }
+
+ neuroc::MemoryStats::AllocationScope network_scope;
+ for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(net.Compute(inputs[i]).data());
+ comparison.networkAllocations = network_scope.Allocations();
+ neuroc::MemoryStats::AllocationScope predict_scope;
+ for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(predict(fixed_inputs[i]));
+ comparison.predictAllocations = predict_scope.Allocations();
+
+ double start = neuroc_bench::NowNanoseconds();
+ for(unsigned int r=0; r<repetitions; r++){
+  for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(net.Compute(inputs[i]).data());
+ }
+ comparison.networkRate = (double) repetitions * inputs.size() / ((neuroc_bench::NowNanoseconds() - start) * 1e-9);
+ start = neuroc_bench::NowNanoseconds();
+ for(unsigned int r=0; r<repetitions; r++){
+  for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(predict(fixed_inputs[i]));
+ }
+ comparison.predictRate = (double) repetitions * inputs.size() / ((neuroc_bench::NowNanoseconds() - start) * 1e-9);
+ return comparison;
+}
+
+void PrintComparison(const std::string& name, const Comparison& comparison, unsigned int samples){
+ std::cout << name << std::endl;
+ std::cout << std::scientific << std::setprecision(3) << "max difference " << comparison.maxDifference
+           << ", bit-exact on " << comparison.exactSamples << " of " << samples << " samples" << std::endl;
+ std::cout << std::fixed << std::setprecision(0)
+           << "Network::Compute  " << comparison.networkRate << " samples/s  " << comparison.networkAllocations << " allocations" << std::endl
+           << "Predict           " << comparison.predictRate << " samples/s  " << comparison.predictAllocations << " allocations" << std::endl
+           << std::setprecision(2) << "speedup " << comparison.predictRate / comparison.networkRate << "x" << std::endl;
+}
+
+std::string ComparisonToJSON(const Comparison& comparison){
+ std::ostringstream stream;
+ stream << std::setprecision(10) << "{\"max_difference\": " << comparison.maxDifference << ", \"exact_samples\": " << comparison.exactSamples
+        << ", \"network_allocations\": " << comparison.networkAllocations << ", \"predict_allocations\": " << comparison.predictAllocations
+        << ", \"network_samples_per_sec\": " << comparison.networkRate << ", \"predict_samples_per_sec\": " << comparison.predictRate << "}";
+ return stream.str();
+}
+
+#endif
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 10;
+ unsigned int epochs = 30;
+ unsigned int seed = 42;
+ double tolerance = 1e-12;
+ std::string export_dir = "";
+ std::string json_path = "./exportbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--tolerance" && i+1<argc) tolerance = std::atof(argv[++i]);
+  else if(arg == "--export-dir" && i+1<argc) export_dir = argv[++i];
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--seed N]"
+             << " [--tolerance X] [--export-dir DIR] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ std::vector<Eigen::VectorXd> test_inputs;
+ for(unsigned int i=0; i<test_input.ReturnNumberOfElements(); i++) test_inputs.push_back(test_input[i]);
+
+ neuroc::Network digits_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(digits_net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(0.35);
+ learning.StartOnlineLearning(&digits_net, train_input, train_target, epochs, false);
+ neuroc::Network mixed_net = MakeMixedNetwork(seed);
+
+ if(export_dir.empty() == false){
+  if(digits_net.ExportCpp(export_dir + "/pendigits_model.h", "pendigits_model") == false) return 1;
+  if(mixed_net.ExportCpp(export_dir + "/mixed_model.h", "mixed_model") == false) return 1;
+  std::cout << "Models exported in " << export_dir << std::endl;
+  return 0;
+ }
+
+#ifdef NEUROC_EXPORTED_MODELS
+ std::cout << "=== neuroc generated code ===" << std::endl;
+ Comparison digits = Compare<pendigits_model::InputVector>(digits_net, pendigits_model::Predict, test_inputs, 50);
+ PrintComparison("pendigits 16-" + std::to_string(hidden) + "-1, " + std::to_string(epochs) + " epochs", digits, test_inputs.size());
+ std::cout << std::endl;
+ Comparison mixed = Compare<mixed_model::InputVector>(mixed_net, mixed_model::Predict, test_inputs, 20);
+ PrintComparison("random 16-64-32-10, Tanh, FastSigmoid with Product join, SaturatedLinear", mixed, test_inputs.size());
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << "{\n \"suite\": \"exportbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"tolerance\": " << tolerance << ",\n"
+             << " \"pendigits\": " << ComparisonToJSON(digits) << ",\n"
+             << " \"mixed\": " << ComparisonToJSON(mixed) << "\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ if(digits.maxDifference > tolerance || mixed.maxDifference > tolerance){
+  std::cerr << "FAILED: the generated code differs from Network::Compute more than " << tolerance << std::endl;
+  return 1;
+ }
+ return 0;
+#else
+ (void) tolerance;
+ std::cerr << "Error: the generated models are not included, build with make exportbench." << std::endl;
+ return 1;
+#endif
+}
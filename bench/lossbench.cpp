@@ -0,0 +1,260 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Loss functions benchmark. The finite differences check the gradient of
+ * every loss, then pendigits.tes is learned with three output heads: the
+ * single sigmoid output regressing digit/10 with the squared error, ten
+ * sigmoid outputs with one-hot targets and the squared error, ten softmax
+ * outputs with the cross entropy. The accuracy on pendigits.tra is measured
+ * after every epoch and the benchmark reports the epochs needed to reach
+ * the target accuracy, the best accuracy and the time of an epoch.
+ *
+ * Usage:
+ * ./lossbench [--data-dir DIR] [--hidden N] [--epochs N] [--target X]
+ *             [--learning-rate X] [--ce-learning-rate X] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <LossFunctions.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* \struct HeadResult
+* \brief The outcome of a training with an output head
+*/
+struct HeadResult {
+ std::string name;
+ unsigned int reachedEpoch; //zero if the target was not reached
+ double bestAccuracy;
+ double epochSeconds;
+};
+
+/**
+* It returns the fraction of the samples classified correctly. A single
+* output is the digit divided by ten, otherwise the largest output is the digit.
+**/
+double Accuracy(neuroc::Network& net, neuroc::Dataset& inputDataset, std::vector<unsigned int>& labels){
+ unsigned int correct = 0;
+ for(unsigned int i=0; i<inputDataset.ReturnNumberOfElements(); i++){
+  const Eigen::VectorXd& output_vector = net.Compute(inputDataset[i]);
+  Eigen::Index digit = 0;
+  if(output_vector.size() == 1) digit = std::lround(output_vector[0] * 10.0);
+  else output_vector.maxCoeff(&digit);
+  if(digit == (Eigen::Index) labels[i]) correct++;
+ }
+ return (double) correct / inputDataset.ReturnNumberOfElements();
+}
+
+/**
+* It returns the loss of the network on a sample
+**/
+double SampleLoss(neuroc::Network& net, neuroc::LossFunctions::Function loss, const Eigen::VectorXd& input, const Eigen::VectorXd& target){
+ net.ComputeDerivative(input);
+ neuroc::DenseLayer& layer = net[net.Size()-1];
+ Eigen::VectorXd delta_vector(target.size());
+ return loss(layer.GetOutputVector(), layer.GetDerivativeVector(), target, delta_vector);
+}
+
+/**
+* It returns the largest relative difference between the gradient of the
+* weights of the output layer given by the error backpropagation and the
+* one given by the central finite differences.
+**/
+double GradientDifference(neuroc::Network& net, neuroc::LossFunctions::Function loss, const Eigen::VectorXd& input, const Eigen::VectorXd& target){
+ neuroc::BackpropagationLearning learning;
+ learning.SetLoss(loss);
+ learning.Forward(&net, input);
+ learning.ErrorBackpropagation(&net, target);
+ neuroc::DenseLayer& layer = net[net.Size()-1];
+ //The delta is the opposite of the gradient with respect to the weighted input
+ Eigen::MatrixXd analytic_matrix = -layer.GetErrorVector() * layer.GetInputVector().transpose();
+ const Eigen::MatrixXd weight_matrix = layer.GetWeightMatrix();
+ const double step = 1e-6;
+ double difference = 0;
+ for(Eigen::Index row=0; row<weight_matrix.rows(); row++){
+  for(Eigen::Index col=0; col<weight_matrix.cols(); col++){
+   Eigen::MatrixXd changed_matrix = weight_matrix;
+   changed_matrix(row, col) += step;
+   layer.SetWeightMatrix(changed_matrix);
+   double loss_plus = SampleLoss(net, loss, input, target);
+   changed_matrix(row, col) -= 2.0 * step;
+   layer.SetWeightMatrix(changed_matrix);
+   double loss_minus = SampleLoss(net, loss, input, target);
+   double numeric = (loss_plus - loss_minus) / (2.0 * step);
+   //The delta of the squared error is the gradient of half of it
+   if(loss == &neuroc::LossFunctions::MeanSquaredError) numeric *= 0.5;
+   double scale = std::max(1.0, std::abs(numeric));
+   difference = std::max(difference, std::abs(numeric - analytic_matrix(row, col)) / scale);
+  }
+ }
+ layer.SetWeightMatrix(weight_matrix);
+ return difference;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 30;
+ double target = 0.9;
+ double learning_rate = 0.35;
+ double ce_learning_rate = 0.05;
+ unsigned int seed = 42;
+ std::string json_path = "./lossbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--target" && i+1<argc) target = std::atof(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--ce-learning-rate" && i+1<argc) ce_learning_rate = std::atof(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--target X]"
+             << " [--learning-rate X] [--ce-learning-rate X] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ test_input.DivideBy(100);
+ std::vector<unsigned int> test_labels;
+ for(unsigned int i=0; i<test_target.ReturnNumberOfElements(); i++) test_labels.push_back(std::lround(test_target[i][0]));
+ neuroc::Dataset train_onehot;
+ for(unsigned int i=0; i<train_target.ReturnNumberOfElements(); i++){
+  Eigen::VectorXd onehot_vector = Eigen::VectorXd::Zero(10);
+  onehot_vector[std::lround(train_target[i][0])] = 1.0;
+  train_onehot.PushBackData(onehot_vector);
+ }
+ train_target.DivideBy(10);
+
+ std::cout << "=== neuroc loss functions ===" << std::endl;
+
+ //Gradients of the losses against the finite differences
+ const char* loss_names[5] = {"MeanSquaredError", "MeanAbsoluteError", "Huber", "CrossEntropy", "BinaryCrossEntropy"};
+ const neuroc::LossFunctions::Function losses[5] = {&neuroc::LossFunctions::MeanSquaredError, &neuroc::LossFunctions::MeanAbsoluteError,
+  &neuroc::LossFunctions::Huber, &neuroc::LossFunctions::CrossEntropy, &neuroc::LossFunctions::BinaryCrossEntropy};
+ double gradient_differences[5];
+ bool gradients_passed = true;
+ for(unsigned int l=0; l<5; l++){
+  neuroc::Network net = (losses[l] == &neuroc::LossFunctions::CrossEntropy) ? neuroc_bench::MakeSoftmaxNetwork({16, 8, 10}) : neuroc_bench::MakeSigmoidNetwork({16, 8, 10});
+  neuroc_bench::RandomizeNetwork(net, seed);
+  gradient_differences[l] = GradientDifference(net, losses[l], train_input[0], train_onehot[0]);
+  gradients_passed &= (gradient_differences[l] < 1e-5);
+  std::cout << std::left << std::setw(20) << loss_names[l] << std::right << "gradient difference " << std::scientific << std::setprecision(2)
+            << gradient_differences[l] << (gradient_differences[l] < 1e-5 ? "  PASS" : "  FAIL") << std::endl;
+ }
+
+ //Logits that overflow the exponential, the log-sum-exp keeps the loss finite
+ Eigen::VectorXd large_logits(3), large_target(3), large_delta(3);
+ large_logits << 1000.0, -1000.0, 0.0;
+ large_target << 0.0, 1.0, 0.0;
+ Eigen::VectorXd large_output = neuroc::TransferFunctions::Softmax(large_logits);
+ double large_loss = neuroc::LossFunctions::CrossEntropy(large_output, large_logits, large_target, large_delta);
+ bool stable = std::isfinite(large_loss) && std::abs(large_loss - 2000.0) < 1e-9 && large_delta.allFinite();
+ gradients_passed &= stable;
+ std::cout << "cross entropy of the logits (1000, -1000, 0): " << std::fixed << std::setprecision(1) << large_loss << (stable ? "  PASS" : "  FAIL") << std::endl;
+
+ //Training of the three output heads from the same hidden layer
+ std::cout << std::endl << "pendigits 16-" << hidden << "-(1|10), " << epochs << " epochs of " << train_input.ReturnNumberOfElements()
+           << " samples, target test accuracy " << std::setprecision(2) << target << std::endl;
+ neuroc::Network regression_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc::Network onehot_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 10});
+ neuroc::Network softmax_net = neuroc_bench::MakeSoftmaxNetwork({16, hidden, 10});
+ neuroc_bench::RandomizeNetwork(regression_net, seed);
+ neuroc_bench::RandomizeNetwork(onehot_net, seed);
+ neuroc_bench::RandomizeNetwork(softmax_net, seed);
+ neuroc::Network* nets[3] = {&regression_net, &onehot_net, &softmax_net};
+ neuroc::Dataset* targets[3] = {&train_target, &train_onehot, &train_onehot};
+ const char* head_names[3] = {"sigmoid digit/10 MSE", "sigmoid one-hot MSE", "softmax cross entropy"};
+
+ std::vector<HeadResult> results;
+ for(unsigned int h=0; h<3; h++){
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(h == 2 ? ce_learning_rate : learning_rate);
+  if(h == 2) learning.SetLoss(neuroc::LossFunctions::CrossEntropy);
+  HeadResult result;
+  result.name = head_names[h];
+  result.reachedEpoch = 0;
+  result.bestAccuracy = 0;
+  double seconds = 0;
+  for(unsigned int e=0; e<epochs; e++){
+   double start = neuroc_bench::NowNanoseconds();
+   learning.StartOnlineLearning(nets[h], train_input, *targets[h], 1, false);
+   seconds += (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+   double accuracy = Accuracy(*nets[h], test_input, test_labels);
+   result.bestAccuracy = std::max(result.bestAccuracy, accuracy);
+   if(result.reachedEpoch == 0 && accuracy >= target) result.reachedEpoch = e + 1;
+  }
+  result.epochSeconds = seconds / epochs;
+  results.push_back(result);
+ }
+
+ std::cout << std::fixed << std::setprecision(4);
+ for(const HeadResult& result : results){
+  std::cout << std::left << std::setw(22) << result.name << std::right;
+  if(result.reachedEpoch > 0) std::cout << "target after " << std::setw(3) << result.reachedEpoch << " epochs";
+  else std::cout << "target not reached    ";
+  std::cout << ", best accuracy " << result.bestAccuracy << ", " << std::setprecision(2) << result.epochSeconds * 1e3 << " ms/epoch" << std::setprecision(4) << std::endl;
+ }
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"lossbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"gradients_passed\": " << (gradients_passed ? "true" : "false") << ",\n \"gradient_differences\": {";
+ for(unsigned int l=0; l<5; l++) file_stream << "\"" << loss_names[l] << "\": " << gradient_differences[l] << (l+1 < 5 ? ", " : "},\n");
+ file_stream << " \"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"target\": " << target << ",\n \"heads\": [\n";
+ for(unsigned int i=0; i<results.size(); i++){
+  file_stream << "  {\"head\": \"" << results[i].name << "\", \"reached_epoch\": " << results[i].reachedEpoch
+              << ", \"best_accuracy\": " << results[i].bestAccuracy << ", \"epoch_sec\": " << results[i].epochSeconds << "}"
+              << (i+1 < results.size() ? ",\n" : "\n");
+ }
+ file_stream << " ]\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return gradients_passed ? 0 : 1;
+}
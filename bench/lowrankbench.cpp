@@ -0,0 +1,241 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Low-rank factorization benchmark. A network with two wide hidden layers
+ * is trained on pendigits.tes and compressed with the truncated SVD, with
+ * the rank of every layer chosen from an energy threshold or from an error
+ * budget on a validation part of the training set. The compressed networks
+ * are tested on pendigits.tra, after the truncation and after a fine-tuning
+ * of the factors (the dense network is trained for the same epochs), with
+ * their size and throughput. Two neurons are removed from a factorized
+ * layer after a learning step and the kept weights must not change. The
+ * last part measures a square layer whose weights have decaying singular values,
+ * computed with the full matrix and with the factors of growing rank.
+ *
+ * Usage:
+ * ./lowrankbench [--data-dir DIR] [--hidden N] [--epochs N] [--finetune N] [--learning-rate X]
+ *                [--validation N] [--width N] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <LowRankFactorization.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* It returns the median time in nanoseconds of the function
+**/
+double MedianNs(std::function<void()> function, unsigned int repetitions){
+ for(unsigned int i=0; i<repetitions/10+1; i++) function();
+ std::vector<double> samples;
+ for(unsigned int i=0; i<repetitions; i++){
+  double start = neuroc_bench::NowNanoseconds();
+  function();
+  samples.push_back(neuroc_bench::NowNanoseconds() - start);
+ }
+ std::sort(samples.begin(), samples.end());
+ return samples[samples.size()/2];
+}
+
+/**
+* It returns the number of weights used by the computation of the network
+**/
+std::size_t WeightCount(neuroc::Network& net){
+ std::size_t weights = 0;
+ for(unsigned int i=0; i<net.Size(); i++){
+  if(net[i].IsFactorized()) weights += net[i].GetLeftFactorMatrix().size() + net[i].GetRightFactorMatrix().size();
+  else weights += net[i].GetWeightMatrix().size();
+ }
+ return weights;
+}
+
+std::string Ranks(neuroc::Network& net){
+ std::string ranks;
+ for(unsigned int i=0; i<net.Size(); i++) ranks += (i ? "-" : "") + (net[i].IsFactorized() ? std::to_string(net[i].ReturnRank()) : std::string("full"));
+ return ranks;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 256;
+ unsigned int epochs = 40;
+ unsigned int finetune_epochs = 10;
+ double learning_rate = 0.05;
+ unsigned int validation_size = 1000;
+ unsigned int width = 1024;
+ unsigned int seed = 42;
+ std::string json_path = "./lowrankbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--finetune" && i+1<argc) finetune_epochs = std::atoi(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--validation" && i+1<argc) validation_size = std::atoi(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--finetune N] [--learning-rate X]"
+             << " [--validation N] [--width N] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+ neuroc::Dataset validation_input, validation_target;
+ for(unsigned int i=0; i<validation_size && i<train_input.ReturnNumberOfElements(); i++){
+  validation_input.PushBackData(train_input[i]);
+  validation_target.PushBackData(train_target[i]);
+ }
+
+ std::cout << "=== neuroc low-rank factorization ===" << std::endl;
+
+ //pendigits: rank chosen by energy and by error budget
+ neuroc::Network dense_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, hidden, 1});
+ neuroc_bench::RandomizeNetwork(dense_net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(learning_rate);
+ learning.StartOnlineLearning(&dense_net, train_input, train_target, epochs, false);
+
+ std::vector<Eigen::VectorXd> test_inputs = neuroc_bench::ReturnInputs(test_input);
+ neuroc::Network tuned_net = dense_net;
+ learning.StartOnlineLearning(&tuned_net, train_input, train_target, finetune_epochs, false);
+ double dense_accuracy = neuroc_bench::DigitAccuracy(dense_net, test_input, test_target);
+ double dense_tuned_accuracy = neuroc_bench::DigitAccuracy(tuned_net, test_input, test_target);
+ double dense_rate = neuroc_bench::Throughput(dense_net, test_inputs, 20);
+ std::ostringstream json_cases;
+ std::cout << std::fixed;
+ std::cout << "pendigits 16-" << hidden << "-" << hidden << "-1, " << epochs << " epochs, fine-tuning " << finetune_epochs
+           << " epochs, validation " << validation_input.ReturnNumberOfElements() << " samples" << std::endl;
+ std::cout << "selection       ranks             weights  truncated  fine-tuned   samples/s  speedup" << std::endl;
+ std::cout << std::left << std::setw(16) << "dense" << std::setw(16) << Ranks(dense_net) << std::right << std::setw(8) << WeightCount(dense_net)
+           << std::setprecision(5) << std::setw(11) << dense_accuracy << std::setw(12) << dense_tuned_accuracy
+           << std::setprecision(0) << std::setw(12) << dense_rate << std::endl;
+
+ std::vector<std::pair<std::string, double> > selections = {{"energy", 0.99}, {"energy", 0.9}, {"energy", 0.8}, {"energy", 0.6},
+                                                            {"error", 0.01}, {"error", 0.05}, {"error", 0.1}};
+ neuroc::LowRankFactorization factorization;
+ for(unsigned int s=0; s<selections.size(); s++){
+  neuroc::Network compressed_net = dense_net;
+  if(selections[s].first == "energy") factorization.FactorizeByEnergy(compressed_net, selections[s].second);
+  else factorization.FactorizeByError(compressed_net, validation_input, validation_target, selections[s].second);
+  double accuracy = neuroc_bench::DigitAccuracy(compressed_net, test_input, test_target);
+  double rate = neuroc_bench::Throughput(compressed_net, test_inputs, 20);
+  learning.StartOnlineLearning(&compressed_net, train_input, train_target, finetune_epochs, false);
+  double tuned_accuracy = neuroc_bench::DigitAccuracy(compressed_net, test_input, test_target);
+  std::ostringstream name;
+  name << selections[s].first << " " << selections[s].second;
+  std::cout << std::left << std::setw(16) << name.str() << std::setw(16) << Ranks(compressed_net) << std::right << std::setw(8) << WeightCount(compressed_net)
+            << std::setprecision(5) << std::setw(11) << accuracy << std::setw(12) << tuned_accuracy << std::setprecision(0) << std::setw(12) << rate
+            << std::setprecision(2) << std::setw(8) << rate / dense_rate << "x" << std::endl;
+  json_cases << (s ? ",\n" : "") << "  {\"selection\": \"" << selections[s].first << "\", \"value\": " << selections[s].second
+             << ", \"ranks\": \"" << Ranks(compressed_net) << "\", \"weights\": " << WeightCount(compressed_net)
+             << ", \"accuracy\": " << accuracy << ", \"finetuned_accuracy\": " << tuned_accuracy << ", \"samples_per_sec\": " << rate << "}";
+ }
+
+ //Neurons removed from a factorized layer after a learning step, the weights
+ //are computed again from the factors and the kept rows and columns are the same
+ neuroc::Network removal_net = dense_net;
+ factorization.FactorizeByEnergy(removal_net, 0.8);
+ learning.SingleStepOnlineLearning(&removal_net, train_input[0], train_target[0], false);
+ neuroc::Network removal_reference = removal_net;
+ const std::vector<unsigned int> removed = {0, 1};
+ bool removal_passed = removal_net.RemoveNeurons(0, removed);
+ const Eigen::MatrixXd& first_reference = removal_reference[0].GetWeightMatrix();
+ const Eigen::MatrixXd& second_reference = removal_reference[1].GetWeightMatrix();
+ removal_passed = removal_passed && removal_net[0].GetWeightMatrix() == first_reference.bottomRows(first_reference.rows() - removed.size())
+                  && removal_net[1].GetWeightMatrix() == second_reference.rightCols(second_reference.cols() - removed.size())
+                  && (removal_net[0].GetLeftFactorMatrix() * removal_net[0].GetRightFactorMatrix() - removal_net[0].GetWeightMatrix()).cwiseAbs().maxCoeff() < 1e-12;
+ std::cout << "neurons removed from a factorized layer after a learning step (" << Ranks(removal_net) << "): "
+           << (removal_passed ? "same weights  PASS" : "FAIL") << std::endl;
+
+ //Square layer with decaying singular values: full matrix and factors
+ std::srand(seed);
+ //Random unit directions, almost orthogonal when the layer is wide
+ Eigen::MatrixXd left_matrix = Eigen::MatrixXd::Random(width, width).colwise().normalized();
+ Eigen::MatrixXd right_matrix = Eigen::MatrixXd::Random(width, width).colwise().normalized();
+ Eigen::VectorXd spectrum_vector(width);
+ for(unsigned int i=0; i<width; i++) spectrum_vector[i] = std::exp(-(double) i / 32.0);
+ neuroc::DenseLayer dense_layer = neuroc_bench::MakeSigmoidLayer(width, width);
+ dense_layer.SetWeightMatrix(left_matrix * spectrum_vector.asDiagonal() * right_matrix.transpose());
+ Eigen::VectorXd input_vector = Eigen::VectorXd::Random(width);
+ Eigen::VectorXd reference_vector = dense_layer.Compute(input_vector);
+ double dense_ns = MedianNs([&](){ neuroc_bench::DoNotOptimize(dense_layer.Compute(input_vector).data()); }, 200);
+ std::ostringstream json_layer;
+ std::cout << std::endl << "layer " << width << "x" << width << ", spectrum exp(-i/32), dense " << std::setprecision(0) << dense_ns << " ns/sample" << std::endl;
+ std::cout << "rank   energy      ns/sample   speedup   weights   max output difference" << std::endl;
+ Eigen::VectorXd energy_vector = neuroc::LowRankFactorization::ReturnSingularValues(dense_layer).cwiseAbs2();
+ double total_energy = energy_vector.sum();
+ unsigned int max_rank = neuroc::LowRankFactorization::ReturnMaximumRank(dense_layer);
+ for(unsigned int rank=16; rank<=max_rank; rank=(rank < max_rank && rank*2 > max_rank) ? max_rank : rank*2){
+  neuroc::DenseLayer factorized_layer = dense_layer;
+  neuroc::LowRankFactorization::Factorize(factorized_layer, rank);
+  double factorized_ns = MedianNs([&](){ neuroc_bench::DoNotOptimize(factorized_layer.Compute(input_vector).data()); }, 200);
+  double difference = (factorized_layer.Compute(input_vector) - reference_vector).cwiseAbs().maxCoeff();
+  double energy = energy_vector.head(rank).sum() / total_energy;
+  std::size_t weights = factorized_layer.GetLeftFactorMatrix().size() + factorized_layer.GetRightFactorMatrix().size();
+  std::cout << std::setw(4) << rank << std::setprecision(6) << std::setw(10) << energy << std::setprecision(0) << std::setw(14) << factorized_ns
+            << std::setprecision(2) << std::setw(9) << dense_ns / factorized_ns << "x" << std::setw(10) << weights
+            << std::scientific << std::setprecision(2) << std::setw(14) << difference << std::fixed << std::endl;
+  json_layer << (rank > 16 ? ",\n" : "") << "  {\"rank\": " << rank << ", \"energy\": " << energy << ", \"ns\": " << factorized_ns
+             << ", \"weights\": " << weights << ", \"max_output_difference\": " << difference << "}";
+ }
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"lowrankbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"finetune_epochs\": " << finetune_epochs << ", \"weights\": " << WeightCount(dense_net)
+             << ", \"accuracy\": " << dense_accuracy << ", \"finetuned_accuracy\": " << dense_tuned_accuracy << ", \"samples_per_sec\": " << dense_rate << ",\n \"cases\": [\n" << json_cases.str() << "]},\n"
+             << " \"removal_passed\": " << (removal_passed ? "true" : "false") << ",\n"
+             << " \"layer\": {\"width\": " << width << ", \"dense_ns\": " << dense_ns << ",\n \"cases\": [\n" << json_layer.str() << "]}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return removal_passed ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Microbenchmarks for the hot paths of the library.
+ * Every case is executed over a matrix of layer widths, network
+ * depths and batch sizes (the number of samples processed by a
+ * single measured repetition).
+ *
+ * Usage:
+ * ./microbench [--quick|--full] [--warmup N] [--reps N] [--filter NAME] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <WeightFunctions.h>
+#include <JoinFunctions.h>
+#include <TransferFunctions.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+using neuroc_bench::Parameters;
+using neuroc_bench::MakeSigmoidLayer;
+using neuroc_bench::MakeSigmoidNetwork;
+
+namespace {
+
+std::vector<Eigen::VectorXd> MakeInputs(unsigned int size, unsigned int count){
+ std::vector<Eigen::VectorXd> inputs;
+ for(unsigned int i=0; i<count; i++) inputs.push_back(Eigen::VectorXd::Random(size));
+ return inputs;
+}
+
+std::string WriteTemporaryCSV(unsigned int rows, unsigned int cols){
+ std::string file_path = "./microbench_dataset.csv";
+ std::ofstream file_stream(file_path);
+ std::srand(1);
+ for(unsigned int r=0; r<rows; r++){
+  for(unsigned int c=0; c<cols; c++){
+   file_stream << (std::rand() % 101);
+   if(c != cols-1) file_stream << ",";
+  }
+  file_stream << '\n';
+ }
+ return file_path;
+}
+
+typedef std::pair<std::string, std::function<Eigen::VectorXd(Eigen::VectorXd)> > NamedFunction;
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ unsigned int warmup = 3;
+ unsigned int reps = 20;
+ std::string filter;
+ std::string json_path = "./microbench.json";
+ std::vector<unsigned int> widths = {16, 64, 256, 1024};
+ std::vector<unsigned int> depths = {1, 3};
+ std::vector<unsigned int> batches = {1, 32};
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--quick"){ widths = {16, 64}; depths = {1, 2}; batches = {1, 8}; reps = 5; }
+  else if(arg == "--full"){ depths = {1, 3, 6}; batches = {1, 32, 128}; }
+  else if(arg == "--warmup" && i+1<argc) warmup = std::atoi(argv[++i]);
+  else if(arg == "--reps" && i+1<argc && std::atoi(argv[i+1]) >= 1) reps = std::atoi(argv[++i]);
+  else if(arg == "--filter" && i+1<argc) filter = argv[++i];
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--quick|--full] [--warmup N] [--reps N] [--filter NAME] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc_bench::BenchRunner runner(warmup, reps);
+ runner.SetFilter(filter);
+ std::cout << "=== neuroc microbenchmarks (warmup " << warmup << ", repetitions " << reps << ") ===" << std::endl;
+
+ //DenseLayer::Compute
+ for(unsigned int w : widths){
+  for(unsigned int b : batches){
+   neuroc::DenseLayer layer = MakeSigmoidLayer(w, w);
+   std::vector<Eigen::VectorXd> inputs = MakeInputs(w, b);
+   runner.Run("DenseLayer::Compute", {{"width", w}, {"batch", b}}, b, [&](){
+    for(unsigned int i=0; i<b; i++) neuroc_bench::DoNotOptimize(layer.Compute(inputs[i]).data());
+   });
+  }
+ }
+
+ //Network::Compute
+ for(unsigned int w : widths){
+  for(unsigned int d : depths){
+   for(unsigned int b : batches){
+    neuroc::Network net = MakeSigmoidNetwork(w, d);
+    std::vector<Eigen::VectorXd> inputs = MakeInputs(w, b);
+    runner.Run("Network::Compute", {{"width", w}, {"depth", d}, {"batch", b}}, b, [&](){
+     for(unsigned int i=0; i<b; i++) neuroc_bench::DoNotOptimize(net.Compute(inputs[i]).data());
+    });
+   }
+  }
+ }
+
+ //TransferFunctions kernels
+ std::vector<NamedFunction> kernels = {
+  NamedFunction("Linear", neuroc::TransferFunctions::Linear),
+  NamedFunction("PositiveLinear", neuroc::TransferFunctions::PositiveLinear),
+  NamedFunction("SaturatedLinear", neuroc::TransferFunctions::SaturatedLinear),
+  NamedFunction("Sigmoid", neuroc::TransferFunctions::Sigmoid),
+  NamedFunction("FastSigmoid", neuroc::TransferFunctions::FastSigmoid),
+  NamedFunction("SigmoidDerivative", neuroc::TransferFunctions::SigmoidDerivative),
+  NamedFunction("Tanh", neuroc::TransferFunctions::Tanh),
+  NamedFunction("TanhDerivative", neuroc::TransferFunctions::TanhDerivative),
+  NamedFunction("RadialBasis", neuroc::TransferFunctions::RadialBasis),
+  NamedFunction("MultiQuadratic", neuroc::TransferFunctions::MultiQuadratic),
+  NamedFunction("HardLimit", neuroc::TransferFunctions::HardLimit)
+ };
+ for(unsigned int k=0; k<kernels.size(); k++){
+  for(unsigned int w : widths){
+   for(unsigned int b : batches){
+    std::vector<Eigen::VectorXd> inputs = MakeInputs(w, b);
+    std::function<Eigen::VectorXd(Eigen::VectorXd)> kernel = kernels[k].second;
+    runner.Run("TransferFunctions::" + kernels[k].first, {{"width", w}, {"batch", b}}, b, [&](){
+     for(unsigned int i=0; i<b; i++) neuroc_bench::DoNotOptimize(kernel(inputs[i]).data());
+    });
+   }
+  }
+ }
+
+ //BackpropagationLearning::SingleStepOnlineLearning
+ for(unsigned int w : widths){
+  for(unsigned int d : depths){
+   for(unsigned int b : batches){
+    neuroc::Network net = MakeSigmoidNetwork(w, d);
+    neuroc::BackpropagationLearning learning;
+    learning.SetLearningRate(0.01);
+    std::vector<Eigen::VectorXd> inputs = MakeInputs(w, b);
+    std::vector<Eigen::VectorXd> targets = MakeInputs(w, b);
+    runner.Run("SingleStepOnlineLearning", {{"width", w}, {"depth", d}, {"batch", b}}, b, [&](){
+     for(unsigned int i=0; i<b; i++) neuroc_bench::DoNotOptimize(learning.SingleStepOnlineLearning(&net, inputs[i], targets[i], false));
+    });
+   }
+  }
+ }
+
+ //BackpropagationLearning::SingleStepBatchLearning
+ for(unsigned int w : widths){
+  for(unsigned int d : depths){
+   for(unsigned int b : batches){
+    neuroc::Network net = MakeSigmoidNetwork(w, d);
+    neuroc::BackpropagationLearning learning;
+    learning.SetLearningRate(0.01);
+    Eigen::MatrixXd inputs = Eigen::MatrixXd::Random(w, b);
+    Eigen::MatrixXd targets = Eigen::MatrixXd::Random(w, b);
+    runner.Run("SingleStepBatchLearning", {{"width", w}, {"depth", d}, {"batch", b}}, b, [&](){
+     neuroc_bench::DoNotOptimize(learning.SingleStepBatchLearning(&net, inputs, targets));
+    });
+   }
+  }
+ }
+
+ //BackpropagationLearning::UpdateWheights
+ //The forward and backward phases are done once in the setup,
+ //the update is then repeated batch times on the same errors.
+ for(unsigned int w : widths){
+  for(unsigned int d : depths){
+   for(unsigned int b : batches){
+    neuroc::Network net = MakeSigmoidNetwork(w, d);
+    neuroc::BackpropagationLearning learning;
+    learning.SetLearningRate(0.01);
+    Eigen::VectorXd input = Eigen::VectorXd::Random(w);
+    Eigen::VectorXd target = Eigen::VectorXd::Random(w);
+    runner.Run("UpdateWheights", {{"width", w}, {"depth", d}, {"batch", b}}, b, [&](){
+     learning.Forward(&net, input);
+     learning.ErrorBackpropagation(&net, target);
+    }, [&](){
+     for(unsigned int i=0; i<b; i++) learning.UpdateWheights(&net);
+    });
+   }
+  }
+ }
+
+ //Dataset::LoadFromCSV and Dataset::Split
+ std::vector<unsigned int> rows_list = {1000, 10000};
+ for(unsigned int rows : rows_list){
+  const unsigned int cols = 17;
+  std::string file_path = WriteTemporaryCSV(rows, cols);
+  runner.Run("Dataset::LoadFromCSV", {{"rows", rows}, {"cols", cols}}, rows, [&](){
+   neuroc::Dataset dataset;
+   dataset.LoadFromCSV(file_path);
+   neuroc_bench::DoNotOptimize(dataset.ReturnNumberOfElements());
+  });
+
+  neuroc::Dataset original;
+  original.LoadFromCSV(file_path);
+  neuroc::Dataset working;
+  runner.Run("Dataset::Split", {{"rows", rows}, {"cols", cols}}, rows, [&](){
+   working = original;
+  }, [&](){
+   neuroc::Dataset target = working.Split(cols-1);
+   neuroc_bench::DoNotOptimize(target.ReturnNumberOfElements());
+  });
+  std::remove(file_path.c_str());
+ }
+
+ if(runner.SaveAsJSON(json_path, "microbench")){
+  std::cout << "Results saved in " << json_path << std::endl;
+ }
+ return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Mixed precision benchmark. The same networks are trained with the batch
+ * learning in double precision and in the mixed precision mode (single
+ * precision products, double precision master weights): on pendigits the
+ * benchmark compares the test error and the accuracy of the two trainings,
+ * on a wide random network the time of a learning step. It also checks that
+ * a step with an overflow is skipped without changing the weights.
+ *
+ * Usage:
+ * ./mixedbench [--data-dir DIR] [--hidden N] [--epochs N] [--batch N]
+ *              [--width N] [--steps N] [--loss-scale X] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* It returns the seconds of a batch learning step, the median of the runs
+**/
+double StepSeconds(neuroc::Network& net, neuroc::BackpropagationLearning& learning, const Eigen::MatrixXd& inputMatrix, const Eigen::MatrixXd& targetMatrix, unsigned int steps){
+ learning.SingleStepBatchLearning(&net, inputMatrix, targetMatrix);
+ std::vector<double> seconds;
+ for(unsigned int i=0; i<steps; i++){
+  double start = neuroc_bench::NowNanoseconds();
+  neuroc_bench::DoNotOptimize(learning.SingleStepBatchLearning(&net, inputMatrix, targetMatrix));
+  seconds.push_back((neuroc_bench::NowNanoseconds() - start) * 1e-9);
+ }
+ std::sort(seconds.begin(), seconds.end());
+ return seconds[seconds.size() / 2];
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 100;
+ unsigned int batch = 16;
+ unsigned int width = 1024;
+ unsigned int steps = 20;
+ double loss_scale = 1024.0;
+ unsigned int seed = 42;
+ std::string json_path = "./mixedbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--batch" && i+1<argc) batch = std::atoi(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--steps" && i+1<argc) steps = std::atoi(argv[++i]);
+  else if(arg == "--loss-scale" && i+1<argc) loss_scale = std::atof(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--batch N]"
+             << " [--width N] [--steps N] [--loss-scale X] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+
+ std::cout << "=== neuroc mixed precision ===" << std::endl;
+ bool passed = true;
+
+ //pendigits: the same training in double and in mixed precision
+ neuroc::Network double_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(double_net, seed);
+ neuroc::Network mixed_net = double_net;
+ neuroc::BackpropagationLearning double_learning;
+ double_learning.SetLearningRate(0.35);
+ double start = neuroc_bench::NowNanoseconds();
+ double_learning.StartBatchLearning(&double_net, train_input, train_target, epochs, batch, false);
+ double double_seconds = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+ neuroc::BackpropagationLearning mixed_learning;
+ mixed_learning.SetLearningRate(0.35);
+ mixed_learning.SetMixedPrecision(true, loss_scale);
+ start = neuroc_bench::NowNanoseconds();
+ mixed_learning.StartBatchLearning(&mixed_net, train_input, train_target, epochs, batch, false);
+ double mixed_seconds = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+
+ double double_mse = double_net.ComputeMeanSquaredError(test_input, test_target);
+ double mixed_mse = mixed_net.ComputeMeanSquaredError(test_input, test_target);
+ double double_accuracy = neuroc_bench::DigitAccuracy(double_net, test_input, test_target);
+ double mixed_accuracy = neuroc_bench::DigitAccuracy(mixed_net, test_input, test_target);
+ bool preserved = std::abs(mixed_accuracy - double_accuracy) <= 0.01;
+ passed &= preserved;
+ std::cout << std::fixed << std::setprecision(5);
+ std::cout << "pendigits 16-" << hidden << "-1, " << epochs << " epochs, batch " << batch << std::endl;
+ std::cout << "double  test MSE " << double_mse << "  accuracy " << double_accuracy << "  " << std::setprecision(2) << double_seconds << " s" << std::setprecision(5) << std::endl;
+ std::cout << "mixed   test MSE " << mixed_mse << "  accuracy " << mixed_accuracy << "  " << std::setprecision(2) << mixed_seconds << " s"
+           << std::setprecision(5) << ", loss scale " << mixed_learning.GetLossScale() << ", skipped steps " << mixed_learning.GetSkippedSteps()
+           << (preserved ? "  PASS" : "  FAIL") << std::endl;
+
+ //Overflow: the step is skipped, the weights stay the same and the scale is halved
+ neuroc::Network overflow_net = mixed_net;
+ neuroc::Network before_net = mixed_net;
+ Eigen::MatrixXd overflow_input = Eigen::MatrixXd::Constant(16, 4, 0.5);
+ overflow_input(3, 2) = std::numeric_limits<double>::infinity();
+ Eigen::MatrixXd overflow_target = Eigen::MatrixXd::Constant(1, 4, 0.5);
+ neuroc::BackpropagationLearning overflow_learning;
+ overflow_learning.SetMixedPrecision(true, loss_scale);
+ overflow_learning.SingleStepBatchLearning(&overflow_net, overflow_input, overflow_target);
+ bool skipped = overflow_learning.GetSkippedSteps() == 1 && neuroc_bench::SameWeights(overflow_net, before_net) && overflow_learning.GetLossScale() == std::max(1.0, loss_scale / 2.0);
+ passed &= skipped;
+ std::cout << "overflow step: " << (skipped ? "skipped, same weights, loss scale halved  PASS" : "FAIL") << std::endl;
+
+ //Growth: after 1000 finite steps the scale is doubled, the update of that
+ //step must still remove the scale used by its own deltas
+ Eigen::MatrixXd growth_input(16, batch), growth_target(1, batch);
+ for(unsigned int i=0; i<batch; i++){
+  growth_input.col(i) = train_input[i];
+  growth_target.col(i) = train_target[i];
+ }
+ overflow_learning.SetLearningRate(0.35);
+ for(unsigned int i=1; i<1000; i++) overflow_learning.SingleStepBatchLearning(&overflow_net, growth_input, growth_target);
+ neuroc::Network growth_before = overflow_net;
+ neuroc::Network growth_double = overflow_net;
+ for(unsigned int i=0; i<growth_double.Size(); i++) growth_double[i].SetMixedPrecision(false);
+ neuroc::BackpropagationLearning growth_learning;
+ growth_learning.SetLearningRate(0.35);
+ growth_learning.SingleStepBatchLearning(&growth_double, growth_input, growth_target);
+ double scale_before = overflow_learning.GetLossScale();
+ overflow_learning.SingleStepBatchLearning(&overflow_net, growth_input, growth_target);
+ double growth_error = 0.0, growth_change = 0.0;
+ for(unsigned int i=0; i<overflow_net.Size(); i++){
+  Eigen::MatrixXd double_change = growth_double[i].GetWeightMatrix() - growth_before[i].GetWeightMatrix();
+  Eigen::MatrixXd mixed_change = overflow_net[i].GetWeightMatrix() - growth_before[i].GetWeightMatrix();
+  growth_error += (mixed_change - double_change).squaredNorm();
+  growth_change += double_change.squaredNorm();
+ }
+ double growth_relative = std::sqrt(growth_error / growth_change);
+ bool grown = overflow_learning.GetLossScale() == std::min(loss_scale, 2.0 * scale_before) && overflow_learning.GetSkippedSteps() == 1 && growth_relative < 1e-2;
+ passed &= grown;
+ std::cout << "growth step: loss scale " << scale_before << " -> " << overflow_learning.GetLossScale() << ", update differs from double by "
+           << std::scientific << std::setprecision(2) << growth_relative << std::fixed << (grown ? "  PASS" : "  FAIL") << std::endl;
+
+ //Wide network: the time of a learning step
+ neuroc::Network wide_double = neuroc_bench::MakeSigmoidNetwork({width, width, width, 10});
+ neuroc_bench::RandomizeNetwork(wide_double, seed);
+ neuroc::Network wide_mixed = wide_double;
+ std::srand(seed);
+ Eigen::MatrixXd wide_input = Eigen::MatrixXd::Random(width, 64);
+ Eigen::MatrixXd wide_target = Eigen::MatrixXd::Random(10, 64);
+ neuroc::BackpropagationLearning wide_double_learning, wide_mixed_learning;
+ wide_double_learning.SetLearningRate(0.01);
+ wide_mixed_learning.SetLearningRate(0.01);
+ wide_mixed_learning.SetMixedPrecision(true, loss_scale);
+ double double_step = StepSeconds(wide_double, wide_double_learning, wide_input, wide_target, steps);
+ double mixed_step = StepSeconds(wide_mixed, wide_mixed_learning, wide_input, wide_target, steps);
+ std::cout << "random " << width << "-" << width << "-" << width << "-10, batch 64" << std::endl;
+ std::cout << std::setprecision(3) << "double  " << double_step * 1e3 << " ms/step" << std::endl;
+ std::cout << "mixed   " << mixed_step * 1e3 << " ms/step, speedup " << std::setprecision(2) << double_step / mixed_step << "x" << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"mixedbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"passed\": " << (passed ? "true" : "false") << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"batch\": " << batch
+             << ", \"double_mse\": " << double_mse << ", \"mixed_mse\": " << mixed_mse
+             << ", \"double_accuracy\": " << double_accuracy << ", \"mixed_accuracy\": " << mixed_accuracy
+             << ", \"double_sec\": " << double_seconds << ", \"mixed_sec\": " << mixed_seconds
+             << ", \"skipped_steps\": " << mixed_learning.GetSkippedSteps() << "},\n"
+             << " \"wide\": {\"width\": " << width << ", \"double_step_sec\": " << double_step << ", \"mixed_step_sec\": " << mixed_step
+             << ", \"speedup\": " << double_step / mixed_step << "}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return passed ? 0 : 1;
+}
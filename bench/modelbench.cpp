@@ -0,0 +1,243 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Model file benchmark. A network trained on pendigits.tes is saved with
+ * Network::SaveAsBinary(), loaded back with LoadFromBinary() and mapped with
+ * MappedNetwork, and the three must give the same output on pendigits.tra.
+ * The modes of the layers (binarized, sparse) must survive the round trip,
+ * and the corrupted, truncated and newer files must be refused. On a wide
+ * random network it measures the time to save, to load, to map with and
+ * without the checksum and of the first inference on the mapped weights,
+ * with the heap memory allocated by loading and by mapping.
+ *
+ * Usage:
+ * ./modelbench [--data-dir DIR] [--hidden N] [--epochs N] [--width N]
+ *              [--seed N] [--dir DIR] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <iterator>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <MappedNetwork.h>
+#include <ModelFormat.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <MemoryStats.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* It copies the file changing the byte at the given position, or
+* truncating the file there if the value is negative
+**/
+bool WriteDamagedCopy(const std::string& sourcePath, const std::string& targetPath, std::size_t position, int value){
+ std::ifstream source_stream(sourcePath, std::ios::binary);
+ std::string content((std::istreambuf_iterator<char>(source_stream)), std::istreambuf_iterator<char>());
+ if(position >= content.size()) return false;
+ if(value < 0) content.resize(position);
+ else content[position] = (char) value;
+ std::ofstream target_stream(targetPath, std::ios::binary | std::ios::trunc);
+ target_stream.write(content.data(), content.size());
+ return (bool) target_stream;
+}
+
+double ElapsedMilliseconds(double start){
+ return (neuroc_bench::NowNanoseconds() - start) * 1e-6;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 10;
+ unsigned int width = 2048;
+ unsigned int seed = 42;
+ std::string model_dir = ".";
+ std::string json_path = "./modelbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--dir" && i+1<argc) model_dir = argv[++i];
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--width N]"
+             << " [--seed N] [--dir DIR] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ if(neuroc::MemoryStats::IsCountingEnabled() == false){
+  std::cerr << "Error: the allocation hooks are not linked, the allocations cannot be counted." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ std::vector<Eigen::VectorXd> test_inputs = neuroc_bench::ReturnInputs(test_input);
+
+ bool passed = true;
+ std::cout << "=== neuroc model files ===" << std::endl;
+
+ //Round trip of a trained network
+ const std::string digits_path = model_dir + "/pendigits.nrc";
+ neuroc::Network digits_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(digits_net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(0.35);
+ learning.StartOnlineLearning(&digits_net, train_input, train_target, epochs, false);
+ passed &= digits_net.SaveAsBinary(digits_path);
+ neuroc::Network loaded_net;
+ passed &= loaded_net.LoadFromBinary(digits_path);
+ neuroc::MappedNetwork mapped_net;
+ passed &= mapped_net.Open(digits_path);
+ double loaded_difference = neuroc_bench::MaxDifference(digits_net, loaded_net, test_inputs);
+ double mapped_difference = neuroc_bench::MaxDifference(digits_net, mapped_net, test_inputs);
+ passed &= (loaded_difference == 0.0 && mapped_difference == 0.0);
+ std::cout << "pendigits 16-" << hidden << "-1: " << mapped_net.ReturnMappedBytes() << " bytes, max difference loaded "
+           << loaded_difference << ", mapped " << mapped_difference << std::endl;
+
+ //The modes of the layers are saved with the weights
+ const std::string modes_path = model_dir + "/modes.nrc";
+ neuroc::Network modes_net = neuroc_bench::MakeBinarizedNetwork({16, 32, 32, 1}, seed);
+ modes_net[2].Prune(0.5);
+ passed &= modes_net.SaveAsBinary(modes_path);
+ neuroc::Network loaded_modes;
+ passed &= loaded_modes.LoadFromBinary(modes_path);
+ bool modes_kept = loaded_modes.Size() == 3 && loaded_modes[0].IsBinarized() && loaded_modes[1].IsBinarized() && loaded_modes[2].IsSparse()
+                   && loaded_modes[2].ReturnSparsity() == modes_net[2].ReturnSparsity() && neuroc_bench::MaxDifference(modes_net, loaded_modes, test_inputs) == 0.0;
+ std::cout << std::left << std::setw(48) << "binarized and sparse layers restored" << std::right << (modes_kept ? "PASS" : "FAIL") << std::endl;
+ passed &= modes_kept;
+
+ //Damaged files must be refused without changing the network
+ const std::string damaged_path = model_dir + "/damaged.nrc";
+ std::size_t file_size = mapped_net.ReturnMappedBytes();
+ struct Damage { std::string name; std::size_t position; int value; };
+ std::vector<Damage> damages = {{"flipped weight byte", file_size / 2, 0x5A},
+                                {"truncated file", file_size - 8, -1},
+                                {"newer version", offsetof(neuroc::ModelFormat::FileHeader, version), 2},
+                                {"wrong magic", 0, 'X'}};
+ for(unsigned int i=0; i<damages.size(); i++){
+  passed &= WriteDamagedCopy(digits_path, damaged_path, damages[i].position, damages[i].value);
+  std::cerr << "[" << damages[i].name << "]" << std::endl;
+  neuroc::MappedNetwork damaged_mapped;
+  bool refused = (loaded_net.LoadFromBinary(damaged_path) == false) && (damaged_mapped.Open(damaged_path) == false)
+                 && loaded_net.Size() == 2 && neuroc_bench::MaxDifference(digits_net, loaded_net, test_inputs) == 0.0;
+  std::cout << std::left << std::setw(48) << (damages[i].name + " refused") << std::right << (refused ? "PASS" : "FAIL") << std::endl;
+  passed &= refused;
+ }
+ std::remove(damaged_path.c_str());
+ std::remove(modes_path.c_str());
+
+ //Wide network: the time of the operations and the heap allocated
+ const std::string wide_path = model_dir + "/wide.nrc";
+ neuroc::Network wide_net = neuroc_bench::MakeSigmoidNetwork({width, width, width, 10});
+ neuroc_bench::RandomizeNetwork(wide_net, seed);
+ std::vector<Eigen::VectorXd> wide_inputs;
+ for(unsigned int i=0; i<16; i++) wide_inputs.push_back(Eigen::VectorXd::Random(width));
+
+ double start = neuroc_bench::NowNanoseconds();
+ passed &= wide_net.SaveAsBinary(wide_path);
+ double save_ms = ElapsedMilliseconds(start);
+
+ neuroc::Network wide_loaded;
+ neuroc::MemoryStats::AllocationScope load_scope;
+ start = neuroc_bench::NowNanoseconds();
+ passed &= wide_loaded.LoadFromBinary(wide_path);
+ double load_ms = ElapsedMilliseconds(start);
+ unsigned long long load_bytes = load_scope.AllocatedBytes();
+
+ neuroc::MappedNetwork wide_mapped;
+ neuroc::MemoryStats::AllocationScope verified_scope;
+ start = neuroc_bench::NowNanoseconds();
+ passed &= wide_mapped.Open(wide_path, true);
+ double verified_ms = ElapsedMilliseconds(start);
+ unsigned long long verified_bytes = verified_scope.AllocatedBytes();
+
+ neuroc::MemoryStats::AllocationScope open_scope;
+ start = neuroc_bench::NowNanoseconds();
+ passed &= wide_mapped.Open(wide_path, false);
+ double open_ms = ElapsedMilliseconds(start);
+ unsigned long long open_bytes = open_scope.AllocatedBytes();
+ start = neuroc_bench::NowNanoseconds();
+ neuroc_bench::DoNotOptimize(wide_mapped.Compute(wide_inputs[0]).data());
+ double first_ms = ElapsedMilliseconds(start);
+
+ double wide_difference = neuroc_bench::MaxDifference(wide_net, wide_mapped, wide_inputs);
+ passed &= (wide_difference == 0.0) && (neuroc_bench::MaxDifference(wide_net, wide_loaded, wide_inputs) == 0.0);
+ start = neuroc_bench::NowNanoseconds();
+ for(unsigned int i=0; i<wide_inputs.size(); i++) neuroc_bench::DoNotOptimize(wide_net.Compute(wide_inputs[i]).data());
+ double network_ms = ElapsedMilliseconds(start) / wide_inputs.size();
+ start = neuroc_bench::NowNanoseconds();
+ for(unsigned int i=0; i<wide_inputs.size(); i++) neuroc_bench::DoNotOptimize(wide_mapped.Compute(wide_inputs[i]).data());
+ double mapped_ms = ElapsedMilliseconds(start) / wide_inputs.size();
+ std::remove(wide_path.c_str());
+
+ std::cout << std::endl << "random " << width << "-" << width << "-" << width << "-10, " << wide_mapped.ReturnMappedBytes() << " bytes" << std::endl;
+ std::cout << std::fixed << std::setprecision(3);
+ std::cout << "SaveAsBinary                 " << save_ms << " ms" << std::endl;
+ std::cout << "LoadFromBinary               " << load_ms << " ms, " << load_bytes << " bytes allocated" << std::endl;
+ std::cout << "MappedNetwork::Open checksum " << verified_ms << " ms, " << verified_bytes << " bytes allocated" << std::endl;
+ std::cout << "MappedNetwork::Open          " << open_ms << " ms, " << open_bytes << " bytes allocated" << std::endl;
+ std::cout << "first Compute after Open     " << first_ms << " ms" << std::endl;
+ std::cout << "Compute Network / mapped     " << network_ms << " ms / " << mapped_ms << " ms, max difference " << wide_difference << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"modelbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"passed\": " << (passed ? "true" : "false") << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"file_bytes\": " << file_size
+             << ", \"loaded_difference\": " << loaded_difference << ", \"mapped_difference\": " << mapped_difference << "},\n"
+             << " \"wide\": {\"width\": " << width << ", \"file_bytes\": " << wide_mapped.ReturnMappedBytes()
+             << ", \"save_ms\": " << save_ms << ", \"load_ms\": " << load_ms << ", \"load_allocated_bytes\": " << load_bytes
+             << ", \"open_checksum_ms\": " << verified_ms << ", \"open_checksum_allocated_bytes\": " << verified_bytes
+             << ", \"open_ms\": " << open_ms << ", \"open_allocated_bytes\": " << open_bytes << ", \"first_compute_ms\": " << first_ms
+             << ", \"network_compute_ms\": " << network_ms << ", \"mapped_compute_ms\": " << mapped_ms << "}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ std::cout << std::endl << (passed ? "PASSED: the model files round trip and the damaged files are refused" : "FAILED: a model file check did not pass") << std::endl;
+ return passed ? 0 : 1;
+}
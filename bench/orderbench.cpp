@@ -0,0 +1,180 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Sample order benchmark. pendigits.tes is sorted by digit, as a dataset
+ * saved class by class, and a network is trained on it with the online
+ * learning in the file order, in a shuffled order and with the importance
+ * sampling. The test error on pendigits.tra is measured after every epoch
+ * (synchronous validation) and the benchmark reports the sample visits
+ * needed to reach the target error, the best error and the time of an
+ * epoch.
+ *
+ * Usage:
+ * ./orderbench [--data-dir DIR] [--hidden N] [--epochs N] [--target X]
+ *              [--mix X] [--learning-rate X] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <SampleOrder.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* \struct OrderResult
+* \brief The outcome of a training with an order of the samples
+*/
+struct OrderResult {
+ std::string name;
+ unsigned int reachedEpoch; //zero if the target was not reached
+ double bestError;
+ double epochSeconds;
+};
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 40;
+ double target = 0.016;
+ double mix = 0.5;
+ unsigned int seed = 42;
+ std::string json_path = "./orderbench.json";
+ double learning_rate = 0.35;
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--target" && i+1<argc) target = std::atof(argv[++i]);
+  else if(arg == "--mix" && i+1<argc) mix = std::atof(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--target X]"
+             << " [--mix X] [--learning-rate X] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset file_input, test_input;
+ if(file_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset file_target = file_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ file_input.DivideBy(100);
+ file_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+
+ //The training set sorted by digit
+ std::vector<unsigned int> sorted(file_input.ReturnNumberOfElements());
+ std::iota(sorted.begin(), sorted.end(), 0);
+ std::stable_sort(sorted.begin(), sorted.end(), [&](unsigned int a, unsigned int b){ return file_target[a][0] < file_target[b][0]; });
+ neuroc::Dataset train_input, train_target;
+ for(unsigned int index : sorted){
+  train_input.PushBackData(file_input[index]);
+  train_target.PushBackData(file_target[index]);
+ }
+ const unsigned int dataset_size = train_input.ReturnNumberOfElements();
+
+ neuroc::Network initial_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(initial_net, seed);
+
+ std::cout << "=== neuroc sample order ===" << std::endl;
+ std::cout << "pendigits sorted by digit, 16-" << hidden << "-1, " << epochs << " epochs of " << dataset_size
+           << " samples, target test MSE " << target << std::endl;
+
+ std::vector<OrderResult> results;
+ const neuroc::SampleOrder::Mode modes[3] = {neuroc::SampleOrder::FILE_ORDER, neuroc::SampleOrder::SHUFFLE, neuroc::SampleOrder::IMPORTANCE_SAMPLING};
+ const char* names[3] = {"file order", "shuffle", "importance sampling"};
+ for(unsigned int m=0; m<3; m++){
+  neuroc::Network net = initial_net;
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(learning_rate);
+  if(modes[m] == neuroc::SampleOrder::SHUFFLE) learning.SetShuffle(seed);
+  else if(modes[m] == neuroc::SampleOrder::IMPORTANCE_SAMPLING) learning.SetImportanceSampling(seed, mix);
+  learning.SetValidation(test_input, test_target, 1, 0, false, false);
+  double start = neuroc_bench::NowNanoseconds();
+  learning.StartOnlineLearning(&net, train_input, train_target, epochs, false);
+  double seconds = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+  const std::vector<double>& errors = learning.GetValidationErrors();
+  //The validation is synchronous, its time is measured apart and removed
+  double validation_start = neuroc_bench::NowNanoseconds();
+  net.ComputeMeanSquaredError(test_input, test_target);
+  double validation_seconds = (neuroc_bench::NowNanoseconds() - validation_start) * 1e-9;
+
+  OrderResult result;
+  result.name = names[m];
+  result.reachedEpoch = 0;
+  for(unsigned int e=0; e<errors.size(); e++){
+   if(errors[e] <= target){
+    result.reachedEpoch = e + 1;
+    break;
+   }
+  }
+  result.bestError = *std::min_element(errors.begin(), errors.end());
+  result.epochSeconds = (seconds - validation_seconds * errors.size()) / epochs;
+  results.push_back(result);
+ }
+
+ std::cout << std::fixed << std::setprecision(5);
+ for(const OrderResult& result : results){
+  std::cout << std::left << std::setw(20) << result.name << std::right;
+  if(result.reachedEpoch > 0) std::cout << "target after " << std::setw(3) << result.reachedEpoch << " epochs, " << std::setw(7) << (unsigned long) result.reachedEpoch * dataset_size << " visits";
+  else std::cout << "target not reached                ";
+  std::cout << ", best MSE " << result.bestError << ", " << std::setprecision(2) << result.epochSeconds * 1e3 << " ms/epoch" << std::setprecision(5) << std::endl;
+ }
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"orderbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"target\": " << target << ", \"mix\": " << mix << ",\n"
+             << " \"orders\": [\n";
+ for(unsigned int i=0; i<results.size(); i++){
+  file_stream << "  {\"order\": \"" << results[i].name << "\", \"reached_epoch\": " << results[i].reachedEpoch
+              << ", \"visits\": " << (unsigned long) results[i].reachedEpoch * dataset_size << ", \"best_mse\": " << results[i].bestError
+              << ", \"epoch_sec\": " << results[i].epochSeconds << "}" << (i+1 < results.size() ? ",\n" : "\n");
+ }
+ file_stream << " ]\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Prefetch benchmark. A network is trained on pendigits.tes with
+ * StartBatchLearning(), with and without the prefetching of the batches,
+ * in the file order and shuffled, and the weights must be the same. Then the batches go through a
+ * transform (a noise made of sines, with a configurable cost) applied on
+ * the training thread or by the loaders of a BatchPipeline, and the two
+ * trainings must give the same weights. It reports the time of the
+ * trainings, the number of times the training waited for a batch and the
+ * heap allocations of the training thread and of the loaders in the
+ * steady state.
+ *
+ * Usage:
+ * ./prefetchbench [--data-dir DIR] [--hidden N] [--epochs N] [--batch N]
+ *                 [--depth N] [--loaders N] [--cost N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <atomic>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <BatchPipeline.h>
+#include <Dataset.h>
+#include <MemoryStats.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* A transform that adds a small deterministic noise to the inputs,
+* the cost is the number of sines computed for every value
+**/
+void AddNoise(Eigen::Ref<Eigen::MatrixXd> inputMatrix, unsigned int cost){
+ for(Eigen::Index c=0; c<inputMatrix.cols(); c++){
+  for(Eigen::Index r=0; r<inputMatrix.rows(); r++){
+   double noise = 0.0;
+   for(unsigned int k=1; k<=cost; k++) noise += std::sin(k * inputMatrix(r, c));
+   inputMatrix(r, c) += 1e-3 * noise / cost;
+  }
+ }
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 20;
+ unsigned int batch = 32;
+ unsigned int depth = 4;
+ unsigned int loaders = 1;
+ unsigned int cost = 16;
+ unsigned int seed = 42;
+ std::string json_path = "./prefetchbench.json";
+ const double learning_rate = 0.35;
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--batch" && i+1<argc) batch = std::atoi(argv[++i]);
+  else if(arg == "--depth" && i+1<argc) depth = std::atoi(argv[++i]);
+  else if(arg == "--loaders" && i+1<argc) loaders = std::atoi(argv[++i]);
+  else if(arg == "--cost" && i+1<argc) cost = std::max(1, std::atoi(argv[++i]));
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--batch N]"
+             << " [--depth N] [--loaders N] [--cost N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ const unsigned int dataset_size = train_input.ReturnNumberOfElements();
+
+ neuroc::Network initial_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(initial_net, seed);
+
+ std::cout << "=== neuroc batch prefetching ===" << std::endl;
+ std::cout << "pendigits 16-" << hidden << "-1, " << epochs << " epochs, batch " << batch << ", depth " << depth
+           << ", " << loaders << " loaders, " << std::thread::hardware_concurrency() << " cores" << std::endl;
+
+ //StartBatchLearning with and without the prefetching
+ double trainer_seconds[4];
+ neuroc::Network trainer_nets[4] = {initial_net, initial_net, initial_net, initial_net};
+ for(unsigned int m=0; m<4; m++){
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(learning_rate);
+  if(m % 2 == 1) learning.SetPrefetch(depth, loaders);
+  if(m >= 2) learning.SetShuffle(seed);
+  double start = neuroc_bench::NowNanoseconds();
+  learning.StartBatchLearning(&trainer_nets[m], train_input, train_target, epochs, batch, false);
+  trainer_seconds[m] = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+ }
+ bool same_trainer = neuroc_bench::SameWeights(trainer_nets[0], trainer_nets[1]);
+ bool same_shuffled = neuroc_bench::SameWeights(trainer_nets[2], trainer_nets[3]);
+ std::cout << std::fixed << std::setprecision(3);
+ std::cout << "StartBatchLearning           " << trainer_seconds[0] << " s" << std::endl;
+ std::cout << "StartBatchLearning prefetch  " << trainer_seconds[1] << " s, " << (same_trainer ? "same weights" : "DIFFERENT weights") << std::endl;
+ std::cout << "shuffled                     " << trainer_seconds[2] << " s" << std::endl;
+ std::cout << "shuffled prefetch            " << trainer_seconds[3] << " s, " << (same_shuffled ? "same weights" : "DIFFERENT weights") << std::endl;
+
+ //The transform on the training thread
+ neuroc::Network inline_net = initial_net;
+ neuroc::BackpropagationLearning inline_learning;
+ inline_learning.SetLearningRate(learning_rate);
+ Eigen::MatrixXd input_matrix(16, batch);
+ Eigen::MatrixXd target_matrix(1, batch);
+ double start = neuroc_bench::NowNanoseconds();
+ for(unsigned int epoch=0; epoch<epochs; epoch++){
+  for(unsigned int i_set=0; i_set<dataset_size; i_set+=batch){
+   unsigned int samples = std::min(batch, dataset_size - i_set);
+   for(unsigned int i=0; i<samples; i++){
+    input_matrix.col(i) = train_input[i_set+i];
+    target_matrix.col(i) = train_target[i_set+i];
+   }
+   AddNoise(input_matrix.leftCols(samples), cost);
+   inline_learning.SingleStepBatchLearning(&inline_net, input_matrix.leftCols(samples), target_matrix.leftCols(samples));
+  }
+ }
+ double inline_seconds = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+
+ //The transform on the loaders, the allocations are counted after the first epoch
+ std::atomic<unsigned long long> loader_allocations(0);
+ std::atomic<unsigned int> transforms(0);
+ const unsigned int warmup_transforms = loaders * depth + (dataset_size + batch - 1) / batch;
+ neuroc::Network pipeline_net = initial_net;
+ neuroc::BackpropagationLearning pipeline_learning;
+ pipeline_learning.SetLearningRate(learning_rate);
+ neuroc::BatchPipeline pipeline(train_input, train_target, batch, depth, loaders);
+ pipeline.SetTransform([&](Eigen::Ref<Eigen::MatrixXd> inputMatrix, Eigen::Ref<Eigen::MatrixXd>){
+  unsigned long long before = neuroc::MemoryStats::GetThreadCounters().allocations;
+  AddNoise(inputMatrix, cost);
+  if(transforms++ >= warmup_transforms) loader_allocations += neuroc::MemoryStats::GetThreadCounters().allocations - before;
+ });
+ start = neuroc_bench::NowNanoseconds();
+ pipeline.Start(0, epochs);
+ neuroc::MemoryStats::AllocationScope training_scope;
+ unsigned long long batches = 0;
+ while(const neuroc::BatchPipeline::Batch* next = pipeline.Next()){
+  if(batches++ == (dataset_size + batch - 1) / batch) training_scope.Restart();
+  pipeline_learning.SingleStepBatchLearning(&pipeline_net, next->input.leftCols(next->samples), next->target.leftCols(next->samples));
+ }
+ double pipeline_seconds = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+ unsigned long long training_allocations = training_scope.Allocations();
+ unsigned long long waits = pipeline.ReturnNumberOfTrainingWaits();
+ bool same_transform = neuroc_bench::SameWeights(inline_net, pipeline_net);
+
+ std::cout << "transform cost " << cost << std::endl;
+ std::cout << "training thread              " << inline_seconds << " s" << std::endl;
+ std::cout << "BatchPipeline                " << pipeline_seconds << " s, " << (same_transform ? "same weights" : "DIFFERENT weights")
+           << ", the training waited " << waits << " times for " << batches << " batches" << std::endl;
+ if(neuroc::MemoryStats::IsCountingEnabled()){
+  std::cout << "steady state allocations: training " << training_allocations << ", loaders " << loader_allocations.load() << std::endl;
+ }
+ std::cout << "pipeline buffers " << pipeline.ReturnMemoryFootprint() << " bytes" << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"prefetchbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"batch\": " << batch << ", \"depth\": " << depth
+             << ", \"loaders\": " << loaders << ", \"cost\": " << cost << ", \"cores\": " << std::thread::hardware_concurrency() << ",\n"
+             << " \"trainer\": {\"seconds\": " << trainer_seconds[0] << ", \"prefetch_seconds\": " << trainer_seconds[1]
+             << ", \"same_weights\": " << (same_trainer ? "true" : "false")
+             << ", \"shuffled_seconds\": " << trainer_seconds[2] << ", \"shuffled_prefetch_seconds\": " << trainer_seconds[3]
+             << ", \"shuffled_same_weights\": " << (same_shuffled ? "true" : "false") << "},\n"
+             << " \"transform\": {\"inline_seconds\": " << inline_seconds << ", \"pipeline_seconds\": " << pipeline_seconds
+             << ", \"same_weights\": " << (same_transform ? "true" : "false") << ", \"waits\": " << waits
+             << ", \"training_allocations\": " << training_allocations << ", \"loader_allocations\": " << loader_allocations.load() << "}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ bool passed = same_trainer && same_shuffled && same_transform && training_allocations == 0 && loader_allocations.load() == 0;
+ return passed ? 0 : 1;
+}
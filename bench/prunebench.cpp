@@ -0,0 +1,242 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Magnitude pruning benchmark. A network with two hidden layers is trained
+ * on pendigits.tes and pruned to the final sparsity, once in a single step
+ * and once with the gradual schedule and the fine-tuning, then the three
+ * networks are tested on pendigits.tra. The same network is also pruned
+ * removing whole neurons, with both scores, and the size, the accuracy
+ * and the throughput are reported. The last part measures the time
+ * of a square layer computed with the dense and with the sparse weights at
+ * growing sparsity, and reports the crossover sparsity above which the
+ * sparse layer is faster, together with the memory of the weights.
+ *
+ * Usage:
+ * ./prunebench [--data-dir DIR] [--hidden N] [--epochs N] [--learning-rate X]
+ *              [--sparsity X] [--steps N] [--width N] [--batch N] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <MagnitudePruning.h>
+#include <NeuronPruning.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* It returns the median time in nanoseconds of the function
+**/
+double MedianNs(std::function<void()> function, unsigned int repetitions){
+ for(unsigned int i=0; i<repetitions/10+1; i++) function();
+ std::vector<double> samples;
+ for(unsigned int i=0; i<repetitions; i++){
+  double start = neuroc_bench::NowNanoseconds();
+  function();
+  samples.push_back(neuroc_bench::NowNanoseconds() - start);
+ }
+ std::sort(samples.begin(), samples.end());
+ return samples[samples.size()/2];
+}
+
+/**
+* It returns true if the zeros of the weights of the
+* pruned layers are at least the ones given by the sparsity
+**/
+bool IsMaskKept(neuroc::Network& net, double sparsity){
+ bool kept = true;
+ for(unsigned int i=0; i<net.Size(); i++){
+  const Eigen::MatrixXd& weight_matrix = net[i].GetWeightMatrix();
+  std::size_t zeros = (weight_matrix.array() == 0.0).count();
+  if(net[i].IsSparse()) kept &= zeros >= (std::size_t) std::llround(sparsity * weight_matrix.size());
+ }
+ return kept;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 100;
+ double learning_rate = 0.1;
+ double final_sparsity = 0.9;
+ unsigned int steps = 5;
+ unsigned int width = 1024;
+ unsigned int batch = 32;
+ unsigned int seed = 42;
+ std::string json_path = "./prunebench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--sparsity" && i+1<argc) final_sparsity = std::atof(argv[++i]);
+  else if(arg == "--steps" && i+1<argc) steps = std::atoi(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--batch" && i+1<argc) batch = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--learning-rate X]"
+             << " [--sparsity X] [--steps N] [--width N] [--batch N] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+
+ std::cout << "=== neuroc magnitude pruning ===" << std::endl;
+
+ //pendigits: accuracy of the dense, one-shot pruned and gradually pruned network
+ neuroc::Network dense_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, hidden, 1});
+ neuroc_bench::RandomizeNetwork(dense_net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(learning_rate);
+ learning.StartOnlineLearning(&dense_net, train_input, train_target, epochs, false);
+
+ neuroc::MagnitudePruning pruning;
+ pruning.SetPruneOutputLayer(false);
+ neuroc::Network oneshot_net = dense_net;
+ pruning.Prune(oneshot_net, final_sparsity);
+
+ neuroc::Network gradual_net = dense_net;
+ pruning.SetSchedule(0.0, final_sparsity, steps);
+ unsigned int cycles_per_step = std::max(1u, epochs / (2 * steps));
+ pruning.StartPruning(&gradual_net, learning, train_input, train_target, cycles_per_step, false);
+ bool mask_kept = IsMaskKept(gradual_net, final_sparsity);
+
+ double dense_accuracy = neuroc_bench::DigitAccuracy(dense_net, test_input, test_target);
+ double oneshot_accuracy = neuroc_bench::DigitAccuracy(oneshot_net, test_input, test_target);
+ double gradual_accuracy = neuroc_bench::DigitAccuracy(gradual_net, test_input, test_target);
+
+ std::cout << std::fixed << std::setprecision(5);
+ std::cout << "pendigits 16-" << hidden << "-" << hidden << "-1, " << epochs << " epochs, output layer not pruned" << std::endl;
+ std::cout << "dense    accuracy " << dense_accuracy << "  sparsity " << neuroc::MagnitudePruning::ReturnSparsity(dense_net) << std::endl;
+ std::cout << "one-shot accuracy " << oneshot_accuracy << "  sparsity " << neuroc::MagnitudePruning::ReturnSparsity(oneshot_net) << std::endl;
+ std::cout << "gradual  accuracy " << gradual_accuracy << "  sparsity " << neuroc::MagnitudePruning::ReturnSparsity(gradual_net)
+           << "  (" << steps << " steps, " << cycles_per_step << " epochs each, mask kept: " << (mask_kept ? "yes" : "no") << ")" << std::endl;
+
+ //Structured pruning: the neurons are removed and the network is smaller
+ std::vector<double> fractions = {0.25, 0.5, 0.75};
+ unsigned int fine_tuning = std::max(1u, epochs / 5);
+ std::vector<Eigen::VectorXd> test_inputs = neuroc_bench::ReturnInputs(test_input);
+ double dense_rate = neuroc_bench::Throughput(dense_net, test_inputs, 5);
+ std::ostringstream json_neurons;
+ std::cout << std::endl << "neuron pruning, " << fine_tuning << " epochs of fine-tuning" << std::endl;
+ std::cout << "score      removed   hidden    parameters   accuracy   fine-tuned   samples/s" << std::endl;
+ std::cout << "none          0.00   " << std::setw(3) << hidden << "-" << std::setw(3) << std::left << hidden << std::right
+           << std::setw(12) << neuroc::NeuronPruning::ReturnNumberOfParameters(dense_net) << std::setprecision(5) << std::setw(11) << dense_accuracy
+           << std::setw(13) << dense_accuracy << std::setprecision(0) << std::setw(12) << dense_rate << std::endl;
+ for(unsigned int s=0; s<2; s++){
+  neuroc::NeuronPruning neuron_pruning;
+  neuron_pruning.SetScore(s == 0 ? neuroc::NeuronPruning::WEIGHT_NORM : neuroc::NeuronPruning::ACTIVATION_VARIANCE);
+  std::string score_name = (s == 0 ? "norm" : "variance");
+  for(unsigned int f=0; f<fractions.size(); f++){
+   neuroc::Network pruned_net = dense_net;
+   neuron_pruning.Prune(pruned_net, fractions[f], train_input);
+   double pruned_accuracy = neuroc_bench::DigitAccuracy(pruned_net, test_input, test_target);
+   learning.StartOnlineLearning(&pruned_net, train_input, train_target, fine_tuning, false);
+   double tuned_accuracy = neuroc_bench::DigitAccuracy(pruned_net, test_input, test_target);
+   double pruned_rate = neuroc_bench::Throughput(pruned_net, test_inputs, 5);
+   std::size_t parameters = neuroc::NeuronPruning::ReturnNumberOfParameters(pruned_net);
+   std::cout << std::left << std::setw(10) << score_name << std::right << std::setprecision(2) << std::setw(7) << fractions[f]
+             << "   " << std::setw(3) << pruned_net[0].ReturnNumberOfNeurons() << "-" << std::setw(3) << std::left << pruned_net[1].ReturnNumberOfNeurons() << std::right
+             << std::setw(12) << parameters << std::setprecision(5) << std::setw(11) << pruned_accuracy << std::setw(13) << tuned_accuracy
+             << std::setprecision(0) << std::setw(12) << pruned_rate << std::endl;
+   json_neurons << (json_neurons.tellp() > 0 ? ",\n" : "") << "  {\"score\": \"" << score_name << "\", \"fraction\": " << fractions[f]
+                << ", \"parameters\": " << parameters << ", \"accuracy\": " << pruned_accuracy << ", \"fine_tuned_accuracy\": " << tuned_accuracy
+                << ", \"samples_per_sec\": " << pruned_rate << "}";
+  }
+ }
+
+ //Square layer: dense and sparse time at growing sparsity
+ std::srand(seed);
+ std::vector<double> sparsities = {0.0, 0.5, 0.7, 0.8, 0.9, 0.95, 0.99};
+ neuroc::DenseLayer dense_layer = neuroc_bench::MakeSigmoidLayer(width, width);
+ Eigen::VectorXd input_vector = Eigen::VectorXd::Random(width);
+ Eigen::MatrixXd input_matrix = Eigen::MatrixXd::Random(width, batch);
+ Eigen::MatrixXd output_matrix(width, batch);
+ Eigen::MatrixXd derivative_matrix(width, batch);
+ double dense_ns = MedianNs([&](){ neuroc_bench::DoNotOptimize(dense_layer.Compute(input_vector).data()); }, 200);
+ double dense_batch_ns = MedianNs([&](){ dense_layer.ComputeBatch(input_matrix, output_matrix, derivative_matrix); }, 50);
+ double crossover = -1;
+ double batch_crossover = -1;
+ std::ostringstream json_cases;
+
+ std::cout << std::endl << "layer " << width << "x" << width << ", dense: " << std::setprecision(0) << dense_ns << " ns/sample, "
+           << dense_batch_ns / batch << " ns/sample with batch " << batch << ", " << neuroc_bench::WeightBytes(dense_layer) << " bytes" << std::endl;
+ std::cout << "sparsity   vector ns   speedup   batch ns/sample   speedup   weights bytes" << std::endl;
+ for(unsigned int i=0; i<sparsities.size(); i++){
+  neuroc::DenseLayer sparse_layer = dense_layer;
+  sparse_layer.Prune(sparsities[i]);
+  double sparse_ns = MedianNs([&](){ neuroc_bench::DoNotOptimize(sparse_layer.Compute(input_vector).data()); }, 200);
+  double sparse_batch_ns = MedianNs([&](){ sparse_layer.ComputeBatch(input_matrix, output_matrix, derivative_matrix); }, 50);
+  if(crossover < 0 && sparse_ns < dense_ns) crossover = sparsities[i];
+  if(batch_crossover < 0 && sparse_batch_ns < dense_batch_ns) batch_crossover = sparsities[i];
+  std::cout << std::setprecision(2) << std::setw(8) << sparsities[i] << std::setprecision(0) << std::setw(12) << sparse_ns
+            << std::setprecision(2) << std::setw(9) << dense_ns / sparse_ns << "x" << std::setprecision(0) << std::setw(18) << sparse_batch_ns / batch
+            << std::setprecision(2) << std::setw(9) << dense_batch_ns / sparse_batch_ns << "x" << std::setw(16) << neuroc_bench::WeightBytes(sparse_layer) << std::endl;
+  json_cases << (i ? ",\n" : "") << "  {\"sparsity\": " << sparsities[i] << ", \"sparse_ns\": " << sparse_ns
+             << ", \"sparse_batch_ns\": " << sparse_batch_ns << ", \"weight_bytes\": " << neuroc_bench::WeightBytes(sparse_layer) << "}";
+ }
+ std::cout << "crossover sparsity: vector " << (crossover < 0 ? std::string("none") : std::to_string(crossover).substr(0, 4))
+           << ", batch " << (batch_crossover < 0 ? std::string("none") : std::to_string(batch_crossover).substr(0, 4)) << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"prunebench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"sparsity\": " << final_sparsity
+             << ", \"steps\": " << steps << ", \"dense_accuracy\": " << dense_accuracy << ", \"oneshot_accuracy\": " << oneshot_accuracy
+             << ", \"gradual_accuracy\": " << gradual_accuracy << ", \"mask_kept\": " << (mask_kept ? "true" : "false") << "},\n"
+             << " \"neurons\": {\"parameters\": " << neuroc::NeuronPruning::ReturnNumberOfParameters(dense_net) << ", \"samples_per_sec\": " << dense_rate
+             << ", \"fine_tuning_epochs\": " << fine_tuning << ",\n \"cases\": [\n" << json_neurons.str() << "]},\n"
+             << " \"layer\": {\"width\": " << width << ", \"batch\": " << batch << ", \"dense_ns\": " << dense_ns
+             << ", \"dense_batch_ns\": " << dense_batch_ns << ", \"dense_weight_bytes\": " << neuroc_bench::WeightBytes(dense_layer)
+             << ", \"crossover\": " << crossover << ", \"batch_crossover\": " << batch_crossover << ",\n \"cases\": [\n" << json_cases.str() << "]}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return mask_kept ? 0 : 1;
+}
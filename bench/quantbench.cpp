@@ -0,0 +1,176 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Int8 quantization benchmark. A network is trained on pendigits.tes
+ * (as in examples/handwritten_digits.cpp), quantized with a part of the
+ * training set as calibration dataset and both versions are tested on
+ * pendigits.tra. It reports the accuracy and the error of the double
+ * and of the int8 network, their difference, the memory of the weights
+ * and the inference throughput. The throughput is also measured on a
+ * wide random network, where the weights dominate the memory traffic.
+ * A binarized network is quantized last, its int8 outputs have to match
+ * the ones of the binarized weights.
+ *
+ * Usage:
+ * ./quantbench [--data-dir DIR] [--hidden N] [--epochs N] [--learning-rate X]
+ *              [--calibration N] [--width N] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <QuantizedNetwork.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 10;
+ unsigned int epochs = 100;
+ double learning_rate = 0.35;
+ unsigned int calibration_size = 500;
+ unsigned int width = 256;
+ unsigned int seed = 42;
+ std::string json_path = "./quantbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--calibration" && i+1<argc) calibration_size = std::atoi(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--learning-rate X]"
+             << " [--calibration N] [--width N] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+
+ std::cout << "=== neuroc int8 quantization (SIMD: " << (neuroc::QuantizedNetwork::IsUsingSIMD() ? "AVX2" : "none") << ") ===" << std::endl;
+
+ //pendigits: accuracy of the double and of the int8 network
+ neuroc::Network net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(learning_rate);
+ learning.StartOnlineLearning(&net, train_input, train_target, epochs, false);
+
+ neuroc::Dataset calibration_dataset;
+ for(unsigned int i=0; i<calibration_size && i<train_input.ReturnNumberOfElements(); i++) calibration_dataset.PushBackData(train_input[i]);
+ neuroc::QuantizedNetwork quantized_net;
+ if(quantized_net.Quantize(net, calibration_dataset) == false) return 1;
+
+ double double_accuracy = neuroc_bench::DigitAccuracy(net, test_input, test_target);
+ double int8_accuracy = neuroc_bench::DigitAccuracy(quantized_net, test_input, test_target);
+ double double_mse = net.ComputeMeanSquaredError(test_input, test_target);
+ double int8_mse = quantized_net.ComputeMeanSquaredError(test_input, test_target);
+ std::vector<Eigen::VectorXd> digit_inputs = neuroc_bench::ReturnInputs(test_input);
+ double double_digits_rate = neuroc_bench::Throughput(net, digit_inputs, 20);
+ double int8_digits_rate = neuroc_bench::Throughput(quantized_net, digit_inputs, 20);
+
+ std::cout << std::fixed << std::setprecision(5);
+ std::cout << "pendigits 16-" << hidden << "-1, " << epochs << " epochs, calibration " << calibration_dataset.ReturnNumberOfElements() << " samples" << std::endl;
+ std::cout << "double  accuracy " << double_accuracy << "  MSE " << double_mse << "  weights " << neuroc_bench::WeightBytes(net) << " bytes  "
+           << std::setprecision(0) << double_digits_rate << " samples/s" << std::setprecision(5) << std::endl;
+ std::cout << "int8    accuracy " << int8_accuracy << "  MSE " << int8_mse << "  model " << quantized_net.ReturnMemoryFootprint() << " bytes  "
+           << std::setprecision(0) << int8_digits_rate << " samples/s" << std::setprecision(5) << std::endl;
+ std::cout << "delta   accuracy " << (int8_accuracy - double_accuracy) << "  MSE " << (int8_mse - double_mse) << std::endl;
+
+ //Wide network: the throughput when the weights do not fit the caches
+ neuroc::Network wide_net = neuroc_bench::MakeSigmoidNetwork({width, width, width, 10});
+ neuroc_bench::RandomizeNetwork(wide_net, seed);
+ std::srand(seed);
+ neuroc::Dataset wide_calibration;
+ std::vector<Eigen::VectorXd> wide_inputs;
+ for(unsigned int i=0; i<256; i++){
+  wide_inputs.push_back(Eigen::VectorXd::Random(width));
+  wide_calibration.PushBackData(wide_inputs.back());
+ }
+ neuroc::QuantizedNetwork wide_quantized;
+ if(wide_quantized.Quantize(wide_net, wide_calibration) == false) return 1;
+ double max_difference = neuroc_bench::MaxDifference(wide_net, wide_quantized, wide_inputs);
+ double double_wide_rate = neuroc_bench::Throughput(wide_net, wide_inputs, 20);
+ double int8_wide_rate = neuroc_bench::Throughput(wide_quantized, wide_inputs, 20);
+ std::cout << std::endl << "random " << width << "-" << width << "-" << width << "-10, max output difference " << max_difference << std::endl;
+ std::cout << std::setprecision(0);
+ std::cout << "double  " << double_wide_rate << " samples/s  weights " << neuroc_bench::WeightBytes(wide_net) << " bytes" << std::endl;
+ std::cout << "int8    " << int8_wide_rate << " samples/s  model " << wide_quantized.ReturnMemoryFootprint() << " bytes" << std::endl;
+ std::cout << std::setprecision(2) << "speedup " << int8_wide_rate / double_wide_rate << "x" << std::endl;
+
+ //Binarized network: the int8 network has to use the binarized weights, not the shadow weights.
+ //A sum of a HardLimit layer close to zero can change sign in int8, the check is on the predicted class.
+ neuroc::Network binarized_net = neuroc_bench::MakeBinarizedNetwork({width, width, width, 10}, seed);
+ neuroc::QuantizedNetwork binarized_quantized;
+ if(binarized_quantized.Quantize(binarized_net, wide_calibration) == false) return 1;
+ unsigned int binarized_agreements = 0;
+ for(unsigned int i=0; i<wide_inputs.size(); i++){
+  Eigen::Index double_class, int8_class;
+  binarized_net.Compute(wide_inputs[i]).maxCoeff(&double_class);
+  binarized_quantized.Compute(wide_inputs[i]).maxCoeff(&int8_class);
+  if(double_class == int8_class) binarized_agreements++;
+ }
+ bool binarized_passed = binarized_agreements * 3 >= wide_inputs.size() * 2;
+ std::cout << std::endl << "binarized " << width << "-" << width << "-" << width << "-10, same class on " << binarized_agreements << "/" << wide_inputs.size()
+           << " inputs" << (binarized_passed ? "  PASS" : "  FAIL") << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"quantbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"simd\": " << (neuroc::QuantizedNetwork::IsUsingSIMD() ? "true" : "false") << ",\n"
+             << " \"pendigits\": {\"hidden\": " << hidden << ", \"epochs\": " << epochs
+             << ", \"double_accuracy\": " << double_accuracy << ", \"int8_accuracy\": " << int8_accuracy
+             << ", \"accuracy_delta\": " << int8_accuracy - double_accuracy
+             << ", \"double_mse\": " << double_mse << ", \"int8_mse\": " << int8_mse
+             << ", \"double_samples_per_sec\": " << double_digits_rate << ", \"int8_samples_per_sec\": " << int8_digits_rate << "},\n"
+             << " \"wide\": {\"width\": " << width << ", \"max_output_difference\": " << max_difference
+             << ", \"double_samples_per_sec\": " << double_wide_rate << ", \"int8_samples_per_sec\": " << int8_wide_rate << "},\n"
+             << " \"binarized\": {\"width\": " << width << ", \"agreements\": " << binarized_agreements
+             << ", \"samples\": " << wide_inputs.size() << ", \"passed\": " << (binarized_passed ? "true" : "false") << "}\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return binarized_passed ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Static network benchmark. A 16-10-1 sigmoid network is trained on
+ * pendigits.tes and loaded in a StaticNetwork with the same topology,
+ * together with a random 16-64-32-10 network with other transfer
+ * functions. The output of StaticNetwork::Compute() is compared with
+ * Network::Compute() on the samples of pendigits.tra, then the weights are
+ * saved back in a new Network that must give the same output. It reports
+ * the largest difference, the samples with a bit-exact output, the
+ * allocations and the throughput of the two paths, and it fails if the
+ * outputs differ more than the tolerance.
+ *
+ * Usage:
+ * ./staticbench [--data-dir DIR] [--epochs N] [--seed N] [--tolerance X] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <StaticNetwork.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <MemoryStats.h>
+#include <WeightFunctions.h>
+#include <JoinFunctions.h>
+#include <TransferFunctions.h>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+typedef neuroc::StaticNetwork<neuroc::StaticDenseLayer<16, 10, neuroc::Activations::Sigmoid>,
+                              neuroc::StaticDenseLayer<10, 1, neuroc::Activations::Sigmoid> > DigitsNetwork;
+
+typedef neuroc::StaticNetwork<neuroc::StaticDenseLayer<16, 64, neuroc::Activations::Tanh>,
+                              neuroc::StaticDenseLayer<64, 32, neuroc::Activations::FastSigmoid>,
+                              neuroc::StaticDenseLayer<32, 10, neuroc::Activations::SaturatedLinear> > MixedNetwork;
+
+/**
+* It returns a 16-64-32-10 network with the Tanh, FastSigmoid
+* and SaturatedLinear transfer functions and random weights.
+**/
+neuroc::Network MakeMixedNetwork(unsigned int seed){
+ neuroc::Network net;
+ net.EmplaceLayer(16, 64, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::Tanh, neuroc::TransferFunctions::TanhDerivative);
+ net.EmplaceLayer(64, 32, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::FastSigmoid, neuroc::TransferFunctions::Linear);
+ net.EmplaceLayer(32, 10, neuroc::WeightFunctions::DotProduct, neuroc::JoinFunctions::Sum, neuroc::TransferFunctions::SaturatedLinear, neuroc::TransferFunctions::Linear);
+ neuroc_bench::RandomizeNetwork(net, seed);
+ return net;
+}
+
+/**
+* \struct Comparison
+* \brief Agreement and speed of a static network and its network
+*/
+struct Comparison {
+ double maxDifference;
+ double saveDifference;
+ unsigned int exactSamples;
+ unsigned long long networkAllocations;
+ unsigned long long staticAllocations;
+ double networkRate;
+ double staticRate;
+};
+
+/**
+* It loads the network in the static network and compares their outputs
+* on the inputs. The weights are saved in a copy of the network whose
+* weights are set to zero first, then it measures the samples per second
+* of the two paths.
+**/
+template<typename Static>
+Comparison Compare(neuroc::Network& net, Static& static_net, const std::vector<Eigen::VectorXd>& inputs, unsigned int repetitions){
+ typedef typename Static::InputVector InputVector;
+ Comparison comparison = Comparison();
+ if(static_net.Load(net) == false) std::exit(1);
+ std::vector<InputVector, Eigen::aligned_allocator<InputVector> > fixed_inputs;
+ for(unsigned int i=0; i<inputs.size(); i++) fixed_inputs.push_back(inputs[i]);
+
+ neuroc::Network saved_net = net;
+ for(unsigned int i=0; i<saved_net.Size(); i++){
+  saved_net[i].SetWeightMatrix(Eigen::MatrixXd::Zero(saved_net[i].ReturnNumberOfNeurons(), saved_net[i].ReturnNumberOfInputs()));
+  saved_net[i].SetBiasVector(Eigen::VectorXd::Zero(saved_net[i].ReturnNumberOfNeurons()));
+ }
+ if(static_net.Save(saved_net) == false) std::exit(1);
+
+ for(unsigned int i=0; i<inputs.size(); i++){
+  const Eigen::VectorXd& output_vector = net.Compute(inputs[i]);
+  Eigen::VectorXd static_vector = static_net.Compute(fixed_inputs[i]);
+  comparison.maxDifference = std::max(comparison.maxDifference, (output_vector - static_vector).cwiseAbs().maxCoeff());
+  comparison.saveDifference = std::max(comparison.saveDifference, (output_vector - saved_net.Compute(inputs[i])).cwiseAbs().maxCoeff());
+  if(output_vector == static_vector) comparison.exactSamples++;
+ }
+
+ neuroc::MemoryStats::AllocationScope network_scope;
+ for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(net.Compute(inputs[i]).data());
+ comparison.networkAllocations = network_scope.Allocations();
+ neuroc::MemoryStats::AllocationScope static_scope;
+ for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(static_net.Compute(fixed_inputs[i]).data());
+ comparison.staticAllocations = static_scope.Allocations();
+
+ double start = neuroc_bench::NowNanoseconds();
+ for(unsigned int r=0; r<repetitions; r++){
+  for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(net.Compute(inputs[i]).data());
+ }
+ comparison.networkRate = (double) repetitions * inputs.size() / ((neuroc_bench::NowNanoseconds() - start) * 1e-9);
+ start = neuroc_bench::NowNanoseconds();
+ for(unsigned int r=0; r<repetitions; r++){
+  for(unsigned int i=0; i<inputs.size(); i++) neuroc_bench::DoNotOptimize(static_net.Compute(fixed_inputs[i]).data());
+ }
+ comparison.staticRate = (double) repetitions * inputs.size() / ((neuroc_bench::NowNanoseconds() - start) * 1e-9);
+ return comparison;
+}
+
+void PrintComparison(const std::string& name, const Comparison& comparison, unsigned int samples){
+ std::cout << name << std::endl;
+ std::cout << std::scientific << std::setprecision(3) << "max difference " << comparison.maxDifference
+           << ", bit-exact on " << comparison.exactSamples << " of " << samples << " samples, after Save() " << comparison.saveDifference << std::endl;
+ std::cout << std::fixed << std::setprecision(0)
+           << "Network::Compute        " << comparison.networkRate << " samples/s  " << comparison.networkAllocations << " allocations" << std::endl
+           << "StaticNetwork::Compute  " << comparison.staticRate << " samples/s  " << comparison.staticAllocations << " allocations" << std::endl
+           << std::setprecision(2) << "speedup " << comparison.staticRate / comparison.networkRate << "x" << std::endl;
+}
+
+std::string ComparisonToJSON(const Comparison& comparison){
+ std::ostringstream stream;
+ stream << std::setprecision(10) << "{\"max_difference\": " << comparison.maxDifference << ", \"save_difference\": " << comparison.saveDifference
+        << ", \"exact_samples\": " << comparison.exactSamples
+        << ", \"network_allocations\": " << comparison.networkAllocations << ", \"static_allocations\": " << comparison.staticAllocations
+        << ", \"network_samples_per_sec\": " << comparison.networkRate << ", \"static_samples_per_sec\": " << comparison.staticRate << "}";
+ return stream.str();
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int epochs = 30;
+ unsigned int seed = 42;
+ double tolerance = 1e-12;
+ std::string json_path = "./staticbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--tolerance" && i+1<argc) tolerance = std::atof(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--epochs N] [--seed N] [--tolerance X] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ std::vector<Eigen::VectorXd> test_inputs;
+ for(unsigned int i=0; i<test_input.ReturnNumberOfElements(); i++) test_inputs.push_back(test_input[i]);
+
+ std::cout << "=== neuroc static network ===" << std::endl;
+ neuroc::Network digits_net = neuroc_bench::MakeSigmoidNetwork({16, 10, 1});
+ neuroc_bench::RandomizeNetwork(digits_net, seed);
+ neuroc::BackpropagationLearning learning;
+ learning.SetLearningRate(0.35);
+ learning.StartOnlineLearning(&digits_net, train_input, train_target, epochs, false);
+ DigitsNetwork digits_static;
+ Comparison digits = Compare(digits_net, digits_static, test_inputs, 50);
+ PrintComparison("pendigits 16-10-1, " + std::to_string(epochs) + " epochs, " + std::to_string(sizeof(DigitsNetwork)) + " bytes", digits, test_inputs.size());
+ std::cout << std::endl;
+
+ neuroc::Network mixed_net = MakeMixedNetwork(seed);
+ MixedNetwork mixed_static;
+ Comparison mixed = Compare(mixed_net, mixed_static, test_inputs, 20);
+ PrintComparison("random 16-64-32-10, Tanh, FastSigmoid, SaturatedLinear, " + std::to_string(sizeof(MixedNetwork)) + " bytes", mixed, test_inputs.size());
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << "{\n \"suite\": \"staticbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"tolerance\": " << tolerance << ",\n"
+             << " \"pendigits\": " << ComparisonToJSON(digits) << ",\n"
+             << " \"mixed\": " << ComparisonToJSON(mixed) << "\n}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ if(digits.maxDifference > tolerance || mixed.maxDifference > tolerance || digits.saveDifference != 0.0 || mixed.saveDifference != 0.0){
+  std::cerr << "FAILED: the static network differs from Network::Compute more than " << tolerance << std::endl;
+  return 1;
+ }
+ return 0;
+}
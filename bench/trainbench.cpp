@@ -0,0 +1,442 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * End-to-end training benchmark. It measures how long every trainer
+ * needs to reach a target error on two workloads:
+ *
+ * pendigits: the handwritten digits dataset used in the example
+ * examples/handwritten_digits.cpp (16-10-1 sigmoid network, trained
+ * on pendigits.tes and tested on pendigits.tra).
+ *
+ * synthetic: a generated regression problem, the targets are produced
+ * by a random teacher network. The number of rows, the width and the
+ * depth of the trained network are configurable.
+ *
+ * For every workload, trainer and thread count of the Executor, the pool
+ * that splits the products of the wide layers, it reports the wall-clock
+ * training time and the epochs needed to reach the target MSE (or the
+ * target accuracy for pendigits), the samples per second and the peak
+ * resident memory. Every combination is trained in a child process, so
+ * the peak memory is the one of its run. The results are saved as CSV
+ * and JSON.
+ *
+ * Usage:
+ * ./trainbench [--workload all|pendigits|synthetic] [--data-dir DIR]
+ *              [--rows N] [--width N] [--depth N] [--max-epochs N]
+ *              [--target-mse X] [--target-accuracy X] [--learning-rate X]
+ *              [--threads 1,2,4] [--threshold N] [--seed N] [--csv FILE]
+ *              [--json FILE] [--trace FILE]
+ *
+ * The default thread counts are 1 and the number of cores. The layers are
+ * split only when their work is above the threshold of the Executor, use
+ * --threshold (multiply-adds) to split the small default networks.
+ *
+ * With --trace the timeline of all the runs is saved in the Chrome
+ * trace format (chrome://tracing or https://ui.perfetto.dev). The runs
+ * are then trained in the benchmark process and the peak memory is not
+ * reported (-1).
+ *
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Executor.h>
+#include <Trace.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* \struct Workload
+* \brief A training problem with its train and test split
+*/
+struct Workload {
+ std::string name;
+ std::vector<unsigned int> sizes; //input size followed by the layers sizes
+ neuroc::Dataset trainInput;
+ neuroc::Dataset trainTarget;
+ neuroc::Dataset testInput;
+ neuroc::Dataset testTarget;
+ double targetMSE;
+ double targetAccuracy; //negative if the accuracy is not defined
+ double learningRate;
+};
+
+/**
+* \struct Trainer
+* \brief A training algorithm. The function runs a single epoch.
+*/
+struct Trainer {
+ std::string name;
+ std::function<void(neuroc::Network*, Workload&)> runEpoch; //the threads are the ones of the Executor
+};
+
+/**
+* \struct RunResult
+* \brief The outcome of a workload/trainer/threads combination
+*/
+struct RunResult {
+ std::string workload;
+ std::string trainer;
+ unsigned int threads;
+ unsigned int rows;
+ bool reached;
+ unsigned int epochs;
+ double trainSeconds;
+ double finalMSE;
+ double finalAccuracy;
+ double samplesPerSecond;
+ long peakRssKb;
+};
+
+/**
+* \struct RunMeasures
+* \brief The measures of a run, sent by the child process that trains it
+*/
+struct RunMeasures {
+ bool reached;
+ unsigned int epochs;
+ double trainSeconds;
+ double finalMSE;
+ double finalAccuracy;
+ double samplesPerSecond;
+ long peakRssKb;
+};
+
+long PeakRssKb(){
+ struct rusage usage;
+ getrusage(RUSAGE_SELF, &usage);
+ return usage.ru_maxrss;
+}
+
+bool LoadPendigits(Workload& workload, std::string dataDir){
+ workload.name = "pendigits";
+ workload.sizes = {16, 10, 1};
+ if(workload.trainInput.LoadFromCSV(dataDir + "/pendigits.tes") == false) return false;
+ if(workload.testInput.LoadFromCSV(dataDir + "/pendigits.tra") == false) return false;
+ workload.trainTarget = workload.trainInput.Split(16);
+ workload.testTarget = workload.testInput.Split(16);
+ workload.trainInput.DivideBy(100);
+ workload.trainTarget.DivideBy(10);
+ workload.testInput.DivideBy(100);
+ workload.testTarget.DivideBy(10);
+ return true;
+}
+
+void MakeSynthetic(Workload& workload, unsigned int rows, unsigned int width, unsigned int depth, unsigned int seed){
+ workload.name = "synthetic";
+ workload.sizes = std::vector<unsigned int>(depth, width);
+ workload.sizes.push_back(1);
+ //The targets are given by a random teacher network
+ neuroc::Network teacher = neuroc_bench::MakeSigmoidNetwork({width, width, 1});
+ neuroc_bench::RandomizeNetwork(teacher, seed + 1);
+ //Scaling the teacher weights keeps its outputs away from saturation
+ for(unsigned int i=0; i<teacher.Size(); i++){
+  double scale = 4.0 / std::sqrt((double) teacher[i].GetWeightMatrix().cols());
+  teacher[i].SetWeightMatrix(teacher[i].GetWeightMatrix() * scale);
+ }
+ std::srand(seed + 2);
+ unsigned int train_rows = rows - rows / 5;
+ for(unsigned int i=0; i<rows; i++){
+  Eigen::VectorXd input_vector = (Eigen::VectorXd::Random(width).array() + 1.0) / 2.0;
+  Eigen::VectorXd target_vector = teacher.Compute(input_vector);
+  if(i < train_rows){
+   workload.trainInput.PushBackData(std::move(input_vector));
+   workload.trainTarget.PushBackData(std::move(target_vector));
+  } else {
+   workload.testInput.PushBackData(std::move(input_vector));
+   workload.testTarget.PushBackData(std::move(target_vector));
+  }
+ }
+}
+
+/**
+* It trains a new network until the target is reached or for the maximum
+* number of epochs. Only the training time is measured, the evaluation is
+* excluded.
+**/
+RunMeasures TrainUntilTarget(Trainer& trainer, Workload& workload, unsigned int threads, unsigned int maxEpochs, unsigned int seed){
+ neuroc::Executor::ReturnInstance().SetNumberOfThreads(threads);
+ neuroc::Network net = neuroc_bench::MakeSigmoidNetwork(workload.sizes);
+ neuroc_bench::RandomizeNetwork(net, seed);
+
+ RunMeasures measures;
+ measures.reached = false;
+ measures.epochs = 0;
+ measures.trainSeconds = 0;
+ measures.finalMSE = 0;
+ measures.finalAccuracy = -1;
+ for(unsigned int epoch=1; epoch<=maxEpochs; epoch++){
+  double start = neuroc_bench::NowNanoseconds();
+  trainer.runEpoch(&net, workload);
+  measures.trainSeconds += (neuroc_bench::NowNanoseconds() - start) / 1e9;
+  measures.epochs = epoch;
+
+  measures.finalMSE = net.ComputeMeanSquaredError(workload.testInput, workload.testTarget);
+  if(workload.name == "pendigits") measures.finalAccuracy = neuroc_bench::DigitAccuracy(net, workload.testInput, workload.testTarget);
+  bool reached_mse = measures.finalMSE <= workload.targetMSE;
+  bool reached_accuracy = workload.targetAccuracy > 0 && measures.finalAccuracy >= workload.targetAccuracy;
+  if(reached_mse || reached_accuracy){
+   measures.reached = true;
+   break;
+  }
+ }
+ unsigned int rows = workload.trainInput.ReturnNumberOfElements();
+ measures.samplesPerSecond = (measures.trainSeconds > 0) ? (double) measures.epochs * rows / measures.trainSeconds : 0;
+ measures.peakRssKb = PeakRssKb();
+ return measures;
+}
+
+/**
+* It trains the network in a child process, so that the peak resident
+* memory is the one of this run and not the largest of all the runs.
+* The measures are sent back through a pipe.
+**/
+bool TrainInChildProcess(Trainer& trainer, Workload& workload, unsigned int threads, unsigned int maxEpochs, unsigned int seed, RunMeasures& measures){
+ int pipe_fds[2];
+ if(pipe(pipe_fds) != 0) return false;
+ std::cout.flush();
+ pid_t pid = fork();
+ if(pid < 0){
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+  return false;
+ }
+ if(pid == 0){
+  close(pipe_fds[0]);
+  RunMeasures child_measures = TrainUntilTarget(trainer, workload, threads, maxEpochs, seed);
+  bool written = write(pipe_fds[1], &child_measures, sizeof(child_measures)) == (ssize_t) sizeof(child_measures);
+  close(pipe_fds[1]);
+  _exit(written ? 0 : 1);
+ }
+ close(pipe_fds[1]);
+ bool received = read(pipe_fds[0], &measures, sizeof(measures)) == (ssize_t) sizeof(measures);
+ close(pipe_fds[0]);
+ int status = 0;
+ waitpid(pid, &status, 0);
+ return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::vector<unsigned int> ParseList(std::string text){
+ std::vector<unsigned int> values;
+ std::stringstream ss(text);
+ std::string token;
+ while(std::getline(ss, token, ',')) values.push_back(std::atoi(token.c_str()));
+ return values;
+}
+
+bool SaveAsCSV(const std::vector<RunResult>& results, std::string filePath){
+ std::ofstream file_stream(filePath);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return false;
+ }
+ file_stream << "workload,trainer,threads,rows,reached,epochs,train_seconds,final_mse,final_accuracy,samples_per_sec,peak_rss_kb\n";
+ file_stream << std::setprecision(10);
+ for(unsigned int i=0; i<results.size(); i++){
+  const RunResult& r = results[i];
+  file_stream << r.workload << "," << r.trainer << "," << r.threads << "," << r.rows << ","
+              << (r.reached ? 1 : 0) << "," << r.epochs << "," << r.trainSeconds << ","
+              << r.finalMSE << "," << r.finalAccuracy << "," << r.samplesPerSecond << ","
+              << r.peakRssKb << "\n";
+ }
+ return true;
+}
+
+bool SaveAsJSON(const std::vector<RunResult>& results, std::string filePath){
+ std::ofstream file_stream(filePath);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return false;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"trainbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n \"results\": [\n";
+ for(unsigned int i=0; i<results.size(); i++){
+  const RunResult& r = results[i];
+  file_stream << "  {\"workload\": \"" << r.workload << "\", \"trainer\": \"" << r.trainer
+              << "\", \"threads\": " << r.threads << ", \"rows\": " << r.rows
+              << ", \"reached\": " << (r.reached ? "true" : "false") << ", \"epochs\": " << r.epochs
+              << ", \"train_seconds\": " << r.trainSeconds << ", \"final_mse\": " << r.finalMSE
+              << ", \"final_accuracy\": " << r.finalAccuracy << ", \"samples_per_sec\": " << r.samplesPerSecond
+              << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+  if(i != results.size()-1) file_stream << ",";
+  file_stream << "\n";
+ }
+ file_stream << " ]\n}\n";
+ return true;
+}
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string workload_name = "all";
+ std::string data_dir = "./examples/build/exec";
+ unsigned int rows = 5000;
+ unsigned int width = 64;
+ unsigned int depth = 2;
+ unsigned int max_epochs = 100;
+ double target_mse = -1;
+ double target_accuracy = -1;
+ double learning_rate = -1;
+ unsigned int seed = 42;
+ std::vector<unsigned int> threads_list = {1};
+ if(std::thread::hardware_concurrency() > 1) threads_list.push_back(std::thread::hardware_concurrency());
+ long threshold = -1;
+ std::string csv_path = "./trainbench.csv";
+ std::string json_path = "./trainbench.json";
+ std::string trace_path;
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--workload" && i+1<argc) workload_name = argv[++i];
+  else if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--rows" && i+1<argc) rows = std::atoi(argv[++i]);
+  else if(arg == "--width" && i+1<argc) width = std::atoi(argv[++i]);
+  else if(arg == "--depth" && i+1<argc) depth = std::atoi(argv[++i]);
+  else if(arg == "--max-epochs" && i+1<argc) max_epochs = std::atoi(argv[++i]);
+  else if(arg == "--target-mse" && i+1<argc) target_mse = std::atof(argv[++i]);
+  else if(arg == "--target-accuracy" && i+1<argc) target_accuracy = std::atof(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--threads" && i+1<argc) threads_list = ParseList(argv[++i]);
+  else if(arg == "--threshold" && i+1<argc) threshold = std::atol(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--csv" && i+1<argc) csv_path = argv[++i];
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else if(arg == "--trace" && i+1<argc) trace_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--workload all|pendigits|synthetic] [--data-dir DIR] [--rows N] [--width N] [--depth N]"
+             << " [--max-epochs N] [--target-mse X] [--target-accuracy X] [--learning-rate X] [--threads 1,2,4]"
+             << " [--threshold N] [--seed N] [--csv FILE] [--json FILE] [--trace FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ //The workers of the Executor are started by the runs, in the child processes:
+ //the threads of a parent are not copied by fork()
+ neuroc::Executor& executor = neuroc::Executor::ReturnInstance();
+ executor.SetNumberOfThreads(1);
+ if(threshold >= 0) executor.SetThreshold(threshold);
+ for(unsigned int& threads : threads_list) if(threads == 0) threads = 1;
+
+ //Workloads
+ std::vector<Workload> workloads;
+ if(workload_name == "all" || workload_name == "pendigits"){
+  Workload workload;
+  if(LoadPendigits(workload, data_dir)){
+   workload.targetMSE = (target_mse > 0) ? target_mse : 0.015;
+   workload.targetAccuracy = (target_accuracy > 0) ? target_accuracy : -1;
+   workload.learningRate = (learning_rate > 0) ? learning_rate : 0.35;
+   workloads.push_back(workload);
+  } else {
+   std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  }
+ }
+ if(workload_name == "all" || workload_name == "synthetic"){
+  Workload workload;
+  MakeSynthetic(workload, rows, width, depth, seed);
+  workload.targetMSE = (target_mse > 0) ? target_mse : 0.0002;
+  workload.targetAccuracy = -1;
+  workload.learningRate = (learning_rate > 0) ? learning_rate : 0.1;
+  workloads.push_back(workload);
+ }
+
+ //Trainers
+ std::vector<Trainer> trainers;
+ Trainer online_trainer;
+ online_trainer.name = "online";
+ online_trainer.runEpoch = [](neuroc::Network* net, Workload& workload){
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(workload.learningRate);
+  learning.StartOnlineLearning(net, workload.trainInput, workload.trainTarget, 1, false);
+ };
+ trainers.push_back(online_trainer);
+ Trainer batch_trainer;
+ batch_trainer.name = "batch32";
+ batch_trainer.runEpoch = [](neuroc::Network* net, Workload& workload){
+  //The changes are averaged over the batch, scaling the learning
+  //rate by the batch size gives the same step size of the online trainer
+  const unsigned int batch_size = 32;
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(workload.learningRate * batch_size);
+  learning.StartBatchLearning(net, workload.trainInput, workload.trainTarget, 1, batch_size, false);
+ };
+ trainers.push_back(batch_trainer);
+
+ std::vector<RunResult> results;
+ if(trace_path.empty() == false) neuroc::Trace::Enable();
+ for(unsigned int w=0; w<workloads.size(); w++){
+  Workload& workload = workloads[w];
+  for(unsigned int t=0; t<trainers.size(); t++){
+   for(unsigned int threads : threads_list){
+    RunResult result;
+    result.workload = workload.name;
+    result.trainer = trainers[t].name;
+    result.threads = threads;
+    result.rows = workload.trainInput.ReturnNumberOfElements();
+    RunMeasures measures;
+    if(trace_path.empty() == false){
+     measures = TrainUntilTarget(trainers[t], workload, threads, max_epochs, seed);
+     measures.peakRssKb = -1;
+    }
+    else if(TrainInChildProcess(trainers[t], workload, threads, max_epochs, seed, measures) == false){
+     std::cerr << "Error: the run " << workload.name << " / " << trainers[t].name << " failed." << std::endl;
+     return 1;
+    }
+    result.reached = measures.reached;
+    result.epochs = measures.epochs;
+    result.trainSeconds = measures.trainSeconds;
+    result.finalMSE = measures.finalMSE;
+    result.finalAccuracy = measures.finalAccuracy;
+    result.samplesPerSecond = measures.samplesPerSecond;
+    result.peakRssKb = measures.peakRssKb;
+    results.push_back(result);
+
+    std::cout << std::left << std::setw(10) << result.workload << std::setw(10) << result.trainer
+              << "threads " << result.threads << "  " << (result.reached ? "reached" : "NOT reached")
+              << " after " << result.epochs << " epochs, " << std::fixed << std::setprecision(3)
+              << result.trainSeconds << " s, MSE " << std::setprecision(5) << result.finalMSE;
+    if(result.finalAccuracy >= 0) std::cout << ", accuracy " << std::setprecision(4) << result.finalAccuracy;
+    std::cout << ", " << std::setprecision(0) << result.samplesPerSecond << " samples/s, peak RSS "
+              << result.peakRssKb << " KB" << std::endl;
+   }
+  }
+ }
+
+ if(trace_path.empty() == false){
+  neuroc::Trace::Disable();
+  if(neuroc::Trace::SaveAsJSON(trace_path)) std::cout << "Trace saved in " << trace_path << std::endl;
+ }
+ SaveAsCSV(results, csv_path);
+ if(SaveAsJSON(results, json_path)) std::cout << "Results saved in " << csv_path << " and " << json_path << std::endl;
+ return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Validation benchmark. A network is trained on pendigits.tes for a fixed
+ * number of epochs, then with the validation on the first half of
+ * pendigits.tra and early stopping, in the synchronous and in the
+ * asynchronous mode. The two modes must give the same validation errors,
+ * the same stopping epoch and the same best network. It reports the epochs
+ * trained, the time and the error on the second half of pendigits.tra.
+ *
+ * Usage:
+ * ./valbench [--data-dir DIR] [--hidden N] [--epochs N] [--interval N]
+ *            [--patience N] [--learning-rate X] [--seed N] [--json FILE]
+ *
+*/
+
+#include <cstdlib>
+#include <DenseLayer.h>
+#include <Network.h>
+#include <BackpropagationLearning.h>
+#include <Dataset.h>
+#include <Eigen/Dense>
+#include "BenchUtils.h"
+#include "BenchModels.h"
+
+namespace {
+
+/**
+* \struct Run
+* \brief The outcome of a training
+*/
+struct Run {
+ double seconds;
+ double testError;
+ unsigned int epochs;
+ unsigned int bestEpoch;
+ std::vector<double> validationErrors;
+ neuroc::Network net;
+};
+
+} //namespace
+
+
+int main(int argc, char* argv[])
+{
+ std::string data_dir = "./examples/build/exec";
+ unsigned int hidden = 64;
+ unsigned int epochs = 300;
+ unsigned int interval = 1;
+ unsigned int patience = 10;
+ double learning_rate = 0.35;
+ unsigned int seed = 42;
+ std::string json_path = "./valbench.json";
+
+ for(int i=1; i<argc; i++){
+  std::string arg = argv[i];
+  if(arg == "--data-dir" && i+1<argc) data_dir = argv[++i];
+  else if(arg == "--hidden" && i+1<argc) hidden = std::atoi(argv[++i]);
+  else if(arg == "--epochs" && i+1<argc) epochs = std::atoi(argv[++i]);
+  else if(arg == "--interval" && i+1<argc) interval = std::atoi(argv[++i]);
+  else if(arg == "--patience" && i+1<argc) patience = std::atoi(argv[++i]);
+  else if(arg == "--learning-rate" && i+1<argc) learning_rate = std::atof(argv[++i]);
+  else if(arg == "--seed" && i+1<argc) seed = std::atoi(argv[++i]);
+  else if(arg == "--json" && i+1<argc) json_path = argv[++i];
+  else {
+   std::cerr << "Usage: " << argv[0] << " [--data-dir DIR] [--hidden N] [--epochs N] [--interval N]"
+             << " [--patience N] [--learning-rate X] [--seed N] [--json FILE]" << std::endl;
+   return 1;
+  }
+ }
+
+ neuroc::Dataset train_input, test_input;
+ if(train_input.LoadFromCSV(data_dir + "/pendigits.tes") == false || test_input.LoadFromCSV(data_dir + "/pendigits.tra") == false){
+  std::cerr << "Error: pendigits not found in " << data_dir << ", use --data-dir." << std::endl;
+  return 1;
+ }
+ neuroc::Dataset train_target = train_input.Split(16);
+ neuroc::Dataset test_target = test_input.Split(16);
+ train_input.DivideBy(100);
+ train_target.DivideBy(10);
+ test_input.DivideBy(100);
+ test_target.DivideBy(10);
+ //The first half of pendigits.tra validates, the second half tests
+ neuroc::Dataset validation_input, validation_target, holdout_input, holdout_target;
+ for(unsigned int i=0; i<test_input.ReturnNumberOfElements(); i++){
+  if(i < test_input.ReturnNumberOfElements() / 2){
+   validation_input.PushBackData(test_input[i]);
+   validation_target.PushBackData(test_target[i]);
+  } else {
+   holdout_input.PushBackData(test_input[i]);
+   holdout_target.PushBackData(test_target[i]);
+  }
+ }
+
+ neuroc::Network initial_net = neuroc_bench::MakeSigmoidNetwork({16, hidden, 1});
+ neuroc_bench::RandomizeNetwork(initial_net, seed);
+
+ const char* mode_names[3] = {"no validation", "synchronous", "asynchronous"};
+ Run runs[3];
+ for(unsigned int m=0; m<3; m++){
+  neuroc::Network net = initial_net;
+  neuroc::BackpropagationLearning learning;
+  learning.SetLearningRate(learning_rate);
+  if(m > 0) learning.SetValidation(validation_input, validation_target, interval, patience, true, m == 2);
+  double start = neuroc_bench::NowNanoseconds();
+  learning.StartOnlineLearning(&net, train_input, train_target, epochs, false);
+  runs[m].seconds = (neuroc_bench::NowNanoseconds() - start) * 1e-9;
+  runs[m].testError = net.ComputeMeanSquaredError(holdout_input, holdout_target);
+  runs[m].epochs = (learning.GetStoppedEpoch() > 0) ? learning.GetStoppedEpoch() : epochs;
+  runs[m].bestEpoch = learning.GetBestEpoch();
+  runs[m].validationErrors = learning.GetValidationErrors();
+  runs[m].net = net;
+ }
+
+ bool same_errors = (runs[1].validationErrors == runs[2].validationErrors);
+ bool same_best = (runs[1].bestEpoch == runs[2].bestEpoch) && neuroc_bench::SameWeights(runs[1].net, runs[2].net);
+
+ std::cout << "=== neuroc validation and early stopping ===" << std::endl;
+ std::cout << "pendigits 16-" << hidden << "-1, at most " << epochs << " epochs, validation every " << interval
+           << " epochs, patience " << patience << std::endl;
+ std::cout << std::fixed << std::setprecision(5);
+ for(unsigned int m=0; m<3; m++){
+  std::cout << std::left << std::setw(15) << mode_names[m] << std::right << std::setprecision(3) << runs[m].seconds << " s  "
+            << runs[m].epochs << " epochs";
+  if(m > 0) std::cout << ", best epoch " << runs[m].bestEpoch;
+  std::cout << std::setprecision(5) << ", test MSE " << runs[m].testError << std::endl;
+ }
+ std::cout << "synchronous and asynchronous: " << (same_errors ? "same validation errors" : "DIFFERENT validation errors")
+           << ", " << (same_best ? "same best network" : "DIFFERENT best network") << std::endl;
+
+ std::ofstream file_stream(json_path);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return 1;
+ }
+ file_stream << std::setprecision(10);
+ file_stream << "{\n \"suite\": \"valbench\",\n \"timestamp\": " << (long) std::time(0) << ",\n"
+             << " \"hidden\": " << hidden << ", \"epochs\": " << epochs << ", \"interval\": " << interval << ", \"patience\": " << patience << ",\n"
+             << " \"same_errors\": " << (same_errors ? "true" : "false") << ", \"same_best\": " << (same_best ? "true" : "false") << ",\n";
+ const char* json_names[3] = {"none", "synchronous", "asynchronous"};
+ for(unsigned int m=0; m<3; m++){
+  file_stream << " \"" << json_names[m] << "\": {\"seconds\": " << runs[m].seconds << ", \"epochs\": " << runs[m].epochs
+              << ", \"best_epoch\": " << runs[m].bestEpoch << ", \"test_mse\": " << runs[m].testError << "}" << (m < 2 ? ",\n" : "\n");
+ }
+ file_stream << "}\n";
+ std::cout << "Results saved in " << json_path << std::endl;
+ return (same_errors && same_best) ? 0 : 1;
+}
@@ -21,12 +21,22 @@
 #define BACKPROPAGATIONLEARNING_H
 
 #include <iostream>  // printing functions
+#include <memory>
+#include <string>
+#include <vector>
 #include <Network.h>
 #include <Eigen/Dense>
 #include <Dataset.h>
+#include <TrainingWorkspace.h>
+#include <BatchPipeline.h>
+#include <SampleOrder.h>
+#include <LossFunctions.h>
 
 namespace neuroc{
 
+class CheckpointWriter;
+class ValidationWorker;
+
 /**
  * \class BackpropagationLearning
  * \brief Implementation of the Error-Backpropagation Learning algorithm
@@ -40,24 +50,137 @@ public:
 BackpropagationLearning();
 ~BackpropagationLearning();
 
-double SingleStepOnlineLearning(Network* net, Eigen::VectorXd inputVector, Eigen::VectorXd targetVector, bool print=true);
+double SingleStepOnlineLearning(Network* net, const Eigen::VectorXd& inputVector, const Eigen::VectorXd& targetVector, bool print=true);
 void StartOnlineLearning(Network* net, Dataset& inputDataset, Dataset& targetDataset, unsigned int cycles, bool print=true);
+
+double SingleStepBatchLearning(Network* net, const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, const Eigen::Ref<const Eigen::MatrixXd>& targetMatrix);
+void StartBatchLearning(Network* net, Dataset& inputDataset, Dataset& targetDataset, unsigned int cycles, unsigned int batchSize, bool print=true);
 //Network StartOnlineLearning(Network net, Dataset& inputDataset, Dataset& targetDataset, unsigned int cycles, bool print=true);
 //void StartTest(Network& net, Dataset& inputDataset, Dataset& targetDataset, bool print=true);
 
 void SetLearningRate(double value);
 double GetLearningRate();
 
+void SetWeightDecay(double value);
+double GetWeightDecay();
+
+void SetGradientClipping(double value);
+double GetGradientClipping();
+
+bool SetCheckpoint(const std::string& filePath, unsigned int interval, bool asynchronous=true);
+void RemoveCheckpoint();
+bool ResumeFromCheckpoint(Network* net, const std::string& filePath);
+bool WaitForCheckpoint();
+
+bool SetValidation(Dataset& inputDataset, Dataset& targetDataset, unsigned int interval, unsigned int patience=0, bool restoreBest=true, bool asynchronous=true);
+void RemoveValidation();
+double GetBestValidationError();
+unsigned int GetBestEpoch();
+unsigned int GetStoppedEpoch();
+const Network& GetBestNetwork();
+const std::vector<double>& GetValidationErrors();
+
+void SetPrefetch(unsigned int depth, unsigned int loaders=1, const BatchPipeline::Transform& transform=BatchPipeline::Transform());
+unsigned int GetPrefetchDepth();
+
+void SetFileOrder();
+void SetShuffle(uint64_t seed);
+void SetImportanceSampling(uint64_t seed, double uniformMix=0.5);
+const SampleOrder& GetSampleOrder();
+
+void SetLoss(LossFunctions::Function loss);
+LossFunctions::Function GetLoss();
+
+void SetMixedPrecision(bool value, double lossScale=1.0);
+bool GetMixedPrecision();
+double GetLossScale();
+unsigned long long GetSkippedSteps();
+
+//The three phases of a learning step, they are public
+//to allow measuring and driving them one by one.
+void Forward(Network* net, const Eigen::VectorXd& inputVector);
+double ErrorBackpropagation(Network* net, const Eigen::VectorXd& targetVector);
+void UpdateWheights(Network* net);
+
+TrainingWorkspace& GetWorkspace();
+
 
 private:
+BackpropagationLearning(const BackpropagationLearning&);
+BackpropagationLearning& operator=(const BackpropagationLearning&);
+
+/**
+* \struct TrainingCursor
+* \brief Position of a training, saved in the checkpoints
+*/
+struct TrainingCursor {
+ unsigned int epoch;
+ unsigned int sample; //next sample of the epoch
+ unsigned int batchSize; //zero for the online learning
+ unsigned int datasetSize;
+ double epochError; //sum of the errors of the epoch before the sample
+};
+
+bool CheckLoss(Network* net);
+bool CheckCheckpoint(Network* net);
+double SingleStepMixedLearning(Network* net, const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, const Eigen::Ref<const Eigen::MatrixXd>& targetMatrix);
+bool StartCursor(unsigned int batchSize, unsigned int datasetSize, TrainingCursor& cursor);
+void CheckpointStep(Network* net, const TrainingCursor& cursor, bool last);
+void StartValidation();
+bool ValidationStep(Network* net, unsigned int epoch, bool last, bool print);
+bool CollectValidation(bool print);
+void FinishValidation(Network* net, bool print);
 
 //Network mNet;
 double mLearningRate;
 double learningRate;
-
-void Forward(Network* net, Eigen::VectorXd );
-double ErrorBackpropagation(Network* net, Eigen::VectorXd );
-void UpdateWheights(Network* net);
+double mWeightDecay;
+double mGradientClipping;
+TrainingWorkspace mWorkspace;
+//Position in the workspace of the matrices of each layer, used by the batch step
+std::vector<double*> mLayerOutputs;
+std::vector<double*> mLayerDerivatives;
+std::vector<double*> mLayerErrors;
+//Single precision matrices of each layer, used by the mixed precision step
+std::vector<float*> mLayerFloatOutputs;
+std::vector<float*> mLayerFloatErrors;
+std::vector<float*> mLayerFloatGradients;
+//Periodic checkpoints, the interval is given in learning steps
+std::string mCheckpointPath;
+unsigned int mCheckpointInterval;
+unsigned long long mCheckpointSteps;
+std::unique_ptr<CheckpointWriter> mCheckpointWriter;
+TrainingCursor mResumeCursor;
+bool mResumePending;
+//Validation and early stopping, the interval is given in epochs
+//and the patience in validations without improvement
+std::unique_ptr<ValidationWorker> mValidationWorker;
+unsigned int mValidationInterval;
+unsigned int mValidationPatience;
+bool mRestoreBest;
+Network mBestNetwork;
+double mBestValidationError;
+unsigned int mBestEpoch;
+unsigned int mStoppedEpoch;
+unsigned int mValidationsWithoutImprovement;
+bool mStopRequested;
+std::vector<double> mValidationErrors;
+//Batches prepared by the loader threads of a BatchPipeline, zero depth disables them
+unsigned int mPrefetchDepth;
+unsigned int mPrefetchLoaders;
+BatchPipeline::Transform mPrefetchTransform;
+//Order of the samples of the epochs and weight of the current sample
+SampleOrder mSampleOrder;
+double mSampleWeight;
+//Loss of the output layer, it computes the deltas of the output layer
+LossFunctions::Function mLoss;
+//Mixed precision of the batch learning, the loss scale is halved when the
+//gradients overflow and doubled again after a run of finite steps
+bool mMixedPrecision;
+double mLossScale;
+double mMaxLossScale;
+unsigned int mFiniteSteps;
+unsigned long long mSkippedSteps;
 
 
 };  // Class BackpropagationLearning
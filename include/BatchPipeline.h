@@ -0,0 +1,126 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef BATCHPIPELINE_H
+#define BATCHPIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <Eigen/Dense>
+#include "Dataset.h"
+#include "SampleOrder.h"
+#include "SpscQueue.h"
+
+namespace neuroc{
+
+/**
+* \class BatchPipeline
+* \brief It prepares the batches of a training in background threads
+*
+* The loader threads gather the samples of the next batches from the
+* datasets in a pool of matrices allocated once, apply the transform and
+* pass them to the training thread, which gives them back after the
+* learning step. The batches are the ones of StartBatchLearning(), in the
+* same order: the loader l prepares the batches l, l+L, l+2L, ... and every
+* loader has its own pair of lock-free single producer single consumer
+* queues, one for the ready batches and one for the free buffers, so the
+* training reads the batches in order without locks. The samples can be
+* shuffled by a SampleOrder, every loader computes the permutations of the
+* epochs from the seed. In the steady state
+* neither the loaders nor the training allocate memory. A thread that finds
+* its queue empty (or full) spins for a while and then sleeps shortly.
+*/
+class BatchPipeline {
+
+public:
+
+/**
+* \struct Batch
+* \brief A batch, the samples are the first columns of the matrices
+*/
+struct Batch {
+ Eigen::MatrixXd input;
+ Eigen::MatrixXd target;
+ unsigned int samples;
+ unsigned int epoch;
+ unsigned int first; //position of the first sample in the epoch
+};
+
+typedef std::function<void(Eigen::Ref<Eigen::MatrixXd> inputMatrix, Eigen::Ref<Eigen::MatrixXd> targetMatrix)> Transform;
+
+BatchPipeline(Dataset& inputDataset, Dataset& targetDataset, unsigned int batchSize, unsigned int depth=4, unsigned int loaders=1);
+~BatchPipeline();
+
+void SetTransform(const Transform& transform);
+bool SetSampleOrder(const SampleOrder& order);
+bool Start(unsigned int firstEpoch, unsigned int lastEpoch, unsigned int firstSample=0);
+void Stop();
+
+const Batch* Next();
+void Release();
+
+unsigned int ReturnBatchSize();
+std::size_t ReturnMemoryFootprint();
+unsigned long long ReturnNumberOfTrainingWaits();
+
+private:
+BatchPipeline(const BatchPipeline&);
+BatchPipeline& operator=(const BatchPipeline&);
+
+/**
+* \struct Loader
+* \brief A loader thread with its buffers and queues
+*/
+struct Loader {
+ Loader(unsigned int buffers) : ready(buffers), free(buffers) {}
+ std::vector<Batch> buffers;
+ SpscQueue<Batch*> ready;
+ SpscQueue<Batch*> free;
+ SampleOrder order;
+ std::thread thread;
+};
+
+void Run(unsigned int loaderIndex);
+void Gather(Batch& batch, const SampleOrder& order);
+
+Dataset& mInputDataset;
+Dataset& mTargetDataset;
+unsigned int mBatchSize;
+unsigned int mDatasetSize;
+Transform mTransform;
+SampleOrder mOrder;
+std::vector<std::unique_ptr<Loader>> mLoaders;
+std::atomic<bool> mStopping;
+bool mRunning;
+unsigned int mFirstEpoch;
+unsigned int mLastEpoch;
+unsigned int mFirstSample;
+unsigned long long mNextBatch; //index of the next batch read by the training
+unsigned long long mTotalBatches;
+Batch* mCurrent;
+unsigned long long mTrainingWaits;
+};
+
+} //namespace
+
+#endif // BATCHPIPELINE_H
@@ -0,0 +1,95 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef BINARYNETWORK_H
+#define BINARYNETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+#include "TransferFunctions.h"
+
+namespace neuroc{
+
+class Network;
+class Dataset;
+
+/**
+* \class BinaryNetwork
+* \brief Binarized copy of a network for the inference
+*
+* The weights of the layers in the binarized mode (DenseLayer::SetBinarized())
+* are stored as the bits of sign(W) packed in 64-bit words, with the scale
+* alpha (mean absolute weight) of each neuron, the other layers keep their
+* weights in double precision. The hidden layers must use the HardLimit
+* transfer function, so that their outputs are bits too and the next layer
+* is computed with XNOR and popcount on the packed words. The first layer
+* takes the input in double precision and the last layer returns its output
+* in double precision, after its own transfer function. The output is the
+* one of the network, apart from the sums of the first layer that are exactly
+* zero, whose sign can be given by the rounding.
+*/
+class BinaryNetwork {
+
+public:
+
+BinaryNetwork();
+
+bool Binarize(Network& net);
+
+const Eigen::VectorXd& Compute(const Eigen::VectorXd& inputVector);
+double ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset);
+
+unsigned int Size();
+std::size_t ReturnMemoryFootprint();
+static bool IsUsingPopcountInstruction();
+
+void Print();
+
+private:
+
+/**
+* \struct BinaryLayer
+* \brief The packed signs of the weights of a layer
+*/
+struct BinaryLayer {
+ unsigned int inputSize;
+ unsigned int outputSize;
+ unsigned int words; //64-bit words of a row
+ bool packed; //false if the weights are kept in double precision
+ std::vector<uint64_t> weights; //row major, outputSize x words, bit set if w >= 0
+ std::vector<int32_t> weightSum; //sum of sign(w) of every row
+ Eigen::VectorXd alpha;
+ Eigen::MatrixXd weightMatrix; //only if not packed
+ Eigen::VectorXd bias;
+ bool productJoin;
+ TransferFunctions::InPlace::Function transfer;
+ std::vector<uint64_t> inputBits; //packed input of the hidden layers
+ Eigen::VectorXd inputValues; //input of the first layer, padded to the words
+ Eigen::VectorXd value; //weighted input
+};
+
+std::vector<BinaryLayer> mLayersVector;
+Eigen::VectorXd mOutputVector;
+};
+
+} //namespace
+
+#endif // BINARYNETWORK_H
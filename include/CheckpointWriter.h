@@ -0,0 +1,80 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef CHECKPOINTWRITER_H
+#define CHECKPOINTWRITER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Network.h"
+
+namespace neuroc{
+
+/**
+* \class CheckpointWriter
+* \brief It writes the checkpoints of a training from a background thread
+*
+* Submit() takes a snapshot of the network, that is a copy sharing the
+* weights with the trained network (the training duplicates them at its
+* next update), and the background thread saves it with the training state
+* in the extra block of a model file. The file is written with a temporary
+* name, flushed to the disk and renamed, so a checkpoint is either the
+* previous one or the new one also if the process is killed. If a snapshot
+* is submitted while the previous one is waiting, the older is dropped.
+*/
+class CheckpointWriter {
+
+public:
+
+CheckpointWriter();
+~CheckpointWriter();
+
+void Submit(const Network& snapshot, const std::string& stateBlock, const std::string& filePath);
+bool Wait();
+
+unsigned int ReturnNumberOfWrites();
+unsigned int ReturnNumberOfDropped();
+
+static bool WriteAtomically(Network& net, const std::string& stateBlock, const std::string& filePath);
+
+private:
+CheckpointWriter(const CheckpointWriter&);
+CheckpointWriter& operator=(const CheckpointWriter&);
+
+void Run();
+
+std::thread mThread;
+std::mutex mMutex;
+std::condition_variable mCondition;
+Network mPendingNetwork;
+std::string mPendingState;
+std::string mPendingPath;
+bool mPending;
+bool mWriting;
+bool mStopping;
+bool mFailed;
+unsigned int mWrites;
+unsigned int mDropped;
+};
+
+} //namespace
+
+#endif // CHECKPOINTWRITER_H
@@ -0,0 +1,93 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef CLUSTEREDNETWORK_H
+#define CLUSTEREDNETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+#include "TransferFunctions.h"
+
+namespace neuroc{
+
+class Network;
+class Dataset;
+
+/**
+* \class ClusteredNetwork
+* \brief Copy of a network with clustered weights for the inference
+*
+* The layers in the clustered mode (DenseLayer::SetCodebook()) keep only the
+* codebook and the index of every weight, packed in 4 bits when the codebook
+* has up to 16 centroids and in 8 bits otherwise, that is 16 or 8 times less
+* memory than the weights in double precision. The indices select the
+* centroids while the dot products are computed: with AVX-512 the 16
+* centroids of a 4-bit codebook stay in two registers and are selected by
+* a permutation, the 8-bit indices gather them from memory. The other layers
+* keep their weights in double precision. The output is the one of the
+* network, apart from the rounding of the different order of the sums.
+*/
+class ClusteredNetwork {
+
+public:
+
+ClusteredNetwork();
+
+bool Compress(Network& net);
+
+const Eigen::VectorXd& Compute(const Eigen::VectorXd& inputVector);
+double ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset);
+
+unsigned int Size();
+std::size_t ReturnMemoryFootprint();
+static bool IsUsingSIMD();
+
+void Print();
+
+private:
+
+/**
+* \struct ClusteredLayer
+* \brief The packed indices and the codebook of a layer
+*/
+struct ClusteredLayer {
+ unsigned int inputSize;
+ unsigned int outputSize;
+ unsigned int bits; //4 or 8, zero if the weights are kept in double precision
+ unsigned int paddedSize; //input size rounded up to a group of 16 columns
+ unsigned int stride; //bytes of a row
+ std::vector<uint8_t> indices; //row major, outputSize x stride, 4-bit: a group of 16 columns in 8 bytes,
+                               //the low nibbles are the first 8 columns and the high ones the others
+ Eigen::VectorXd centroids; //at least 16 centroids with 4-bit indices
+ Eigen::MatrixXd weightMatrix; //only if not clustered
+ Eigen::VectorXd bias;
+ bool productJoin;
+ TransferFunctions::InPlace::Function transfer;
+ Eigen::VectorXd inputValues; //input of the layer, padded with zeros
+ Eigen::VectorXd value; //weighted input
+};
+
+std::vector<ClusteredLayer> mLayersVector;
+};
+
+} //namespace
+
+#endif // CLUSTEREDNETWORK_H
@@ -45,11 +45,20 @@ Dataset(unsigned int datasetDimension);
 
 Dataset();
 
+Dataset(const Dataset &rDataset);
+
+Dataset(Dataset &&rDataset) noexcept;
+
 ~Dataset();
 
+Dataset& operator=(const Dataset &rDataset);
+
+Dataset& operator=(Dataset &&rDataset) noexcept;
+
 Eigen::VectorXd& operator[](unsigned int index);
 
-bool PushBackData(Eigen::VectorXd dataToPush);
+bool PushBackData(const Eigen::VectorXd& dataToPush);
+bool PushBackData(Eigen::VectorXd&& dataToPush);
 
 Dataset Split(unsigned int index);
 
@@ -62,6 +71,7 @@ Eigen::VectorXd GetData(unsigned int index);
 bool SetData(unsigned int index, Eigen::VectorXd data);
 
 unsigned int ReturnNumberOfElements();
+std::size_t ReturnMemoryFootprint();
 
 void PrintData(unsigned int index);
 bool LoadFromCSV(std::string filePath);
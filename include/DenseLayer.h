@@ -21,8 +21,14 @@
 #define DENSELAYER_H
 
 #include <iostream> //printing functions
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <Eigen/Dense>
+#include <Eigen/SparseCore>
+#include "Profiler.h"
+#include "TransferFunctions.h"
 
 
 namespace neuroc{
@@ -34,58 +40,166 @@ class DenseLayer {
 
 public:
 
+typedef Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> IndexMatrix;
+
 DenseLayer(unsigned int inputSize, unsigned int outputSize,std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)>, std::function<Eigen::VectorXd(Eigen::VectorXd,Eigen::VectorXd)>, std::function<Eigen::VectorXd(Eigen::VectorXd)>, std::function<Eigen::VectorXd(Eigen::VectorXd)>);
 
 DenseLayer(const DenseLayer &rDenseLayer);
+DenseLayer(DenseLayer &&rDenseLayer) noexcept;
 
-DenseLayer operator=(const DenseLayer &rDenseLayer);
+DenseLayer& operator=(const DenseLayer &rDenseLayer);
+DenseLayer& operator=(DenseLayer &&rDenseLayer) noexcept;
 
 ~DenseLayer();
 
 
 
-Eigen::VectorXd Compute(Eigen::VectorXd inputVector);
-Eigen::VectorXd ComputeDerivative(Eigen::VectorXd inputVector);
+const Eigen::VectorXd& Compute(const Eigen::VectorXd& inputVector);
+const Eigen::VectorXd& ComputeDerivative(const Eigen::VectorXd& inputVector);
+const Eigen::VectorXd& ComputeWithDerivative(const Eigen::VectorXd& inputVector);
+void ComputeBatch(const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, Eigen::Ref<Eigen::MatrixXd> outputMatrix, Eigen::Ref<Eigen::MatrixXd> derivativeMatrix);
+void ComputeBatchMixed(const Eigen::Ref<const Eigen::MatrixXf>& inputMatrix, Eigen::Ref<Eigen::MatrixXd> outputMatrix, Eigen::Ref<Eigen::MatrixXd> derivativeMatrix, Eigen::Ref<Eigen::MatrixXf> floatOutputMatrix);
 
-bool SetInputVector(Eigen::VectorXd valueVector);
-Eigen::VectorXd GetInputVector();
+bool SetInputVector(const Eigen::Ref<const Eigen::VectorXd>& valueVector);
+const Eigen::VectorXd& GetInputVector();
 
-bool SetOutputVector(Eigen::VectorXd valueVector);
-Eigen::VectorXd GetOutputVector();
+bool SetOutputVector(const Eigen::Ref<const Eigen::VectorXd>& valueVector);
+const Eigen::VectorXd& GetOutputVector();
 
-bool SetBiasVector(Eigen::VectorXd biasVector);
-Eigen::VectorXd GetBiasVector();
+bool SetBiasVector(const Eigen::Ref<const Eigen::VectorXd>& biasVector);
+const Eigen::VectorXd& GetBiasVector();
 
-bool SetErrorVector(Eigen::VectorXd errorVector);
-Eigen::VectorXd GetErrorVector();
+bool SetErrorVector(const Eigen::Ref<const Eigen::VectorXd>& errorVector);
+const Eigen::VectorXd& GetErrorVector();
 
-bool SetDerivativeVector(Eigen::VectorXd errorVector);
-Eigen::VectorXd GetDerivativeVector();
+bool SetDerivativeVector(const Eigen::Ref<const Eigen::VectorXd>& derivativeVector);
+const Eigen::VectorXd& GetDerivativeVector();
 
 unsigned int ReturnNumberOfNeurons();
-
-bool SetWeightMatrix(Eigen::MatrixXd);
-Eigen::MatrixXd GetWeightMatrix();
+unsigned int ReturnNumberOfInputs();
+
+bool SetWeightMatrix(const Eigen::Ref<const Eigen::MatrixXd>& weightMatrix);
+const Eigen::MatrixXd& GetWeightMatrix();
+bool AddToWeightMatrix(const Eigen::Ref<const Eigen::MatrixXd>& deltaMatrix, double learningRate=1.0, double weightDecay=0.0, double clipValue=0.0);
+bool UpdateWeights(double learningRate, const Eigen::Ref<const Eigen::VectorXd>& errorVector, const Eigen::Ref<const Eigen::VectorXd>& inputVector, double weightDecay=0.0, double clipValue=0.0);
+bool UpdateWeightsBatch(double learningRate, const Eigen::Ref<const Eigen::MatrixXd>& errorMatrix, const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, double weightDecay=0.0);
+bool IsSharingWeights();
+
+bool SetBinarized(bool value);
+bool IsBinarized();
+const Eigen::MatrixXd& GetEffectiveWeightMatrix();
+
+bool Prune(double sparsity);
+bool SetSparse(bool value);
+bool IsSparse();
+double ReturnSparsity();
+const Eigen::SparseMatrix<double, Eigen::RowMajor>& GetSparseWeightMatrix();
+
+bool RemoveNeurons(const std::vector<unsigned int>& neurons);
+bool RemoveInputs(const std::vector<unsigned int>& inputs);
+
+bool SetFactorMatrices(const Eigen::MatrixXd& leftMatrix, const Eigen::MatrixXd& rightMatrix);
+void RemoveFactorMatrices();
+bool IsFactorized();
+unsigned int ReturnRank();
+const Eigen::MatrixXd& GetLeftFactorMatrix();
+const Eigen::MatrixXd& GetRightFactorMatrix();
+
+bool SetCodebook(const Eigen::VectorXd& centroidVector, const IndexMatrix& indexMatrix);
+void RemoveCodebook();
+bool IsClustered();
+const Eigen::VectorXd& GetCentroidVector();
+const IndexMatrix& GetIndexMatrix();
+
+bool SetMixedPrecision(bool value);
+bool IsMixedPrecision();
+const Eigen::MatrixXf& GetFloatWeightMatrix();
+bool UpdateMasterWeights(const Eigen::Ref<const Eigen::MatrixXf>& gradientMatrix, double gradientScale, double learningRate, double weightDecay=0.0, double clipValue=0.0);
+
+void ComputeInputError(const Eigen::Ref<const Eigen::MatrixXd>& errorMatrix, Eigen::Ref<Eigen::MatrixXd> inputErrorMatrix);
+void ComputeInputErrorMixed(const Eigen::Ref<const Eigen::MatrixXf>& errorMatrix, Eigen::Ref<Eigen::MatrixXf> inputErrorMatrix);
 
 bool SetTransferFunction(std::function<Eigen::VectorXd(Eigen::VectorXd)>);
 bool SetDerivativeFunction(std::function<Eigen::VectorXd(Eigen::VectorXd)>);
+const std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)>& GetWeightFunction();
+const std::function<Eigen::VectorXd(Eigen::VectorXd, Eigen::VectorXd)>& GetJoinFunction();
+const std::function<Eigen::VectorXd(Eigen::VectorXd)>& GetTransferFunction();
+const std::function<Eigen::VectorXd(Eigen::VectorXd)>& GetDerivativeFunction();
+
+std::size_t ReturnMemoryFootprint();
+
+const LayerProfile& GetProfile();
+void ResetProfile();
 
 void Print();
 
 
 
 private:
-Eigen::MatrixXd mWeightMatrix;
+void SelectKernels();
+void ComputeWeightedInput(const Eigen::VectorXd& inputVector, Eigen::VectorXd& outputVector);
+void JoinAndTransferBatch(Eigen::Ref<Eigen::MatrixXd> outputMatrix, Eigen::Ref<Eigen::MatrixXd> derivativeMatrix);
+Eigen::MatrixXd& ReturnWritableWeightMatrix();
+Eigen::VectorXd& ReturnWritableBiasVector();
+void BinarizeWeights(bool clip);
+void MaskWeights();
+const Eigen::MatrixXd& ReturnComputeWeightMatrix(){ return mBinarized ? mBinaryWeightMatrix : *mWeightMatrix; }
+std::size_t ReturnComputeWeightCount(){ return mFactorized ? mLeftFactorMatrix.size() + mRightFactorMatrix.size() : (mSparse ? mSparseWeightMatrix.nonZeros() : mWeightMatrix->size()); }
+void RefreshFactorizedWeights();
+template<typename DeltaFunction> void UpdateNonZeroWeights(double learningRate, double weightDecay, double clipValue, DeltaFunction delta);
+template<typename DeltaFunction> void UpdateCentroids(double learningRate, double weightDecay, double clipValue, DeltaFunction delta);
+void RefreshClusteredWeights();
+void RefreshFloatWeights();
+
+//The weights and the bias are shared between the copies of the layer
+//and they are duplicated by the first copy that writes them
+std::shared_ptr<Eigen::MatrixXd> mWeightMatrix;
+std::shared_ptr<Eigen::VectorXd> mBiasVector;
+//In the binarized mode the output is computed with alpha * sign(W)
+Eigen::MatrixXd mBinaryWeightMatrix;
+bool mBinarized;
+//In the sparse mode the output is computed with the non-zero weights only,
+//the pattern of the sparse matrix is the mask kept by the updates
+Eigen::SparseMatrix<double, Eigen::RowMajor> mSparseWeightMatrix;
+bool mSparse;
+//In the factorized mode the weight matrix is the product of the left
+//(output x rank) and right (rank x input) factors, the updates change
+//the factors and the weight matrix is computed again when it is read
+Eigen::MatrixXd mLeftFactorMatrix;
+Eigen::MatrixXd mRightFactorMatrix;
+Eigen::MatrixXd mFactorMatrix;
+Eigen::MatrixXd mFactorErrorMatrix;
+bool mFactorized;
+bool mFactorizedWeightsOutdated;
+//In the clustered mode every weight is the centroid of the codebook given
+//by its index, the updates change the centroids and the indices stay fixed
+Eigen::VectorXd mCentroidVector;
+Eigen::VectorXd mCentroidChangeVector;
+IndexMatrix mIndexMatrix;
+bool mClustered;
+//In the mixed precision mode the batch products use a single precision copy
+//of the weights, the weights of the layer are the double precision master
+Eigen::MatrixXf mFloatWeightMatrix;
+bool mMixedPrecision;
+bool mFloatWeightsOutdated;
 Eigen::VectorXd mInputVector;
 Eigen::VectorXd mOutputVector;
 Eigen::VectorXd mDerivativeVector;
-Eigen::VectorXd mBiasVector;
 Eigen::VectorXd mErrorVector;
 
 std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)> mWeightFunction;
 std::function<Eigen::VectorXd(Eigen::VectorXd)> mTransferFunction;
 std::function<Eigen::VectorXd(Eigen::VectorXd)> mDerivativeFunction;
 std::function<Eigen::VectorXd(Eigen::VectorXd, Eigen::VectorXd)> mJoinFunction;
+
+//Allocation free versions of the library functions assigned to the layer
+enum JoinKernel { JOIN_GENERIC, JOIN_SUM, JOIN_PRODUCT };
+bool mDotProductKernel;
+JoinKernel mJoinKernel;
+TransferFunctions::InPlace::Function mTransferKernel;
+TransferFunctions::InPlace::Function mDerivativeKernel;
+
+LayerProfile mProfile;
 };
 
 } //namespace
@@ -0,0 +1,166 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace neuroc{
+
+/**
+* \class Executor
+* \brief The thread pool shared by the parallel kernels of the library
+*
+* ParallelFor() splits a range, for example the rows of a weight matrix,
+* in blocks that are executed by the worker threads and by the calling
+* thread, which waits for them helping. Every worker has its own queue of
+* blocks: it takes the newest blocks of its queue and, when the queue is
+* empty, it steals the oldest blocks of the other queues. The work below
+* the threshold, and the work started from a block, runs serially in the
+* calling thread, so the library never uses more threads than the pool.
+* The blocks of a range depend only on its size and on the number of
+* threads, so the results are the same at every run. The workers are
+* started by the first parallel range and ParallelFor() does not allocate.
+* The pool is configured before the parallel work, SetNumberOfThreads()
+* and SetPinning() must not be called while a range is running.
+*/
+class Executor {
+
+public:
+
+typedef void (*RangeFunction)(const void* context, std::size_t begin, std::size_t end);
+
+static Executor& ReturnInstance();
+
+~Executor();
+
+void SetNumberOfThreads(unsigned int value);
+unsigned int GetNumberOfThreads();
+
+void SetPinning(bool value);
+bool GetPinning();
+
+void SetThreshold(std::size_t value);
+std::size_t GetThreshold();
+
+bool IsParallel(std::size_t work);
+
+/**
+* It calls function(blockBegin, blockEnd) on blocks covering [begin, end).
+* If the work is below the threshold it calls function(begin, end) in the
+* calling thread.
+*
+* @param begin first index of the range
+* @param end index past the last one
+* @param work the cost of the whole range, in multiply-adds
+* @param function callable taking the begin and the end of a block
+**/
+template<typename Function>
+void ParallelFor(std::size_t begin, std::size_t end, std::size_t work, const Function& function){
+ if(end <= begin) return;
+ if(end - begin <= kBlockAlignment || IsParallel(work) == false){
+  function(begin, end);
+  return;
+ }
+ Run(begin, end, &Invoke<Function>, &function);
+}
+
+unsigned long long ReturnNumberOfBlocks();
+unsigned long long ReturnNumberOfSteals();
+
+static const std::size_t kBlockAlignment = 8; //blocks start on a cache line of doubles
+
+private:
+Executor();
+Executor(const Executor&);
+Executor& operator=(const Executor&);
+
+/**
+* \struct Job
+* \brief A range given to ParallelFor(), it lives in the calling thread
+*/
+struct Job {
+ RangeFunction function;
+ const void* context;
+ std::atomic<std::size_t> pending;
+};
+
+/**
+* \struct Task
+* \brief A block of a job
+*/
+struct Task {
+ Job* job;
+ std::size_t begin;
+ std::size_t end;
+};
+
+static const std::size_t kQueueCapacity = 256;
+
+/**
+* \struct Worker
+* \brief A thread of the pool with its queue of blocks, a ring buffer
+*/
+struct Worker {
+ std::mutex mutex;
+ Task tasks[kQueueCapacity];
+ std::size_t head; //oldest block, taken by the thieves
+ std::size_t size;
+ std::thread thread;
+};
+
+template<typename Function>
+static void Invoke(const void* context, std::size_t begin, std::size_t end){
+ (*static_cast<const Function*>(context))(begin, end);
+}
+
+void Run(std::size_t begin, std::size_t end, RangeFunction function, const void* context);
+void Start();
+void Stop();
+void WorkerLoop(unsigned int index);
+bool Push(Worker& worker, const Task& task);
+bool PopNewest(Worker& worker, Task& task);
+bool PopOldest(Worker& worker, Task& task);
+bool Steal(unsigned int first, unsigned int self, Task& task);
+void Execute(const Task& task);
+
+std::vector<std::unique_ptr<Worker>> mWorkers;
+std::mutex mMutex; //it guards the start and the sleep of the workers
+std::condition_variable mCondition;
+std::atomic<bool> mStarted;
+std::atomic<std::size_t> mQueued;
+std::atomic<unsigned int> mNextWorker;
+std::atomic<unsigned long long> mBlocks;
+std::atomic<unsigned long long> mSteals;
+bool mStopping;
+unsigned int mThreads; //the calling thread is one of them
+bool mPinning;
+std::atomic<std::size_t> mThreshold;
+};
+
+} //namespace
+
+#endif // EXECUTOR_H
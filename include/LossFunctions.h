@@ -0,0 +1,59 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef LOSSFUNCTIONS_H
+#define LOSSFUNCTIONS_H
+
+#include <Eigen/Dense>
+
+namespace neuroc{
+
+/**
+ * \namespace LossFunctions
+ *
+ * It contains the losses minimized by the BackpropagationLearning.
+ * Every column of the matrices is a sample. A loss takes the output
+ * and the derivative of the output layer and the target, it writes
+ * the delta of the output layer, that is the opposite of the gradient
+ * of the loss with respect to the weighted input, and it returns the
+ * loss summed over the samples. The derivative is applied inside the
+ * loss, so the output layer does not need a separate Hadamard product.
+ */
+namespace LossFunctions{
+
+typedef double (*Function)(const Eigen::Ref<const Eigen::MatrixXd>& output,
+                           const Eigen::Ref<const Eigen::MatrixXd>& derivative,
+                           const Eigen::Ref<const Eigen::MatrixXd>& target,
+                           Eigen::Ref<Eigen::MatrixXd> delta);
+
+double MeanSquaredError(const Eigen::Ref<const Eigen::MatrixXd>&, const Eigen::Ref<const Eigen::MatrixXd>&,
+                        const Eigen::Ref<const Eigen::MatrixXd>&, Eigen::Ref<Eigen::MatrixXd>);
+double MeanAbsoluteError(const Eigen::Ref<const Eigen::MatrixXd>&, const Eigen::Ref<const Eigen::MatrixXd>&,
+                         const Eigen::Ref<const Eigen::MatrixXd>&, Eigen::Ref<Eigen::MatrixXd>);
+double Huber(const Eigen::Ref<const Eigen::MatrixXd>&, const Eigen::Ref<const Eigen::MatrixXd>&,
+             const Eigen::Ref<const Eigen::MatrixXd>&, Eigen::Ref<Eigen::MatrixXd>);
+double CrossEntropy(const Eigen::Ref<const Eigen::MatrixXd>&, const Eigen::Ref<const Eigen::MatrixXd>&,
+                    const Eigen::Ref<const Eigen::MatrixXd>&, Eigen::Ref<Eigen::MatrixXd>);
+double BinaryCrossEntropy(const Eigen::Ref<const Eigen::MatrixXd>&, const Eigen::Ref<const Eigen::MatrixXd>&,
+                          const Eigen::Ref<const Eigen::MatrixXd>&, Eigen::Ref<Eigen::MatrixXd>);
+
+}
+}
+
+#endif // LOSSFUNCTIONS_H
@@ -0,0 +1,67 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef LOWRANKFACTORIZATION_H
+#define LOWRANKFACTORIZATION_H
+
+#include <Eigen/Dense>
+#include "DenseLayer.h"
+#include "Network.h"
+#include "Dataset.h"
+
+namespace neuroc{
+
+/**
+* \class LowRankFactorization
+* \brief Compression of the weight matrices with the truncated SVD
+*
+* The weight matrix of a layer W = U S V' (Eigen::BDCSVD) is replaced by the
+* factors U sqrt(S) and sqrt(S) V' truncated to a rank r, and the layer
+* computes its output with two thinner products (DenseLayer::SetFactorMatrices()).
+* A layer is factorized only if r * (input + output) < input * output, that
+* is if the factors are smaller and faster than the weight matrix. The rank
+* of every layer is chosen from the fraction of the energy (sum of the
+* squared singular values) to keep, or as the smallest rank that keeps the
+* error of the network on a validation dataset within a budget.
+*/
+class LowRankFactorization {
+
+public:
+
+LowRankFactorization();
+~LowRankFactorization();
+
+bool FactorizeByEnergy(Network& net, double energy);
+bool FactorizeByError(Network& net, Dataset& inputDataset, Dataset& targetDataset, double errorBudget);
+
+static bool Factorize(DenseLayer& layer, unsigned int rank);
+static Eigen::VectorXd ReturnSingularValues(DenseLayer& layer);
+static unsigned int ReturnRankForEnergy(const Eigen::VectorXd& singularValues, double energy);
+static unsigned int ReturnMaximumRank(DenseLayer& layer);
+
+void Print(Network& net);
+
+private:
+
+static bool Factorize(DenseLayer& layer, const Eigen::BDCSVD<Eigen::MatrixXd>& svd, unsigned int rank);
+};
+
+} //namespace
+
+#endif // LOWRANKFACTORIZATION_H
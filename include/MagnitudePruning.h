@@ -0,0 +1,70 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef MAGNITUDEPRUNING_H
+#define MAGNITUDEPRUNING_H
+
+#include "Network.h"
+#include "Dataset.h"
+#include "BackpropagationLearning.h"
+
+namespace neuroc{
+
+/**
+* \class MagnitudePruning
+* \brief Magnitude pruning of a trained network with a sparsity schedule
+*
+* The weights with the smallest absolute value of every layer are set to
+* zero and the layers are moved to the sparse mode (DenseLayer::Prune()),
+* where the computation uses the non-zero weights only and the learning
+* does not change the pruned ones. The sparsity grows from the initial
+* to the final value following the cubic schedule of the gradual pruning:
+* s(t) = sf + (si - sf) * (1 - t / (steps - 1))^3
+* and the network is fine-tuned after every step.
+*/
+class MagnitudePruning {
+
+public:
+
+MagnitudePruning();
+~MagnitudePruning();
+
+bool SetSchedule(double initialSparsity, double finalSparsity, unsigned int steps);
+double ReturnScheduledSparsity(unsigned int step);
+unsigned int GetSteps();
+
+void SetPruneOutputLayer(bool value);
+bool IsPruningOutputLayer();
+
+bool Prune(Network& net, double sparsity);
+bool StartPruning(Network* net, BackpropagationLearning& learning, Dataset& inputDataset, Dataset& targetDataset, unsigned int cyclesPerStep, bool print=true);
+
+static double ReturnSparsity(Network& net);
+
+private:
+
+double mInitialSparsity;
+double mFinalSparsity;
+unsigned int mSteps;
+bool mPruneOutputLayer;
+};
+
+} //namespace
+
+#endif // MAGNITUDEPRUNING_H
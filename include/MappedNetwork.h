@@ -0,0 +1,88 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef MAPPEDNETWORK_H
+#define MAPPEDNETWORK_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#include "ModelFormat.h"
+#include "TransferFunctions.h"
+
+namespace neuroc{
+
+class Dataset;
+
+/**
+* \class MappedNetwork
+* \brief Inference on a model file mapped in memory
+*
+* The file written by Network::SaveAsBinary() is mapped in read-only mode
+* and the layers compute with Eigen::Map views of the weight blocks, so the
+* weights are never copied in the heap of the process. Opening a model costs
+* the check of the header, the pages are read by the kernel the first time
+* they are used and they are shared by all the processes that map the same
+* file. Only the layers with the DotProduct weight function, the Sum or
+* Product join function and a transfer function of the library can be
+* mapped; the binarized layers have to be computed by a Network or a
+* BinaryNetwork.
+*/
+class MappedNetwork {
+
+public:
+
+MappedNetwork();
+
+bool Open(const std::string& filePath, bool verifyChecksum=true);
+void Close();
+
+const Eigen::VectorXd& Compute(const Eigen::VectorXd& inputVector);
+double ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset);
+
+unsigned int Size();
+std::size_t ReturnMemoryFootprint();
+std::size_t ReturnMappedBytes();
+
+void Print();
+
+private:
+
+/**
+* \struct MappedLayer
+* \brief The views of the blocks of a layer in the mapped file
+*/
+struct MappedLayer {
+ unsigned int inputSize;
+ unsigned int outputSize;
+ const double* weights; //outputSize x inputSize, column major
+ const double* bias;
+ bool productJoin;
+ TransferFunctions::InPlace::Function transfer;
+ Eigen::VectorXd value;
+};
+
+ModelFormat::MappedFile mFile;
+std::vector<MappedLayer> mLayersVector;
+};
+
+} //namespace
+
+#endif // MAPPEDNETWORK_H
@@ -0,0 +1,86 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <cstddef>
+
+/**
+ *
+ * \brief Accounting of the heap allocations.
+ *
+ * The counters are updated by the allocation hooks, which are not part
+ * of the library. To enable the counting the object file
+ * bin/obj/AllocationHooks.o must be linked in the executable, it replaces
+ * malloc and free (and so the allocations of Eigen and of the standard
+ * containers) with versions that update the counters of the calling thread.
+ * Without the hooks all the counters stay at zero.
+ *
+*/
+
+namespace neuroc{
+
+/**
+ * \namespace MemoryStats
+ *
+ * It contains the allocation counters and the scope used to measure them
+ */
+namespace MemoryStats{
+
+/**
+* \struct AllocationCounters
+* \brief Heap activity of a thread
+*/
+struct AllocationCounters {
+ unsigned long long allocations;
+ unsigned long long deallocations;
+ unsigned long long allocatedBytes;
+ unsigned long long freedBytes;
+};
+
+bool IsCountingEnabled();
+void EnableCounting();
+
+void RecordAllocation(std::size_t bytes);
+void RecordDeallocation(std::size_t bytes);
+
+AllocationCounters GetThreadCounters();
+
+/**
+* \class AllocationScope
+* \brief It measures the allocations made by the current thread
+* from its construction.
+*/
+class AllocationScope {
+public:
+ AllocationScope();
+ void Restart();
+ AllocationCounters Elapsed() const;
+ unsigned long long Allocations() const;
+ unsigned long long AllocatedBytes() const;
+private:
+ AllocationCounters mStart;
+};
+
+} //namespace
+
+} //namespace
+
+#endif // MEMORYSTATS_H
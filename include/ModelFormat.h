@@ -0,0 +1,153 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef MODELFORMAT_H
+#define MODELFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <Eigen/Dense>
+
+namespace neuroc{
+
+class DenseLayer;
+
+/**
+ * \namespace ModelFormat
+ *
+ * It contains the description of the binary model files written by
+ * Network::SaveAsBinary(). A file starts with a FileHeader, followed by
+ * one LayerRecord for every layer and by the weight and bias blocks of
+ * the layers. The blocks are aligned to 64 bytes and they store doubles in
+ * column major order, so a mapped file can be read with Eigen::Map without
+ * copying. The functions of a layer are stored as the index of the function
+ * in the namespaces of the library, custom functions cannot be saved.
+ * The checksum covers everything after the header.
+ *
+ * Layout of version 1 (native byte order, checked with the byteOrder field):
+ * [FileHeader 64 bytes][LayerRecord 64 bytes x layers][weights][bias]...[extra block]
+ */
+namespace ModelFormat{
+
+const uint32_t kVersion = 1;
+const uint32_t kByteOrder = 0x01020304;
+const std::size_t kAlignment = 64;
+const char kMagic[8] = {'N', 'E', 'U', 'R', 'O', 'C', 'N', 'N'};
+
+enum DataType : uint32_t { FLOAT64 = 1 };
+enum LayerMode : uint32_t { DENSE = 0, BINARIZED = 1, SPARSE = 2 };
+
+/**
+* \struct FileHeader
+* \brief The first 64 bytes of a model file
+*/
+struct FileHeader {
+ char magic[8];
+ uint32_t version;
+ uint32_t headerSize; //bytes of the header
+ uint32_t dataType;
+ uint32_t numberOfLayers;
+ uint32_t byteOrder; //kByteOrder as written by the machine that saved the file
+ uint32_t alignment; //alignment of the blocks in bytes
+ uint64_t fileSize;
+ uint64_t checksum; //checksum of the bytes after the header
+ uint64_t extraOffset; //optional block stored after the layers, for example
+ uint64_t extraSize; //the training state of a checkpoint, the size is 0 if missing
+};
+
+/**
+* \struct LayerRecord
+* \brief Topology, functions and position of the blocks of a layer
+*/
+struct LayerRecord {
+ uint32_t inputSize;
+ uint32_t outputSize;
+ uint32_t weightFunction; //index in WeightFunctions
+ uint32_t joinFunction; //index in JoinFunctions
+ uint32_t transferFunction; //index in TransferFunctions
+ uint32_t derivativeFunction; //index in TransferFunctions
+ uint32_t mode; //LayerMode
+ uint32_t reserved0;
+ uint64_t weightOffset; //outputSize x inputSize doubles, column major
+ uint64_t biasOffset; //outputSize doubles
+ uint8_t reserved[16];
+};
+
+static_assert(sizeof(FileHeader) == 64, "ModelFormat: the header must take 64 bytes");
+static_assert(sizeof(LayerRecord) == 64, "ModelFormat: the layer record must take 64 bytes");
+
+/**
+* \class Checksum
+* \brief 64-bit FNV-1a over the 8-byte words, in four interleaved lanes
+*
+* The lanes remove the dependency between consecutive words, so the
+* checksum of a large model is computed at the speed of the memory.
+* The words can be given in several calls.
+*/
+class Checksum {
+public:
+ Checksum();
+ void Update(const uint64_t* words, std::size_t numberOfWords);
+ uint64_t Return() const;
+private:
+ uint64_t mLanes[4];
+ uint64_t mWords;
+};
+
+/**
+* \class MappedFile
+* \brief Read-only memory mapping of a file
+*
+* The pages are shared with the other processes that map the same file
+* and they are loaded by the kernel when they are read.
+*/
+class MappedFile {
+public:
+ MappedFile();
+ MappedFile(MappedFile&& rMappedFile) noexcept;
+ MappedFile& operator=(MappedFile&& rMappedFile) noexcept;
+ MappedFile(const MappedFile&) = delete;
+ MappedFile& operator=(const MappedFile&) = delete;
+ ~MappedFile();
+ bool Open(const std::string& filePath);
+ void Close();
+ const char* GetData() const { return mData; }
+ std::size_t Size() const { return mSize; }
+private:
+ const char* mData;
+ std::size_t mSize;
+};
+
+bool ReturnFunctionIds(DenseLayer& layer, LayerRecord& record);
+std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)> ReturnWeightFunction(uint32_t id);
+std::function<Eigen::VectorXd(Eigen::VectorXd, Eigen::VectorXd)> ReturnJoinFunction(uint32_t id);
+std::function<Eigen::VectorXd(Eigen::VectorXd)> ReturnTransferFunction(uint32_t id);
+
+bool CheckFile(const char* data, std::size_t size, bool verifyChecksum);
+const LayerRecord* ReturnLayerRecords(const char* data);
+const double* ReturnBlock(const char* data, uint64_t offset);
+std::string ReturnExtraBlock(const char* data);
+
+} //namespace ModelFormat
+
+} //namespace neuroc
+
+#endif // MODELFORMAT_H
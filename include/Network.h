@@ -22,7 +22,11 @@
 
 #include "DenseLayer.h"
 #include "Dataset.h"
+#include "Profiler.h"
 #include <iostream> //printing functions
+#include <string>
+#include <vector>
+#include <utility>
 #include <Eigen/Dense>
 
 using namespace std;
@@ -44,27 +48,60 @@ Network();
 
 Network(const Network &rNetwork);
 
+Network(Network &&rNetwork) noexcept;
+
 Network(std::initializer_list<DenseLayer> layersList);
 
 ~Network();
 
-Network operator=(const Network &rNetwork);
+Network& operator=(const Network &rNetwork);
+
+Network& operator=(Network &&rNetwork) noexcept;
 
 DenseLayer& operator[](unsigned int index);
 
 
 unsigned int Size();
 
-Eigen::VectorXd Compute(Eigen::VectorXd InputVector);
-Eigen::VectorXd ComputeDerivative(Eigen::VectorXd InputVector);
-double ComputeMeanSquaredError(neuroc::Dataset, neuroc::Dataset);
+void AddLayer(const DenseLayer& layer);
+void AddLayer(DenseLayer&& layer);
+
+/**
+* It constructs a layer at the end of the network, the arguments are the
+* ones of the DenseLayer constructor. The layer is not copied.
+*
+* @return it returns a reference to the new layer
+**/
+template<typename... Args>
+DenseLayer& EmplaceLayer(Args&&... args){
+ mLayersVector.emplace_back(std::forward<Args>(args)...);
+ return mLayersVector.back();
+}
+
+void ReserveLayers(unsigned int numberOfLayers);
 
-double Test(neuroc::Dataset, neuroc::Dataset);
+bool RemoveNeurons(unsigned int layerIndex, const std::vector<unsigned int>& neurons);
+
+const Eigen::VectorXd& Compute(const Eigen::VectorXd& InputVector);
+const Eigen::VectorXd& ComputeDerivative(const Eigen::VectorXd& InputVector);
+double ComputeMeanSquaredError(neuroc::Dataset& inputDataset, neuroc::Dataset& targetDataset);
+
+double Test(neuroc::Dataset& inputDataset, neuroc::Dataset& targetDataset);
 
 int ReturnNumberOfLayers();
 
 unsigned int ReturnNumberOfNeurons();
 
+std::size_t ReturnMemoryFootprint();
+
+bool SaveAsBinary(const std::string& filePath, const std::string& extraBlock = std::string());
+bool LoadFromBinary(const std::string& filePath);
+
+bool ExportCpp(const std::string& path, const std::string& modelName = "neuroc_model");
+
+NetworkProfile GetProfile();
+void ResetProfile();
+
 void Print();
 
 
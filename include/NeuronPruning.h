@@ -0,0 +1,82 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef NEURONPRUNING_H
+#define NEURONPRUNING_H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "Network.h"
+#include "Dataset.h"
+#include "BackpropagationLearning.h"
+
+namespace neuroc{
+
+/**
+* \class NeuronPruning
+* \brief Structured pruning that removes whole neurons from a network
+*
+* Every neuron of the hidden layers receives a score, the neurons with
+* the lowest scores are removed with their row of the weight matrix, their
+* bias and the matching column of the next layer (Network::RemoveNeurons()).
+* The result is a smaller dense network, faster with any kernel. The mean
+* output of a removed neuron on the calibration dataset can be added to
+* the bias of the next layer, when its join function is the Sum.
+*/
+class NeuronPruning {
+
+public:
+
+/**
+* The score of a neuron: the norm of its incoming weights multiplied by
+* the norm of its outgoing weights, or the variance of its output on the
+* calibration dataset.
+*/
+enum Score { WEIGHT_NORM, ACTIVATION_VARIANCE };
+
+NeuronPruning();
+~NeuronPruning();
+
+void SetScore(Score score);
+Score GetScore();
+
+void SetBiasCompensation(bool value);
+bool IsCompensatingBias();
+
+Eigen::VectorXd ReturnScores(Network& net, unsigned int layerIndex, Dataset& calibrationDataset);
+bool Prune(Network& net, double fraction, Dataset& calibrationDataset);
+bool StartPruning(Network* net, BackpropagationLearning& learning, double fraction, Dataset& inputDataset, Dataset& targetDataset, unsigned int cycles, bool print=true);
+
+static std::size_t ReturnNumberOfParameters(Network& net);
+
+private:
+
+void ComputeStatistics(Network& net, Dataset& calibrationDataset);
+Eigen::VectorXd ReturnScores(Network& net, unsigned int layerIndex);
+
+Score mScore;
+bool mBiasCompensation;
+//Mean and variance of the output of every layer on the calibration dataset
+std::vector<Eigen::VectorXd> mMeanVectors;
+std::vector<Eigen::VectorXd> mVarianceVectors;
+};
+
+} //namespace
+
+#endif // NEURONPRUNING_H
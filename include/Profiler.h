@@ -0,0 +1,124 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+/**
+ *
+ * \brief Opt-in profiling counters for the hot paths of the library.
+ *
+ * The counters are recorded only if the library is compiled with the
+ * NEUROC_PROFILE macro defined (make compile PROFILE=1), otherwise the
+ * recording macros are empty and the instrumentation has no cost.
+ * The data structures are always defined, so the library and the user
+ * code can be compiled with different settings.
+ *
+*/
+
+namespace neuroc{
+
+/**
+* \struct LayerProfile
+* \brief Counters collected by a single DenseLayer
+*/
+struct LayerProfile {
+ unsigned long long calls = 0; //calls of Compute()
+ unsigned long long derivativeCalls = 0; //calls of ComputeDerivative()
+ unsigned long long weightNs = 0; //time spent in the weight function
+ unsigned long long joinNs = 0; //time spent in the join function
+ unsigned long long transferNs = 0; //time spent in the transfer function
+ unsigned long long derivativeNs = 0; //time spent in the derivative function
+ unsigned long long flops = 0; //floating point operations
+ unsigned long long bytes = 0; //bytes of weights, bias and vectors touched
+};
+
+/**
+* \struct PhaseProfile
+* \brief Time spent in the phases of the learning algorithm
+*/
+struct PhaseProfile {
+ unsigned long long steps = 0; //learning steps
+ unsigned long long forwardNs = 0;
+ unsigned long long backpropNs = 0;
+ unsigned long long updateNs = 0;
+};
+
+/**
+* \struct NetworkProfile
+* \brief Snapshot of the counters of a Network
+*/
+struct NetworkProfile {
+ std::vector<LayerProfile> layers;
+ PhaseProfile phases;
+
+ std::string ToJSON() const;
+ bool SaveAsJSON(std::string filePath) const;
+ void Print() const;
+};
+
+/**
+ * \namespace Profiler
+ *
+ * It contains the clock and the thread-local accumulators used for the
+ * learning phases. Every thread writes only its own accumulator, the
+ * values are summed when they are read.
+ */
+namespace Profiler{
+
+/**
+* It returns true if the library was compiled with NEUROC_PROFILE
+*
+**/
+bool IsEnabled();
+
+/**
+* Monotonic clock in nanoseconds
+*
+**/
+inline unsigned long long Now(){
+ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AddPhaseTimes(unsigned long long forwardNs, unsigned long long backpropNs, unsigned long long updateNs);
+PhaseProfile GetPhaseProfile();
+void ResetPhaseProfile();
+
+} //namespace
+
+} //namespace
+
+
+#ifdef NEUROC_PROFILE
+#define NEUROC_PROFILE_START(timer) unsigned long long timer = neuroc::Profiler::Now()
+#define NEUROC_PROFILE_LAP(timer, accumulator) { unsigned long long profile_now = neuroc::Profiler::Now(); (accumulator) += profile_now - timer; timer = profile_now; }
+#define NEUROC_PROFILE_COUNT(accumulator, value) (accumulator) += (value)
+#define NEUROC_PROFILE_PHASES(start, forward, backprop, update) neuroc::Profiler::AddPhaseTimes((forward)-(start), (backprop)-(forward), (update)-(backprop))
+#else
+#define NEUROC_PROFILE_START(timer)
+#define NEUROC_PROFILE_LAP(timer, accumulator)
+#define NEUROC_PROFILE_COUNT(accumulator, value)
+#define NEUROC_PROFILE_PHASES(start, forward, backprop, update)
+#endif
+
+#endif // PROFILER_H
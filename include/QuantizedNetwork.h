@@ -0,0 +1,98 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef QUANTIZEDNETWORK_H
+#define QUANTIZEDNETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace neuroc{
+
+class Network;
+class Dataset;
+class DenseLayer;
+
+/**
+* \class QuantizedNetwork
+* \brief Int8 copy of a trained network for the inference
+*
+* The weights of every layer are stored as int8 with a scale and a zero
+* point for each neuron (per-channel), the inputs of every layer as int8
+* with a scale and a zero point measured on a calibration dataset.
+* The dot products accumulate in int32, using AVX2 when the processor
+* supports it, and the bias, the transfer function and the quantization
+* of the next layer input are applied in a single pass on the results.
+* Only the layers using the DotProduct weight function and the Sum or
+* Product join functions of the library can be quantized.
+*/
+class QuantizedNetwork {
+
+public:
+
+QuantizedNetwork();
+
+bool Quantize(Network& net, Dataset& calibrationDataset);
+
+const Eigen::VectorXd& Compute(const Eigen::VectorXd& inputVector);
+double ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset);
+
+unsigned int Size();
+std::size_t ReturnMemoryFootprint();
+static bool IsUsingSIMD();
+
+void Print();
+
+private:
+
+enum Transfer { LINEAR, POSITIVE_LINEAR, SATURATED_LINEAR, SIGMOID, FAST_SIGMOID, SIGMOID_DERIVATIVE,
+                TANH, TANH_DERIVATIVE, RADIAL_BASIS, MULTI_QUADRATIC, HARD_LIMIT };
+
+/**
+* \struct QuantizedLayer
+* \brief The int8 weights of a layer with their quantization parameters
+*/
+struct QuantizedLayer {
+ unsigned int inputSize;
+ unsigned int outputSize;
+ unsigned int stride; //row length padded to the SIMD width
+ std::vector<int8_t> weights; //row major, outputSize x stride
+ std::vector<double> weightScale;
+ std::vector<int32_t> weightZeroPoint;
+ std::vector<int32_t> offset; //inputSize * zw * zx - zx * sum(qw) for every row
+ std::vector<double> outputScale; //weightScale * inputScale
+ Eigen::VectorXd bias;
+ bool productJoin;
+ Transfer transfer;
+ double inputScale;
+ int32_t inputZeroPoint;
+ std::vector<int8_t> inputBuffer; //quantized input, stride values
+};
+
+static bool ReturnTransfer(DenseLayer& layer, Transfer& transfer);
+
+std::vector<QuantizedLayer> mLayersVector;
+Eigen::VectorXd mOutputVector;
+};
+
+} //namespace
+
+#endif // QUANTIZEDNETWORK_H
@@ -0,0 +1,96 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef SAMPLEORDER_H
+#define SAMPLEORDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace neuroc{
+
+/**
+* \class SampleOrder
+* \brief The order in which a training visits the samples of an epoch
+*
+* In the file order the position is the index of the sample. In the shuffle
+* order every epoch is a permutation of the indices, drawn with a generator
+* seeded by the seed and the epoch, so that the permutation of an epoch can
+* be computed again by a loader thread or after a resume, and the dataset
+* is never copied. In the importance sampling order the first epoch is
+* shuffled, then every epoch draws the samples with replacement with a
+* probability proportional to the last loss of the sample, mixed with the
+* uniform probability, and every sample has a weight 1/(N p) that corrects
+* the bias of the gradient when it multiplies the learning rate.
+*/
+class SampleOrder {
+
+public:
+
+enum Mode { FILE_ORDER = 0, SHUFFLE = 1, IMPORTANCE_SAMPLING = 2 };
+
+SampleOrder();
+
+void SetFileOrder();
+void SetShuffle(uint64_t seed);
+void SetImportanceSampling(uint64_t seed, double uniformMix=0.5);
+
+Mode GetMode() const;
+uint64_t GetSeed() const;
+double GetUniformMix() const;
+
+void Reset();
+void Prepare(unsigned int epoch, unsigned int datasetSize);
+
+/**
+* It returns the index of the sample visited at the position of the prepared epoch
+**/
+unsigned int ReturnIndex(unsigned int position) const { return mIndices.empty() ? position : mIndices[position]; }
+
+/**
+* It returns the weight of the sample visited at the position of the prepared epoch
+**/
+double ReturnWeight(unsigned int position) const { return mWeights.empty() ? 1.0 : mWeights[position]; }
+
+void UpdateLoss(unsigned int index, double loss);
+
+std::string Serialize() const;
+bool Deserialize(const char* data, std::size_t size);
+
+private:
+
+uint64_t ReturnEpochSeed(unsigned int epoch) const;
+void Shuffle(unsigned int epoch, unsigned int datasetSize);
+
+Mode mMode;
+uint64_t mSeed;
+double mUniformMix;
+bool mPrepared;
+unsigned int mPreparedEpoch;
+std::vector<unsigned int> mIndices; //empty in the file order
+std::vector<double> mWeights; //empty if all the weights are one
+std::vector<double> mLosses; //last loss of every sample, importance sampling only
+std::vector<double> mCumulative; //cumulative probabilities, importance sampling only
+unsigned int mVisited; //samples with a loss, importance sampling only
+};
+
+} //namespace
+
+#endif // SAMPLEORDER_H
@@ -0,0 +1,108 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace neuroc{
+
+/**
+* \class SpscQueue
+* \brief Bounded lock-free queue for one producer thread and one consumer thread
+*
+* The elements are stored in a ring allocated by the constructor, Push()
+* and Pop() never allocate and never wait, they return false when the queue
+* is full or empty. The head is written only by the consumer and the tail
+* only by the producer, and every side keeps a copy of the other index so
+* that it reads the shared one only when the queue looks full or empty.
+* The data of the two sides is kept on different cache lines by padding,
+* because C++11 cannot allocate over-aligned types with new.
+*/
+template<typename T>
+class SpscQueue {
+
+public:
+
+/**
+* Class constructor
+*
+* @param capacity the maximum number of elements in the queue
+**/
+explicit SpscQueue(std::size_t capacity) : mRing(capacity + 1), mHead(0), mCachedTail(0), mTail(0), mCachedHead(0) {}
+
+/**
+* It adds an element, it must be called by the producer thread only
+*
+* @return it returns false if the queue is full
+**/
+bool Push(const T& element){
+ const std::size_t tail = mTail.load(std::memory_order_relaxed);
+ const std::size_t next = Next(tail);
+ if(next == mCachedHead){
+  mCachedHead = mHead.load(std::memory_order_acquire);
+  if(next == mCachedHead) return false;
+ }
+ mRing[tail] = element;
+ mTail.store(next, std::memory_order_release);
+ return true;
+}
+
+/**
+* It removes the oldest element, it must be called by the consumer thread only
+*
+* @return it returns false if the queue is empty
+**/
+bool Pop(T& element){
+ const std::size_t head = mHead.load(std::memory_order_relaxed);
+ if(head == mCachedTail){
+  mCachedTail = mTail.load(std::memory_order_acquire);
+  if(head == mCachedTail) return false;
+ }
+ element = mRing[head];
+ mHead.store(Next(head), std::memory_order_release);
+ return true;
+}
+
+std::size_t Capacity() const { return mRing.size() - 1; }
+
+private:
+SpscQueue(const SpscQueue&);
+SpscQueue& operator=(const SpscQueue&);
+
+std::size_t Next(std::size_t index) const { return (index + 1 == mRing.size()) ? 0 : index + 1; }
+
+static const std::size_t kCacheLine = 64;
+
+std::vector<T> mRing;
+char mPadding0[kCacheLine];
+std::atomic<std::size_t> mHead; //next element to pop, written by the consumer
+std::size_t mCachedTail; //copy of the tail, used by the consumer
+char mPadding1[kCacheLine];
+std::atomic<std::size_t> mTail; //next free place, written by the producer
+std::size_t mCachedHead; //copy of the head, used by the producer
+char mPadding2[kCacheLine];
+};
+
+} //namespace
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,319 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef STATICNETWORK_H
+#define STATICNETWORK_H
+
+#include <cstddef>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <Eigen/Dense>
+#include "DenseLayer.h"
+#include "Network.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include "TransferFunctions.h"
+
+namespace neuroc{
+
+/**
+* The transfer functions of the static layers. Every type applies the
+* same expression of the in place function of the library, written in
+* the header so that it is inlined and unrolled on the fixed-size vectors.
+* Function() returns the in place function used to check the layers of
+* the dynamic network.
+*/
+namespace Activations{
+
+struct Linear {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::Linear; }
+ template<typename Vector> static void Apply(Vector&){}
+};
+
+struct PositiveLinear {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::PositiveLinear; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = vector.cwiseAbs(); }
+};
+
+struct SaturatedLinear {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::SaturatedLinear; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = vector.cwiseMin(1.0).cwiseMax(-1.0); }
+};
+
+struct Sigmoid {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::Sigmoid; }
+ template<typename Vector> static void Apply(Vector& vector){
+  vector = (1.0 + (-vector.array()).exp()).inverse().matrix();
+  vector = vector.array().isNaN().select(0.0, vector.array()).matrix(); //protection against large negative number
+ }
+};
+
+struct FastSigmoid {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::FastSigmoid; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = (vector.array() / (1.0 + vector.array().abs())).matrix(); }
+};
+
+struct Tanh {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::Tanh; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = vector.array().tanh().matrix(); }
+};
+
+struct RadialBasis {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::RadialBasis; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = (-vector.array().square()).exp().matrix(); }
+};
+
+struct MultiQuadratic {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::MultiQuadratic; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = (1.0 + vector.array().square()).sqrt().matrix(); }
+};
+
+struct HardLimit {
+ static TransferFunctions::InPlace::Function Function(){ return &TransferFunctions::InPlace::HardLimit; }
+ template<typename Vector> static void Apply(Vector& vector){ vector = (vector.array() > 0.0).template cast<double>().matrix(); }
+};
+
+} //namespace Activations
+
+/**
+* \class StaticDenseLayer
+* \brief Layer whose dimensions and transfer function are fixed at compile time
+*
+* The weights, the bias and the output are fixed-size Eigen objects stored
+* inside the layer, so the layer does not allocate memory and the compiler
+* can unroll the product for the small layers. The layer computes
+* Activation(W*x + b), as a DenseLayer with the DotProduct weight function
+* and the Sum join function. It is used for the inference, the weights are
+* trained in a DenseLayer and copied with LoadFrom().
+*/
+template<int In, int Out, typename Activation>
+class StaticDenseLayer {
+
+public:
+
+static const int InputSize = In;
+static const int OutputSize = Out;
+typedef Eigen::Matrix<double, In, 1> InputVector;
+typedef Eigen::Matrix<double, Out, 1> OutputVector;
+typedef Eigen::Matrix<double, Out, In> WeightMatrix;
+typedef Activation ActivationType;
+
+static_assert(In > 0 && Out > 0, "StaticDenseLayer: the dimensions must be positive");
+
+EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+StaticDenseLayer() : mWeightMatrix(WeightMatrix::Zero()), mBiasVector(OutputVector::Zero()) {}
+
+/**
+* It computes the output of the layer in the vector given by the caller
+*
+**/
+inline void Compute(const InputVector& inputVector, OutputVector& outputVector) const {
+ outputVector.noalias() = mWeightMatrix * inputVector;
+ outputVector += mBiasVector;
+ Activation::Apply(outputVector);
+}
+
+/**
+* It copies the weights and the bias of a DenseLayer. The effective weights
+* are copied, so the layers in the binarized, sparse, factorized and clustered
+* modes can be loaded too.
+*
+* @param layer a layer with the same dimensions and the same functions
+* @return it returns true if it is all right, otherwise false
+**/
+bool LoadFrom(DenseLayer& layer){
+ typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+ if(layer.ReturnNumberOfInputs() != (unsigned int) In || layer.ReturnNumberOfNeurons() != (unsigned int) Out){
+  std::cerr << "Neuroc Error: StaticDenseLayer<" << In << ", " << Out << "> cannot load a layer of " << layer.ReturnNumberOfInputs()
+            << " inputs and " << layer.ReturnNumberOfNeurons() << " neurons" << std::endl;
+  return false;
+ }
+ const WeightFunction* weight_target = layer.GetWeightFunction().target<WeightFunction>();
+ const JoinFunction* join_target = layer.GetJoinFunction().target<JoinFunction>();
+ if(weight_target == nullptr || *weight_target != &WeightFunctions::DotProduct || join_target == nullptr || *join_target != &JoinFunctions::Sum ||
+    TransferFunctions::InPlace::ReturnFunction(layer.GetTransferFunction()) != Activation::Function()){
+  std::cerr << "Neuroc Error: StaticDenseLayer the functions of the layer are not the ones of the static layer" << std::endl;
+  return false;
+ }
+ mWeightMatrix = layer.GetEffectiveWeightMatrix();
+ mBiasVector = layer.GetBiasVector();
+ return true;
+}
+
+/**
+* It copies the weights and the bias in a DenseLayer with the same dimensions
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool SaveTo(DenseLayer& layer) const {
+ if(layer.ReturnNumberOfInputs() != (unsigned int) In || layer.ReturnNumberOfNeurons() != (unsigned int) Out){
+  std::cerr << "Neuroc Error: StaticDenseLayer<" << In << ", " << Out << "> cannot be saved in a layer of " << layer.ReturnNumberOfInputs()
+            << " inputs and " << layer.ReturnNumberOfNeurons() << " neurons" << std::endl;
+  return false;
+ }
+ return layer.SetWeightMatrix(mWeightMatrix) && layer.SetBiasVector(mBiasVector);
+}
+
+const WeightMatrix& GetWeightMatrix() const { return mWeightMatrix; }
+void SetWeightMatrix(const WeightMatrix& weightMatrix){ mWeightMatrix = weightMatrix; }
+const OutputVector& GetBiasVector() const { return mBiasVector; }
+void SetBiasVector(const OutputVector& biasVector){ mBiasVector = biasVector; }
+
+private:
+WeightMatrix mWeightMatrix;
+OutputVector mBiasVector;
+};
+
+namespace StaticDetail{
+
+/**
+* It is true if the output of every layer has the size of the input of the next one
+*/
+template<typename... Layers>
+struct Chained : std::true_type {};
+
+template<typename First, typename Second, typename... Others>
+struct Chained<First, Second, Others...> : std::integral_constant<bool, First::OutputSize == Second::InputSize && Chained<Second, Others...>::value> {};
+
+template<typename... Layers>
+struct Last;
+
+template<typename Layer>
+struct Last<Layer> { typedef Layer type; };
+
+template<typename First, typename... Others>
+struct Last<First, Others...> { typedef typename Last<Others...>::type type; };
+
+template<std::size_t Index>
+using Position = std::integral_constant<std::size_t, Index>;
+
+} //namespace StaticDetail
+
+/**
+* \class StaticNetwork
+* \brief Network of static layers whose topology is checked at compile time
+*
+* The layers are given as template arguments, and a static_assert checks
+* that the output of every layer fits the input of the next one. The layers
+* and their outputs are stored in std::tuple members, so Compute() does not
+* allocate memory and does not call through std::function or pointers. The
+* weights are loaded from a trained Network with the same topology and can
+* be saved back in it.
+*
+* Example:
+* neuroc::StaticNetwork<neuroc::StaticDenseLayer<16, 10, neuroc::Activations::Sigmoid>,
+*                       neuroc::StaticDenseLayer<10, 1, neuroc::Activations::Sigmoid>> static_net;
+* static_net.Load(net);
+* double output = static_net.Compute(input_vector)[0];
+*/
+template<typename... Layers>
+class StaticNetwork {
+
+static_assert(sizeof...(Layers) > 0, "StaticNetwork: the network needs at least one layer");
+static_assert(StaticDetail::Chained<Layers...>::value, "StaticNetwork: the output of a layer does not fit the input of the next one");
+
+typedef typename std::tuple_element<0, std::tuple<Layers...> >::type FirstLayer;
+typedef typename StaticDetail::Last<Layers...>::type LastLayer;
+
+public:
+
+static const std::size_t NumberOfLayers = sizeof...(Layers);
+typedef typename FirstLayer::InputVector InputVector;
+typedef typename LastLayer::OutputVector OutputVector;
+
+EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+/**
+* It computes all the layers, the output of each layer is the input of the next one
+*
+* @return it returns a reference to the output of the last layer
+**/
+inline const OutputVector& Compute(const InputVector& inputVector){
+ std::get<0>(mLayers).Compute(inputVector, std::get<0>(mOutputs));
+ ComputeFrom(StaticDetail::Position<1>());
+ return std::get<NumberOfLayers-1>(mOutputs);
+}
+
+/**
+* It copies the weights of a Network with the same topology
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool Load(Network& net){
+ if(net.Size() != NumberOfLayers){
+  std::cerr << "Neuroc Error: StaticNetwork of " << NumberOfLayers << " layers cannot load a network of " << net.Size() << " layers" << std::endl;
+  return false;
+ }
+ return LoadFrom(net, StaticDetail::Position<0>());
+}
+
+/**
+* It copies the weights in a Network with the same topology
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool Save(Network& net) const {
+ if(net.Size() != NumberOfLayers){
+  std::cerr << "Neuroc Error: StaticNetwork of " << NumberOfLayers << " layers cannot be saved in a network of " << net.Size() << " layers" << std::endl;
+  return false;
+ }
+ return SaveTo(net, StaticDetail::Position<0>());
+}
+
+template<std::size_t Index>
+typename std::tuple_element<Index, std::tuple<Layers...> >::type& GetLayer(){ return std::get<Index>(mLayers); }
+
+std::size_t Size() const { return NumberOfLayers; }
+
+private:
+
+template<std::size_t Index>
+inline void ComputeFrom(StaticDetail::Position<Index>){
+ std::get<Index>(mLayers).Compute(std::get<Index-1>(mOutputs), std::get<Index>(mOutputs));
+ ComputeFrom(StaticDetail::Position<Index+1>());
+}
+inline void ComputeFrom(StaticDetail::Position<NumberOfLayers>){}
+
+template<std::size_t Index>
+bool LoadFrom(Network& net, StaticDetail::Position<Index>){
+ if(std::get<Index>(mLayers).LoadFrom(net[Index]) == false){
+  std::cerr << "Neuroc Error: StaticNetwork cannot load the layer " << Index << std::endl;
+  return false;
+ }
+ return LoadFrom(net, StaticDetail::Position<Index+1>());
+}
+bool LoadFrom(Network&, StaticDetail::Position<NumberOfLayers>){ return true; }
+
+template<std::size_t Index>
+bool SaveTo(Network& net, StaticDetail::Position<Index>) const {
+ if(std::get<Index>(mLayers).SaveTo(net[Index]) == false) return false;
+ return SaveTo(net, StaticDetail::Position<Index+1>());
+}
+bool SaveTo(Network&, StaticDetail::Position<NumberOfLayers>) const { return true; }
+
+std::tuple<Layers...> mLayers;
+std::tuple<typename Layers::OutputVector...> mOutputs;
+};
+
+} //namespace
+
+#endif // STATICNETWORK_H
@@ -0,0 +1,98 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <atomic>
+#include "Profiler.h"
+
+/**
+ *
+ * \brief Timeline tracing of training and inference.
+ *
+ * The spans are recorded in a ring buffer owned by each thread, the
+ * owner is the only writer so no lock is taken on the hot path. When
+ * the buffer is full the oldest spans are overwritten. The timeline is
+ * exported in the Chrome trace format, it can be opened with
+ * chrome://tracing or https://ui.perfetto.dev
+ *
+ * The tracing is disabled by default, in this case a span costs a
+ * single load of the enabled flag and a predictable branch.
+ *
+*/
+
+namespace neuroc{
+
+/**
+ * \namespace Trace
+ *
+ * It contains the functions for starting, stopping and exporting the trace
+ */
+namespace Trace{
+
+extern std::atomic<bool> gEnabled;
+
+inline bool IsEnabled(){
+ return gEnabled.load(std::memory_order_relaxed);
+}
+
+void Enable();
+void Disable();
+void Clear();
+void SetBufferSize(unsigned int eventsPerThread);
+
+void Record(const char* name, unsigned long long startNs, unsigned long long endNs);
+
+std::string ToJSON();
+bool SaveAsJSON(std::string filePath);
+
+/**
+* \class ScopedSpan
+* \brief It records a span from its construction to its destruction.
+* The name must be a string literal, only the pointer is stored.
+*/
+class ScopedSpan {
+public:
+ explicit ScopedSpan(const char* name) : mName(nullptr), mStart(0) {
+  if(IsEnabled()){
+   mName = name;
+   mStart = Profiler::Now();
+  }
+ }
+ ~ScopedSpan(){
+  if(mName != nullptr) Record(mName, mStart, Profiler::Now());
+ }
+private:
+ ScopedSpan(const ScopedSpan&);
+ ScopedSpan& operator=(const ScopedSpan&);
+ const char* mName;
+ unsigned long long mStart;
+};
+
+} //namespace
+
+} //namespace
+
+#define NEUROC_TRACE_CONCAT_IMPL(a, b) a##b
+#define NEUROC_TRACE_CONCAT(a, b) NEUROC_TRACE_CONCAT_IMPL(a, b)
+#define NEUROC_TRACE_SCOPE(name) neuroc::Trace::ScopedSpan NEUROC_TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,89 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef TRAININGWORKSPACE_H
+#define TRAININGWORKSPACE_H
+
+#include <cstddef>
+#include <Eigen/Dense>
+
+namespace neuroc{
+
+class Network;
+
+/**
+* \class TrainingWorkspace
+* \brief Arena for the temporaries of the learning algorithms
+*
+* The workspace is a single buffer sized once from the topology of the
+* network and the maximum batch size. The deltas, the gradients and the
+* activations of a learning step are taken from the buffer moving a
+* pointer forward, and Reset() gives back all of them at once, so the
+* steps do not allocate memory. The buffer can be backed by huge pages
+* to reduce the TLB misses of wide layers.
+*/
+class TrainingWorkspace {
+
+public:
+
+typedef Eigen::Map<Eigen::MatrixXd, Eigen::Aligned64> MatrixMap;
+typedef Eigen::Map<Eigen::VectorXd, Eigen::Aligned64> VectorMap;
+typedef Eigen::Map<Eigen::MatrixXf, Eigen::Aligned64> FloatMatrixMap;
+
+TrainingWorkspace(bool hugePages=false);
+~TrainingWorkspace();
+
+bool Reserve(Network& net, unsigned int maxBatchSize);
+bool Reserve(std::size_t numberOfDoubles);
+void Reset();
+
+MatrixMap AllocateMatrix(unsigned int rows, unsigned int cols);
+VectorMap AllocateVector(unsigned int size);
+FloatMatrixMap AllocateFloatMatrix(unsigned int rows, unsigned int cols);
+
+void SetHugePages(bool value);
+bool IsUsingHugePages();
+
+unsigned int GetMaxBatchSize();
+std::size_t ReturnCapacity();
+std::size_t ReturnUsed();
+std::size_t ReturnPeakUsage();
+std::size_t ReturnMemoryFootprint();
+
+static std::size_t ReturnRequiredSize(Network& net, unsigned int batchSize);
+
+private:
+TrainingWorkspace(const TrainingWorkspace&);
+TrainingWorkspace& operator=(const TrainingWorkspace&);
+
+void Release();
+
+double* mBuffer;
+std::size_t mCapacity; //doubles in the buffer
+std::size_t mOffset; //doubles given by the arena since the last Reset()
+std::size_t mPeak;
+std::size_t mMappedBytes;
+unsigned int mMaxBatchSize;
+bool mHugePagesRequested;
+bool mHugePages;
+};
+
+} //namespace
+
+#endif // TRAININGWORKSPACE_H
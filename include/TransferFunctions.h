@@ -20,6 +20,7 @@
 #ifndef TRANSFERFUNCTIONS_H
 #define TRANSFERFUNCTIONS_H
 
+#include <functional>
 #include <Eigen/Dense>
 
 /**
@@ -54,7 +55,39 @@ Eigen::VectorXd TanhDerivative(Eigen::VectorXd);
 Eigen::VectorXd RadialBasis(Eigen::VectorXd);
 Eigen::VectorXd MultiQuadratic(Eigen::VectorXd);
 Eigen::VectorXd HardLimit(Eigen::VectorXd);
+Eigen::VectorXd HardLimitDerivative(Eigen::VectorXd);
+Eigen::VectorXd Softmax(Eigen::VectorXd);
+Eigen::VectorXd SoftmaxDerivative(Eigen::VectorXd);
 
+/**
+ * \namespace InPlace
+ *
+ * The same functions working in place on the given vector.
+ * They do not allocate memory and are used by the DenseLayer
+ * when one of the functions above is assigned to it.
+ */
+namespace InPlace{
+
+typedef void (*Function)(Eigen::Ref<Eigen::VectorXd>);
+
+void Linear(Eigen::Ref<Eigen::VectorXd>);
+void PositiveLinear(Eigen::Ref<Eigen::VectorXd>);
+void SaturatedLinear(Eigen::Ref<Eigen::VectorXd>);
+void Sigmoid(Eigen::Ref<Eigen::VectorXd>);
+void FastSigmoid(Eigen::Ref<Eigen::VectorXd>);
+void SigmoidDerivative(Eigen::Ref<Eigen::VectorXd>);
+void Tanh(Eigen::Ref<Eigen::VectorXd>);
+void TanhDerivative(Eigen::Ref<Eigen::VectorXd>);
+void RadialBasis(Eigen::Ref<Eigen::VectorXd>);
+void MultiQuadratic(Eigen::Ref<Eigen::VectorXd>);
+void HardLimit(Eigen::Ref<Eigen::VectorXd>);
+void HardLimitDerivative(Eigen::Ref<Eigen::VectorXd>);
+void Softmax(Eigen::Ref<Eigen::VectorXd>);
+void SoftmaxDerivative(Eigen::Ref<Eigen::VectorXd>);
+
+Function ReturnFunction(const std::function<Eigen::VectorXd(Eigen::VectorXd)>& transferFunction);
+
+}
 
 }
 
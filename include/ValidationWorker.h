@@ -0,0 +1,86 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef VALIDATIONWORKER_H
+#define VALIDATIONWORKER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Network.h"
+#include "Dataset.h"
+
+namespace neuroc{
+
+/**
+* \class ValidationWorker
+* \brief It computes the validation error of the snapshots of a training
+*
+* Submit() takes a snapshot of the network, a copy sharing the weights with
+* the trained network, and a background thread computes its mean squared
+* error on the validation dataset while the training goes on. The results
+* are returned in the order of submission, with their snapshot. At most two
+* snapshots wait in the queue, a third Submit() waits for the thread, so
+* that the copies of the weights do not grow without bound. In the
+* synchronous mode Submit() computes the error before returning.
+* The datasets must not change until the worker is destroyed.
+*/
+class ValidationWorker {
+
+public:
+
+/**
+* \struct Result
+* \brief The validation error of a snapshot
+*/
+struct Result {
+ unsigned int epoch;
+ double error;
+ Network snapshot;
+};
+
+ValidationWorker(Dataset& inputDataset, Dataset& targetDataset, bool asynchronous);
+~ValidationWorker();
+
+void Submit(const Network& snapshot, unsigned int epoch);
+bool ReturnResult(Result& result);
+void Wait();
+
+private:
+ValidationWorker(const ValidationWorker&);
+ValidationWorker& operator=(const ValidationWorker&);
+
+void Run();
+
+Dataset& mInputDataset;
+Dataset& mTargetDataset;
+bool mAsynchronous;
+std::thread mThread;
+std::mutex mMutex;
+std::condition_variable mCondition;
+std::deque<Result> mPending;
+std::deque<Result> mDone;
+bool mValidating;
+bool mStopping;
+};
+
+} //namespace
+
+#endif // VALIDATIONWORKER_H
@@ -0,0 +1,64 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#ifndef WEIGHTCLUSTERING_H
+#define WEIGHTCLUSTERING_H
+
+#include <Eigen/Dense>
+#include "DenseLayer.h"
+#include "Network.h"
+
+namespace neuroc{
+
+/**
+* \class WeightClustering
+* \brief Compression of the weights with a codebook found by k-means
+*
+* The weights of every layer are grouped in 2^bits clusters with the k-means
+* on their values, starting from centroids spaced linearly between the
+* smallest and the largest weight, and every weight is replaced by the index
+* of its cluster (DenseLayer::SetCodebook()). The learning of the clustered
+* layers fine-tunes the centroids only, and ClusteredNetwork stores the
+* indices in 4 or 8 bits for the inference.
+*/
+class WeightClustering {
+
+public:
+
+WeightClustering();
+~WeightClustering();
+
+void SetIterations(unsigned int iterations);
+unsigned int GetIterations();
+
+bool Cluster(Network& net, unsigned int bits);
+
+static bool Cluster(DenseLayer& layer, unsigned int clusters, unsigned int iterations);
+static std::size_t ReturnClusteredWeightBytes(Network& net);
+
+void Print(Network& net);
+
+private:
+
+unsigned int mIterations;
+};
+
+} //namespace
+
+#endif // WEIGHTCLUSTERING_H
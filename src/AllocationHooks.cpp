@@ -0,0 +1,94 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+/*
+ *
+ * Allocation hooks for the MemoryStats counters.
+ * This file is NOT part of the library, the object file must be linked
+ * in the executable that wants to count the allocations. It replaces the
+ * malloc family of the C library (glibc), so every allocation made by
+ * Eigen, by the standard containers and by operator new is counted.
+ *
+*/
+
+#include "MemoryStats.h"
+#include <cstddef>
+#include <malloc.h>
+
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(std::size_t size){
+ void* pointer = __libc_malloc(size);
+ if(pointer != nullptr) neuroc::MemoryStats::RecordAllocation(malloc_usable_size(pointer));
+ return pointer;
+}
+
+void* calloc(std::size_t count, std::size_t size){
+ void* pointer = __libc_calloc(count, size);
+ if(pointer != nullptr) neuroc::MemoryStats::RecordAllocation(malloc_usable_size(pointer));
+ return pointer;
+}
+
+void* realloc(void* pointer, std::size_t size){
+ if(pointer != nullptr) neuroc::MemoryStats::RecordDeallocation(malloc_usable_size(pointer));
+ void* new_pointer = __libc_realloc(pointer, size);
+ if(new_pointer != nullptr) neuroc::MemoryStats::RecordAllocation(malloc_usable_size(new_pointer));
+ return new_pointer;
+}
+
+void* memalign(std::size_t alignment, std::size_t size){
+ void* pointer = __libc_memalign(alignment, size);
+ if(pointer != nullptr) neuroc::MemoryStats::RecordAllocation(malloc_usable_size(pointer));
+ return pointer;
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size){
+ return memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, std::size_t alignment, std::size_t size){
+ void* new_pointer = memalign(alignment, size);
+ if(new_pointer == nullptr) return 12; //ENOMEM
+ *pointer = new_pointer;
+ return 0;
+}
+
+void free(void* pointer){
+ if(pointer == nullptr) return;
+ neuroc::MemoryStats::RecordDeallocation(malloc_usable_size(pointer));
+ __libc_free(pointer);
+}
+
+} //extern "C"
+
+namespace {
+
+struct HooksRegistration {
+ HooksRegistration(){ neuroc::MemoryStats::EnableCounting(); }
+};
+
+HooksRegistration gHooksRegistration;
+
+} //namespace
@@ -18,19 +18,86 @@
 */
 
 #include "BackpropagationLearning.h"
+#include "CheckpointWriter.h"
+#include "Executor.h"
+#include "ModelFormat.h"
+#include "ValidationWorker.h"
+#include "Trace.h"
+#include "TransferFunctions.h"
 #include <math.h>       // pow
 #include <chrono> //timer
+#include <algorithm> //min
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
 //#define DEBUG
 
 namespace neuroc{
 
+namespace {
+
+/**
+* \struct CheckpointState
+* \brief The training state stored in the extra block of a checkpoint,
+* it is followed by the state of the SampleOrder. The mixed precision
+* fields keep the loss scale and its growth counter, a resumed training
+* skips the same steps as the interrupted one.
+*/
+struct CheckpointState {
+ char magic[8];
+ uint32_t version;
+ uint32_t batchSize;
+ uint64_t epoch;
+ uint64_t sample;
+ uint64_t datasetSize;
+ uint64_t steps;
+ double learningRate;
+ double weightDecay;
+ double gradientClipping;
+ double epochError;
+ uint32_t mixedPrecision;
+ uint32_t finiteSteps;
+ double lossScale;
+ double maxLossScale;
+};
+
+const char kStateMagic[8] = {'N', 'R', 'C', 'S', 'T', 'A', 'T', 'E'};
+const uint32_t kStateVersion = 3;
+//Finite steps after which the loss scale of the mixed precision is doubled
+const unsigned int kLossScaleGrowthSteps = 1000;
+
+} //namespace
+
 /**
 * Class constructor.
 *
 **/
 BackpropagationLearning::BackpropagationLearning(){
  mLearningRate = 0.5;
+ mWeightDecay = 0.0;
+ mGradientClipping = 0.0;
+ mCheckpointInterval = 0;
+ mCheckpointSteps = 0;
+ mResumeCursor = TrainingCursor();
+ mResumePending = false;
+ mValidationInterval = 0;
+ mValidationPatience = 0;
+ mRestoreBest = true;
+ mBestValidationError = std::numeric_limits<double>::infinity();
+ mBestEpoch = 0;
+ mStoppedEpoch = 0;
+ mValidationsWithoutImprovement = 0;
+ mStopRequested = false;
+ mPrefetchDepth = 0;
+ mPrefetchLoaders = 1;
+ mSampleWeight = 1.0;
+ mLoss = &LossFunctions::MeanSquaredError;
+ mMixedPrecision = false;
+ mLossScale = 1.0;
+ mMaxLossScale = 1.0;
+ mFiniteSteps = 0;
+ mSkippedSteps = 0;
 }
 
 /**
@@ -42,22 +109,27 @@ BackpropagationLearning::~BackpropagationLearning(){
 }
 
 
-double BackpropagationLearning::SingleStepOnlineLearning(Network* net, Eigen::VectorXd inputVector, Eigen::VectorXd targetVector, bool print){
+double BackpropagationLearning::SingleStepOnlineLearning(Network* net, const Eigen::VectorXd& inputVector, const Eigen::VectorXd& targetVector, bool print){
+ NEUROC_PROFILE_START(profile_start);
  #ifdef DEBUG 
   std::cout << "Forward phase... " << std::endl;
  #endif
  Forward(net, inputVector);
+ NEUROC_PROFILE_START(profile_forward);
 
  #ifdef DEBUG 
   std::cout << "ErrorBackpropagation phase... " << std::endl;
  #endif
  double squared_error = ErrorBackpropagation(net, targetVector);
+ NEUROC_PROFILE_START(profile_backprop);
 
  //3- Update the wheights
  #ifdef DEBUG 
   std::cout << "UpdateWheights phase... " << std::endl;
  #endif
  UpdateWheights(net);
+ NEUROC_PROFILE_START(profile_update);
+ NEUROC_PROFILE_PHASES(profile_start, profile_forward, profile_backprop, profile_update);
 
  return squared_error;
 }
@@ -73,7 +145,17 @@ void BackpropagationLearning::StartOnlineLearning(Network* net, Dataset& inputDa
  std::chrono::time_point<std::chrono::system_clock> start, end;
  start = std::chrono::system_clock::now();
 
-  for(unsigned int epoch=0; epoch<cycles; epoch++){
+  if(CheckLoss(net) == false || CheckCheckpoint(net) == false) return;
+  if(mMixedPrecision){
+   std::cerr << "Neuroc Error: BackpropagationLearning the mixed precision is available in the batch learning only" << std::endl;
+   return;
+  }
+  TrainingCursor cursor;
+  if(StartCursor(0, inputDataset.ReturnNumberOfElements(), cursor) == false) return;
+  const unsigned int first_epoch = cursor.epoch;
+  StartValidation();
+
+  for(unsigned int epoch=first_epoch; epoch<cycles; epoch++){
 
    if(print==true){ 
     std::cout << "=====================" << std::endl;
@@ -85,27 +167,49 @@ void BackpropagationLearning::StartOnlineLearning(Network* net, Dataset& inputDa
     std::cerr << "Neuroc Error: BackpropagationLearning the input dataset and the target dataset have different size" << std::endl;
    }
    
-   double MSE = 0; //Mean Squared Error
+   double MSE = (epoch == first_epoch) ? cursor.epochError : 0; //Mean Squared Error
    double dataset_size = inputDataset.ReturnNumberOfElements();
-   //Main Cycle, for all data in dataset
-   for(unsigned int i_set=0; i_set<dataset_size; i_set++){
+   mSampleOrder.Prepare(epoch, dataset_size);
+   //Main Cycle, for all data in dataset, a resumed epoch starts from the saved sample
+   for(unsigned int i_set=(epoch == first_epoch ? cursor.sample : 0); i_set<dataset_size; i_set++){
 
-    MSE += SingleStepOnlineLearning(net, inputDataset[i_set], targetDataset[i_set], true);
+    const unsigned int index = mSampleOrder.ReturnIndex(i_set);
+    mSampleWeight = mSampleOrder.ReturnWeight(i_set);
+    double squared_error = SingleStepOnlineLearning(net, inputDataset[index], targetDataset[index], true);
+    mSampleOrder.UpdateLoss(index, squared_error);
+    MSE += squared_error;
+    if(mCheckpointInterval > 0){
+     cursor.epoch = epoch;
+     cursor.sample = i_set + 1;
+     cursor.epochError = MSE;
+     CheckpointStep(net, cursor, false);
+    }
    }//main cycle
+   mSampleWeight = 1.0;
 
    //Epoch Statistics
    if(print==true){
     std::cout << "MSE: " << MSE / dataset_size  << std::endl;
    }
 
+   if(ValidationStep(net, epoch+1, epoch+1 == cycles, print) == true) break;
  }//epoch cycle
+ FinishValidation(net, print);
+
+ //The last checkpoint marks the training as completed
+ if(mCheckpointInterval > 0){
+  cursor.epoch = cycles;
+  cursor.sample = 0;
+  cursor.epochError = 0;
+  CheckpointStep(net, cursor, true);
+ }
 
  //Final statistics
  if(print==true){
   std::cout << "=====================" << std::endl;
   end = std::chrono::system_clock::now();
   std::chrono::duration<double> elapsed_seconds = end-start;
-  std::cout << "EPOCHS: " << cycles << std::endl;
+  std::cout << "EPOCHS: " << (mStoppedEpoch > 0 ? mStoppedEpoch : cycles) << std::endl;
   std::cout << "LEARNING RATE: " << mLearningRate << std::endl;
   std::cout << "LAYERS: " << net->ReturnNumberOfLayers() << std::endl;
   //std::cout << "NEURONS: " << net->ReturnNumberOfNeurons() << std::endl;
@@ -134,102 +238,955 @@ double BackpropagationLearning::GetLearningRate(){
 }
 
 
+/**
+* Set the L2 decay of the weights, applied during the update of the weights.
+* The default value is zero.
+*
+* @param value
+**/
+void BackpropagationLearning::SetWeightDecay(double value){
+ mWeightDecay = value;
+}
+
+/**
+* Get the L2 decay of the weights
+*
+**/
+double BackpropagationLearning::GetWeightDecay(){
+ return mWeightDecay;
+}
+
+/**
+* Set the clipping of the changes of the weights, every change is clipped
+* in [-value, +value] before it is multiplied by the learning rate.
+* The default value is zero, that disables the clipping.
+*
+* @param value
+**/
+void BackpropagationLearning::SetGradientClipping(double value){
+ mGradientClipping = value;
+}
+
+/**
+* Get the clipping of the changes of the weights
+*
+**/
+double BackpropagationLearning::GetGradientClipping(){
+ return mGradientClipping;
+}
+
+/**
+* It enables the periodic checkpoints of StartOnlineLearning() and
+* StartBatchLearning(). Every interval learning steps (samples for the online
+* learning, batches for the batch learning) the network and the position of
+* the training are saved in a model file (see Network::SaveAsBinary()) whose
+* extra block holds the state of the training. At the end of the training a
+* last checkpoint marks it as completed. The file is replaced atomically.
+* In the asynchronous mode the training only copies the layers, sharing the
+* weights, and a background thread writes the file. If the training is
+* faster than the disk the intermediate checkpoints can be dropped, the last
+* one is always written. The model file keeps the dense, binarized and
+* sparse layers only, a training with checkpoints refuses the factorized
+* and the clustered layers, their factors and codebook would be lost.
+*
+* @param filePath the path of the checkpoint
+* @param interval the number of learning steps between two checkpoints, zero disables them
+* @param asynchronous if true the checkpoints are written by a background thread
+* @return it returns true if it is all right, otherwise false
+**/
+bool BackpropagationLearning::SetCheckpoint(const std::string& filePath, unsigned int interval, bool asynchronous){
+ if(interval > 0 && filePath.empty()){
+  std::cerr << "Neuroc Error: BackpropagationLearning the path of the checkpoint is empty" << std::endl;
+  return false;
+ }
+ WaitForCheckpoint();
+ mCheckpointPath = filePath;
+ mCheckpointInterval = interval;
+ if(interval > 0 && asynchronous){
+  if(!mCheckpointWriter) mCheckpointWriter.reset(new CheckpointWriter());
+ } else {
+  mCheckpointWriter.reset();
+ }
+ return true;
+}
+
+/**
+* It disables the checkpoints, the pending one is written first
+*
+**/
+void BackpropagationLearning::RemoveCheckpoint(){
+ SetCheckpoint(std::string(), 0);
+}
+
+/**
+* It loads a checkpoint: the network gets the saved weights and the learning
+* takes the saved learning rate, weight decay, clipping, sample order and
+* mixed precision state (enabled, loss scale and growth counter). The next call of
+* StartOnlineLearning() or StartBatchLearning(), with the same datasets, the
+* same batch size and the same number of cycles as the interrupted one, starts
+* from the saved sample and it gives the same weights as a training that was
+* not interrupted. A completed training is not repeated.
+*
+* @param net the network, its layers are replaced
+* @param filePath the path of the checkpoint
+* @return it returns true if it is all right, otherwise false
+**/
+bool BackpropagationLearning::ResumeFromCheckpoint(Network* net, const std::string& filePath){
+ ModelFormat::MappedFile file;
+ if(file.Open(filePath) == false) return false;
+ CheckpointState state;
+ if(ModelFormat::CheckFile(file.GetData(), file.Size(), true) == false){
+  std::cerr << "Neuroc Error: BackpropagationLearning the checkpoint " << filePath << " is not valid" << std::endl;
+  return false;
+ }
+ std::string state_block = ModelFormat::ReturnExtraBlock(file.GetData());
+ if(state_block.size() < sizeof(CheckpointState)){
+  std::cerr << "Neuroc Error: BackpropagationLearning the file " << filePath << " has no training state" << std::endl;
+  return false;
+ }
+ std::memcpy(&state, state_block.data(), sizeof(CheckpointState));
+ SampleOrder order;
+ if(std::memcmp(state.magic, kStateMagic, sizeof(kStateMagic)) != 0 || state.version != kStateVersion ||
+    order.Deserialize(state_block.data() + sizeof(CheckpointState), state_block.size() - sizeof(CheckpointState)) == false){
+  std::cerr << "Neuroc Error: BackpropagationLearning the training state of " << filePath << " is not supported" << std::endl;
+  return false;
+ }
+ if(net->LoadFromBinary(filePath) == false) return false;
+ mSampleOrder = order;
+ mLearningRate = state.learningRate;
+ mWeightDecay = state.weightDecay;
+ mGradientClipping = state.gradientClipping;
+ mMixedPrecision = (state.mixedPrecision != 0);
+ mLossScale = state.lossScale;
+ mMaxLossScale = state.maxLossScale;
+ mFiniteSteps = state.finiteSteps;
+ mCheckpointSteps = state.steps;
+ mResumeCursor.epoch = state.epoch;
+ mResumeCursor.sample = state.sample;
+ mResumeCursor.batchSize = state.batchSize;
+ mResumeCursor.datasetSize = state.datasetSize;
+ mResumeCursor.epochError = state.epochError;
+ mResumePending = true;
+ return true;
+}
+
+/**
+* It waits until the pending checkpoint is written
+*
+* @return it returns false if the writing of a checkpoint failed
+**/
+bool BackpropagationLearning::WaitForCheckpoint(){
+ if(mCheckpointWriter) return mCheckpointWriter->Wait();
+ return true;
+}
+
+/**
+* It returns the position where a training starts: the one of the loaded
+* checkpoint, if the training is the same, otherwise the beginning.
+*
+* @return it returns false if the checkpoint was saved by a different training
+**/
+bool BackpropagationLearning::StartCursor(unsigned int batchSize, unsigned int datasetSize, TrainingCursor& cursor){
+ cursor = TrainingCursor();
+ cursor.batchSize = batchSize;
+ cursor.datasetSize = datasetSize;
+ if(mResumePending == false){
+  mCheckpointSteps = 0;
+  mSampleOrder.Reset();
+  return true;
+ }
+ mResumePending = false;
+ if(mResumeCursor.batchSize != batchSize || mResumeCursor.datasetSize != datasetSize){
+  std::cerr << "Neuroc Error: BackpropagationLearning the checkpoint was saved by a training with a different dataset or batch size" << std::endl;
+  return false;
+ }
+ cursor = mResumeCursor;
+ return true;
+}
+
+/**
+* It counts a learning step and it saves a checkpoint when the interval
+* is reached. The last checkpoint of a training is always saved and the
+* function waits until it is written.
+*
+**/
+void BackpropagationLearning::CheckpointStep(Network* net, const TrainingCursor& cursor, bool last){
+ if(last == false && ++mCheckpointSteps % mCheckpointInterval != 0) return;
+ NEUROC_TRACE_SCOPE("BackpropagationLearning::Checkpoint");
+ CheckpointState state = CheckpointState();
+ std::memcpy(state.magic, kStateMagic, sizeof(kStateMagic));
+ state.version = kStateVersion;
+ state.batchSize = cursor.batchSize;
+ //The end of an epoch is saved as the beginning of the next one
+ bool epoch_end = (cursor.sample >= cursor.datasetSize);
+ state.epoch = epoch_end ? cursor.epoch + 1 : cursor.epoch;
+ state.sample = epoch_end ? 0 : cursor.sample;
+ state.epochError = epoch_end ? 0.0 : cursor.epochError;
+ state.datasetSize = cursor.datasetSize;
+ state.steps = mCheckpointSteps;
+ state.learningRate = mLearningRate;
+ state.weightDecay = mWeightDecay;
+ state.gradientClipping = mGradientClipping;
+ state.mixedPrecision = mMixedPrecision ? 1 : 0;
+ state.finiteSteps = mFiniteSteps;
+ state.lossScale = mLossScale;
+ state.maxLossScale = mMaxLossScale;
+ std::string state_block(reinterpret_cast<const char*>(&state), sizeof(CheckpointState));
+ state_block += mSampleOrder.Serialize();
+
+ //The factorized layers compute their weights here, not in the writer thread
+ for(unsigned int i=0; i<net->Size(); i++) (*net)[i].GetWeightMatrix();
+ bool written = true;
+ if(mCheckpointWriter){
+  mCheckpointWriter->Submit(*net, state_block, mCheckpointPath);
+  if(last) written = mCheckpointWriter->Wait();
+ } else {
+  written = CheckpointWriter::WriteAtomically(*net, state_block, mCheckpointPath);
+ }
+ if(written == false) std::cerr << "Neuroc Error: BackpropagationLearning the checkpoint " << mCheckpointPath << " was not written" << std::endl;
+}
+
+/**
+* It enables the validation of StartOnlineLearning() and StartBatchLearning().
+* Every interval epochs, and after the last one, the mean squared error of
+* the network on the validation dataset is computed. In the asynchronous
+* mode a background thread validates a snapshot of the network (a copy
+* sharing the weights) while the training goes on. The training stops when
+* the error did not improve for patience validations in a row, the
+* validations of the epochs trained after that are discarded, so the
+* result does not depend on the mode. The network with the lowest error
+* is kept and, if restoreBest is true, it replaces the trained network
+* at the end of the training.
+*
+* @param inputDataset the validation inputs, they must not change during the training
+* @param targetDataset the validation targets
+* @param interval the number of epochs between two validations, zero disables them
+* @param patience the number of validations without improvement before stopping, zero never stops
+* @param restoreBest if true the network with the lowest validation error is returned
+* @param asynchronous if true the validation is computed by a background thread
+* @return it returns true if it is all right, otherwise false
+**/
+bool BackpropagationLearning::SetValidation(Dataset& inputDataset, Dataset& targetDataset, unsigned int interval, unsigned int patience, bool restoreBest, bool asynchronous){
+ if(interval > 0 && (inputDataset.ReturnNumberOfElements() == 0 || inputDataset.ReturnNumberOfElements() != targetDataset.ReturnNumberOfElements())){
+  std::cerr << "Neuroc Error: BackpropagationLearning the validation datasets are empty or they have different size" << std::endl;
+  return false;
+ }
+ mValidationWorker.reset();
+ mValidationInterval = interval;
+ mValidationPatience = patience;
+ mRestoreBest = restoreBest;
+ if(interval > 0) mValidationWorker.reset(new ValidationWorker(inputDataset, targetDataset, asynchronous));
+ return true;
+}
+
+/**
+* It disables the validation
+*
+**/
+void BackpropagationLearning::RemoveValidation(){
+ mValidationWorker.reset();
+ mValidationInterval = 0;
+ mBestNetwork = Network();
+}
+
+/**
+* It returns the lowest validation error of the last training
+*
+**/
+double BackpropagationLearning::GetBestValidationError(){
+ return mBestValidationError;
+}
+
+/**
+* It returns the epoch of the lowest validation error of the last training
+*
+**/
+unsigned int BackpropagationLearning::GetBestEpoch(){
+ return mBestEpoch;
+}
+
+/**
+* It returns the epoch where the last training was stopped early,
+* zero if it trained all the epochs
+*
+**/
+unsigned int BackpropagationLearning::GetStoppedEpoch(){
+ return mStoppedEpoch;
+}
+
+/**
+* It returns the network with the lowest validation error of the last training
+*
+**/
+const Network& BackpropagationLearning::GetBestNetwork(){
+ return mBestNetwork;
+}
+
+/**
+* It returns the validation errors of the last training, in the order of the epochs
+*
+**/
+const std::vector<double>& BackpropagationLearning::GetValidationErrors(){
+ return mValidationErrors;
+}
+
+/**
+* It clears the results of the previous validation
+*
+**/
+void BackpropagationLearning::StartValidation(){
+ mBestNetwork = Network();
+ mBestValidationError = std::numeric_limits<double>::infinity();
+ mBestEpoch = 0;
+ mStoppedEpoch = 0;
+ mValidationsWithoutImprovement = 0;
+ mStopRequested = false;
+ mValidationErrors.clear();
+}
+
+/**
+* It submits the network to the validation at the end of an epoch
+* and it reads the validations that are done. The last epoch is always validated.
+*
+* @param epoch the number of epochs trained
+* @param last true after the last epoch of the training
+* @return it returns true if the training has to stop
+**/
+bool BackpropagationLearning::ValidationStep(Network* net, unsigned int epoch, bool last, bool print){
+ if(mValidationInterval == 0) return false;
+ if(epoch % mValidationInterval == 0 || last){
+  //The factorized layers compute their weights here, not in the validation thread
+  for(unsigned int i=0; i<net->Size(); i++) (*net)[i].GetWeightMatrix();
+  mValidationWorker->Submit(*net, epoch);
+ }
+ if(CollectValidation(print) == false) return false;
+ if(last == false) mStoppedEpoch = epoch;
+ return true;
+}
+
+/**
+* It reads the validations that are done, in order, updating the best network
+* and the patience. The validations after the stopping one are discarded.
+*
+* @return it returns true if the training has to stop
+**/
+bool BackpropagationLearning::CollectValidation(bool print){
+ ValidationWorker::Result result;
+ while(mValidationWorker->ReturnResult(result)){
+  if(mStopRequested) continue;
+  mValidationErrors.push_back(result.error);
+  if(print==true) std::cout << "VALIDATION EPOCH: " << result.epoch << " MSE: " << result.error << std::endl;
+  if(result.error < mBestValidationError){
+   mBestValidationError = result.error;
+   mBestEpoch = result.epoch;
+   mBestNetwork = std::move(result.snapshot);
+   mValidationsWithoutImprovement = 0;
+  } else if(mValidationPatience > 0 && ++mValidationsWithoutImprovement >= mValidationPatience){
+   mStopRequested = true;
+   if(print==true) std::cout << "EARLY STOPPING, BEST EPOCH: " << mBestEpoch << std::endl;
+  }
+  result.snapshot = Network(); //the shared weights are released at once
+ }
+ return mStopRequested;
+}
+
+/**
+* It waits for the pending validations and it restores the best network
+*
+**/
+void BackpropagationLearning::FinishValidation(Network* net, bool print){
+ if(mValidationInterval == 0) return;
+ mValidationWorker->Wait();
+ CollectValidation(print);
+ if(mRestoreBest && mBestEpoch > 0) *net = mBestNetwork;
+}
+
+/**
+* It enables the prefetching of the batches in StartBatchLearning(): the
+* loader threads of a BatchPipeline gather the next depth batches, and apply
+* the transform, while the training computes the current one. Without a
+* transform the training is the same as without the prefetching.
+*
+* @param depth the number of batches prepared in advance, zero disables the prefetching
+* @param loaders the number of loader threads
+* @param transform a function applied by the loaders to every batch
+**/
+void BackpropagationLearning::SetPrefetch(unsigned int depth, unsigned int loaders, const BatchPipeline::Transform& transform){
+ mPrefetchDepth = depth;
+ mPrefetchLoaders = (loaders == 0) ? 1 : loaders;
+ mPrefetchTransform = transform;
+}
+
+unsigned int BackpropagationLearning::GetPrefetchDepth(){
+ return mPrefetchDepth;
+}
+
+/**
+* The epochs visit the samples in the order of the dataset, it is the default
+*
+**/
+void BackpropagationLearning::SetFileOrder(){
+ mSampleOrder.SetFileOrder();
+}
+
+/**
+* Every epoch visits a permutation of the samples, drawn from the seed
+* and the epoch (see SampleOrder). The dataset is not copied.
+*
+* @param seed the seed of the permutations
+**/
+void BackpropagationLearning::SetShuffle(uint64_t seed){
+ mSampleOrder.SetShuffle(seed);
+}
+
+/**
+* The online learning draws the samples with a probability proportional
+* to their last loss, mixed with the uniform probability, and it multiplies
+* the learning rate by 1/(N p) to correct the bias. The first epoch is
+* shuffled to measure the losses. The batch learning does not support it.
+*
+* @param seed the seed of the draws
+* @param uniformMix the fraction of the uniform probability, in (0, 1]
+**/
+void BackpropagationLearning::SetImportanceSampling(uint64_t seed, double uniformMix){
+ mSampleOrder.SetImportanceSampling(seed, uniformMix);
+}
+
+const SampleOrder& BackpropagationLearning::GetSampleOrder(){
+ return mSampleOrder;
+}
+
+/**
+* Set the loss minimized by the learning, it computes the deltas of the
+* output layer (see LossFunctions). The default is the Squared Error.
+* LossFunctions::CrossEntropy needs an output layer with the Softmax and
+* SoftmaxDerivative functions, LossFunctions::BinaryCrossEntropy an output
+* layer with the Sigmoid function.
+*
+* @param loss one of the functions of LossFunctions or a custom one
+**/
+void BackpropagationLearning::SetLoss(LossFunctions::Function loss){
+ mLoss = (loss == nullptr) ? &LossFunctions::MeanSquaredError : loss;
+}
+
+/**
+* Get the loss minimized by the learning
+*
+**/
+LossFunctions::Function BackpropagationLearning::GetLoss(){
+ return mLoss;
+}
+
+/**
+* It enables the mixed precision in the batch learning. The layers keep a
+* single precision copy of their weights (see DenseLayer::SetMixedPrecision()),
+* used by the products of the forward and of the backward phase, that move half
+* of the bytes and fill twice the SIMD lanes, while the updates are added to the
+* double precision weights, that are the master weights used by Compute(). The
+* deltas are multiplied by the loss scale before they are rounded, so that the
+* small ones do not underflow, and the gradients are divided by it. A step with
+* an infinite or NaN gradient is skipped and the scale is halved, it grows back
+* to the given value after 1000 finite steps. The layers are switched to the
+* mixed precision mode by the first step.
+*
+* @param value true to enable the mixed precision
+* @param lossScale the largest loss scale, a power of two
+**/
+void BackpropagationLearning::SetMixedPrecision(bool value, double lossScale){
+ mMixedPrecision = value;
+ mMaxLossScale = (lossScale >= 1.0) ? lossScale : 1.0;
+ mLossScale = mMaxLossScale;
+ mFiniteSteps = 0;
+ mSkippedSteps = 0;
+}
+
+bool BackpropagationLearning::GetMixedPrecision(){
+ return mMixedPrecision;
+}
+
+/**
+* Get the current loss scale of the mixed precision
+*
+**/
+double BackpropagationLearning::GetLossScale(){
+ return mLossScale;
+}
+
+/**
+* Get the number of mixed precision steps skipped because a gradient was not finite
+*
+**/
+unsigned long long BackpropagationLearning::GetSkippedSteps(){
+ return mSkippedSteps;
+}
+
+/**
+* It checks that the layers of the network can be saved in a checkpoint.
+* The model file stores the weights computed from the factors and from
+* the codebook, a resumed training would continue on dense weights.
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool BackpropagationLearning::CheckCheckpoint(Network* net){
+ if(mCheckpointInterval == 0) return true;
+ for(unsigned int i=0; i<net->Size(); i++){
+  if((*net)[i].IsFactorized() || (*net)[i].IsClustered()){
+   std::cerr << "Neuroc Error: BackpropagationLearning the layer " << i << " is factorized or clustered, it cannot be saved in a checkpoint" << std::endl;
+   return false;
+  }
+ }
+ return true;
+}
+
+/**
+* It checks that the output layer of the network fits the loss.
+* The derivative of a Softmax layer holds the logits, they are
+* meaningful only for the cross entropy.
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool BackpropagationLearning::CheckLoss(Network* net){
+ if(net->ReturnNumberOfLayers() == 0) return true;
+ DenseLayer& layer = (*net)[net->ReturnNumberOfLayers()-1];
+ TransferFunctions::InPlace::Function transfer = TransferFunctions::InPlace::ReturnFunction(layer.GetTransferFunction());
+ TransferFunctions::InPlace::Function derivative = TransferFunctions::InPlace::ReturnFunction(layer.GetDerivativeFunction());
+ const bool softmax = (transfer == &TransferFunctions::InPlace::Softmax && derivative == &TransferFunctions::InPlace::SoftmaxDerivative);
+ if(mLoss == &LossFunctions::CrossEntropy && softmax == false){
+  std::cerr << "Neuroc Error: BackpropagationLearning the cross entropy needs a Softmax output layer" << std::endl;
+  return false;
+ }
+ if(mLoss != &LossFunctions::CrossEntropy && derivative == &TransferFunctions::InPlace::SoftmaxDerivative){
+  std::cerr << "Neuroc Error: BackpropagationLearning the Softmax output layer needs the cross entropy loss" << std::endl;
+  return false;
+ }
+ if(mLoss == &LossFunctions::BinaryCrossEntropy && transfer != &TransferFunctions::InPlace::Sigmoid){
+  std::cerr << "Neuroc Error: BackpropagationLearning the binary cross entropy needs a Sigmoid output layer" << std::endl;
+  return false;
+ }
+ return true;
+}
+
+/**
+* It returns the workspace used for the temporaries of the learning steps.
+* It can be used to reserve the memory before the training or to enable the
+* huge pages.
+*
+**/
+TrainingWorkspace& BackpropagationLearning::GetWorkspace(){
+ return mWorkspace;
+}
+
+
 /**
 * Forward passage
+* The output and the derivative of each layer are computed in a single pass.
 *
 * @param inputVector
 **/
-void BackpropagationLearning::Forward(Network* net, Eigen::VectorXd inputVector){
- net->Compute(inputVector);
+void BackpropagationLearning::Forward(Network* net, const Eigen::VectorXd& inputVector){
+ NEUROC_TRACE_SCOPE("BackpropagationLearning::Forward");
  net->ComputeDerivative(inputVector);
 }
 
 /**
 * Error Backpropagation
-* It returns the Sqared Error
-* It returns the RMSD (Root Mean Square Deviation)
-* 
+* It returns the loss of the sample, the Squared Error by default
+* The deltas are computed in the workspace and the weights of the next
+* layer are read in place. The deltas of the output layer are given
+* by the loss (see SetLoss()).
 *
-* @param inputVector
+* @param targetVector
 **/
-double BackpropagationLearning::ErrorBackpropagation(Network* net, Eigen::VectorXd targetVector){
+double BackpropagationLearning::ErrorBackpropagation(Network* net, const Eigen::VectorXd& targetVector){
+  NEUROC_TRACE_SCOPE("BackpropagationLearning::ErrorBackpropagation");
+  mWorkspace.Reserve(*net, 1);
+  mWorkspace.Reset();
   int tot_layers = net->ReturnNumberOfLayers();
   tot_layers = tot_layers - 1; //zero based index
-  Eigen::VectorXd delta_vector;
-  Eigen::MatrixXd next_layer_connection_matrix;
+  double loss = 0;
 
   //Iteration through all the layers of the network
   //starting from the last one
   for(int i_layer=tot_layers; i_layer>-1; i_layer--){
+   DenseLayer& layer = (*net)[i_layer];
+   TrainingWorkspace::VectorMap delta_vector = mWorkspace.AllocateVector(layer.GetOutputVector().size());
    //This is the case for the OUTPUT layer
    if(i_layer==tot_layers){
-    delta_vector = targetVector - (*net)[i_layer].GetOutputVector(); 
-    delta_vector = delta_vector.cwiseProduct( (*net)[i_layer].GetDerivativeVector() ); //HadamardProduct
-    (*net)[i_layer].SetErrorVector(delta_vector);
+    loss = mLoss(layer.GetOutputVector(), layer.GetDerivativeVector(), targetVector, delta_vector);
    //If the layer is HIDDEN
    } else {
-
-    //The connection matrix is taken for the layer next to the current one
-    next_layer_connection_matrix = (*net)[i_layer+1].GetWeightMatrix();
-    //To allow the matrix-vector multiplication the matrix must be transpose
-    
-    //Matrix-vector multiplication returns a vector with lenght equal
-    //to the error-vector for the current layer
-    Eigen::VectorXd next_layer_error_vector = (*net)[i_layer+1].GetErrorVector();
-    delta_vector = next_layer_connection_matrix.transpose() * next_layer_error_vector;
-    Eigen::VectorXd current_layer_derivative_vector = (*net)[i_layer].GetDerivativeVector();
-    Eigen::VectorXd current_layer_error_vector = delta_vector.cwiseProduct(current_layer_derivative_vector); //HadamardProduct
-    (*net)[i_layer].SetErrorVector(current_layer_error_vector);
+    //The transposed connection matrix of the next layer multiplied by its
+    //error returns a vector with lenght equal to the error of the current layer
+    DenseLayer& next_layer = (*net)[i_layer+1];
+    next_layer.ComputeInputError(next_layer.GetErrorVector(), delta_vector);
+    delta_vector.array() *= layer.GetDerivativeVector().array(); //HadamardProduct
    }
+   layer.SetErrorVector(delta_vector);
   }//layer cycle
 
- //Computing the Squared-Error
- double SE = 0;
- Eigen::VectorXd distance_evector = targetVector - (*net)[tot_layers].GetOutputVector();
- SE = distance_evector.squaredNorm();
- //double accumulator = error_vector.dot(error_vector); //here we take the power of the vector
- //accumulator = accumulator / 2;
- //return accumulator;
- return SE;
+ return loss;
 }
 
 
 /**
 * Update the Wheights
+* The weights are updated in place with a single pass, that applies also
+* the weight decay and the clipping. The learning rate is multiplied by
+* the weight of the sample given by the importance sampling.
 *
 **/
 void BackpropagationLearning::UpdateWheights(Network* net){
+  NEUROC_TRACE_SCOPE("BackpropagationLearning::UpdateWheights");
+  mWorkspace.Reserve(*net, 1);
+  mWorkspace.Reset();
   int tot_layers = net->ReturnNumberOfLayers();
-  tot_layers = tot_layers; //zero based index
 
- //Iteration through all the layers of the network
- //starting from the last one
  for(int i_layer=0; i_layer<tot_layers; i_layer++){
+  DenseLayer& layer = (*net)[i_layer];
 
   //1-Setting the Bias value
   //This value is equal to BiasValue * ErrorValue of the neuron
-  Eigen::VectorXd bias_vector;
-  bias_vector = (*net)[i_layer].GetBiasVector();
-  bias_vector = bias_vector.cwiseProduct( (*net)[i_layer].GetErrorVector() );  //HadamardProduct
-  (*net)[i_layer].SetBiasVector(bias_vector);
+  TrainingWorkspace::VectorMap bias_vector = mWorkspace.AllocateVector(layer.GetBiasVector().size());
+  bias_vector = layer.GetBiasVector().cwiseProduct(layer.GetErrorVector());  //HadamardProduct
+  layer.SetBiasVector(bias_vector);
 
   //2-Setting the Weight Matrix
-  //if INPUT layer
-  Eigen::MatrixXd change_rate_matrix;
-  Eigen::MatrixXd updated_connection_matrix;
-  Eigen::VectorXd inputVector;
-  inputVector = (*net)[i_layer].GetInputVector();
-  change_rate_matrix = (*net)[i_layer].GetErrorVector() * inputVector.transpose();
-  //add here the MatrixScalarMultiplication between change_rate_matrix and LearningRateValue
-  change_rate_matrix = change_rate_matrix * mLearningRate; //MatrixScalarMultiplication(change_rate_matrix, mLearningRate);
-  updated_connection_matrix = change_rate_matrix + (*net)[i_layer].GetWeightMatrix();
-  (*net)[i_layer].SetWeightMatrix(updated_connection_matrix);
+  //The change rate is the outer product of the error and the input, scaled by the learning rate
+  layer.UpdateWeights(mLearningRate * mSampleWeight, layer.GetErrorVector(), layer.GetInputVector(), mWeightDecay, mGradientClipping);
  }
 }
 
 
+/**
+* Learning step on a batch of samples, every column of the matrices is a sample.
+* The activations, the deltas and the gradients of all the layers are taken from
+* the workspace, the changes are averaged over the batch. With a batch of one
+* sample the step is equal to SingleStepOnlineLearning().
+*
+* @param inputMatrix input size x batch size
+* @param targetMatrix output size x batch size
+* @return it returns the loss summed over the batch, the Squared Error by default
+**/
+double BackpropagationLearning::SingleStepBatchLearning(Network* net, const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, const Eigen::Ref<const Eigen::MatrixXd>& targetMatrix){
+ if(mMixedPrecision) return SingleStepMixedLearning(net, inputMatrix, targetMatrix);
+ NEUROC_TRACE_SCOPE("BackpropagationLearning::SingleStepBatchLearning");
+ NEUROC_PROFILE_START(profile_start);
+ unsigned int tot_layers = net->ReturnNumberOfLayers();
+ unsigned int batch_size = inputMatrix.cols();
+ if(tot_layers == 0 || batch_size == 0 || targetMatrix.cols() != batch_size ||
+    targetMatrix.rows() != (*net)[tot_layers-1].ReturnNumberOfNeurons()){
+  std::cerr << "Neuroc Error: BackpropagationLearning the batch does not fit the network" << std::endl;
+  return 0;
+ }
+ mWorkspace.Reserve(*net, batch_size);
+ mWorkspace.Reset();
+ if(mLayerOutputs.size() != tot_layers){
+  mLayerOutputs.resize(tot_layers);
+  mLayerDerivatives.resize(tot_layers);
+  mLayerErrors.resize(tot_layers);
+ }
 
-} //namespace
+ //1- Forward, the output of each layer is the input of the next one
+ for(unsigned int i_layer=0; i_layer<tot_layers; i_layer++){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  TrainingWorkspace::MatrixMap output_matrix = mWorkspace.AllocateMatrix(rows, batch_size);
+  TrainingWorkspace::MatrixMap derivative_matrix = mWorkspace.AllocateMatrix(rows, batch_size);
+  if(i_layer == 0) layer.ComputeBatch(inputMatrix, output_matrix, derivative_matrix);
+  else layer.ComputeBatch(TrainingWorkspace::MatrixMap(mLayerOutputs[i_layer-1], layer.ReturnNumberOfInputs(), batch_size), output_matrix, derivative_matrix);
+  mLayerOutputs[i_layer] = output_matrix.data();
+  mLayerDerivatives[i_layer] = derivative_matrix.data();
+ }
+ NEUROC_PROFILE_START(profile_forward);
 
+ //2- Error Backpropagation, starting from the last layer
+ double SE = 0;
+ for(int i_layer=tot_layers-1; i_layer>-1; i_layer--){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  TrainingWorkspace::MatrixMap delta_matrix = mWorkspace.AllocateMatrix(rows, batch_size);
+  if(i_layer == (int) tot_layers-1){
+   SE = mLoss(TrainingWorkspace::MatrixMap(mLayerOutputs[i_layer], rows, batch_size),
+              TrainingWorkspace::MatrixMap(mLayerDerivatives[i_layer], rows, batch_size), targetMatrix, delta_matrix);
+  } else {
+   DenseLayer& next_layer = (*net)[i_layer+1];
+   next_layer.ComputeInputError(TrainingWorkspace::MatrixMap(mLayerErrors[i_layer+1], next_layer.ReturnNumberOfNeurons(), batch_size), delta_matrix);
+   delta_matrix.array() *= TrainingWorkspace::MatrixMap(mLayerDerivatives[i_layer], rows, batch_size).array(); //HadamardProduct
+  }
+  mLayerErrors[i_layer] = delta_matrix.data();
+ }
+ NEUROC_PROFILE_START(profile_backprop);
 
+ //3- Update of bias and weights with the mean over the batch
+ for(unsigned int i_layer=0; i_layer<tot_layers; i_layer++){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  unsigned int cols = layer.ReturnNumberOfInputs();
+  TrainingWorkspace::MatrixMap delta_matrix(mLayerErrors[i_layer], rows, batch_size);
 
+  TrainingWorkspace::VectorMap bias_vector = mWorkspace.AllocateVector(rows);
+  bias_vector = delta_matrix.rowwise().mean();
+  bias_vector.array() *= layer.GetBiasVector().array();
+  layer.SetBiasVector(bias_vector);
+
+  //The product of the deltas and the inputs accumulates directly in the weights,
+  //the clipping needs the changes before they are added so they are kept in the workspace
+  delta_matrix /= batch_size;
+  if(mGradientClipping > 0){
+   TrainingWorkspace::MatrixMap change_rate_matrix = mWorkspace.AllocateMatrix(rows, cols);
+   if(i_layer == 0) change_rate_matrix.noalias() = delta_matrix * inputMatrix.transpose();
+   else change_rate_matrix.noalias() = delta_matrix * TrainingWorkspace::MatrixMap(mLayerOutputs[i_layer-1], cols, batch_size).transpose();
+   layer.AddToWeightMatrix(change_rate_matrix, mLearningRate, mWeightDecay, mGradientClipping);
+  } else {
+   if(i_layer == 0) layer.UpdateWeightsBatch(mLearningRate, delta_matrix, inputMatrix, mWeightDecay);
+   else layer.UpdateWeightsBatch(mLearningRate, delta_matrix, TrainingWorkspace::MatrixMap(mLayerOutputs[i_layer-1], cols, batch_size), mWeightDecay);
+  }
+ }
+ NEUROC_PROFILE_START(profile_update);
+ NEUROC_PROFILE_PHASES(profile_start, profile_forward, profile_backprop, profile_update);
+
+ return SE;
+}
+
+/**
+* Learning step on a batch of samples in the mixed precision mode (see
+* SetMixedPrecision()). The products of the forward and of the backward
+* phase and the gradients of the weights are computed in single precision,
+* the transfer functions, the loss, the deltas and the updates of the master
+* weights in double precision. The deltas are multiplied by the loss scale
+* before they are rounded to single precision. If a gradient is not finite
+* the weights are not changed and the loss scale is halved.
+*
+* @param inputMatrix input size x batch size
+* @param targetMatrix output size x batch size
+* @return it returns the loss summed over the batch, the Squared Error by default
+**/
+double BackpropagationLearning::SingleStepMixedLearning(Network* net, const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, const Eigen::Ref<const Eigen::MatrixXd>& targetMatrix){
+ NEUROC_TRACE_SCOPE("BackpropagationLearning::SingleStepMixedLearning");
+ NEUROC_PROFILE_START(profile_start);
+ unsigned int tot_layers = net->ReturnNumberOfLayers();
+ unsigned int batch_size = inputMatrix.cols();
+ if(tot_layers == 0 || batch_size == 0 || targetMatrix.cols() != batch_size ||
+    targetMatrix.rows() != (*net)[tot_layers-1].ReturnNumberOfNeurons()){
+  std::cerr << "Neuroc Error: BackpropagationLearning the batch does not fit the network" << std::endl;
+  return 0;
+ }
+ //The layers keep a single precision copy of their weights
+ for(unsigned int i_layer=0; i_layer<tot_layers; i_layer++){
+  if((*net)[i_layer].IsMixedPrecision() == false && (*net)[i_layer].SetMixedPrecision(true) == false) return 0;
+ }
+ mWorkspace.Reserve(*net, batch_size);
+ mWorkspace.Reset();
+ if(mLayerOutputs.size() != tot_layers || mLayerFloatOutputs.size() != tot_layers){
+  mLayerOutputs.resize(tot_layers);
+  mLayerDerivatives.resize(tot_layers);
+  mLayerErrors.resize(tot_layers);
+  mLayerFloatOutputs.resize(tot_layers);
+  mLayerFloatErrors.resize(tot_layers);
+  mLayerFloatGradients.resize(tot_layers);
+ }
+
+ //1- Forward, the single precision output of each layer is the input of the next one
+ TrainingWorkspace::FloatMatrixMap input_matrix = mWorkspace.AllocateFloatMatrix(inputMatrix.rows(), batch_size);
+ input_matrix = inputMatrix.cast<float>();
+ for(unsigned int i_layer=0; i_layer<tot_layers; i_layer++){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  TrainingWorkspace::MatrixMap output_matrix = mWorkspace.AllocateMatrix(rows, batch_size);
+  TrainingWorkspace::MatrixMap derivative_matrix = mWorkspace.AllocateMatrix(rows, batch_size);
+  TrainingWorkspace::FloatMatrixMap float_output_matrix = mWorkspace.AllocateFloatMatrix(rows, batch_size);
+  if(i_layer == 0) layer.ComputeBatchMixed(input_matrix, output_matrix, derivative_matrix, float_output_matrix);
+  else layer.ComputeBatchMixed(TrainingWorkspace::FloatMatrixMap(mLayerFloatOutputs[i_layer-1], layer.ReturnNumberOfInputs(), batch_size), output_matrix, derivative_matrix, float_output_matrix);
+  mLayerOutputs[i_layer] = output_matrix.data();
+  mLayerDerivatives[i_layer] = derivative_matrix.data();
+  mLayerFloatOutputs[i_layer] = float_output_matrix.data();
+ }
+ NEUROC_PROFILE_START(profile_forward);
+
+ //2- Error Backpropagation, the deltas are scaled and rounded to single precision.
+ //The scale of this step is kept, the growth below must not change the update
+ const double scale = mLossScale;
+ double SE = 0;
+ for(int i_layer=tot_layers-1; i_layer>-1; i_layer--){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  TrainingWorkspace::MatrixMap delta_matrix = mWorkspace.AllocateMatrix(rows, batch_size);
+  TrainingWorkspace::FloatMatrixMap float_delta_matrix = mWorkspace.AllocateFloatMatrix(rows, batch_size);
+  if(i_layer == (int) tot_layers-1){
+   SE = mLoss(TrainingWorkspace::MatrixMap(mLayerOutputs[i_layer], rows, batch_size),
+              TrainingWorkspace::MatrixMap(mLayerDerivatives[i_layer], rows, batch_size), targetMatrix, delta_matrix);
+   delta_matrix *= scale;
+  } else {
+   DenseLayer& next_layer = (*net)[i_layer+1];
+   next_layer.ComputeInputErrorMixed(TrainingWorkspace::FloatMatrixMap(mLayerFloatErrors[i_layer+1], next_layer.ReturnNumberOfNeurons(), batch_size), float_delta_matrix);
+   delta_matrix = float_delta_matrix.cast<double>().cwiseProduct(TrainingWorkspace::MatrixMap(mLayerDerivatives[i_layer], rows, batch_size)); //HadamardProduct
+  }
+  float_delta_matrix = delta_matrix.cast<float>();
+  mLayerErrors[i_layer] = delta_matrix.data();
+  mLayerFloatErrors[i_layer] = float_delta_matrix.data();
+ }
+
+ //3- Gradients of the weights in single precision, they are checked before any update
+ Executor& executor = Executor::ReturnInstance();
+ bool finite = true;
+ for(unsigned int i_layer=0; i_layer<tot_layers; i_layer++){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  unsigned int cols = layer.ReturnNumberOfInputs();
+  TrainingWorkspace::FloatMatrixMap float_delta_matrix(mLayerFloatErrors[i_layer], rows, batch_size);
+  TrainingWorkspace::FloatMatrixMap gradient_matrix = mWorkspace.AllocateFloatMatrix(rows, cols);
+  const TrainingWorkspace::FloatMatrixMap layer_input_matrix((i_layer == 0) ? input_matrix.data() : mLayerFloatOutputs[i_layer-1], cols, batch_size);
+  const std::size_t work = (std::size_t) rows * cols * batch_size;
+  if(executor.IsParallel(work)){
+   executor.ParallelFor(0, rows, work, [&](std::size_t begin, std::size_t end){
+    gradient_matrix.middleRows(begin, end - begin).noalias() = float_delta_matrix.middleRows(begin, end - begin) * layer_input_matrix.transpose();
+   });
+  }
+  else gradient_matrix.noalias() = float_delta_matrix * layer_input_matrix.transpose();
+  mLayerFloatGradients[i_layer] = gradient_matrix.data();
+  finite = finite && gradient_matrix.allFinite() && TrainingWorkspace::MatrixMap(mLayerErrors[i_layer], rows, batch_size).allFinite();
+ }
+ NEUROC_PROFILE_START(profile_backprop);
+
+ if(finite == false){
+  mSkippedSteps++;
+  mFiniteSteps = 0;
+  mLossScale = std::max(1.0, mLossScale / 2.0);
+  return SE;
+ }
+ if(++mFiniteSteps >= kLossScaleGrowthSteps && mLossScale < mMaxLossScale){
+  mFiniteSteps = 0;
+  mLossScale = std::min(mMaxLossScale, mLossScale * 2.0);
+ }
+
+ //4- Update of bias and master weights with the mean over the batch, without the loss scale
+ for(unsigned int i_layer=0; i_layer<tot_layers; i_layer++){
+  DenseLayer& layer = (*net)[i_layer];
+  unsigned int rows = layer.ReturnNumberOfNeurons();
+  unsigned int cols = layer.ReturnNumberOfInputs();
+  TrainingWorkspace::MatrixMap delta_matrix(mLayerErrors[i_layer], rows, batch_size);
+
+  TrainingWorkspace::VectorMap bias_vector = mWorkspace.AllocateVector(rows);
+  bias_vector = delta_matrix.rowwise().mean() / scale;
+  bias_vector.array() *= layer.GetBiasVector().array();
+  layer.SetBiasVector(bias_vector);
+
+  layer.UpdateMasterWeights(TrainingWorkspace::FloatMatrixMap(mLayerFloatGradients[i_layer], rows, cols), 1.0 / (scale * batch_size),
+                            mLearningRate, mWeightDecay, mGradientClipping);
+ }
+ NEUROC_PROFILE_START(profile_update);
+ NEUROC_PROFILE_PHASES(profile_start, profile_forward, profile_backprop, profile_update);
+
+ return SE;
+}
+
+/**
+* Start the batch learning algorithm for the specified number of cycles.
+* The samples are taken in order, the last batch of an epoch can be smaller.
+*
+* @param batchSize number of samples of each step
+**/
+void BackpropagationLearning::StartBatchLearning(Network* net, Dataset& inputDataset, Dataset& targetDataset, unsigned int cycles, unsigned int batchSize, bool print){
+ std::chrono::time_point<std::chrono::system_clock> start, end;
+ start = std::chrono::system_clock::now();
+
+ //Check if the two dataset have the same size
+ if(inputDataset.ReturnNumberOfElements() != targetDataset.ReturnNumberOfElements()){
+  std::cerr << "Neuroc Error: BackpropagationLearning the input dataset and the target dataset have different size" << std::endl;
+  return;
+ }
+ unsigned int dataset_size = inputDataset.ReturnNumberOfElements();
+ if(dataset_size == 0) return;
+ if(batchSize == 0) batchSize = 1;
+ if(batchSize > dataset_size) batchSize = dataset_size;
+ if(mSampleOrder.GetMode() == SampleOrder::IMPORTANCE_SAMPLING){
+  std::cerr << "Neuroc Error: BackpropagationLearning the importance sampling is available in the online learning only" << std::endl;
+  return;
+ }
+
+ //The batches are copied in these matrices, allocated once
+ Eigen::MatrixXd input_matrix(inputDataset[0].size(), batchSize);
+ Eigen::MatrixXd target_matrix(targetDataset[0].size(), batchSize);
+ mWorkspace.Reserve(*net, batchSize);
+
+ if(CheckLoss(net) == false || CheckCheckpoint(net) == false) return;
+ TrainingCursor cursor;
+ if(StartCursor(batchSize, dataset_size, cursor) == false) return;
+ const unsigned int first_epoch = cursor.epoch;
+ StartValidation();
+
+ //The loader threads gather the batches in advance
+ std::unique_ptr<BatchPipeline> pipeline;
+ if(mPrefetchDepth > 0){
+  pipeline.reset(new BatchPipeline(inputDataset, targetDataset, batchSize, mPrefetchDepth, mPrefetchLoaders));
+  pipeline->SetTransform(mPrefetchTransform);
+  pipeline->SetSampleOrder(mSampleOrder);
+  if(pipeline->Start(first_epoch, cycles, cursor.sample) == false) return;
+ }
+
+ for(unsigned int epoch=first_epoch; epoch<cycles; epoch++){
+
+  if(print==true){
+   std::cout << "=====================" << std::endl;
+   std::cout << "EPOCH: " << epoch+1 << std::endl;
+  }
+
+  double MSE = (epoch == first_epoch) ? cursor.epochError : 0; //Mean Squared Error
+  if(!pipeline) mSampleOrder.Prepare(epoch, dataset_size);
+  for(unsigned int i_set=(epoch == first_epoch ? cursor.sample : 0); i_set<dataset_size; i_set+=batchSize){
+   unsigned int samples = std::min(batchSize, dataset_size - i_set);
+   if(pipeline){
+    const BatchPipeline::Batch* batch = pipeline->Next();
+    MSE += SingleStepBatchLearning(net, batch->input.leftCols(samples), batch->target.leftCols(samples));
+    pipeline->Release();
+   } else {
+    for(unsigned int i=0; i<samples; i++){
+     const unsigned int index = mSampleOrder.ReturnIndex(i_set+i);
+     input_matrix.col(i) = inputDataset[index];
+     target_matrix.col(i) = targetDataset[index];
+    }
+    MSE += SingleStepBatchLearning(net, input_matrix.leftCols(samples), target_matrix.leftCols(samples));
+   }
+   if(mCheckpointInterval > 0){
+    cursor.epoch = epoch;
+    cursor.sample = i_set + samples;
+    cursor.epochError = MSE;
+    CheckpointStep(net, cursor, false);
+   }
+  }
+
+  //Epoch Statistics
+  if(print==true){
+   std::cout << "MSE: " << MSE / dataset_size  << std::endl;
+  }
+
+  if(ValidationStep(net, epoch+1, epoch+1 == cycles, print) == true) break;
+ }//epoch cycle
+ FinishValidation(net, print);
+
+ //The last checkpoint marks the training as completed
+ if(mCheckpointInterval > 0){
+  cursor.epoch = cycles;
+  cursor.sample = 0;
+  cursor.epochError = 0;
+  CheckpointStep(net, cursor, true);
+ }
+
+ //Final statistics
+ if(print==true){
+  std::cout << "=====================" << std::endl;
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end-start;
+  std::cout << "EPOCHS: " << (mStoppedEpoch > 0 ? mStoppedEpoch : cycles) << std::endl;
+  std::cout << "BATCH SIZE: " << batchSize << std::endl;
+  std::cout << "LEARNING RATE: " << mLearningRate << std::endl;
+  std::cout << "LAYERS: " << net->ReturnNumberOfLayers() << std::endl;
+  std::cout << "TIME: "   << elapsed_seconds.count() << "s" << std::endl;
+  std::cout << "=====================" << std::endl;
+  std::cout << std::endl;
+ }
+}
+
+
+
+} //namespace
@@ -0,0 +1,273 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "BatchPipeline.h"
+#include "Trace.h"
+#include <algorithm> //min
+#include <chrono>
+
+namespace neuroc{
+
+namespace {
+
+/**
+* It waits a little, first giving the processor to the other
+* threads and then sleeping
+*
+**/
+void Backoff(unsigned int& spins){
+ if(++spins < 64) std::this_thread::yield();
+ else std::this_thread::sleep_for(std::chrono::microseconds(20));
+}
+
+} //namespace
+
+/**
+* Class constructor, the buffers of the batches are allocated here
+*
+* @param inputDataset the inputs, they must not change while the pipeline is running
+* @param targetDataset the targets
+* @param batchSize the number of samples of a batch
+* @param depth the number of batches prepared in advance
+* @param loaders the number of loader threads
+**/
+BatchPipeline::BatchPipeline(Dataset& inputDataset, Dataset& targetDataset, unsigned int batchSize, unsigned int depth, unsigned int loaders)
+ : mInputDataset(inputDataset), mTargetDataset(targetDataset), mStopping(false){
+ mDatasetSize = std::min(inputDataset.ReturnNumberOfElements(), targetDataset.ReturnNumberOfElements());
+ mBatchSize = std::max(1u, std::min(batchSize, mDatasetSize));
+ mRunning = false;
+ mFirstEpoch = 0;
+ mLastEpoch = 0;
+ mFirstSample = 0;
+ mNextBatch = 0;
+ mTotalBatches = 0;
+ mCurrent = nullptr;
+ mTrainingWaits = 0;
+ if(loaders == 0) loaders = 1;
+ const unsigned int buffers = std::max(1u, (depth + loaders - 1) / loaders);
+ const unsigned int input_size = (mDatasetSize > 0) ? inputDataset[0].size() : 0;
+ const unsigned int target_size = (mDatasetSize > 0) ? targetDataset[0].size() : 0;
+ for(unsigned int l=0; l<loaders; l++){
+  mLoaders.emplace_back(new Loader(buffers));
+  Loader& loader = *mLoaders.back();
+  loader.buffers.resize(buffers);
+  for(Batch& batch : loader.buffers){
+   batch.input.resize(input_size, mBatchSize);
+   batch.target.resize(target_size, mBatchSize);
+   batch.samples = 0;
+   batch.epoch = 0;
+   batch.first = 0;
+   loader.free.Push(&batch);
+  }
+ }
+}
+
+/**
+* Class destructor, the loader threads are stopped here
+*
+**/
+BatchPipeline::~BatchPipeline(){
+ Stop();
+}
+
+/**
+* It sets a transform applied by the loaders to every batch, after the
+* samples are gathered. It is called from several threads at once when
+* there are more loaders. It must be set before Start().
+*
+**/
+void BatchPipeline::SetTransform(const Transform& transform){
+ Stop();
+ mTransform = transform;
+}
+
+/**
+* It sets the order of the samples, file order or shuffle. The importance
+* sampling needs the losses of the training and it is not supported.
+* It must be set before Start().
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool BatchPipeline::SetSampleOrder(const SampleOrder& order){
+ if(order.GetMode() == SampleOrder::IMPORTANCE_SAMPLING){
+  std::cerr << "Neuroc Error: BatchPipeline the importance sampling is not supported" << std::endl;
+  return false;
+ }
+ Stop();
+ mOrder = order;
+ return true;
+}
+
+/**
+* It starts the loaders. The batches go from the sample firstSample of the
+* epoch firstEpoch to the end of the epoch lastEpoch - 1, every epoch
+* starting from its first sample.
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool BatchPipeline::Start(unsigned int firstEpoch, unsigned int lastEpoch, unsigned int firstSample){
+ Stop();
+ if(mDatasetSize == 0 || mInputDataset.ReturnNumberOfElements() != mTargetDataset.ReturnNumberOfElements()){
+  std::cerr << "Neuroc Error: BatchPipeline the datasets are empty or they have different size" << std::endl;
+  return false;
+ }
+ if(firstSample > mDatasetSize){
+  std::cerr << "Neuroc Error: BatchPipeline the first sample is out of the dataset" << std::endl;
+  return false;
+ }
+ mFirstEpoch = firstEpoch;
+ mLastEpoch = lastEpoch;
+ mFirstSample = firstSample;
+ mNextBatch = 0;
+ mTotalBatches = 0;
+ for(unsigned int epoch=firstEpoch; epoch<lastEpoch; epoch++){
+  unsigned int samples = mDatasetSize - (epoch == firstEpoch ? firstSample : 0);
+  mTotalBatches += (samples + mBatchSize - 1) / mBatchSize;
+ }
+ mTrainingWaits = 0;
+ mStopping.store(false);
+ mRunning = true;
+ for(unsigned int l=0; l<mLoaders.size(); l++) mLoaders[l]->order = mOrder;
+ for(unsigned int l=0; l<mLoaders.size(); l++) mLoaders[l]->thread = std::thread(&BatchPipeline::Run, this, l);
+ return true;
+}
+
+/**
+* It stops the loaders, the batches prepared and not read are discarded
+*
+**/
+void BatchPipeline::Stop(){
+ if(mRunning == false) return;
+ mStopping.store(true, std::memory_order_release);
+ for(std::unique_ptr<Loader>& loader : mLoaders) loader->thread.join();
+ //The threads are over, all the buffers go back to the free queues
+ if(mCurrent != nullptr){
+  mLoaders[mNextBatch % mLoaders.size()]->free.Push(mCurrent);
+  mCurrent = nullptr;
+ }
+ for(std::unique_ptr<Loader>& loader : mLoaders){
+  Batch* batch;
+  while(loader->ready.Pop(batch)) loader->free.Push(batch);
+ }
+ mRunning = false;
+}
+
+/**
+* It returns the next batch, waiting for the loader if it is not ready.
+* The batch is valid until Release().
+*
+* @return it returns nullptr after the last batch
+**/
+const BatchPipeline::Batch* BatchPipeline::Next(){
+ if(mCurrent != nullptr) Release();
+ if(mRunning == false || mNextBatch >= mTotalBatches) return nullptr;
+ Loader& loader = *mLoaders[mNextBatch % mLoaders.size()];
+ Batch* batch = nullptr;
+ unsigned int spins = 0;
+ while(loader.ready.Pop(batch) == false){
+  if(spins == 0) mTrainingWaits++;
+  Backoff(spins);
+ }
+ mCurrent = batch;
+ return batch;
+}
+
+/**
+* It gives back to the loader the batch returned by Next()
+*
+**/
+void BatchPipeline::Release(){
+ if(mCurrent == nullptr) return;
+ mLoaders[mNextBatch % mLoaders.size()]->free.Push(mCurrent);
+ mCurrent = nullptr;
+ mNextBatch++;
+}
+
+unsigned int BatchPipeline::ReturnBatchSize(){
+ return mBatchSize;
+}
+
+/**
+* It returns the bytes of the buffers of the batches
+*
+**/
+std::size_t BatchPipeline::ReturnMemoryFootprint(){
+ std::size_t bytes = sizeof(BatchPipeline);
+ for(std::unique_ptr<Loader>& loader : mLoaders){
+  bytes += sizeof(Loader) + 2 * (loader->free.Capacity() + 1) * sizeof(Batch*);
+  for(Batch& batch : loader->buffers) bytes += sizeof(Batch) + sizeof(double) * (batch.input.size() + batch.target.size());
+ }
+ return bytes;
+}
+
+/**
+* It returns the number of times the training found its batch not ready
+*
+**/
+unsigned long long BatchPipeline::ReturnNumberOfTrainingWaits(){
+ return mTrainingWaits;
+}
+
+/**
+* It copies the samples of a batch in its matrices and it applies the transform
+*
+**/
+void BatchPipeline::Gather(Batch& batch, const SampleOrder& order){
+ for(unsigned int i=0; i<batch.samples; i++){
+  const unsigned int index = order.ReturnIndex(batch.first + i);
+  batch.input.col(i) = mInputDataset[index];
+  batch.target.col(i) = mTargetDataset[index];
+ }
+ if(mTransform) mTransform(batch.input.leftCols(batch.samples), batch.target.leftCols(batch.samples));
+}
+
+/**
+* The loop of a loader thread, it prepares the batches whose index
+* modulo the number of loaders is the index of the loader
+*
+**/
+void BatchPipeline::Run(unsigned int loaderIndex){
+ Loader& loader = *mLoaders[loaderIndex];
+ const unsigned long long loaders = mLoaders.size();
+ unsigned long long index = 0;
+ for(unsigned int epoch=mFirstEpoch; epoch<mLastEpoch; epoch++){
+  for(unsigned int position=(epoch == mFirstEpoch ? mFirstSample : 0); position<mDatasetSize; position+=mBatchSize, index++){
+   if(index % loaders != loaderIndex) continue;
+   Batch* batch = nullptr;
+   unsigned int spins = 0;
+   while(loader.free.Pop(batch) == false){
+    if(mStopping.load(std::memory_order_acquire)) return;
+    Backoff(spins);
+   }
+   if(mStopping.load(std::memory_order_acquire)){
+    loader.ready.Push(batch); //Stop() puts it back in the free queue
+    return;
+   }
+   NEUROC_TRACE_SCOPE("BatchPipeline::Gather");
+   batch->epoch = epoch;
+   batch->first = position;
+   batch->samples = std::min(mBatchSize, mDatasetSize - position);
+   loader.order.Prepare(epoch, mDatasetSize);
+   Gather(*batch, loader.order);
+   loader.ready.Push(batch);
+  }
+ }
+}
+
+} //namespace
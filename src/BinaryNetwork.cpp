@@ -0,0 +1,301 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "BinaryNetwork.h"
+#include "Network.h"
+#include "Dataset.h"
+#include "DenseLayer.h"
+#include "Trace.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include <iostream>
+#include <stdexcept>
+
+//The popcnt instruction is selected at runtime on the x86 processors,
+//the library does not need to be built with -mpopcnt
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEUROC_BINARY_POPCNT
+#endif
+
+namespace neuroc{
+
+namespace {
+
+const unsigned int kWordBits = 64;
+
+typedef int32_t (*XorCountFunction)(const uint64_t*, const uint64_t*, std::size_t);
+
+/**
+* It returns the number of different bits of the two arrays, the
+* number of equal bits (XNOR) is the number of bits minus this value.
+**/
+int32_t XorCountGeneric(const uint64_t* weights, const uint64_t* input, std::size_t words){
+ int32_t count = 0;
+ for(std::size_t i=0; i<words; i++) count += __builtin_popcountll(weights[i] ^ input[i]);
+ return count;
+}
+
+#ifdef NEUROC_BINARY_POPCNT
+__attribute__((target("popcnt")))
+int32_t XorCountPopcnt(const uint64_t* weights, const uint64_t* input, std::size_t words){
+ int32_t count = 0;
+ for(std::size_t i=0; i<words; i++) count += __builtin_popcountll(weights[i] ^ input[i]);
+ return count;
+}
+#endif
+
+XorCountFunction SelectXorCount(){
+ #ifdef NEUROC_BINARY_POPCNT
+ __builtin_cpu_init();
+ if(__builtin_cpu_supports("popcnt")) return &XorCountPopcnt;
+ #endif
+ return &XorCountGeneric;
+}
+
+const XorCountFunction kXorCount = SelectXorCount();
+
+/**
+* \struct ByteMasks
+* \brief For every byte, the eight bits as 0.0 or 1.0
+*/
+struct ByteMasks {
+ double values[256][8];
+ ByteMasks(){
+  for(unsigned int byte=0; byte<256; byte++){
+   for(unsigned int bit=0; bit<8; bit++) values[byte][bit] = (double) ((byte >> bit) & 1);
+  }
+ }
+};
+
+const ByteMasks kByteMasks;
+
+} //namespace
+
+
+BinaryNetwork::BinaryNetwork(){
+}
+
+/**
+* It builds the binarized network from a network trained in the binarized
+* mode, the layers that are not in the binarized mode are copied in double
+* precision. The layers must use the DotProduct weight function and the Sum
+* or Product join function, all the layers but the last one the HardLimit
+* transfer function and the last one a transfer function of the library.
+*
+* @param net the network, it is not modified
+* @return it returns true if it is all right, otherwise false
+**/
+bool BinaryNetwork::Binarize(Network& net){
+ typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+
+ if(net.Size() == 0){
+  std::cerr << "Neuroc Error: BinaryNetwork the network is empty" << std::endl;
+  return false;
+ }
+
+ std::vector<BinaryLayer> layers_vector(net.Size());
+ for(unsigned int i=0; i<net.Size(); i++){
+  BinaryLayer& layer = layers_vector[i];
+  const WeightFunction* weight_target = net[i].GetWeightFunction().target<WeightFunction>();
+  const JoinFunction* join_target = net[i].GetJoinFunction().target<JoinFunction>();
+  bool dot_product = (weight_target != nullptr && *weight_target == &WeightFunctions::DotProduct);
+  bool sum_join = (join_target != nullptr && *join_target == &JoinFunctions::Sum);
+  bool product_join = (join_target != nullptr && *join_target == &JoinFunctions::Product);
+  layer.transfer = TransferFunctions::InPlace::ReturnFunction(net[i].GetTransferFunction());
+  bool hard_limit = (layer.transfer == &TransferFunctions::InPlace::HardLimit);
+  if(dot_product == false || (sum_join == false && product_join == false) || layer.transfer == nullptr){
+   std::cerr << "Neuroc Error: BinaryNetwork the layer " << i << " uses functions that cannot be binarized" << std::endl;
+   return false;
+  }
+  if(i != net.Size()-1 && hard_limit == false){
+   std::cerr << "Neuroc Error: BinaryNetwork the hidden layer " << i << " must use the HardLimit transfer function" << std::endl;
+   return false;
+  }
+
+  const Eigen::MatrixXd& weight_matrix = net[i].GetWeightMatrix();
+  layer.inputSize = weight_matrix.cols();
+  layer.outputSize = weight_matrix.rows();
+  layer.words = (layer.inputSize + kWordBits - 1) / kWordBits;
+  layer.packed = net[i].IsBinarized();
+  layer.productJoin = product_join;
+  layer.bias = net[i].GetBiasVector();
+  layer.value = Eigen::VectorXd::Zero(layer.outputSize);
+  //The padding is zero both in the weights and in the input
+  if(i == 0) layer.inputValues = Eigen::VectorXd::Zero(layer.words * kWordBits);
+  else layer.inputBits.assign(layer.words, 0);
+  if(layer.packed == false){
+   layer.weightMatrix = weight_matrix;
+   continue;
+  }
+  layer.alpha = weight_matrix.cwiseAbs().rowwise().mean();
+  layer.weights.assign((std::size_t) layer.outputSize * layer.words, 0);
+  layer.weightSum.resize(layer.outputSize);
+  for(unsigned int row=0; row<layer.outputSize; row++){
+   int32_t positives = 0;
+   for(unsigned int col=0; col<layer.inputSize; col++){
+    if(weight_matrix(row, col) >= 0.0){
+     layer.weights[(std::size_t) row * layer.words + col / kWordBits] |= (uint64_t) 1 << (col % kWordBits);
+     positives++;
+    }
+   }
+   layer.weightSum[row] = 2 * positives - (int32_t) layer.inputSize;
+  }
+ }
+
+ mLayersVector = std::move(layers_vector);
+ mOutputVector = Eigen::VectorXd::Zero(mLayersVector.back().outputSize);
+ return true;
+}
+
+/**
+* It computes the output of the network. It does not allocate memory.
+*
+* @param inputVector
+* @return it returns a reference to the output of the network
+**/
+const Eigen::VectorXd& BinaryNetwork::Compute(const Eigen::VectorXd& inputVector){
+ NEUROC_TRACE_SCOPE("BinaryNetwork::Compute");
+ if(mLayersVector.size() == 0) throw std::domain_error("Error: BinaryNetwork the network was not binarized");
+ if(inputVector.size() != mLayersVector[0].inputSize) throw std::domain_error("Error: BinaryNetwork the input vector has a wrong size");
+
+ double input_sum = inputVector.sum();
+ mLayersVector[0].inputValues.head(inputVector.size()) = inputVector;
+ for(unsigned int l=0; l<mLayersVector.size(); l++){
+  BinaryLayer& layer = mLayersVector[l];
+
+  if(layer.packed == false && l == 0){
+   layer.value.noalias() = layer.weightMatrix * inputVector;
+  } else if(layer.packed == false){
+   //Only the columns of the input bits that are set are summed
+   layer.value.setZero();
+   for(unsigned int word=0; word<layer.words; word++){
+    for(uint64_t bits = layer.inputBits[word]; bits != 0; bits &= bits - 1){
+     layer.value += layer.weightMatrix.col(word * kWordBits + __builtin_ctzll(bits));
+    }
+   }
+  } else if(l == 0){
+   //sum(sign(w) * x) = 2 * sum(x where w >= 0) - sum(x), the bits of the
+   //weights select the input values eight at a time
+   const double* input = layer.inputValues.data();
+   for(unsigned int row=0; row<layer.outputSize; row++){
+    const uint64_t* weights = &layer.weights[(std::size_t) row * layer.words];
+    double positive_sums[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for(unsigned int word=0; word<layer.words; word++){
+     for(unsigned int byte=0; byte<8; byte++){
+      const double* mask = kByteMasks.values[(weights[word] >> (8 * byte)) & 0xFF];
+      const double* values = input + word * kWordBits + byte * 8;
+      for(unsigned int bit=0; bit<8; bit++) positive_sums[bit] += values[bit] * mask[bit];
+     }
+    }
+    double positive_sum = 0;
+    for(unsigned int bit=0; bit<8; bit++) positive_sum += positive_sums[bit];
+    layer.value[row] = layer.alpha[row] * (2.0 * positive_sum - input_sum);
+   }
+  } else {
+   //With the input bits h and s = 2h - 1: sum(sign(w) * s) = n - 2 * popcount(w xor h),
+   //the number of equal bits minus the different ones, and sum(sign(w) * h) is
+   //(sum(sign(w) * s) + sum(sign(w))) / 2
+   for(unsigned int row=0; row<layer.outputSize; row++){
+    int32_t different = kXorCount(&layer.weights[(std::size_t) row * layer.words], layer.inputBits.data(), layer.words);
+    layer.value[row] = layer.alpha[row] * 0.5 * ((int32_t) layer.inputSize - 2 * different + layer.weightSum[row]);
+   }
+  }
+
+  if(layer.productJoin) layer.value.array() *= layer.bias.array();
+  else layer.value += layer.bias;
+
+  if(l+1 < mLayersVector.size()){
+   //HardLimit packed directly in the input of the next layer
+   std::vector<uint64_t>& next_bits = mLayersVector[l+1].inputBits;
+   std::fill(next_bits.begin(), next_bits.end(), 0);
+   for(unsigned int row=0; row<layer.outputSize; row++){
+    if(layer.value[row] > 0.0) next_bits[row / kWordBits] |= (uint64_t) 1 << (row % kWordBits);
+   }
+  } else {
+   mOutputVector = layer.value;
+  }
+ }
+ mLayersVector.back().transfer(mOutputVector);
+ return mOutputVector;
+}
+
+/**
+* It returns the mean squared error of the network on a dataset
+*
+* @param inputDataset
+* @param targetDataset
+**/
+double BinaryNetwork::ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset){
+ double MSE = 0;
+ double dataset_size = inputDataset.ReturnNumberOfElements();
+ if(dataset_size != targetDataset.ReturnNumberOfElements()){
+  std::cerr << "Error: The input dataset and the target dataset have different dimensions." << std::endl;
+  return 0;
+ }
+ for(unsigned int i=0; i<dataset_size; i++){
+  MSE += (targetDataset[i] - Compute(inputDataset[i])).squaredNorm();
+ }
+ return MSE / dataset_size;
+}
+
+/**
+* It returns the number of layers
+*
+**/
+unsigned int BinaryNetwork::Size(){
+ return mLayersVector.size();
+}
+
+/**
+* It returns the memory used by the packed weights, the scales, the bias
+* and the buffers of the network
+*
+* @return it returns the number of bytes
+**/
+std::size_t BinaryNetwork::ReturnMemoryFootprint(){
+ std::size_t total_bytes = sizeof(BinaryNetwork) + mOutputVector.size() * sizeof(double);
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const BinaryLayer& layer = mLayersVector[i];
+  total_bytes += sizeof(BinaryLayer);
+  total_bytes += (layer.weights.size() + layer.inputBits.size()) * sizeof(uint64_t);
+  total_bytes += layer.weightSum.size() * sizeof(int32_t);
+  total_bytes += (layer.alpha.size() + layer.weightMatrix.size() + layer.bias.size() + layer.inputValues.size() + layer.value.size()) * sizeof(double);
+ }
+ return total_bytes;
+}
+
+/**
+* It returns true if the bits are counted by the popcnt instruction
+*
+**/
+bool BinaryNetwork::IsUsingPopcountInstruction(){
+ return kXorCount != &XorCountGeneric;
+}
+
+void BinaryNetwork::Print(){
+ std::cout << "popcnt ..... " << (IsUsingPopcountInstruction() ? "yes" : "no") << std::endl;
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const BinaryLayer& layer = mLayersVector[i];
+  std::cout << "Layer[" << i << "] " << layer.inputSize << "x" << layer.outputSize
+            << (layer.packed ? " packed in " : " double, input in ") << layer.words << " words per neuron" << std::endl;
+ }
+}
+
+} //namespace
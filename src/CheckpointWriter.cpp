@@ -0,0 +1,166 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "CheckpointWriter.h"
+#include "Trace.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace neuroc{
+
+namespace {
+
+/**
+* It flushes a file or a directory to the disk
+*
+**/
+bool Synchronize(const std::string& path){
+ int descriptor = open(path.c_str(), O_RDONLY);
+ if(descriptor < 0) return false;
+ bool done = (fsync(descriptor) == 0);
+ close(descriptor);
+ return done;
+}
+
+} //namespace
+
+/**
+* Class constructor, the background thread is started here
+*
+**/
+CheckpointWriter::CheckpointWriter(){
+ mPending = false;
+ mWriting = false;
+ mStopping = false;
+ mFailed = false;
+ mWrites = 0;
+ mDropped = 0;
+ mThread = std::thread(&CheckpointWriter::Run, this);
+}
+
+/**
+* Class destructor, the pending checkpoint is written before stopping the thread
+*
+**/
+CheckpointWriter::~CheckpointWriter(){
+ {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStopping = true;
+ }
+ mCondition.notify_all();
+ mThread.join();
+}
+
+/**
+* It gives a checkpoint to the background thread and it returns at once.
+* The copy of the network shares the weights and it costs the copy of the
+* layer buffers only. The binarized, sparse, factorized and clustered
+* layers also copy their own matrices, the copy costs as much as the model.
+*
+* @param snapshot the network to save
+* @param stateBlock the training state, saved in the extra block of the file
+* @param filePath the path of the checkpoint
+**/
+void CheckpointWriter::Submit(const Network& snapshot, const std::string& stateBlock, const std::string& filePath){
+ NEUROC_TRACE_SCOPE("CheckpointWriter::Submit");
+ Network network = snapshot;
+ {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if(mPending) mDropped++;
+  //The old snapshot is released outside the lock by the destructor of network
+  std::swap(mPendingNetwork, network);
+  mPendingState = stateBlock;
+  mPendingPath = filePath;
+  mPending = true;
+ }
+ mCondition.notify_all();
+}
+
+/**
+* It waits until the submitted checkpoints are written
+*
+* @return it returns false if a write failed since the previous call
+**/
+bool CheckpointWriter::Wait(){
+ std::unique_lock<std::mutex> lock(mMutex);
+ mCondition.wait(lock, [this](){ return mPending == false && mWriting == false; });
+ bool failed = mFailed;
+ mFailed = false;
+ return failed == false;
+}
+
+unsigned int CheckpointWriter::ReturnNumberOfWrites(){
+ std::lock_guard<std::mutex> lock(mMutex);
+ return mWrites;
+}
+
+unsigned int CheckpointWriter::ReturnNumberOfDropped(){
+ std::lock_guard<std::mutex> lock(mMutex);
+ return mDropped;
+}
+
+/**
+* It saves the network with the state in a temporary file, it flushes
+* the file to the disk and it renames it, then it flushes the directory
+* so that the new name survives a crash.
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool CheckpointWriter::WriteAtomically(Network& net, const std::string& stateBlock, const std::string& filePath){
+ NEUROC_TRACE_SCOPE("CheckpointWriter::WriteAtomically");
+ const std::string temporary_path = filePath + ".tmp";
+ if(net.SaveAsBinary(temporary_path, stateBlock) == false) return false;
+ if(Synchronize(temporary_path) == false || std::rename(temporary_path.c_str(), filePath.c_str()) != 0){
+  std::cerr << "Neuroc Error: CheckpointWriter cannot replace the checkpoint " << filePath << std::endl;
+  std::remove(temporary_path.c_str());
+  return false;
+ }
+ std::string::size_type separator = filePath.find_last_of('/');
+ Synchronize(separator == std::string::npos ? std::string(".") : (separator == 0 ? std::string("/") : filePath.substr(0, separator)));
+ return true;
+}
+
+/**
+* The loop of the background thread
+*
+**/
+void CheckpointWriter::Run(){
+ std::unique_lock<std::mutex> lock(mMutex);
+ while(true){
+  mCondition.wait(lock, [this](){ return mPending || mStopping; });
+  if(mPending == false) return;
+  Network network;
+  std::swap(network, mPendingNetwork);
+  std::string state = std::move(mPendingState);
+  std::string path = std::move(mPendingPath);
+  mPending = false;
+  mWriting = true;
+  lock.unlock();
+  bool written = WriteAtomically(network, state, path);
+  network = Network(); //the shared weights are released before the training is told
+  lock.lock();
+  mWriting = false;
+  if(written) mWrites++;
+  else mFailed = true;
+  mCondition.notify_all();
+ }
+}
+
+} //namespace
@@ -0,0 +1,316 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "ClusteredNetwork.h"
+#include "Network.h"
+#include "Dataset.h"
+#include "DenseLayer.h"
+#include "Trace.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include <iostream>
+#include <stdexcept>
+
+//The AVX-512 kernels are compiled for the x86 processors with g++ and they
+//are selected at runtime, the library does not need to be built with -mavx512f
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEUROC_CLUSTERED_AVX512
+#include <immintrin.h>
+#endif
+
+namespace neuroc{
+
+namespace {
+
+//Columns processed by an iteration of the kernels
+const unsigned int kGroupSize = 16;
+
+typedef double (*LookupDotFunction)(const uint8_t*, const double*, const double*, std::size_t);
+
+/**
+* It returns the dot product of the input with the centroids selected
+* by the 8-bit indices. The size must be a multiple of kGroupSize.
+**/
+double LookupDot8Scalar(const uint8_t* indices, const double* centroids, const double* input, std::size_t size){
+ double accumulators[4] = {0, 0, 0, 0};
+ for(std::size_t i=0; i<size; i+=4){
+  for(unsigned int j=0; j<4; j++) accumulators[j] += centroids[indices[i+j]] * input[i+j];
+ }
+ return (accumulators[0] + accumulators[1]) + (accumulators[2] + accumulators[3]);
+}
+
+/**
+* The same with the 4-bit indices, every 8 bytes hold the
+* indices of 16 columns (see ClusteredLayer::indices).
+**/
+double LookupDot4Scalar(const uint8_t* indices, const double* centroids, const double* input, std::size_t size){
+ double accumulators[4] = {0, 0, 0, 0};
+ for(std::size_t i=0; i<size; i+=kGroupSize){
+  const uint8_t* group = indices + i / 2;
+  for(unsigned int j=0; j<8; j+=2){
+   accumulators[0] += centroids[group[j] & 0x0F] * input[i+j];
+   accumulators[1] += centroids[group[j+1] & 0x0F] * input[i+j+1];
+   accumulators[2] += centroids[group[j] >> 4] * input[i+j+8];
+   accumulators[3] += centroids[group[j+1] >> 4] * input[i+j+9];
+  }
+ }
+ return (accumulators[0] + accumulators[1]) + (accumulators[2] + accumulators[3]);
+}
+
+#ifdef NEUROC_CLUSTERED_AVX512
+//The masked forms of the intrinsics are used where the plain ones
+//start from an undefined register, that g++ 12 reports as uninitialized
+
+__attribute__((target("avx512f")))
+double ReduceAdd(__m512d values){
+ double lanes[8];
+ _mm512_storeu_pd(lanes, values);
+ return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+/**
+* The 8-bit indices are extended to 64 bits and the
+* centroids are gathered eight at a time.
+**/
+__attribute__((target("avx512f")))
+double LookupDot8AVX512(const uint8_t* indices, const double* centroids, const double* input, std::size_t size){
+ __m512d accumulator_low = _mm512_setzero_pd();
+ __m512d accumulator_high = _mm512_setzero_pd();
+ for(std::size_t i=0; i<size; i+=kGroupSize){
+  __m512i indices_low = _mm512_maskz_cvtepu8_epi64(0xFF, _mm_loadl_epi64((const __m128i*)(indices + i)));
+  __m512i indices_high = _mm512_maskz_cvtepu8_epi64(0xFF, _mm_loadl_epi64((const __m128i*)(indices + i + 8)));
+  accumulator_low = _mm512_fmadd_pd(_mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, indices_low, centroids, 8), _mm512_loadu_pd(input + i), accumulator_low);
+  accumulator_high = _mm512_fmadd_pd(_mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, indices_high, centroids, 8), _mm512_loadu_pd(input + i + 8), accumulator_high);
+ }
+ return ReduceAdd(_mm512_add_pd(accumulator_low, accumulator_high));
+}
+
+/**
+* The 16 centroids of the 4-bit codebook are kept in two registers and
+* selected by a permutation, without reading the memory.
+**/
+__attribute__((target("avx512f")))
+double LookupDot4AVX512(const uint8_t* indices, const double* centroids, const double* input, std::size_t size){
+ const __m512d centroids_low = _mm512_loadu_pd(centroids);
+ const __m512d centroids_high = _mm512_loadu_pd(centroids + 8);
+ const __m512i mask = _mm512_set1_epi64(0x0F);
+ __m512d accumulator_low = _mm512_setzero_pd();
+ __m512d accumulator_high = _mm512_setzero_pd();
+ for(std::size_t i=0; i<size; i+=kGroupSize){
+  __m512i group = _mm512_maskz_cvtepu8_epi64(0xFF, _mm_loadl_epi64((const __m128i*)(indices + i / 2)));
+  __m512d weights_low = _mm512_permutex2var_pd(centroids_low, _mm512_and_si512(group, mask), centroids_high);
+  __m512d weights_high = _mm512_permutex2var_pd(centroids_low, _mm512_maskz_srli_epi64(0xFF, group, 4), centroids_high);
+  accumulator_low = _mm512_fmadd_pd(weights_low, _mm512_loadu_pd(input + i), accumulator_low);
+  accumulator_high = _mm512_fmadd_pd(weights_high, _mm512_loadu_pd(input + i + 8), accumulator_high);
+ }
+ return ReduceAdd(_mm512_add_pd(accumulator_low, accumulator_high));
+}
+#endif
+
+bool SupportsAVX512(){
+ #ifdef NEUROC_CLUSTERED_AVX512
+ __builtin_cpu_init();
+ return __builtin_cpu_supports("avx512f");
+ #else
+ return false;
+ #endif
+}
+
+LookupDotFunction SelectLookupDot8(){
+ #ifdef NEUROC_CLUSTERED_AVX512
+ if(SupportsAVX512()) return &LookupDot8AVX512;
+ #endif
+ return &LookupDot8Scalar;
+}
+
+LookupDotFunction SelectLookupDot4(){
+ #ifdef NEUROC_CLUSTERED_AVX512
+ if(SupportsAVX512()) return &LookupDot4AVX512;
+ #endif
+ return &LookupDot4Scalar;
+}
+
+const LookupDotFunction kLookupDot8 = SelectLookupDot8();
+const LookupDotFunction kLookupDot4 = SelectLookupDot4();
+
+} //namespace
+
+
+ClusteredNetwork::ClusteredNetwork(){
+}
+
+/**
+* It builds the compressed network. The layers must use the DotProduct
+* weight function, the Sum or Product join function and a transfer
+* function of the library.
+*
+* @param net the network, it is not modified
+* @return it returns true if it is all right, otherwise false
+**/
+bool ClusteredNetwork::Compress(Network& net){
+ typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+
+ if(net.Size() == 0){
+  std::cerr << "Neuroc Error: ClusteredNetwork the network is empty" << std::endl;
+  return false;
+ }
+
+ std::vector<ClusteredLayer> layers_vector(net.Size());
+ for(unsigned int i=0; i<net.Size(); i++){
+  ClusteredLayer& layer = layers_vector[i];
+  const WeightFunction* weight_target = net[i].GetWeightFunction().target<WeightFunction>();
+  const JoinFunction* join_target = net[i].GetJoinFunction().target<JoinFunction>();
+  bool dot_product = (weight_target != nullptr && *weight_target == &WeightFunctions::DotProduct);
+  bool sum_join = (join_target != nullptr && *join_target == &JoinFunctions::Sum);
+  bool product_join = (join_target != nullptr && *join_target == &JoinFunctions::Product);
+  layer.transfer = TransferFunctions::InPlace::ReturnFunction(net[i].GetTransferFunction());
+  if(dot_product == false || (sum_join == false && product_join == false) || layer.transfer == nullptr){
+   std::cerr << "Neuroc Error: ClusteredNetwork the layer " << i << " uses functions that cannot be compressed" << std::endl;
+   return false;
+  }
+
+  layer.inputSize = net[i].ReturnNumberOfInputs();
+  layer.outputSize = net[i].ReturnNumberOfNeurons();
+  layer.productJoin = product_join;
+  layer.bias = net[i].GetBiasVector();
+  layer.value = Eigen::VectorXd::Zero(layer.outputSize);
+  //The padding is zero in the input and it has the index zero
+  layer.paddedSize = (layer.inputSize + kGroupSize - 1) / kGroupSize * kGroupSize;
+  layer.inputValues = Eigen::VectorXd::Zero(layer.paddedSize);
+  if(net[i].IsClustered() == false){
+   layer.bits = 0;
+   layer.stride = 0;
+   //The binarized layers compute with the binarized weights, not with the shadow weights
+   layer.weightMatrix = net[i].GetEffectiveWeightMatrix();
+   continue;
+  }
+  const DenseLayer::IndexMatrix& index_matrix = net[i].GetIndexMatrix();
+  const Eigen::VectorXd& centroid_vector = net[i].GetCentroidVector();
+  layer.bits = (centroid_vector.size() <= 16) ? 4 : 8;
+  layer.centroids = Eigen::VectorXd::Zero(std::max<Eigen::Index>(centroid_vector.size(), 16));
+  layer.centroids.head(centroid_vector.size()) = centroid_vector;
+  layer.stride = (layer.bits == 4) ? layer.paddedSize / 2 : layer.paddedSize;
+  layer.indices.assign((std::size_t) layer.outputSize * layer.stride, 0);
+  for(unsigned int row=0; row<layer.outputSize; row++){
+   uint8_t* indices = &layer.indices[(std::size_t) row * layer.stride];
+   for(unsigned int col=0; col<layer.inputSize; col++){
+    if(layer.bits == 8) indices[col] = index_matrix(row, col);
+    else indices[col / 2 - (col % kGroupSize) / 2 + col % 8] |= index_matrix(row, col) << (col % kGroupSize >= 8 ? 4 : 0);
+   }
+  }
+ }
+
+ mLayersVector = std::move(layers_vector);
+ return true;
+}
+
+/**
+* It computes the output of the network. It does not allocate memory.
+*
+* @param inputVector
+* @return it returns a reference to the output of the network
+**/
+const Eigen::VectorXd& ClusteredNetwork::Compute(const Eigen::VectorXd& inputVector){
+ NEUROC_TRACE_SCOPE("ClusteredNetwork::Compute");
+ if(mLayersVector.size() == 0) throw std::domain_error("Error: ClusteredNetwork the network was not compressed");
+ if(inputVector.size() != mLayersVector[0].inputSize) throw std::domain_error("Error: ClusteredNetwork the input vector has a wrong size");
+
+ mLayersVector[0].inputValues.head(inputVector.size()) = inputVector;
+ for(unsigned int l=0; l<mLayersVector.size(); l++){
+  ClusteredLayer& layer = mLayersVector[l];
+  if(layer.bits == 0){
+   layer.value.noalias() = layer.weightMatrix * layer.inputValues.head(layer.inputSize);
+  } else {
+   LookupDotFunction lookup_dot = (layer.bits == 4) ? kLookupDot4 : kLookupDot8;
+   for(unsigned int row=0; row<layer.outputSize; row++){
+    layer.value[row] = lookup_dot(&layer.indices[(std::size_t) row * layer.stride], layer.centroids.data(), layer.inputValues.data(), layer.paddedSize);
+   }
+  }
+
+  if(layer.productJoin) layer.value.array() *= layer.bias.array();
+  else layer.value += layer.bias;
+  layer.transfer(layer.value);
+  if(l+1 < mLayersVector.size()) mLayersVector[l+1].inputValues.head(layer.outputSize) = layer.value;
+ }
+ return mLayersVector.back().value;
+}
+
+/**
+* It returns the mean squared error of the network on a dataset
+*
+* @param inputDataset
+* @param targetDataset
+**/
+double ClusteredNetwork::ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset){
+ double MSE = 0;
+ double dataset_size = inputDataset.ReturnNumberOfElements();
+ if(dataset_size != targetDataset.ReturnNumberOfElements()){
+  std::cerr << "Error: The input dataset and the target dataset have different dimensions." << std::endl;
+  return 0;
+ }
+ for(unsigned int i=0; i<dataset_size; i++){
+  MSE += (targetDataset[i] - Compute(inputDataset[i])).squaredNorm();
+ }
+ return MSE / dataset_size;
+}
+
+/**
+* It returns the number of layers
+*
+**/
+unsigned int ClusteredNetwork::Size(){
+ return mLayersVector.size();
+}
+
+/**
+* It returns the memory used by the indices, the codebooks, the bias
+* and the buffers of the network
+*
+* @return it returns the number of bytes
+**/
+std::size_t ClusteredNetwork::ReturnMemoryFootprint(){
+ std::size_t total_bytes = sizeof(ClusteredNetwork);
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const ClusteredLayer& layer = mLayersVector[i];
+  total_bytes += sizeof(ClusteredLayer) + layer.indices.size() * sizeof(uint8_t);
+  total_bytes += (layer.centroids.size() + layer.weightMatrix.size() + layer.bias.size() + layer.inputValues.size() + layer.value.size()) * sizeof(double);
+ }
+ return total_bytes;
+}
+
+/**
+* It returns true if the dot products use the AVX-512 kernels
+*
+**/
+bool ClusteredNetwork::IsUsingSIMD(){
+ return kLookupDot4 != &LookupDot4Scalar;
+}
+
+void ClusteredNetwork::Print(){
+ std::cout << "AVX-512 ..... " << (IsUsingSIMD() ? "yes" : "no") << std::endl;
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const ClusteredLayer& layer = mLayersVector[i];
+  std::cout << "Layer[" << i << "] " << layer.inputSize << "x" << layer.outputSize;
+  if(layer.bits == 0) std::cout << " double" << std::endl;
+  else std::cout << " " << layer.centroids.size() << " centroids, " << layer.bits << "-bit indices" << std::endl;
+ }
+}
+
+} //namespace
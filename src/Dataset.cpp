@@ -18,14 +18,31 @@
 */
 
 #include"Dataset.h"
+#include "Trace.h"
+#include "Executor.h"
 #include <iterator>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <sstream>
+#include <utility>
 
 namespace neuroc{
 
+namespace {
+
+/**
+* It returns the number of values stored in the elements, the work of an
+* operation on every value for the threshold of the Executor
+**/
+std::size_t ReturnNumberOfValues(const std::vector<Eigen::VectorXd,Eigen::aligned_allocator<Eigen::VectorXd> >& dataVector){
+ std::size_t values = 0;
+ for(std::size_t i=0; i<dataVector.size(); i++) values += dataVector[i].size();
+ return values;
+}
+
+} //namespace
+
 /**
 * Class constructor.
 *
@@ -42,6 +59,46 @@ Dataset::Dataset(unsigned int datasetDimension) {
  mDataVector.reserve(datasetDimension);
 }
 
+/**
+* Copy constructor
+*
+* @param rDataset reference to an existing Dataset
+*/
+Dataset::Dataset(const Dataset &rDataset) {
+ mDataVector = rDataset.mDataVector;
+}
+
+/**
+* Move constructor, the vectors are taken without copying them
+*
+* @param rDataset rvalue reference to an existing Dataset
+*/
+Dataset::Dataset(Dataset &&rDataset) noexcept {
+ mDataVector = std::move(rDataset.mDataVector);
+}
+
+/**
+* Overload of the assignment operator
+*
+* @param rDataset reference to an existing Dataset
+*/
+Dataset& Dataset::operator=(const Dataset &rDataset) {
+ if (this == &rDataset) return *this;  // check for self-assignment
+ mDataVector = rDataset.mDataVector;
+ return *this;
+}
+
+/**
+* Overload of the move assignment operator
+*
+* @param rDataset rvalue reference to an existing Dataset
+*/
+Dataset& Dataset::operator=(Dataset &&rDataset) noexcept {
+ if (this == &rDataset) return *this;  // check for self-assignment
+ mDataVector = std::move(rDataset.mDataVector);
+ return *this;
+}
+
 /**
 * Class destructor.
 *
@@ -57,13 +114,10 @@ Dataset::~Dataset() {
 **/
 bool Dataset::DivideBy(double divisor){
  if(divisor == 0) return false;
- for(auto it_set=mDataVector.begin(); it_set!=mDataVector.end(); ++it_set) {
-  (*it_set) = (*it_set) / divisor; //using the eigen vector properties for the division
-  //for(unsigned int i=0; i<it_set->size(); i++){
-   //double evector_value = (*it_set)[i];
-   //(*it_set)[i] = evector_value / divisor;
-  //}
- }
+ //Large datasets are split in blocks of elements among the threads of the Executor
+ Executor::ReturnInstance().ParallelFor(0, mDataVector.size(), ReturnNumberOfValues(mDataVector), [&](std::size_t begin, std::size_t end){
+  for(std::size_t i=begin; i<end; i++) mDataVector[i] = mDataVector[i] / divisor; //using the eigen vector properties for the division
+ });
  return true;
 }
 
@@ -73,13 +127,9 @@ bool Dataset::DivideBy(double divisor){
 * @param multiplier
 **/
 bool Dataset::MultiplyBy(double multiplier){
- for(auto it_set=mDataVector.begin(); it_set!=mDataVector.end(); ++it_set) {
-  (*it_set) = (*it_set) * multiplier;
-  //for(unsigned int i=0; i<it_set->size(); i++){
-  // double evector_value = (*it_set)[i];
-   //(*it_set)[i] = evector_value * multiplier;
-  //}
- }
+ Executor::ReturnInstance().ParallelFor(0, mDataVector.size(), ReturnNumberOfValues(mDataVector), [&](std::size_t begin, std::size_t end){
+  for(std::size_t i=begin; i<end; i++) mDataVector[i] = mDataVector[i] * multiplier;
+ });
  return true;
 }
 
@@ -99,11 +149,21 @@ Eigen::VectorXd& Dataset::operator[](unsigned int index) {
 *
 * @param dataToPush the vector of values to push inside the Dataset
 **/
-bool Dataset::PushBackData(Eigen::VectorXd dataToPush) {
+bool Dataset::PushBackData(const Eigen::VectorXd& dataToPush) {
  mDataVector.push_back(dataToPush);
  return true;
 }
 
+/**
+* It moves a vector at the end of the Dataset, the values are not copied
+*
+* @param dataToPush the vector of values to move inside the Dataset
+**/
+bool Dataset::PushBackData(Eigen::VectorXd&& dataToPush) {
+ mDataVector.push_back(std::move(dataToPush));
+ return true;
+}
+
 /**
 * It splits the dataset in two parts, mantaining in the current object
 * only the first part, and returning as a dataset the second part.
@@ -111,7 +171,8 @@ bool Dataset::PushBackData(Eigen::VectorXd dataToPush) {
 * @param index the point where apply the split.
 **/
 Dataset Dataset::Split(unsigned int index){
- Dataset dataset_to_return;
+ NEUROC_TRACE_SCOPE("Dataset::Split");
+ Dataset dataset_to_return(mDataVector.size());
 
  if(mDataVector.size()==0){
   std::cerr << "Error: Dataset empty." << std::endl;
@@ -129,12 +190,9 @@ Dataset Dataset::Split(unsigned int index){
  //single eigen-vectors in two subvectors, one to
  //return and one to have.
  for(unsigned int i=0; i<mDataVector.size(); i++){
-  Eigen::VectorXd vector_to_give(size_to_give);
-  Eigen::VectorXd vector_to_have(index);
-  vector_to_give = mDataVector[i].tail(size_to_give);
-  vector_to_have = mDataVector[i].head(index);
-  dataset_to_return.PushBackData(vector_to_give);
-  mDataVector[i] = vector_to_have;
+  Eigen::VectorXd vector_to_give = mDataVector[i].tail(size_to_give);
+  dataset_to_return.PushBackData(std::move(vector_to_give));
+  mDataVector[i].conservativeResize(index);
  }
  
  return dataset_to_return;
@@ -169,7 +227,7 @@ Eigen::VectorXd Dataset::GetData(unsigned int index) {
 **/
 bool Dataset::SetData(unsigned int index, Eigen::VectorXd data) {
  try {
-  mDataVector[index] = data;
+  mDataVector[index] = std::move(data);
   return true;
  } catch(...) {
   std::cerr << "Error: out of Range error." << '\n';
@@ -187,6 +245,21 @@ unsigned int Dataset::ReturnNumberOfElements() {
 }
 
 
+/**
+* It returns the memory used by the Dataset, including
+* the unused capacity of the container.
+*
+* @return it returns the number of bytes
+**/
+std::size_t Dataset::ReturnMemoryFootprint() {
+ std::size_t total_bytes = sizeof(Dataset) + mDataVector.capacity() * sizeof(Eigen::VectorXd);
+ for(auto it_set=mDataVector.begin(); it_set!=mDataVector.end(); ++it_set) {
+  total_bytes += it_set->size() * sizeof(double);
+ }
+ return total_bytes;
+}
+
+
 /**
 * It prints the data stored inside the Dataset
 *
@@ -230,6 +303,7 @@ void Dataset::PrintData(unsigned int index){
 * @param filePath the path to the file to load
 **/
 bool Dataset::LoadFromCSV(std::string filePath){
+ NEUROC_TRACE_SCOPE("Dataset::LoadFromCSV");
  if(FileExist(filePath) == false){
   std::cerr<<"Error: Cannot find the input file."<<std::endl;
   return false;
@@ -256,7 +330,7 @@ bool Dataset::LoadFromCSV(std::string filePath){
    data_vector[j] = temp_vector[j];
   }
   //push the temp vector inside the dataset
-  mDataVector.push_back(data_vector);
+  mDataVector.push_back(std::move(data_vector));
  }
  train_file.close();
  return true;
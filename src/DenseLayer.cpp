@@ -19,10 +19,64 @@
 
 
 #include "DenseLayer.h"
+#include "Trace.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include "Executor.h"
+#include <utility>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <cmath>
 
 
 namespace neuroc{
 
+namespace {
+
+//Multiply-adds counted for an element of a transfer function, for the threshold of the Executor
+const std::size_t kTransferCost = 16;
+
+/**
+* It returns the indices in [0, size) that are not in the removed ones
+*
+* @return it returns false if an index is out of range or nothing is left
+**/
+bool ReturnKeptIndices(const std::vector<unsigned int>& removed, Eigen::Index size, std::vector<Eigen::Index>& kept){
+ std::vector<bool> is_removed(size, false);
+ for(unsigned int i=0; i<removed.size(); i++){
+  if(removed[i] >= size){
+   std::cerr << "Neuroc Error: DenseLayer the index " << removed[i] << " is out of range" << std::endl;
+   return false;
+  }
+  is_removed[removed[i]] = true;
+ }
+ kept.clear();
+ for(Eigen::Index i=0; i<size; i++) if(is_removed[i] == false) kept.push_back(i);
+ if(kept.empty()){
+  std::cerr << "Neuroc Error: DenseLayer at least one element must be kept" << std::endl;
+  return false;
+ }
+ return true;
+}
+
+/**
+* It adds the outer product of two vectors to a matrix in place, column by column:
+* M = decayFactor * M + learningRate * clip(leftVector * rightVector')
+*
+* @param clipValue the changes are clipped in [-clipValue, +clipValue], zero to disable it
+**/
+void AddOuterProduct(Eigen::MatrixXd& matrix, double learningRate, const Eigen::Ref<const Eigen::VectorXd>& leftVector, const Eigen::Ref<const Eigen::VectorXd>& rightVector, double decayFactor, double clipValue){
+ for(unsigned int col=0; col<matrix.cols(); col++){
+  if(clipValue > 0) matrix.col(col) = decayFactor * matrix.col(col) + learningRate * (leftVector * rightVector[col]).cwiseMax(-clipValue).cwiseMin(clipValue);
+  else if(decayFactor != 1.0) matrix.col(col) = decayFactor * matrix.col(col) + (learningRate * rightVector[col]) * leftVector;
+  else matrix.col(col) += (learningRate * rightVector[col]) * leftVector;
+ }
+}
+
+} //namespace
+
 
 
 DenseLayer::DenseLayer(unsigned int inputSize, unsigned int outputSize, std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)> weightFunction, std::function<Eigen::VectorXd(Eigen::VectorXd,Eigen::VectorXd)> joinFunction, std::function<Eigen::VectorXd(Eigen::VectorXd)> transferFunction, std::function<Eigen::VectorXd(Eigen::VectorXd)> derivativeFunction){
@@ -33,13 +87,13 @@ DenseLayer::DenseLayer(unsigned int inputSize, unsigned int outputSize, std::fun
  mInputVector = Eigen::VectorXd::Zero(inputSize);
  mOutputVector = Eigen::VectorXd::Zero(outputSize);
  mErrorVector = Eigen::VectorXd::Zero(outputSize);
- mBiasVector = Eigen::VectorXd::Random(outputSize);
+ mBiasVector = std::make_shared<Eigen::VectorXd>(Eigen::VectorXd::Random(outputSize));
 
  //Eigen create a random matrix of input x output dimension
  //The value of the weights are randomized between -1 and +1
  std::srand((unsigned int) time(0));
  //mWeightMatrix = Eigen::MatrixXd::Random(inputSize,outputSize);
- mWeightMatrix = Eigen::MatrixXd::Random(outputSize,inputSize);
+ mWeightMatrix = std::make_shared<Eigen::MatrixXd>(Eigen::MatrixXd::Random(outputSize,inputSize));
 
  //Assigning the activation function to he layer
  //The default function is the linear one.
@@ -48,6 +102,14 @@ DenseLayer::DenseLayer(unsigned int inputSize, unsigned int outputSize, std::fun
  mJoinFunction = joinFunction;
  mTransferFunction =  transferFunction;
  mDerivativeFunction =  derivativeFunction;
+ mBinarized = false;
+ mSparse = false;
+ mFactorized = false;
+ mFactorizedWeightsOutdated = false;
+ mClustered = false;
+ mMixedPrecision = false;
+ mFloatWeightsOutdated = false;
+ SelectKernels();
 }
 
 /**
@@ -63,20 +125,83 @@ DenseLayer::DenseLayer(const DenseLayer &rDenseLayer)
  mErrorVector = rDenseLayer.mErrorVector;
  mBiasVector = rDenseLayer.mBiasVector;
  mWeightMatrix = rDenseLayer.mWeightMatrix;
+ mBinaryWeightMatrix = rDenseLayer.mBinaryWeightMatrix;
+ mBinarized = rDenseLayer.mBinarized;
+ mSparseWeightMatrix = rDenseLayer.mSparseWeightMatrix;
+ mSparse = rDenseLayer.mSparse;
+ mLeftFactorMatrix = rDenseLayer.mLeftFactorMatrix;
+ mRightFactorMatrix = rDenseLayer.mRightFactorMatrix;
+ mFactorized = rDenseLayer.mFactorized;
+ mFactorizedWeightsOutdated = rDenseLayer.mFactorizedWeightsOutdated;
+ mCentroidVector = rDenseLayer.mCentroidVector;
+ mCentroidChangeVector = rDenseLayer.mCentroidChangeVector;
+ mIndexMatrix = rDenseLayer.mIndexMatrix;
+ mClustered = rDenseLayer.mClustered;
+ //The single precision copy is not copied, the master weights are shared and
+ //the copy computes it again if it is trained (snapshots use the master weights)
+ mMixedPrecision = rDenseLayer.mMixedPrecision;
+ mFloatWeightsOutdated = rDenseLayer.mMixedPrecision;
  mWeightFunction = rDenseLayer.mWeightFunction;
  mJoinFunction = rDenseLayer.mJoinFunction;
  mTransferFunction = rDenseLayer.mTransferFunction;
  mDerivativeFunction = rDenseLayer.mDerivativeFunction;
+ mDotProductKernel = rDenseLayer.mDotProductKernel;
+ mJoinKernel = rDenseLayer.mJoinKernel;
+ mTransferKernel = rDenseLayer.mTransferKernel;
+ mDerivativeKernel = rDenseLayer.mDerivativeKernel;
+ mProfile = rDenseLayer.mProfile;
 }
 
 
 
+/**
+* Move constructor, the weights and the vectors are taken without copying them
+*
+* @param rDenseLayer rvalue reference to an existing DenseLayer
+*/
+DenseLayer::DenseLayer(DenseLayer &&rDenseLayer) noexcept
+{
+ mInputVector = std::move(rDenseLayer.mInputVector);
+ mOutputVector = std::move(rDenseLayer.mOutputVector);
+ mDerivativeVector = std::move(rDenseLayer.mDerivativeVector);
+ mErrorVector = std::move(rDenseLayer.mErrorVector);
+ mBiasVector = std::move(rDenseLayer.mBiasVector);
+ mWeightMatrix = std::move(rDenseLayer.mWeightMatrix);
+ mBinaryWeightMatrix = std::move(rDenseLayer.mBinaryWeightMatrix);
+ mBinarized = rDenseLayer.mBinarized;
+ mSparseWeightMatrix.swap(rDenseLayer.mSparseWeightMatrix); //the sparse matrices of Eigen 3.4 are not movable
+ mSparse = rDenseLayer.mSparse;
+ mLeftFactorMatrix = std::move(rDenseLayer.mLeftFactorMatrix);
+ mRightFactorMatrix = std::move(rDenseLayer.mRightFactorMatrix);
+ mFactorMatrix = std::move(rDenseLayer.mFactorMatrix);
+ mFactorErrorMatrix = std::move(rDenseLayer.mFactorErrorMatrix);
+ mFactorized = rDenseLayer.mFactorized;
+ mFactorizedWeightsOutdated = rDenseLayer.mFactorizedWeightsOutdated;
+ mCentroidVector = std::move(rDenseLayer.mCentroidVector);
+ mCentroidChangeVector = std::move(rDenseLayer.mCentroidChangeVector);
+ mIndexMatrix = std::move(rDenseLayer.mIndexMatrix);
+ mClustered = rDenseLayer.mClustered;
+ mFloatWeightMatrix = std::move(rDenseLayer.mFloatWeightMatrix);
+ mMixedPrecision = rDenseLayer.mMixedPrecision;
+ mFloatWeightsOutdated = rDenseLayer.mFloatWeightsOutdated;
+ mWeightFunction = std::move(rDenseLayer.mWeightFunction);
+ mJoinFunction = std::move(rDenseLayer.mJoinFunction);
+ mTransferFunction = std::move(rDenseLayer.mTransferFunction);
+ mDerivativeFunction = std::move(rDenseLayer.mDerivativeFunction);
+ mDotProductKernel = rDenseLayer.mDotProductKernel;
+ mJoinKernel = rDenseLayer.mJoinKernel;
+ mTransferKernel = rDenseLayer.mTransferKernel;
+ mDerivativeKernel = rDenseLayer.mDerivativeKernel;
+ mProfile = rDenseLayer.mProfile;
+}
+
+
 /**
 * Overload of the assignment operator
 *
 * @param rDenseLayer reference to an existing DenseLayer
 */
-DenseLayer DenseLayer::operator=(const DenseLayer &rDenseLayer)
+DenseLayer& DenseLayer::operator=(const DenseLayer &rDenseLayer)
 {  		
 if (this == &rDenseLayer) return *this;  // check for self-assignment 
  mInputVector = rDenseLayer.mInputVector;
@@ -85,50 +210,345 @@ if (this == &rDenseLayer) return *this;  // check for self-assignment
  mErrorVector = rDenseLayer.mErrorVector;
  mBiasVector = rDenseLayer.mBiasVector;
  mWeightMatrix = rDenseLayer.mWeightMatrix;
+ mBinaryWeightMatrix = rDenseLayer.mBinaryWeightMatrix;
+ mBinarized = rDenseLayer.mBinarized;
+ mSparseWeightMatrix = rDenseLayer.mSparseWeightMatrix;
+ mSparse = rDenseLayer.mSparse;
+ mLeftFactorMatrix = rDenseLayer.mLeftFactorMatrix;
+ mRightFactorMatrix = rDenseLayer.mRightFactorMatrix;
+ mFactorized = rDenseLayer.mFactorized;
+ mFactorizedWeightsOutdated = rDenseLayer.mFactorizedWeightsOutdated;
+ mCentroidVector = rDenseLayer.mCentroidVector;
+ mCentroidChangeVector = rDenseLayer.mCentroidChangeVector;
+ mIndexMatrix = rDenseLayer.mIndexMatrix;
+ mClustered = rDenseLayer.mClustered;
+ mFloatWeightMatrix.resize(0, 0); //see the copy constructor
+ mMixedPrecision = rDenseLayer.mMixedPrecision;
+ mFloatWeightsOutdated = rDenseLayer.mMixedPrecision;
  mWeightFunction = rDenseLayer.mWeightFunction;
  mJoinFunction = rDenseLayer.mJoinFunction;
  mTransferFunction = rDenseLayer.mTransferFunction;
  mDerivativeFunction = rDenseLayer.mDerivativeFunction;
+ mDotProductKernel = rDenseLayer.mDotProductKernel;
+ mJoinKernel = rDenseLayer.mJoinKernel;
+ mTransferKernel = rDenseLayer.mTransferKernel;
+ mDerivativeKernel = rDenseLayer.mDerivativeKernel;
+ mProfile = rDenseLayer.mProfile;
 return *this;
 }
 
 
 
+/**
+* Overload of the move assignment operator
+*
+* @param rDenseLayer rvalue reference to an existing DenseLayer
+*/
+DenseLayer& DenseLayer::operator=(DenseLayer &&rDenseLayer) noexcept
+{
+if (this == &rDenseLayer) return *this;  // check for self-assignment
+ mInputVector = std::move(rDenseLayer.mInputVector);
+ mOutputVector = std::move(rDenseLayer.mOutputVector);
+ mDerivativeVector = std::move(rDenseLayer.mDerivativeVector);
+ mErrorVector = std::move(rDenseLayer.mErrorVector);
+ mBiasVector = std::move(rDenseLayer.mBiasVector);
+ mWeightMatrix = std::move(rDenseLayer.mWeightMatrix);
+ mBinaryWeightMatrix = std::move(rDenseLayer.mBinaryWeightMatrix);
+ mBinarized = rDenseLayer.mBinarized;
+ mSparseWeightMatrix.swap(rDenseLayer.mSparseWeightMatrix); //the sparse matrices of Eigen 3.4 are not movable
+ mSparse = rDenseLayer.mSparse;
+ mLeftFactorMatrix = std::move(rDenseLayer.mLeftFactorMatrix);
+ mRightFactorMatrix = std::move(rDenseLayer.mRightFactorMatrix);
+ mFactorMatrix = std::move(rDenseLayer.mFactorMatrix);
+ mFactorErrorMatrix = std::move(rDenseLayer.mFactorErrorMatrix);
+ mFactorized = rDenseLayer.mFactorized;
+ mFactorizedWeightsOutdated = rDenseLayer.mFactorizedWeightsOutdated;
+ mCentroidVector = std::move(rDenseLayer.mCentroidVector);
+ mCentroidChangeVector = std::move(rDenseLayer.mCentroidChangeVector);
+ mIndexMatrix = std::move(rDenseLayer.mIndexMatrix);
+ mClustered = rDenseLayer.mClustered;
+ mFloatWeightMatrix = std::move(rDenseLayer.mFloatWeightMatrix);
+ mMixedPrecision = rDenseLayer.mMixedPrecision;
+ mFloatWeightsOutdated = rDenseLayer.mFloatWeightsOutdated;
+ mWeightFunction = std::move(rDenseLayer.mWeightFunction);
+ mJoinFunction = std::move(rDenseLayer.mJoinFunction);
+ mTransferFunction = std::move(rDenseLayer.mTransferFunction);
+ mDerivativeFunction = std::move(rDenseLayer.mDerivativeFunction);
+ mDotProductKernel = rDenseLayer.mDotProductKernel;
+ mJoinKernel = rDenseLayer.mJoinKernel;
+ mTransferKernel = rDenseLayer.mTransferKernel;
+ mDerivativeKernel = rDenseLayer.mDerivativeKernel;
+ mProfile = rDenseLayer.mProfile;
+return *this;
+}
+
+
 DenseLayer::~DenseLayer() {
 }
 
 
 
+/**
+* It looks for the allocation free versions of the functions assigned to the layer.
+* The library functions (DotProduct, Sum, Product and the TransferFunctions) are
+* replaced by kernels working in place, the other functions are called as they are.
+*
+**/
+void DenseLayer::SelectKernels(){
+ typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+
+ const WeightFunction* weight_target = mWeightFunction.target<WeightFunction>();
+ mDotProductKernel = (weight_target != nullptr && *weight_target == &WeightFunctions::DotProduct);
+
+ const JoinFunction* join_target = mJoinFunction.target<JoinFunction>();
+ mJoinKernel = JOIN_GENERIC;
+ if(join_target != nullptr && *join_target == &JoinFunctions::Sum) mJoinKernel = JOIN_SUM;
+ if(join_target != nullptr && *join_target == &JoinFunctions::Product) mJoinKernel = JOIN_PRODUCT;
+
+ mTransferKernel = TransferFunctions::InPlace::ReturnFunction(mTransferFunction);
+ mDerivativeKernel = TransferFunctions::InPlace::ReturnFunction(mDerivativeFunction);
+}
+
+/**
+* It applies the weight function and the join function to the input vector.
+*
+* @param inputVector the input of the layer
+* @param outputVector where the result is stored
+**/
+void DenseLayer::ComputeWeightedInput(const Eigen::VectorXd& inputVector, Eigen::VectorXd& outputVector){
+ NEUROC_PROFILE_START(profile_timer);
+ if(mDotProductKernel){
+  if(mWeightMatrix->cols() != inputVector.size()) throw std::domain_error("Error: DotProduct requires equal length vectors");
+  if(mFactorized){
+   mFactorMatrix.resize(mRightFactorMatrix.rows(), 1);
+   mFactorMatrix.col(0).noalias() = mRightFactorMatrix * inputVector;
+   outputVector.noalias() = mLeftFactorMatrix * mFactorMatrix.col(0);
+  }
+  else if(mSparse) outputVector.noalias() = mSparseWeightMatrix * inputVector;
+  else {
+   //Wide layers are split in blocks of rows among the threads of the Executor
+   const Eigen::MatrixXd& weight_matrix = ReturnComputeWeightMatrix();
+   Executor& executor = Executor::ReturnInstance();
+   if(executor.IsParallel(weight_matrix.size())){
+    outputVector.resize(weight_matrix.rows());
+    executor.ParallelFor(0, weight_matrix.rows(), weight_matrix.size(), [&](std::size_t begin, std::size_t end){
+     outputVector.segment(begin, end - begin).noalias() = weight_matrix.middleRows(begin, end - begin) * inputVector;
+    });
+   }
+   else outputVector.noalias() = weight_matrix * inputVector; //outputVector = weight_matrix * inputVector;
+  }
+ } else {
+  outputVector = mWeightFunction(ReturnComputeWeightMatrix(), inputVector);
+ }
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.weightNs);
+
+ if(mJoinKernel == JOIN_SUM) outputVector += (*mBiasVector);
+ else if(mJoinKernel == JOIN_PRODUCT) outputVector.array() *= mBiasVector->array();
+ else outputVector = mJoinFunction(outputVector, (*mBiasVector));
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.joinNs);
+}
+
 /**
 * Compute all the neurons of the DenseLayer and return a vector containing the values of these neurons
+* If the functions of the layer are the ones of the library, the computation does not allocate memory.
 *
-* @return it returns the vector containing the double, in case of problems it returns an empty vector and print an error
+* @return it returns a reference to the output vector of the layer
 **/
-Eigen::VectorXd DenseLayer::Compute(Eigen::VectorXd inputVector) {
+const Eigen::VectorXd& DenseLayer::Compute(const Eigen::VectorXd& inputVector) {
 
+ NEUROC_TRACE_SCOPE("DenseLayer::Compute");
  mInputVector = inputVector;
- mOutputVector = mWeightFunction(mWeightMatrix, mInputVector);  //mOutputVector = mWeightMatrix * mInputVector;
- mOutputVector = mJoinFunction(mOutputVector, mBiasVector);  //mOutputVector = mOutputVector + mBiasVector;
- mOutputVector = mTransferFunction(mOutputVector);
+ ComputeWeightedInput(mInputVector, mOutputVector);
+ NEUROC_PROFILE_START(profile_timer);
+ if(mTransferKernel != nullptr) mTransferKernel(mOutputVector);
+ else mOutputVector = mTransferFunction(mOutputVector);
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.transferNs);
 
+ //The operations are counted as for the DotProduct weight function
+ NEUROC_PROFILE_COUNT(mProfile.calls, 1);
+ NEUROC_PROFILE_COUNT(mProfile.flops, 2 * ReturnComputeWeightCount() + 2 * mOutputVector.size());
+ NEUROC_PROFILE_COUNT(mProfile.bytes, sizeof(double) * (ReturnComputeWeightCount() + mInputVector.size() + 2 * mOutputVector.size()));
  return mOutputVector;
 }
 
-Eigen::VectorXd DenseLayer::ComputeDerivative(Eigen::VectorXd inputVector) {
+const Eigen::VectorXd& DenseLayer::ComputeDerivative(const Eigen::VectorXd& inputVector) {
 
- mDerivativeVector = mWeightFunction(mWeightMatrix, inputVector); //mDerivativeVector = mWeightMatrix * mInputVector;
- mDerivativeVector = mJoinFunction(mDerivativeVector, mBiasVector); //mDerivativeVector = mDerivativeVector + mBiasVector;
- mDerivativeVector = mDerivativeFunction(mDerivativeVector);
+ NEUROC_TRACE_SCOPE("DenseLayer::ComputeDerivative");
+ ComputeWeightedInput(inputVector, mDerivativeVector);
+ NEUROC_PROFILE_START(profile_timer);
+ if(mDerivativeKernel != nullptr) mDerivativeKernel(mDerivativeVector);
+ else mDerivativeVector = mDerivativeFunction(mDerivativeVector);
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.derivativeNs);
 
+ NEUROC_PROFILE_COUNT(mProfile.derivativeCalls, 1);
+ NEUROC_PROFILE_COUNT(mProfile.flops, 2 * ReturnComputeWeightCount() + 2 * mDerivativeVector.size());
+ NEUROC_PROFILE_COUNT(mProfile.bytes, sizeof(double) * (ReturnComputeWeightCount() + inputVector.size() + 2 * mDerivativeVector.size()));
  return mDerivativeVector;
 }
 
+/**
+* It computes the output and the derivative of the layer in a single pass.
+* The weighted input is computed once and it is given both to the transfer
+* function and to the derivative function.
+*
+* @return it returns a reference to the output vector of the layer
+**/
+const Eigen::VectorXd& DenseLayer::ComputeWithDerivative(const Eigen::VectorXd& inputVector) {
+
+ NEUROC_TRACE_SCOPE("DenseLayer::ComputeWithDerivative");
+ mInputVector = inputVector;
+ ComputeWeightedInput(mInputVector, mDerivativeVector);
+ mOutputVector = mDerivativeVector;
+ NEUROC_PROFILE_START(profile_timer);
+ if(mTransferKernel != nullptr) mTransferKernel(mOutputVector);
+ else mOutputVector = mTransferFunction(mOutputVector);
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.transferNs);
+ if(mDerivativeKernel != nullptr) mDerivativeKernel(mDerivativeVector);
+ else mDerivativeVector = mDerivativeFunction(mDerivativeVector);
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.derivativeNs);
+
+ NEUROC_PROFILE_COUNT(mProfile.calls, 1);
+ NEUROC_PROFILE_COUNT(mProfile.derivativeCalls, 1);
+ NEUROC_PROFILE_COUNT(mProfile.flops, 2 * ReturnComputeWeightCount() + 3 * mOutputVector.size());
+ NEUROC_PROFILE_COUNT(mProfile.bytes, sizeof(double) * (ReturnComputeWeightCount() + mInputVector.size() + 3 * mOutputVector.size()));
+ return mOutputVector;
+}
+
+/**
+* It computes the output and the derivative of the layer for a batch of samples.
+* Every column of the input matrix is a sample. The results are written in the
+* matrices given by the caller and the vectors of the layer are not modified.
+* If the functions of the layer are the ones of the library, the computation
+* is a single matrix-matrix product and it does not allocate memory.
+*
+* @param inputMatrix input size x batch size
+* @param outputMatrix output size x batch size, where the output is stored
+* @param derivativeMatrix output size x batch size, where the derivative is stored
+**/
+void DenseLayer::ComputeBatch(const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, Eigen::Ref<Eigen::MatrixXd> outputMatrix, Eigen::Ref<Eigen::MatrixXd> derivativeMatrix) {
+
+ NEUROC_TRACE_SCOPE("DenseLayer::ComputeBatch");
+ if(inputMatrix.rows() != mWeightMatrix->cols()) throw std::domain_error("Error: DenseLayer the input matrix has a wrong number of rows");
+ if(outputMatrix.rows() != mWeightMatrix->rows() || outputMatrix.cols() != inputMatrix.cols() ||
+    derivativeMatrix.rows() != outputMatrix.rows() || derivativeMatrix.cols() != outputMatrix.cols())
+  throw std::domain_error("Error: DenseLayer the output matrices have a wrong size");
+
+ NEUROC_PROFILE_START(profile_timer);
+ if(mDotProductKernel && mFactorized){
+  mFactorMatrix.resize(mRightFactorMatrix.rows(), inputMatrix.cols());
+  mFactorMatrix.noalias() = mRightFactorMatrix * inputMatrix;
+  outputMatrix.noalias() = mLeftFactorMatrix * mFactorMatrix;
+ }
+ else if(mDotProductKernel && mSparse) outputMatrix.noalias() = mSparseWeightMatrix * inputMatrix;
+ else if(mDotProductKernel){
+  const Eigen::MatrixXd& weight_matrix = ReturnComputeWeightMatrix();
+  Executor& executor = Executor::ReturnInstance();
+  const std::size_t work = weight_matrix.size() * inputMatrix.cols();
+  if(executor.IsParallel(work)){
+   executor.ParallelFor(0, weight_matrix.rows(), work, [&](std::size_t begin, std::size_t end){
+    outputMatrix.middleRows(begin, end - begin).noalias() = weight_matrix.middleRows(begin, end - begin) * inputMatrix;
+   });
+  }
+  else outputMatrix.noalias() = weight_matrix * inputMatrix;
+ }
+ else for(unsigned int i=0; i<inputMatrix.cols(); i++) outputMatrix.col(i) = mWeightFunction(ReturnComputeWeightMatrix(), inputMatrix.col(i));
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.weightNs);
+ JoinAndTransferBatch(outputMatrix, derivativeMatrix);
+
+ NEUROC_PROFILE_COUNT(mProfile.calls, inputMatrix.cols());
+ NEUROC_PROFILE_COUNT(mProfile.derivativeCalls, inputMatrix.cols());
+ NEUROC_PROFILE_COUNT(mProfile.flops, inputMatrix.cols() * (2 * ReturnComputeWeightCount() + 3 * outputMatrix.rows()));
+ NEUROC_PROFILE_COUNT(mProfile.bytes, sizeof(double) * (ReturnComputeWeightCount() + inputMatrix.size() + 3 * outputMatrix.size()));
+}
+
+/**
+* It adds the bias to the weighted inputs of a batch and it applies the
+* transfer function and its derivative, every column is a sample.
+*
+* @param outputMatrix the weighted inputs, replaced by the outputs
+* @param derivativeMatrix the derivatives of the outputs
+**/
+void DenseLayer::JoinAndTransferBatch(Eigen::Ref<Eigen::MatrixXd> outputMatrix, Eigen::Ref<Eigen::MatrixXd> derivativeMatrix) {
+ NEUROC_PROFILE_START(profile_timer);
+ if(mJoinKernel == JOIN_SUM) outputMatrix.colwise() += (*mBiasVector);
+ else if(mJoinKernel == JOIN_PRODUCT) outputMatrix.array().colwise() *= mBiasVector->array();
+ else for(unsigned int i=0; i<outputMatrix.cols(); i++) outputMatrix.col(i) = mJoinFunction(outputMatrix.col(i), (*mBiasVector));
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.joinNs);
+
+ derivativeMatrix = outputMatrix;
+ //The in-place kernels of the library are split in blocks of samples
+ Executor& executor = Executor::ReturnInstance();
+ const std::size_t work = outputMatrix.size() * kTransferCost;
+ if(mTransferKernel != nullptr && executor.IsParallel(work)){
+  executor.ParallelFor(0, outputMatrix.cols(), work, [&](std::size_t begin, std::size_t end){
+   for(std::size_t i=begin; i<end; i++) mTransferKernel(outputMatrix.col(i));
+  });
+ }
+ else for(unsigned int i=0; i<outputMatrix.cols(); i++){
+  if(mTransferKernel != nullptr) mTransferKernel(outputMatrix.col(i));
+  else outputMatrix.col(i) = mTransferFunction(outputMatrix.col(i));
+ }
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.transferNs);
+ if(mDerivativeKernel != nullptr && executor.IsParallel(work)){
+  executor.ParallelFor(0, derivativeMatrix.cols(), work, [&](std::size_t begin, std::size_t end){
+   for(std::size_t i=begin; i<end; i++) mDerivativeKernel(derivativeMatrix.col(i));
+  });
+ }
+ else for(unsigned int i=0; i<derivativeMatrix.cols(); i++){
+  if(mDerivativeKernel != nullptr) mDerivativeKernel(derivativeMatrix.col(i));
+  else derivativeMatrix.col(i) = mDerivativeFunction(derivativeMatrix.col(i));
+ }
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.derivativeNs);
+}
+
+/**
+* Batch computation of the mixed precision mode (see SetMixedPrecision()).
+* The product of the weights and the inputs is done in single precision
+* with the float copy of the weights, the bias, the transfer function and
+* its derivative are applied in double precision.
+*
+* @param inputMatrix input size x batch size, in single precision
+* @param outputMatrix the outputs in double precision
+* @param derivativeMatrix the derivatives in double precision
+* @param floatOutputMatrix the outputs in single precision, the input of the next layer
+**/
+void DenseLayer::ComputeBatchMixed(const Eigen::Ref<const Eigen::MatrixXf>& inputMatrix, Eigen::Ref<Eigen::MatrixXd> outputMatrix, Eigen::Ref<Eigen::MatrixXd> derivativeMatrix, Eigen::Ref<Eigen::MatrixXf> floatOutputMatrix) {
+ NEUROC_TRACE_SCOPE("DenseLayer::ComputeBatchMixed");
+ if(mMixedPrecision == false) throw std::domain_error("Error: DenseLayer the mixed precision mode is not enabled");
+ if(inputMatrix.rows() != mWeightMatrix->cols()) throw std::domain_error("Error: DenseLayer the input matrix has a wrong number of rows");
+ if(outputMatrix.rows() != mWeightMatrix->rows() || outputMatrix.cols() != inputMatrix.cols() ||
+    derivativeMatrix.rows() != outputMatrix.rows() || derivativeMatrix.cols() != outputMatrix.cols() ||
+    floatOutputMatrix.rows() != outputMatrix.rows() || floatOutputMatrix.cols() != outputMatrix.cols())
+  throw std::domain_error("Error: DenseLayer the output matrices have a wrong size");
+
+ NEUROC_PROFILE_START(profile_timer);
+ const Eigen::MatrixXf& float_weight_matrix = GetFloatWeightMatrix();
+ Executor& executor = Executor::ReturnInstance();
+ const std::size_t work = float_weight_matrix.size() * inputMatrix.cols();
+ if(executor.IsParallel(work)){
+  executor.ParallelFor(0, float_weight_matrix.rows(), work, [&](std::size_t begin, std::size_t end){
+   floatOutputMatrix.middleRows(begin, end - begin).noalias() = float_weight_matrix.middleRows(begin, end - begin) * inputMatrix;
+  });
+ }
+ else floatOutputMatrix.noalias() = float_weight_matrix * inputMatrix;
+ outputMatrix = floatOutputMatrix.cast<double>();
+ NEUROC_PROFILE_LAP(profile_timer, mProfile.weightNs);
+ JoinAndTransferBatch(outputMatrix, derivativeMatrix);
+ floatOutputMatrix = outputMatrix.cast<float>();
+
+ NEUROC_PROFILE_COUNT(mProfile.calls, inputMatrix.cols());
+ NEUROC_PROFILE_COUNT(mProfile.derivativeCalls, inputMatrix.cols());
+ NEUROC_PROFILE_COUNT(mProfile.flops, inputMatrix.cols() * (2 * mFloatWeightMatrix.size() + 3 * outputMatrix.rows()));
+ NEUROC_PROFILE_COUNT(mProfile.bytes, sizeof(float) * (mFloatWeightMatrix.size() + inputMatrix.size() + 2 * outputMatrix.size()) + sizeof(double) * 3 * outputMatrix.size());
+}
+
 /**
 * Get the values of all the neurons inside the DenseLayer
 *
 * @return it returns true if it is all right, otherwise false
 **/
-Eigen::VectorXd DenseLayer::GetInputVector(){
+const Eigen::VectorXd& DenseLayer::GetInputVector(){
 return mInputVector;
 }
 
@@ -138,7 +558,7 @@ return mInputVector;
 * @param inputValues vector of doubles of the same size of the DenseLayer. Every double is given as input to the neurons inside the DenseLayer.
 * @return it returns true if it is all right, otherwise false
 **/
-bool DenseLayer::SetInputVector(Eigen::VectorXd inputVector) {
+bool DenseLayer::SetInputVector(const Eigen::Ref<const Eigen::VectorXd>& inputVector) {
  mInputVector = inputVector;
  return true;
 }
@@ -148,7 +568,7 @@ bool DenseLayer::SetInputVector(Eigen::VectorXd inputVector) {
 *
 * @return it returns true if it is all right, otherwise false
 **/
-Eigen::VectorXd DenseLayer::GetOutputVector(){
+const Eigen::VectorXd& DenseLayer::GetOutputVector(){
 return mOutputVector;
 }
 
@@ -158,7 +578,7 @@ return mOutputVector;
 * @param inputValues vector of doubles of the same size of the DenseLayer. Every double is given as input to the neurons inside the DenseLayer.
 * @return it returns true if it is all right, otherwise false
 **/
-bool DenseLayer::SetOutputVector(Eigen::VectorXd outputVector) {
+bool DenseLayer::SetOutputVector(const Eigen::Ref<const Eigen::VectorXd>& outputVector) {
  mOutputVector = outputVector;
  return true;
 }
@@ -170,8 +590,9 @@ bool DenseLayer::SetOutputVector(Eigen::VectorXd outputVector) {
 * @param biasVector vector of values with the same size of the DenseLayer.
 * @return it returns true if it is all right, otherwise false
 **/
-bool DenseLayer::SetBiasVector(Eigen::VectorXd biasVector) {
- mBiasVector = biasVector;
+bool DenseLayer::SetBiasVector(const Eigen::Ref<const Eigen::VectorXd>& biasVector) {
+ if(mBiasVector.use_count() > 1) mBiasVector = std::make_shared<Eigen::VectorXd>(biasVector);
+ else *mBiasVector = biasVector;
  return true;
 }
 
@@ -180,8 +601,8 @@ bool DenseLayer::SetBiasVector(Eigen::VectorXd biasVector) {
 *
 * @return it returns a vector with the bias values
 **/
-Eigen::VectorXd DenseLayer::GetBiasVector(){
- return mBiasVector;
+const Eigen::VectorXd& DenseLayer::GetBiasVector(){
+ return (*mBiasVector);
 }
 
 /**
@@ -190,12 +611,12 @@ Eigen::VectorXd DenseLayer::GetBiasVector(){
 * @param value vector of the same size of the DenseLayer.
 * @return it returns true if it is all right, otherwise false
 **/
-bool DenseLayer::SetErrorVector(Eigen::VectorXd errorVector) {
+bool DenseLayer::SetErrorVector(const Eigen::Ref<const Eigen::VectorXd>& errorVector) {
  mErrorVector = errorVector;
  return true;
 }
 
-Eigen::VectorXd DenseLayer::GetErrorVector(){
+const Eigen::VectorXd& DenseLayer::GetErrorVector(){
  return mErrorVector;
 }
 
@@ -205,12 +626,12 @@ Eigen::VectorXd DenseLayer::GetErrorVector(){
 * @param value vector of the same size of the DenseLayer.
 * @return it returns true if it is all right, otherwise false
 **/
-bool DenseLayer::SetDerivativeVector(Eigen::VectorXd errorVector) {
- mDerivativeVector = errorVector;
+bool DenseLayer::SetDerivativeVector(const Eigen::Ref<const Eigen::VectorXd>& derivativeVector) {
+ mDerivativeVector = derivativeVector;
  return true;
 }
 
-Eigen::VectorXd DenseLayer::GetDerivativeVector(){
+const Eigen::VectorXd& DenseLayer::GetDerivativeVector(){
  return mDerivativeVector;
 }
 
@@ -221,7 +642,16 @@ Eigen::VectorXd DenseLayer::GetDerivativeVector(){
 * @return it returns the number of neurons
 **/
 unsigned int DenseLayer::ReturnNumberOfNeurons() {
- return 0;
+ return mWeightMatrix->rows();
+}
+
+/**
+* It returns the size of the input of the DenseLayer
+*
+* @return it returns the number of inputs
+**/
+unsigned int DenseLayer::ReturnNumberOfInputs() {
+ return mWeightMatrix->cols();
 }
 
 /**
@@ -229,8 +659,19 @@ unsigned int DenseLayer::ReturnNumberOfNeurons() {
 *
 * @return it returns true if everything is correct
 **/
-bool DenseLayer::SetWeightMatrix(Eigen::MatrixXd weightMatrix){
- mWeightMatrix = weightMatrix;
+bool DenseLayer::SetWeightMatrix(const Eigen::Ref<const Eigen::MatrixXd>& weightMatrix){
+ if(mWeightMatrix.use_count() > 1) mWeightMatrix = std::make_shared<Eigen::MatrixXd>(weightMatrix);
+ else *mWeightMatrix = weightMatrix;
+ mFloatWeightsOutdated = mMixedPrecision;
+ if(mBinarized) BinarizeWeights(false);
+ if(mSparse) MaskWeights();
+ if(mFactorized){
+  //The new weights replace the factors
+  mFactorizedWeightsOutdated = false;
+  RemoveFactorMatrices();
+ }
+ //The new weights replace the codebook
+ if(mClustered) RemoveCodebook();
  return true;
 }
 
@@ -241,8 +682,730 @@ bool DenseLayer::SetWeightMatrix(Eigen::MatrixXd weightMatrix){
 * If the DenseLayer has a Bias Unit then the first connection of the neurons is the Bias incoming connection
 * @return it returns a vector of double or float
 **/
-Eigen::MatrixXd DenseLayer::GetWeightMatrix() {
- return mWeightMatrix;
+const Eigen::MatrixXd& DenseLayer::GetWeightMatrix() {
+ if(mFactorizedWeightsOutdated) RefreshFactorizedWeights();
+ return (*mWeightMatrix);
+}
+
+/**
+* It returns true if the weights or the bias are shared with a copy of the layer.
+* The copies share them until one of them writes its own weights.
+*
+**/
+bool DenseLayer::IsSharingWeights(){
+ return mWeightMatrix.use_count() > 1 || mBiasVector.use_count() > 1;
+}
+
+/**
+* It returns the weight matrix ready to be written. If the matrix is
+* shared with other copies of the layer it is duplicated first.
+*
+**/
+Eigen::MatrixXd& DenseLayer::ReturnWritableWeightMatrix(){
+ if(mWeightMatrix.use_count() > 1) mWeightMatrix = std::make_shared<Eigen::MatrixXd>(*mWeightMatrix);
+ else std::atomic_thread_fence(std::memory_order_acquire); //the reads of the released copies come before the writes
+ mFloatWeightsOutdated = mMixedPrecision;
+ return *mWeightMatrix;
+}
+
+/**
+* It returns the bias vector ready to be written. If the vector is
+* shared with other copies of the layer it is duplicated first.
+*
+**/
+Eigen::VectorXd& DenseLayer::ReturnWritableBiasVector(){
+ if(mBiasVector.use_count() > 1) mBiasVector = std::make_shared<Eigen::VectorXd>(*mBiasVector);
+ else std::atomic_thread_fence(std::memory_order_acquire); //the reads of the released copies come before the writes
+ return *mBiasVector;
+}
+
+/**
+* It enables the binarized mode. The layer computes its output with the
+* binarized weights alpha * sign(W), where alpha is the mean absolute
+* value of the weights of the neuron, while the weights of the layer are
+* kept in full precision as shadow weights and they receive the updates.
+* In this mode the updated weights are clipped in [-1, +1].
+*
+* @param value true to enable the binarized mode
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::SetBinarized(bool value){
+ if(value && (mSparse || mFactorized || mClustered || mMixedPrecision)){
+  std::cerr << "Neuroc Error: DenseLayer a sparse, factorized, clustered or mixed precision layer cannot be binarized" << std::endl;
+  return false;
+ }
+ mBinarized = value;
+ if(mBinarized) BinarizeWeights(false);
+ else mBinaryWeightMatrix.resize(0, 0);
+ return true;
+}
+
+bool DenseLayer::IsBinarized(){
+ return mBinarized;
+}
+
+/**
+* It returns the weights used by the computation of the layer: the
+* binarized weights in the binarized mode, otherwise the weight matrix.
+* The error of the previous layer has to be propagated through them.
+*
+**/
+const Eigen::MatrixXd& DenseLayer::GetEffectiveWeightMatrix(){
+ if(mFactorizedWeightsOutdated) RefreshFactorizedWeights();
+ return ReturnComputeWeightMatrix();
+}
+
+/**
+* It computes the binarized weights from the shadow weights.
+*
+* @param clip if true the shadow weights are clipped in [-1, +1] first
+**/
+void DenseLayer::BinarizeWeights(bool clip){
+ if(clip){
+  Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+  weight_matrix = weight_matrix.cwiseMax(-1.0).cwiseMin(1.0);
+ }
+ const Eigen::MatrixXd& weight_matrix = *mWeightMatrix;
+ mBinaryWeightMatrix.resize(weight_matrix.rows(), weight_matrix.cols());
+ for(unsigned int row=0; row<weight_matrix.rows(); row++){
+  double alpha = weight_matrix.row(row).cwiseAbs().mean();
+  mBinaryWeightMatrix.row(row) = alpha * ((weight_matrix.row(row).array() >= 0.0).cast<double>() * 2.0 - 1.0).matrix();
+ }
+}
+
+/**
+* Magnitude pruning of the layer. The weights with the smallest absolute
+* value are set to zero until the given fraction of the weights is zero,
+* then the layer is set in the sparse mode, so that the pruned weights
+* stay zero during the learning. The weights pruned before stay pruned.
+*
+* @param sparsity fraction of the weights to prune, in [0, 1]
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::Prune(double sparsity){
+ if(sparsity < 0.0 || sparsity > 1.0){
+  std::cerr << "Neuroc Error: DenseLayer the sparsity must be in [0, 1]" << std::endl;
+  return false;
+ }
+ if(mBinarized || mFactorized || mClustered || mMixedPrecision){
+  std::cerr << "Neuroc Error: DenseLayer a binarized, factorized, clustered or mixed precision layer cannot be pruned" << std::endl;
+  return false;
+ }
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ std::size_t pruned = (std::size_t) std::llround(sparsity * weight_matrix.size());
+ if(pruned > 0){
+  double* weights = weight_matrix.data();
+  std::vector<Eigen::Index> indices(weight_matrix.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  std::nth_element(indices.begin(), indices.begin() + (pruned - 1), indices.end(),
+                   [weights](Eigen::Index a, Eigen::Index b){ return std::abs(weights[a]) < std::abs(weights[b]); });
+  for(std::size_t i=0; i<pruned; i++) weights[indices[i]] = 0.0;
+ }
+ return SetSparse(true);
+}
+
+/**
+* It enables the sparse mode. The non-zero weights are stored in a
+* compressed sparse row matrix used by the computation, and the zero
+* weights become a mask: the updates change only the non-zero weights.
+* When the mode is disabled the pruned weights can grow again.
+*
+* @param value true to enable the sparse mode
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::SetSparse(bool value){
+ if(value && (mBinarized || mFactorized || mClustered || mMixedPrecision)){
+  std::cerr << "Neuroc Error: DenseLayer a binarized, factorized, clustered or mixed precision layer cannot be sparse" << std::endl;
+  return false;
+ }
+ mSparse = value;
+ if(mSparse){
+  mSparseWeightMatrix = mWeightMatrix->sparseView();
+  mSparseWeightMatrix.makeCompressed();
+ } else {
+  mSparseWeightMatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>();
+ }
+ return true;
+}
+
+bool DenseLayer::IsSparse(){
+ return mSparse;
+}
+
+/**
+* It returns the fraction of the weights that are zero.
+* In the sparse mode it is the fraction of the pruned weights.
+*
+**/
+double DenseLayer::ReturnSparsity(){
+ if(mWeightMatrix->size() == 0) return 0.0;
+ if(mSparse) return 1.0 - (double) mSparseWeightMatrix.nonZeros() / mWeightMatrix->size();
+ return (double) (mWeightMatrix->array() == 0.0).count() / mWeightMatrix->size();
+}
+
+/**
+* It returns the non-zero weights used by the computation in the
+* sparse mode, the matrix is empty if the mode is disabled.
+*
+**/
+const Eigen::SparseMatrix<double, Eigen::RowMajor>& DenseLayer::GetSparseWeightMatrix(){
+ return mSparseWeightMatrix;
+}
+
+/**
+* It removes the given neurons from the layer, with their rows of the
+* weight matrix and their bias, so that the layer becomes smaller. The
+* inputs of the next layer connected to them must be removed too
+* (see Network::RemoveNeurons()).
+*
+* @param neurons indices of the neurons to remove
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::RemoveNeurons(const std::vector<unsigned int>& neurons){
+ std::vector<Eigen::Index> kept;
+ if(ReturnKeptIndices(neurons, mWeightMatrix->rows(), kept) == false) return false;
+ //The weights are read first, an outdated factorized layer computes them from the full factors
+ Eigen::MatrixXd weight_matrix = GetWeightMatrix()(kept, Eigen::all);
+ if(mFactorized){
+  Eigen::MatrixXd left_matrix = mLeftFactorMatrix(kept, Eigen::all);
+  mLeftFactorMatrix.swap(left_matrix);
+ }
+ if(mClustered){
+  IndexMatrix index_matrix = mIndexMatrix(kept, Eigen::all);
+  mIndexMatrix.swap(index_matrix);
+ }
+ Eigen::VectorXd bias_vector = (*mBiasVector)(kept);
+ mWeightMatrix = std::make_shared<Eigen::MatrixXd>(std::move(weight_matrix));
+ mFloatWeightsOutdated = mMixedPrecision;
+ mBiasVector = std::make_shared<Eigen::VectorXd>(std::move(bias_vector));
+ mOutputVector = Eigen::VectorXd::Zero(kept.size());
+ mDerivativeVector = Eigen::VectorXd::Zero(kept.size());
+ mErrorVector = Eigen::VectorXd::Zero(kept.size());
+ if(mBinarized) BinarizeWeights(false);
+ if(mSparse) SetSparse(true);
+ return true;
+}
+
+/**
+* It removes the given inputs from the layer, with their
+* columns of the weight matrix.
+*
+* @param inputs indices of the inputs to remove
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::RemoveInputs(const std::vector<unsigned int>& inputs){
+ std::vector<Eigen::Index> kept;
+ if(ReturnKeptIndices(inputs, mWeightMatrix->cols(), kept) == false) return false;
+ //See RemoveNeurons(), the weights are read before the factors shrink
+ Eigen::MatrixXd weight_matrix = GetWeightMatrix()(Eigen::all, kept);
+ if(mFactorized){
+  Eigen::MatrixXd right_matrix = mRightFactorMatrix(Eigen::all, kept);
+  mRightFactorMatrix.swap(right_matrix);
+ }
+ if(mClustered){
+  IndexMatrix index_matrix = mIndexMatrix(Eigen::all, kept);
+  mIndexMatrix.swap(index_matrix);
+ }
+ mWeightMatrix = std::make_shared<Eigen::MatrixXd>(std::move(weight_matrix));
+ mInputVector = Eigen::VectorXd::Zero(kept.size());
+ mFloatWeightsOutdated = mMixedPrecision;
+ if(mBinarized) BinarizeWeights(false);
+ if(mSparse) SetSparse(true);
+ return true;
+}
+
+/**
+* It enables the factorized mode: the weight matrix is replaced by the product
+* of a left (output x rank) and a right (rank x input) factor, for example the
+* truncated singular value decomposition (see LowRankFactorization). The output
+* is computed with two thinner products, that are faster and smaller than the
+* weight matrix when rank * (input + output) < input * output, and the updates
+* change the factors. The weight matrix is computed again when it is read.
+*
+* @param leftMatrix output size x rank
+* @param rightMatrix rank x input size
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::SetFactorMatrices(const Eigen::MatrixXd& leftMatrix, const Eigen::MatrixXd& rightMatrix){
+ if(leftMatrix.rows() != mWeightMatrix->rows() || rightMatrix.cols() != mWeightMatrix->cols() ||
+    leftMatrix.cols() != rightMatrix.rows() || leftMatrix.cols() == 0){
+  std::cerr << "Neuroc Error: DenseLayer the factors do not fit the weight matrix" << std::endl;
+  return false;
+ }
+ if(mBinarized || mSparse || mClustered || mMixedPrecision || mDotProductKernel == false){
+  std::cerr << "Neuroc Error: DenseLayer only a layer with the DotProduct weight function, not binarized, sparse, clustered or mixed precision, can be factorized" << std::endl;
+  return false;
+ }
+ mLeftFactorMatrix = leftMatrix;
+ mRightFactorMatrix = rightMatrix;
+ mFactorized = true;
+ RefreshFactorizedWeights();
+ return true;
+}
+
+/**
+* It goes back to a single weight matrix, equal to the product of the factors
+*
+**/
+void DenseLayer::RemoveFactorMatrices(){
+ if(mFactorizedWeightsOutdated) RefreshFactorizedWeights();
+ mFactorized = false;
+ mLeftFactorMatrix.resize(0, 0);
+ mRightFactorMatrix.resize(0, 0);
+ mFactorMatrix.resize(0, 0);
+ mFactorErrorMatrix.resize(0, 0);
+}
+
+bool DenseLayer::IsFactorized(){
+ return mFactorized;
+}
+
+/**
+* It returns the rank of the factors, zero if the layer is not factorized
+*
+**/
+unsigned int DenseLayer::ReturnRank(){
+ return mFactorized ? mLeftFactorMatrix.cols() : 0;
+}
+
+const Eigen::MatrixXd& DenseLayer::GetLeftFactorMatrix(){
+ return mLeftFactorMatrix;
+}
+
+const Eigen::MatrixXd& DenseLayer::GetRightFactorMatrix(){
+ return mRightFactorMatrix;
+}
+
+/**
+* It computes the weight matrix from the factors
+*
+**/
+void DenseLayer::RefreshFactorizedWeights(){
+ ReturnWritableWeightMatrix().noalias() = mLeftFactorMatrix * mRightFactorMatrix;
+ mFactorizedWeightsOutdated = false;
+}
+
+/**
+* It enables the clustered mode: every weight becomes the centroid of the
+* codebook selected by its index, for example found with the k-means of the
+* weights (see WeightClustering). The updates change only the centroids,
+* each of them receives the sum of the changes of its weights, that is the
+* gradient of the error with respect to the centroid, so the weights sharing
+* a centroid stay equal. The output is computed with the weight matrix, the
+* compact inference with the indices is done by ClusteredNetwork.
+*
+* @param centroidVector the codebook, at most 256 centroids
+* @param indexMatrix for every weight the index of its centroid
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::SetCodebook(const Eigen::VectorXd& centroidVector, const IndexMatrix& indexMatrix){
+ if(indexMatrix.rows() != mWeightMatrix->rows() || indexMatrix.cols() != mWeightMatrix->cols()){
+  std::cerr << "Neuroc Error: DenseLayer the index matrix and the weight matrix have different size" << std::endl;
+  return false;
+ }
+ if(centroidVector.size() == 0 || centroidVector.size() > 256 || (indexMatrix.size() > 0 && indexMatrix.maxCoeff() >= centroidVector.size())){
+  std::cerr << "Neuroc Error: DenseLayer the codebook must have between 1 and 256 centroids and an entry for every index" << std::endl;
+  return false;
+ }
+ if(mBinarized || mSparse || mFactorized || mMixedPrecision){
+  std::cerr << "Neuroc Error: DenseLayer a binarized, sparse, factorized or mixed precision layer cannot be clustered" << std::endl;
+  return false;
+ }
+ mCentroidVector = centroidVector;
+ mCentroidChangeVector = Eigen::VectorXd::Zero(centroidVector.size());
+ mIndexMatrix = indexMatrix;
+ mClustered = true;
+ RefreshClusteredWeights();
+ return true;
+}
+
+/**
+* It leaves the clustered mode, the weights keep the values of their
+* centroids and they can change independently again
+*
+**/
+void DenseLayer::RemoveCodebook(){
+ mClustered = false;
+ mCentroidVector.resize(0);
+ mCentroidChangeVector.resize(0);
+ mIndexMatrix.resize(0, 0);
+}
+
+bool DenseLayer::IsClustered(){
+ return mClustered;
+}
+
+const Eigen::VectorXd& DenseLayer::GetCentroidVector(){
+ return mCentroidVector;
+}
+
+/**
+* It enables the mixed precision mode. The layer keeps a single precision
+* copy of the weights, used by ComputeBatchMixed() and ComputeInputErrorMixed(),
+* while the weights of the layer stay in double precision as master weights:
+* they receive the updates (see UpdateMasterWeights()) and they are used by
+* Compute(). The copy is refreshed when the master weights change.
+*
+* @param value true to enable the mixed precision mode
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::SetMixedPrecision(bool value){
+ if(value && (mBinarized || mSparse || mFactorized || mClustered || mDotProductKernel == false)){
+  std::cerr << "Neuroc Error: DenseLayer only a layer with the DotProduct weight function, not binarized, sparse, factorized or clustered, can use the mixed precision" << std::endl;
+  return false;
+ }
+ mMixedPrecision = value;
+ if(mMixedPrecision) RefreshFloatWeights();
+ else mFloatWeightMatrix.resize(0, 0);
+ mFloatWeightsOutdated = false;
+ return true;
+}
+
+bool DenseLayer::IsMixedPrecision(){
+ return mMixedPrecision;
+}
+
+/**
+* It returns the single precision copy of the weights used by the
+* mixed precision mode, the matrix is empty if the mode is disabled.
+*
+**/
+const Eigen::MatrixXf& DenseLayer::GetFloatWeightMatrix(){
+ if(mFloatWeightsOutdated) RefreshFloatWeights();
+ return mFloatWeightMatrix;
+}
+
+/**
+* It computes the single precision copy of the master weights
+*
+**/
+void DenseLayer::RefreshFloatWeights(){
+ mFloatWeightMatrix = mWeightMatrix->cast<float>();
+ mFloatWeightsOutdated = false;
+}
+
+const DenseLayer::IndexMatrix& DenseLayer::GetIndexMatrix(){
+ return mIndexMatrix;
+}
+
+/**
+* It writes the centroids in the weight matrix
+*
+**/
+void DenseLayer::RefreshClusteredWeights(){
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ for(unsigned int col=0; col<weight_matrix.cols(); col++){
+  for(unsigned int row=0; row<weight_matrix.rows(); row++) weight_matrix(row, col) = mCentroidVector[mIndexMatrix(row, col)];
+ }
+}
+
+/**
+* It propagates the error of the layer to its input: the weights used by
+* the computation (binarized, sparse or factorized) transposed and
+* multiplied by the error. Every column is a sample.
+*
+* @param errorMatrix output size x batch size
+* @param inputErrorMatrix input size x batch size, where the result is stored
+**/
+void DenseLayer::ComputeInputError(const Eigen::Ref<const Eigen::MatrixXd>& errorMatrix, Eigen::Ref<Eigen::MatrixXd> inputErrorMatrix){
+ if(mFactorized){
+  mFactorErrorMatrix.resize(mLeftFactorMatrix.cols(), errorMatrix.cols());
+  mFactorErrorMatrix.noalias() = mLeftFactorMatrix.transpose() * errorMatrix;
+  inputErrorMatrix.noalias() = mRightFactorMatrix.transpose() * mFactorErrorMatrix;
+ }
+ else if(mSparse) inputErrorMatrix.noalias() = mSparseWeightMatrix.transpose() * errorMatrix;
+ else {
+  //The blocks are the columns of the weights, the rows of the result
+  const Eigen::MatrixXd& weight_matrix = ReturnComputeWeightMatrix();
+  Executor& executor = Executor::ReturnInstance();
+  const std::size_t work = weight_matrix.size() * errorMatrix.cols();
+  if(executor.IsParallel(work)){
+   executor.ParallelFor(0, weight_matrix.cols(), work, [&](std::size_t begin, std::size_t end){
+    inputErrorMatrix.middleRows(begin, end - begin).noalias() = weight_matrix.middleCols(begin, end - begin).transpose() * errorMatrix;
+   });
+  }
+  else inputErrorMatrix.noalias() = weight_matrix.transpose() * errorMatrix;
+ }
+}
+
+/**
+* It propagates the error of a batch to the inputs of the layer in the
+* mixed precision mode, with the single precision copy of the weights.
+*
+* @param errorMatrix output size x batch size, in single precision
+* @param inputErrorMatrix input size x batch size, in single precision
+**/
+void DenseLayer::ComputeInputErrorMixed(const Eigen::Ref<const Eigen::MatrixXf>& errorMatrix, Eigen::Ref<Eigen::MatrixXf> inputErrorMatrix){
+ if(mMixedPrecision == false) throw std::domain_error("Error: DenseLayer the mixed precision mode is not enabled");
+ const Eigen::MatrixXf& float_weight_matrix = GetFloatWeightMatrix();
+ Executor& executor = Executor::ReturnInstance();
+ const std::size_t work = float_weight_matrix.size() * errorMatrix.cols();
+ if(executor.IsParallel(work)){
+  executor.ParallelFor(0, float_weight_matrix.cols(), work, [&](std::size_t begin, std::size_t end){
+   inputErrorMatrix.middleRows(begin, end - begin).noalias() = float_weight_matrix.middleCols(begin, end - begin).transpose() * errorMatrix;
+  });
+ }
+ else inputErrorMatrix.noalias() = float_weight_matrix.transpose() * errorMatrix;
+}
+
+/**
+* It applies the mask of the sparse mode to new weights: the pruned
+* weights are set to zero and the others are copied in the sparse matrix.
+* If the size of the weights changed the mask is taken from their zeros.
+*
+**/
+void DenseLayer::MaskWeights(){
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ if(weight_matrix.rows() != mSparseWeightMatrix.rows() || weight_matrix.cols() != mSparseWeightMatrix.cols()){
+  SetSparse(true);
+  return;
+ }
+ Eigen::MatrixXd masked_matrix = Eigen::MatrixXd::Zero(weight_matrix.rows(), weight_matrix.cols());
+ for(int row=0; row<mSparseWeightMatrix.outerSize(); row++){
+  for(Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(mSparseWeightMatrix, row); it; ++it){
+   it.valueRef() = weight_matrix(row, it.col());
+   masked_matrix(row, it.col()) = it.value();
+  }
+ }
+ weight_matrix.swap(masked_matrix);
+}
+
+/**
+* It updates in place only the weights kept by the mask of the sparse mode,
+* the cost is proportional to the number of non-zero weights:
+* w = (1 - learningRate * weightDecay) * w + learningRate * clip(delta(row, col))
+* The weight matrix and the sparse matrix are written in the same pass.
+*
+* @param delta function returning the change of the weight in (row, col)
+**/
+template<typename DeltaFunction>
+void DenseLayer::UpdateNonZeroWeights(double learningRate, double weightDecay, double clipValue, DeltaFunction delta){
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ double decay_factor = 1.0 - learningRate * weightDecay;
+ for(int row=0; row<mSparseWeightMatrix.outerSize(); row++){
+  for(Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(mSparseWeightMatrix, row); it; ++it){
+   double change = delta(row, it.col());
+   if(clipValue > 0) change = std::max(-clipValue, std::min(clipValue, change));
+   double& weight = weight_matrix(row, it.col());
+   weight = decay_factor * weight + learningRate * change;
+   it.valueRef() = weight;
+  }
+ }
+}
+
+/**
+* It updates the centroids of the clustered mode with the sum of the
+* changes of their weights, then it writes them in the weight matrix:
+* c = (1 - learningRate * weightDecay) * c + learningRate * sum(clip(delta(row, col)))
+*
+* @param delta function returning the change of the weight in (row, col)
+**/
+template<typename DeltaFunction>
+void DenseLayer::UpdateCentroids(double learningRate, double weightDecay, double clipValue, DeltaFunction delta){
+ mCentroidChangeVector.setZero();
+ for(unsigned int col=0; col<mIndexMatrix.cols(); col++){
+  for(unsigned int row=0; row<mIndexMatrix.rows(); row++){
+   double change = delta(row, col);
+   if(clipValue > 0) change = std::max(-clipValue, std::min(clipValue, change));
+   mCentroidChangeVector[mIndexMatrix(row, col)] += change;
+  }
+ }
+ mCentroidVector = (1.0 - learningRate * weightDecay) * mCentroidVector + learningRate * mCentroidChangeVector;
+ RefreshClusteredWeights();
+}
+
+/**
+* It adds a matrix of changes to the weights of the layer, in place.
+* The weight decay and the clipping are applied in the same pass:
+* W = (1 - learningRate * weightDecay) * W + learningRate * clip(deltaMatrix)
+*
+* @param deltaMatrix matrix with the same size of the weight matrix
+* @param learningRate the changes are multiplied by this value
+* @param weightDecay L2 decay of the weights, zero to disable it
+* @param clipValue the changes are clipped in [-clipValue, +clipValue], zero to disable it
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::AddToWeightMatrix(const Eigen::Ref<const Eigen::MatrixXd>& deltaMatrix, double learningRate, double weightDecay, double clipValue){
+ if(deltaMatrix.rows() != mWeightMatrix->rows() || deltaMatrix.cols() != mWeightMatrix->cols()){
+  std::cerr << "Neuroc Error: DenseLayer the delta matrix and the weight matrix have different size" << std::endl;
+  return false;
+ }
+ if(mSparse){
+  UpdateNonZeroWeights(learningRate, weightDecay, clipValue, [&deltaMatrix](Eigen::Index row, Eigen::Index col){ return deltaMatrix(row, col); });
+  return true;
+ }
+ if(mClustered){
+  UpdateCentroids(learningRate, weightDecay, clipValue, [&deltaMatrix](Eigen::Index row, Eigen::Index col){ return deltaMatrix(row, col); });
+  return true;
+ }
+ if(mFactorized){
+  //The changes of the weights are projected on the factors
+  Eigen::MatrixXd change_matrix = deltaMatrix;
+  if(clipValue > 0) change_matrix = change_matrix.cwiseMax(-clipValue).cwiseMin(clipValue);
+  Eigen::MatrixXd left_change = change_matrix * mRightFactorMatrix.transpose();
+  Eigen::MatrixXd right_change = mLeftFactorMatrix.transpose() * change_matrix;
+  double decay_factor = 1.0 - learningRate * weightDecay;
+  mLeftFactorMatrix = decay_factor * mLeftFactorMatrix + learningRate * left_change;
+  mRightFactorMatrix = decay_factor * mRightFactorMatrix + learningRate * right_change;
+  mFactorizedWeightsOutdated = true;
+  return true;
+ }
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ double decay_factor = 1.0 - learningRate * weightDecay;
+ if(clipValue > 0) weight_matrix = decay_factor * weight_matrix + learningRate * deltaMatrix.cwiseMax(-clipValue).cwiseMin(clipValue);
+ else if(weightDecay != 0) weight_matrix = decay_factor * weight_matrix + learningRate * deltaMatrix;
+ else weight_matrix += learningRate * deltaMatrix;
+ if(mBinarized) BinarizeWeights(true);
+ return true;
+}
+
+/**
+* It updates the weights with the outer product of the error and the input,
+* in place and touching every weight once:
+* W = (1 - learningRate * weightDecay) * W + learningRate * clip(errorVector * inputVector')
+*
+* @param learningRate
+* @param errorVector error of the layer, with the size of the output
+* @param inputVector input of the layer
+* @param weightDecay L2 decay of the weights, zero to disable it
+* @param clipValue the changes are clipped in [-clipValue, +clipValue], zero to disable it
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::UpdateWeights(double learningRate, const Eigen::Ref<const Eigen::VectorXd>& errorVector, const Eigen::Ref<const Eigen::VectorXd>& inputVector, double weightDecay, double clipValue){
+ if(errorVector.size() != mWeightMatrix->rows() || inputVector.size() != mWeightMatrix->cols()){
+  std::cerr << "Neuroc Error: DenseLayer the error vector or the input vector do not fit the weight matrix" << std::endl;
+  return false;
+ }
+ if(mSparse){
+  UpdateNonZeroWeights(learningRate, weightDecay, clipValue, [&errorVector, &inputVector](Eigen::Index row, Eigen::Index col){ return errorVector[row] * inputVector[col]; });
+  return true;
+ }
+ if(mClustered){
+  UpdateCentroids(learningRate, weightDecay, clipValue, [&errorVector, &inputVector](Eigen::Index row, Eigen::Index col){ return errorVector[row] * inputVector[col]; });
+  return true;
+ }
+ double decay_factor = 1.0 - learningRate * weightDecay;
+ //In the factorized mode the left factor receives the error of the layer
+ //with the right factor times the input as input, the right factor receives
+ //the left factor transposed times the error with the input of the layer
+ if(mFactorized){
+  mFactorMatrix.resize(mRightFactorMatrix.rows(), 1);
+  mFactorErrorMatrix.resize(mLeftFactorMatrix.cols(), 1);
+  mFactorMatrix.col(0).noalias() = mRightFactorMatrix * inputVector;
+  mFactorErrorMatrix.col(0).noalias() = mLeftFactorMatrix.transpose() * errorVector;
+  AddOuterProduct(mLeftFactorMatrix, learningRate, errorVector, mFactorMatrix.col(0), decay_factor, clipValue);
+  AddOuterProduct(mRightFactorMatrix, learningRate, mFactorErrorMatrix.col(0), inputVector, decay_factor, clipValue);
+  mFactorizedWeightsOutdated = true;
+  return true;
+ }
+ //Every column of the weight matrix is updated with the error
+ //multiplied by the corresponding input value
+ AddOuterProduct(ReturnWritableWeightMatrix(), learningRate, errorVector, inputVector, decay_factor, clipValue);
+ if(mBinarized) BinarizeWeights(true);
+ return true;
+}
+
+/**
+* It updates the weights with the errors and the inputs of a batch, every column
+* is a sample. The changes are summed in a single matrix-matrix product that
+* accumulates directly in the weights:
+* W = (1 - learningRate * weightDecay) * W + learningRate * errorMatrix * inputMatrix'
+* To use the mean over the batch the errors must be divided by the batch size.
+*
+* @param learningRate
+* @param errorMatrix output size x batch size
+* @param inputMatrix input size x batch size
+* @param weightDecay L2 decay of the weights, zero to disable it
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::UpdateWeightsBatch(double learningRate, const Eigen::Ref<const Eigen::MatrixXd>& errorMatrix, const Eigen::Ref<const Eigen::MatrixXd>& inputMatrix, double weightDecay){
+ if(errorMatrix.rows() != mWeightMatrix->rows() || inputMatrix.rows() != mWeightMatrix->cols() || errorMatrix.cols() != inputMatrix.cols()){
+  std::cerr << "Neuroc Error: DenseLayer the error matrix or the input matrix do not fit the weight matrix" << std::endl;
+  return false;
+ }
+ if(mSparse){
+  UpdateNonZeroWeights(learningRate, weightDecay, 0.0, [&errorMatrix, &inputMatrix](Eigen::Index row, Eigen::Index col){ return errorMatrix.row(row).dot(inputMatrix.row(col)); });
+  return true;
+ }
+ if(mClustered){
+  //Every weight is changed, the changes are computed with a single product
+  Eigen::MatrixXd change_matrix = errorMatrix * inputMatrix.transpose();
+  UpdateCentroids(learningRate, weightDecay, 0.0, [&change_matrix](Eigen::Index row, Eigen::Index col){ return change_matrix(row, col); });
+  return true;
+ }
+ if(mFactorized){
+  mFactorMatrix.resize(mRightFactorMatrix.rows(), inputMatrix.cols());
+  mFactorErrorMatrix.resize(mLeftFactorMatrix.cols(), errorMatrix.cols());
+  mFactorMatrix.noalias() = mRightFactorMatrix * inputMatrix;
+  mFactorErrorMatrix.noalias() = mLeftFactorMatrix.transpose() * errorMatrix;
+  if(weightDecay != 0){
+   mLeftFactorMatrix *= 1.0 - learningRate * weightDecay;
+   mRightFactorMatrix *= 1.0 - learningRate * weightDecay;
+  }
+  mLeftFactorMatrix.noalias() += learningRate * errorMatrix * mFactorMatrix.transpose();
+  mRightFactorMatrix.noalias() += learningRate * mFactorErrorMatrix * inputMatrix.transpose();
+  mFactorizedWeightsOutdated = true;
+  return true;
+ }
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ if(weightDecay != 0) weight_matrix *= 1.0 - learningRate * weightDecay;
+ //With a single neuron the product is a matrix-vector one, written on the
+ //transposed row to keep the learning rate out of the copied operands
+ if(weight_matrix.rows() == 1) weight_matrix.row(0).transpose().noalias() += inputMatrix * (learningRate * errorMatrix.row(0).transpose());
+ else {
+  Executor& executor = Executor::ReturnInstance();
+  const std::size_t work = weight_matrix.size() * errorMatrix.cols();
+  if(executor.IsParallel(work)){
+   executor.ParallelFor(0, weight_matrix.rows(), work, [&](std::size_t begin, std::size_t end){
+    weight_matrix.middleRows(begin, end - begin).noalias() += learningRate * errorMatrix.middleRows(begin, end - begin) * inputMatrix.transpose();
+   });
+  }
+  else weight_matrix.noalias() += learningRate * errorMatrix * inputMatrix.transpose();
+ }
+ if(mBinarized) BinarizeWeights(true);
+ return true;
+}
+
+/**
+* It adds a gradient computed in single precision to the master weights of
+* the mixed precision mode, and it writes the single precision copy of the
+* weights in the same pass:
+* W = (1 - learningRate * weightDecay) * W + learningRate * clip(gradientScale * gradient)
+*
+* @param gradientMatrix the change of the weights, in single precision
+* @param gradientScale factor applied to the gradient, to remove the loss scale and the batch size
+* @param learningRate
+* @param weightDecay
+* @param clipValue
+* @return it returns true if it is all right, otherwise false
+**/
+bool DenseLayer::UpdateMasterWeights(const Eigen::Ref<const Eigen::MatrixXf>& gradientMatrix, double gradientScale, double learningRate, double weightDecay, double clipValue){
+ if(mMixedPrecision == false){
+  std::cerr << "Neuroc Error: DenseLayer the mixed precision mode is not enabled" << std::endl;
+  return false;
+ }
+ if(gradientMatrix.rows() != mWeightMatrix->rows() || gradientMatrix.cols() != mWeightMatrix->cols()){
+  std::cerr << "Neuroc Error: DenseLayer the gradient matrix and the weight matrix have different size" << std::endl;
+  return false;
+ }
+ Eigen::MatrixXd& weight_matrix = ReturnWritableWeightMatrix();
+ if(mFloatWeightMatrix.rows() != weight_matrix.rows() || mFloatWeightMatrix.cols() != weight_matrix.cols()) mFloatWeightMatrix.resize(weight_matrix.rows(), weight_matrix.cols());
+ const double decay_factor = 1.0 - learningRate * weightDecay;
+ //Every weight is independent, the blocks of columns give the same result
+ Executor::ReturnInstance().ParallelFor(0, weight_matrix.cols(), weight_matrix.size(), [&](std::size_t begin, std::size_t end){
+  for(std::size_t col=begin; col<end; col++){
+   double* weights = weight_matrix.col(col).data();
+   float* float_weights = mFloatWeightMatrix.col(col).data();
+   for(Eigen::Index row=0; row<weight_matrix.rows(); row++){
+    double change = gradientScale * gradientMatrix(row, col);
+    if(clipValue > 0) change = std::min(clipValue, std::max(-clipValue, change));
+    weights[row] = decay_factor * weights[row] + learningRate * change;
+    float_weights[row] = (float) weights[row];
+   }
+  }
+ });
+ mFloatWeightsOutdated = false;
+ return true;
 }
 
 /**
@@ -252,6 +1415,7 @@ Eigen::MatrixXd DenseLayer::GetWeightMatrix() {
 **/
 bool DenseLayer::SetTransferFunction(std::function<Eigen::VectorXd(Eigen::VectorXd)> transferFunction){
  mTransferFunction = transferFunction;
+ SelectKernels();
  return true;
 }
 
@@ -261,24 +1425,91 @@ bool DenseLayer::SetDerivativeFunction(std::function<Eigen::VectorXd(Eigen::Vect
  return false;
 }
 
+/**
+* It returns the weight function of the layer
+*
+**/
+const std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)>& DenseLayer::GetWeightFunction(){
+ return mWeightFunction;
+}
+
+/**
+* It returns the join function of the layer
+*
+**/
+const std::function<Eigen::VectorXd(Eigen::VectorXd, Eigen::VectorXd)>& DenseLayer::GetJoinFunction(){
+ return mJoinFunction;
+}
+
+/**
+* It returns the transfer function of the layer
+*
+**/
+const std::function<Eigen::VectorXd(Eigen::VectorXd)>& DenseLayer::GetTransferFunction(){
+ return mTransferFunction;
+}
+
+/**
+* It returns the derivative of the transfer function of the layer
+*
+**/
+const std::function<Eigen::VectorXd(Eigen::VectorXd)>& DenseLayer::GetDerivativeFunction(){
+ return mDerivativeFunction;
+}
+
+
 
 
+/**
+* It returns the memory used by the weights and by the vectors of the layer.
+* The weights shared with other copies of the layer are divided among them.
+*
+* @return it returns the number of bytes
+**/
+std::size_t DenseLayer::ReturnMemoryFootprint(){
+ std::size_t coefficients = mInputVector.size() + mOutputVector.size() + mDerivativeVector.size() + mErrorVector.size() + mBinaryWeightMatrix.size()
+                          + mLeftFactorMatrix.size() + mRightFactorMatrix.size() + mFactorMatrix.size() + mFactorErrorMatrix.size()
+                          + mCentroidVector.size() + mCentroidChangeVector.size() + (mFloatWeightMatrix.size() + 1) / 2;
+ std::size_t shared_bytes = 0;
+ if(mWeightMatrix) shared_bytes += mWeightMatrix->size() * sizeof(double) / mWeightMatrix.use_count();
+ if(mBiasVector) shared_bytes += mBiasVector->size() * sizeof(double) / mBiasVector.use_count();
+ if(mSparse) shared_bytes += mSparseWeightMatrix.nonZeros() * (sizeof(double) + sizeof(int)) + (mSparseWeightMatrix.outerSize() + 1) * sizeof(int);
+ return sizeof(DenseLayer) + coefficients * sizeof(double) + shared_bytes + mIndexMatrix.size() * sizeof(uint8_t);
+}
+
+/**
+* It returns the profiling counters of the layer.
+* The counters are updated only if the library is compiled with NEUROC_PROFILE.
+*
+* @return it returns a reference to the counters
+**/
+const LayerProfile& DenseLayer::GetProfile(){
+ return mProfile;
+}
+
+/**
+* It sets to zero the profiling counters of the layer.
+*
+**/
+void DenseLayer::ResetProfile(){
+ mProfile = LayerProfile();
+}
 
 /**
 * Print information about all the neurons contained inside the DenseLayer
 *
 **/
 void DenseLayer::Print() {
-std::cout << "Input Size ..... " << mWeightMatrix.cols() << std::endl;
+std::cout << "Input Size ..... " << mWeightMatrix->cols() << std::endl;
 std::cout << "Input Vector: " << std::endl << mInputVector << std::endl;
 std::cout << std::endl;
-std::cout << "Output Size ..... " << mWeightMatrix.rows() << std::endl;
+std::cout << "Output Size ..... " << mWeightMatrix->rows() << std::endl;
 std::cout << "Output Vector: " << std::endl << mOutputVector << std::endl;
 std::cout << std::endl;
-std::cout << "Bias Size ..... " << mBiasVector.size() << std::endl;
-std::cout << "Bias Vector: " << std::endl << mBiasVector << std::endl;
+std::cout << "Bias Size ..... " << mBiasVector->size() << std::endl;
+std::cout << "Bias Vector: " << std::endl << (*mBiasVector) << std::endl;
 std::cout << std::endl;
-std::cout << "Weight Matrix: " << std::endl << mWeightMatrix << std::endl;
+std::cout << "Weight Matrix: " << std::endl << (*mWeightMatrix) << std::endl;
 }
 
 
@@ -0,0 +1,330 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "Executor.h"
+#include "Trace.h"
+#include <Eigen/Core>
+#include <algorithm> //min
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace neuroc{
+
+namespace {
+
+//Blocks of a range for every thread, the extra blocks balance the load
+const std::size_t kBlocksPerThread = 4;
+//Below this number of multiply-adds the work stays in the calling thread
+const std::size_t kDefaultThreshold = 1 << 18;
+
+//True while the thread executes a block, the ranges started by a block are serial
+thread_local bool tInsideBlock = false;
+
+unsigned int ReturnHardwareThreads(){
+ unsigned int threads = std::thread::hardware_concurrency();
+ return threads > 0 ? threads : 1;
+}
+
+} //namespace
+
+const std::size_t Executor::kBlockAlignment;
+const std::size_t Executor::kQueueCapacity;
+
+/**
+* It returns the pool shared by the library
+*
+**/
+Executor& Executor::ReturnInstance(){
+ static Executor executor;
+ return executor;
+}
+
+/**
+* Class constructor. The pool has a thread for every core, the
+* calling thread included, and the workers are not started yet.
+*
+**/
+Executor::Executor(){
+ mStarted = false;
+ mQueued = 0;
+ mNextWorker = 0;
+ mBlocks = 0;
+ mSteals = 0;
+ mStopping = false;
+ mThreads = ReturnHardwareThreads();
+ mPinning = false;
+ mThreshold = kDefaultThreshold;
+}
+
+/**
+* Class destructor, the workers are stopped
+*
+**/
+Executor::~Executor(){
+ Stop();
+}
+
+/**
+* It sets the number of threads used by a parallel range, the calling
+* thread included. One makes all the work serial, zero uses a thread
+* for every core. The workers are started again by the next range.
+*
+* @param value the number of threads
+**/
+void Executor::SetNumberOfThreads(unsigned int value){
+ Stop();
+ mThreads = (value == 0) ? ReturnHardwareThreads() : value;
+}
+
+unsigned int Executor::GetNumberOfThreads(){
+ return mThreads;
+}
+
+/**
+* It pins every worker to a core, the worker i runs on the core i+1
+* so that the core 0 is left to the calling thread. It is available
+* on Linux only. The workers are started again by the next range.
+*
+* @param value true to pin the workers
+**/
+void Executor::SetPinning(bool value){
+ Stop();
+ mPinning = value;
+}
+
+bool Executor::GetPinning(){
+ return mPinning;
+}
+
+/**
+* It sets the work, in multiply-adds, below which a range is executed
+* serially by the calling thread. The default is 262144, the product of
+* a 512 x 512 matrix and a vector.
+*
+* @param value the threshold
+**/
+void Executor::SetThreshold(std::size_t value){
+ mThreshold.store(value, std::memory_order_relaxed);
+}
+
+std::size_t Executor::GetThreshold(){
+ return mThreshold.load(std::memory_order_relaxed);
+}
+
+/**
+* It returns true if a range with the given work is split among the threads
+*
+* @param work the cost of the range, in multiply-adds
+**/
+bool Executor::IsParallel(std::size_t work){
+ return mThreads > 1 && work >= mThreshold.load(std::memory_order_relaxed) && tInsideBlock == false;
+}
+
+/**
+* It returns the number of blocks executed by the parallel ranges
+*
+**/
+unsigned long long Executor::ReturnNumberOfBlocks(){
+ return mBlocks.load(std::memory_order_relaxed);
+}
+
+/**
+* It returns the number of blocks taken from the queue of another thread
+*
+**/
+unsigned long long Executor::ReturnNumberOfSteals(){
+ return mSteals.load(std::memory_order_relaxed);
+}
+
+/**
+* It splits the range in blocks, the first one is executed by the calling
+* thread and the others are given to the queues of the workers, in turn.
+* Then the calling thread takes the blocks left in the queues until all
+* the blocks of the range are done.
+*
+**/
+void Executor::Run(std::size_t begin, std::size_t end, RangeFunction function, const void* context){
+ if(mStarted.load(std::memory_order_acquire) == false) Start();
+ const std::size_t size = end - begin;
+ const std::size_t target = (std::size_t) mThreads * kBlocksPerThread;
+ std::size_t block = (size + target - 1) / target;
+ block = ((block + kBlockAlignment - 1) / kBlockAlignment) * kBlockAlignment;
+ const std::size_t blocks = (size + block - 1) / block;
+
+ Job job;
+ job.function = function;
+ job.context = context;
+ job.pending.store(blocks, std::memory_order_relaxed);
+ mBlocks.fetch_add(blocks, std::memory_order_relaxed);
+
+ const unsigned int first = mNextWorker.fetch_add(1, std::memory_order_relaxed);
+ const unsigned int workers = mWorkers.size();
+ bool queued = false;
+ for(std::size_t b=1; b<blocks; b++){
+  Task task = {&job, begin + b * block, std::min(end, begin + (b + 1) * block)};
+  if(Push(*mWorkers[(first + b) % workers], task)) queued = true;
+  else Execute(task);
+ }
+ if(queued){
+  //The lock orders the notification after the check of a worker going to sleep
+  { std::lock_guard<std::mutex> lock(mMutex); }
+  mCondition.notify_all();
+ }
+
+ Task task = {&job, begin, std::min(end, begin + block)};
+ Execute(task);
+ while(job.pending.load(std::memory_order_acquire) > 0){
+  if(Steal(first, workers, task)) Execute(task);
+  else std::this_thread::yield();
+ }
+}
+
+/**
+* It starts the workers, one less than the threads of the pool
+*
+**/
+void Executor::Start(){
+ std::lock_guard<std::mutex> lock(mMutex);
+ if(mStarted.load(std::memory_order_relaxed)) return;
+ //The static data of the Eigen products are initialized before the workers use them
+ Eigen::initParallel();
+ mStopping = false;
+ for(unsigned int i=0; i+1<mThreads; i++){
+  mWorkers.emplace_back(new Worker());
+  mWorkers.back()->head = 0;
+  mWorkers.back()->size = 0;
+ }
+ for(unsigned int i=0; i<mWorkers.size(); i++) mWorkers[i]->thread = std::thread(&Executor::WorkerLoop, this, i);
+ mStarted.store(true, std::memory_order_release);
+}
+
+/**
+* It stops and joins the workers
+*
+**/
+void Executor::Stop(){
+ if(mStarted.load(std::memory_order_acquire) == false) return;
+ {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStopping = true;
+ }
+ mCondition.notify_all();
+ for(unsigned int i=0; i<mWorkers.size(); i++) mWorkers[i]->thread.join();
+ mWorkers.clear();
+ mStopping = false;
+ mStarted.store(false, std::memory_order_release);
+}
+
+/**
+* The loop of a worker: it executes the newest block of its queue or it
+* steals the oldest block of another queue, and it sleeps when all the
+* queues are empty.
+*
+**/
+void Executor::WorkerLoop(unsigned int index){
+ #ifdef __linux__
+ if(mPinning){
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET((index + 1) % ReturnHardwareThreads(), &cpu_set);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+ }
+ #endif
+ Worker& worker = *mWorkers[index];
+ Task task;
+ while(true){
+  if(PopNewest(worker, task) || Steal(index + 1, index, task)){
+   Execute(task);
+   continue;
+  }
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCondition.wait(lock, [this](){ return mStopping || mQueued.load(std::memory_order_acquire) > 0; });
+  if(mStopping && mQueued.load(std::memory_order_acquire) == 0) return;
+ }
+}
+
+bool Executor::Push(Worker& worker, const Task& task){
+ std::lock_guard<std::mutex> lock(worker.mutex);
+ if(worker.size == kQueueCapacity) return false;
+ worker.tasks[(worker.head + worker.size) % kQueueCapacity] = task;
+ worker.size++;
+ mQueued.fetch_add(1, std::memory_order_release);
+ return true;
+}
+
+bool Executor::PopNewest(Worker& worker, Task& task){
+ std::lock_guard<std::mutex> lock(worker.mutex);
+ if(worker.size == 0) return false;
+ worker.size--;
+ task = worker.tasks[(worker.head + worker.size) % kQueueCapacity];
+ mQueued.fetch_sub(1, std::memory_order_relaxed);
+ return true;
+}
+
+bool Executor::PopOldest(Worker& worker, Task& task){
+ std::lock_guard<std::mutex> lock(worker.mutex);
+ if(worker.size == 0) return false;
+ task = worker.tasks[worker.head];
+ worker.head = (worker.head + 1) % kQueueCapacity;
+ worker.size--;
+ mQueued.fetch_sub(1, std::memory_order_relaxed);
+ return true;
+}
+
+/**
+* It takes the oldest block of the first queue that is not empty,
+* starting from the given one and skipping the queue of the thief.
+*
+* @param first the queue looked first
+* @param self the worker stealing, or the number of workers for the calling thread
+**/
+bool Executor::Steal(unsigned int first, unsigned int self, Task& task){
+ const unsigned int workers = mWorkers.size();
+ for(unsigned int i=0; i<workers; i++){
+  unsigned int victim = (first + i) % workers;
+  if(victim == self) continue;
+  if(PopOldest(*mWorkers[victim], task)){
+   mSteals.fetch_add(1, std::memory_order_relaxed);
+   return true;
+  }
+ }
+ return false;
+}
+
+/**
+* It executes a block, the ranges started by the block are serial
+*
+**/
+void Executor::Execute(const Task& task){
+ Job* job = task.job;
+ const bool inside = tInsideBlock;
+ tInsideBlock = true;
+ {
+  //One span per block, the timeline shows how the range is split between the threads
+  NEUROC_TRACE_SCOPE("Executor::Block");
+  job->function(job->context, task.begin, task.end);
+ }
+ tInsideBlock = inside;
+ //The last access to the job, the calling thread can return after it
+ job->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+} //namespace
@@ -0,0 +1,105 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "LossFunctions.h"
+#include <algorithm> //min max
+#include <cmath>
+
+namespace neuroc{
+namespace LossFunctions{
+
+/**
+* Squared error, the delta is (target - output) multiplied by the derivative,
+* that is the gradient of half the squared error. It gives the same deltas
+* and the same error as the error backpropagation without a loss.
+* @return the squared error summed over the samples
+*/
+double MeanSquaredError(const Eigen::Ref<const Eigen::MatrixXd>& output, const Eigen::Ref<const Eigen::MatrixXd>& derivative,
+                        const Eigen::Ref<const Eigen::MatrixXd>& target, Eigen::Ref<Eigen::MatrixXd> delta) {
+ delta = target - output;
+ const double loss = delta.squaredNorm();
+ delta.array() *= derivative.array();
+ return loss;
+}
+
+/**
+* Absolute error, the delta is the sign of (target - output) multiplied
+* by the derivative. It is less sensitive to the outliers.
+* @return the absolute error summed over the samples
+*/
+double MeanAbsoluteError(const Eigen::Ref<const Eigen::MatrixXd>& output, const Eigen::Ref<const Eigen::MatrixXd>& derivative,
+                         const Eigen::Ref<const Eigen::MatrixXd>& target, Eigen::Ref<Eigen::MatrixXd> delta) {
+ delta = target - output;
+ const double loss = delta.lpNorm<1>();
+ delta = delta.array().sign() * derivative.array();
+ return loss;
+}
+
+/**
+* Huber loss with threshold one: squared for the differences smaller than
+* one and absolute for the larger ones, the delta is the difference clipped
+* in [-1, +1] multiplied by the derivative.
+* @return the Huber loss summed over the samples
+*/
+double Huber(const Eigen::Ref<const Eigen::MatrixXd>& output, const Eigen::Ref<const Eigen::MatrixXd>& derivative,
+             const Eigen::Ref<const Eigen::MatrixXd>& target, Eigen::Ref<Eigen::MatrixXd> delta) {
+ delta = target - output;
+ const double loss = (delta.array().abs() <= 1.0).select(0.5 * delta.array().square(), delta.array().abs() - 0.5).sum();
+ delta = delta.array().min(1.0).max(-1.0) * derivative.array();
+ return loss;
+}
+
+/**
+* Cross entropy of a Softmax output layer. The derivative of the layer
+* (see TransferFunctions::SoftmaxDerivative) holds the logits: the log-sum-exp
+* of every sample is computed once from them, the loss is taken from the
+* logits and the delta is (target - probability), so the probabilities that
+* underflow to zero never reach a logarithm.
+* @return the cross entropy summed over the samples
+*/
+double CrossEntropy(const Eigen::Ref<const Eigen::MatrixXd>&, const Eigen::Ref<const Eigen::MatrixXd>& derivative,
+                    const Eigen::Ref<const Eigen::MatrixXd>& target, Eigen::Ref<Eigen::MatrixXd> delta) {
+ double loss = 0;
+ for(Eigen::Index col=0; col<derivative.cols(); col++){
+  const double max_logit = derivative.col(col).maxCoeff();
+  delta.col(col) = (derivative.col(col).array() - max_logit).exp().matrix();
+  const double sum = delta.col(col).sum();
+  loss -= target.col(col).dot(derivative.col(col)) - (max_logit + std::log(sum)) * target.col(col).sum();
+  delta.col(col) = target.col(col) - delta.col(col) / sum;
+ }
+ return loss;
+}
+
+/**
+* Binary cross entropy of a Sigmoid output layer, every output is an
+* independent probability. The derivative of the sigmoid cancels out and the
+* delta is (target - output). The outputs are clamped before the logarithm.
+* @return the binary cross entropy summed over the samples
+*/
+double BinaryCrossEntropy(const Eigen::Ref<const Eigen::MatrixXd>& output, const Eigen::Ref<const Eigen::MatrixXd>&,
+                          const Eigen::Ref<const Eigen::MatrixXd>& target, Eigen::Ref<Eigen::MatrixXd> delta) {
+ const double epsilon = 1e-12;
+ const double loss = -(target.array() * output.array().max(epsilon).min(1.0 - epsilon).log() +
+                       (1.0 - target.array()) * (1.0 - output.array().max(epsilon).min(1.0 - epsilon)).log()).sum();
+ delta = target - output;
+ return loss;
+}
+
+}
+}
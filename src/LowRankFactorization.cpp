@@ -0,0 +1,182 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "LowRankFactorization.h"
+#include <iostream>
+
+namespace neuroc{
+
+LowRankFactorization::LowRankFactorization(){
+}
+
+LowRankFactorization::~LowRankFactorization(){
+}
+
+/**
+* It factorizes every layer keeping the given fraction of the energy of its
+* weights. The layers where the factors would not be smaller are not changed.
+*
+* @param energy fraction of the sum of the squared singular values to keep, in (0, 1]
+* @return it returns true if it is all right, otherwise false
+**/
+bool LowRankFactorization::FactorizeByEnergy(Network& net, double energy){
+ if(energy <= 0.0 || energy > 1.0){
+  std::cerr << "Neuroc Error: LowRankFactorization the energy must be in (0, 1]" << std::endl;
+  return false;
+ }
+ for(unsigned int i=0; i<net.Size(); i++){
+  net[i].RemoveFactorMatrices();
+  Eigen::BDCSVD<Eigen::MatrixXd> svd(net[i].GetWeightMatrix(), Eigen::ComputeThinU | Eigen::ComputeThinV);
+  unsigned int rank = ReturnRankForEnergy(svd.singularValues(), energy);
+  if(rank <= ReturnMaximumRank(net[i]) && Factorize(net[i], svd, rank) == false) return false;
+ }
+ return true;
+}
+
+/**
+* It factorizes the layers one after the other with the smallest rank that
+* keeps the mean squared error of the network on the validation dataset
+* below the error of the uncompressed network plus the budget. The rank is
+* found with a binary search, the layers where no rank fits the budget
+* are not changed.
+*
+* @param inputDataset the validation inputs
+* @param targetDataset the validation targets
+* @param errorBudget the increase of the mean squared error allowed to the whole network
+* @return it returns true if it is all right, otherwise false
+**/
+bool LowRankFactorization::FactorizeByError(Network& net, Dataset& inputDataset, Dataset& targetDataset, double errorBudget){
+ if(inputDataset.ReturnNumberOfElements() == 0 || inputDataset.ReturnNumberOfElements() != targetDataset.ReturnNumberOfElements()){
+  std::cerr << "Neuroc Error: LowRankFactorization the validation datasets are empty or of different size" << std::endl;
+  return false;
+ }
+ for(unsigned int i=0; i<net.Size(); i++) net[i].RemoveFactorMatrices();
+ double max_error = net.ComputeMeanSquaredError(inputDataset, targetDataset) + errorBudget;
+
+ for(unsigned int i=0; i<net.Size(); i++){
+  unsigned int max_rank = ReturnMaximumRank(net[i]);
+  if(max_rank == 0) continue;
+  Eigen::MatrixXd weight_matrix = net[i].GetWeightMatrix();
+  Eigen::BDCSVD<Eigen::MatrixXd> svd(weight_matrix, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  //Smallest rank in [1, max_rank] within the budget, zero if none
+  unsigned int low = 1;
+  unsigned int high = max_rank;
+  unsigned int best_rank = 0;
+  while(low <= high){
+   unsigned int rank = (low + high) / 2;
+   if(Factorize(net[i], svd, rank) == false){
+    std::cerr << "Neuroc Error: LowRankFactorization the layer " << i << " cannot be factorized" << std::endl;
+    net[i].SetWeightMatrix(weight_matrix);
+    return false;
+   }
+   if(net.ComputeMeanSquaredError(inputDataset, targetDataset) <= max_error){
+    best_rank = rank;
+    high = rank - 1;
+   } else {
+    low = rank + 1;
+   }
+  }
+  net[i].SetWeightMatrix(weight_matrix);
+  if(best_rank > 0 && Factorize(net[i], svd, best_rank) == false){
+   std::cerr << "Neuroc Error: LowRankFactorization the layer " << i << " cannot be factorized" << std::endl;
+   return false;
+  }
+ }
+ return true;
+}
+
+/**
+* It factorizes a layer with the given rank
+*
+* @return it returns true if it is all right, otherwise false
+**/
+bool LowRankFactorization::Factorize(DenseLayer& layer, unsigned int rank){
+ layer.RemoveFactorMatrices();
+ const Eigen::MatrixXd& weight_matrix = layer.GetWeightMatrix();
+ if(rank == 0 || rank > std::min(weight_matrix.rows(), weight_matrix.cols())){
+  std::cerr << "Neuroc Error: LowRankFactorization the rank must be between 1 and the size of the weight matrix" << std::endl;
+  return false;
+ }
+ Eigen::BDCSVD<Eigen::MatrixXd> svd(weight_matrix, Eigen::ComputeThinU | Eigen::ComputeThinV);
+ return Factorize(layer, svd, rank);
+}
+
+bool LowRankFactorization::Factorize(DenseLayer& layer, const Eigen::BDCSVD<Eigen::MatrixXd>& svd, unsigned int rank){
+ Eigen::VectorXd root_vector = svd.singularValues().head(rank).cwiseSqrt();
+ Eigen::MatrixXd left_matrix = svd.matrixU().leftCols(rank) * root_vector.asDiagonal();
+ Eigen::MatrixXd right_matrix = root_vector.asDiagonal() * svd.matrixV().leftCols(rank).transpose();
+ return layer.SetFactorMatrices(left_matrix, right_matrix);
+}
+
+/**
+* It returns the singular values of the weights of the layer, in decreasing order
+*
+**/
+Eigen::VectorXd LowRankFactorization::ReturnSingularValues(DenseLayer& layer){
+ Eigen::BDCSVD<Eigen::MatrixXd> svd(layer.GetWeightMatrix());
+ return svd.singularValues();
+}
+
+/**
+* It returns the smallest rank that keeps the given fraction of the energy
+*
+* @param singularValues the singular values in decreasing order
+* @param energy fraction of the sum of the squared singular values to keep
+**/
+unsigned int LowRankFactorization::ReturnRankForEnergy(const Eigen::VectorXd& singularValues, double energy){
+ double total = singularValues.squaredNorm();
+ if(total == 0.0) return 1;
+ double kept = 0;
+ for(unsigned int rank=1; rank<=singularValues.size(); rank++){
+  kept += singularValues[rank-1] * singularValues[rank-1];
+  if(kept >= energy * total) return rank;
+ }
+ return singularValues.size();
+}
+
+/**
+* It returns the largest rank whose factors are smaller than the weight matrix
+*
+**/
+unsigned int LowRankFactorization::ReturnMaximumRank(DenseLayer& layer){
+ std::size_t inputs = layer.ReturnNumberOfInputs();
+ std::size_t outputs = layer.ReturnNumberOfNeurons();
+ return (inputs * outputs - 1) / (inputs + outputs);
+}
+
+/**
+* It prints the rank and the size of the weights of every layer
+*
+**/
+void LowRankFactorization::Print(Network& net){
+ std::size_t dense_total = 0;
+ std::size_t compressed_total = 0;
+ for(unsigned int i=0; i<net.Size(); i++){
+  std::size_t dense = net[i].GetWeightMatrix().size();
+  std::size_t compressed = net[i].IsFactorized() ? net[i].GetLeftFactorMatrix().size() + net[i].GetRightFactorMatrix().size() : dense;
+  dense_total += dense;
+  compressed_total += compressed;
+  std::cout << "Layer " << i << " " << net[i].ReturnNumberOfInputs() << "x" << net[i].ReturnNumberOfNeurons()
+            << " rank: " << (net[i].IsFactorized() ? std::to_string(net[i].ReturnRank()) : std::string("full"))
+            << " weights: " << dense << " -> " << compressed << std::endl;
+ }
+ std::cout << "Total weights: " << dense_total << " -> " << compressed_total << std::endl;
+}
+
+} //namespace
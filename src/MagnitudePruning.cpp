@@ -0,0 +1,143 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "MagnitudePruning.h"
+#include <iostream>
+#include <cmath>
+
+namespace neuroc{
+
+/**
+* Class constructor. The default schedule prunes the network
+* to 90% of sparsity in a single step.
+*
+**/
+MagnitudePruning::MagnitudePruning(){
+ mInitialSparsity = 0.0;
+ mFinalSparsity = 0.9;
+ mSteps = 1;
+ mPruneOutputLayer = true;
+}
+
+MagnitudePruning::~MagnitudePruning(){
+}
+
+/**
+* It sets the sparsity schedule.
+*
+* @param initialSparsity sparsity of the first step, in [0, 1]
+* @param finalSparsity sparsity of the last step, in [0, 1]
+* @param steps number of pruning steps
+* @return it returns true if it is all right, otherwise false
+**/
+bool MagnitudePruning::SetSchedule(double initialSparsity, double finalSparsity, unsigned int steps){
+ if(initialSparsity < 0.0 || initialSparsity > 1.0 || finalSparsity < 0.0 || finalSparsity > 1.0){
+  std::cerr << "Neuroc Error: MagnitudePruning the sparsity must be in [0, 1]" << std::endl;
+  return false;
+ }
+ if(steps == 0){
+  std::cerr << "Neuroc Error: MagnitudePruning the schedule needs at least one step" << std::endl;
+  return false;
+ }
+ mInitialSparsity = initialSparsity;
+ mFinalSparsity = finalSparsity;
+ mSteps = steps;
+ return true;
+}
+
+/**
+* It returns the sparsity of the given step of the schedule.
+* The sparsity grows fast in the first steps, when the network
+* has many redundant weights, and slowly near the final value.
+*
+**/
+double MagnitudePruning::ReturnScheduledSparsity(unsigned int step){
+ if(mSteps <= 1 || step >= mSteps - 1) return mFinalSparsity;
+ double remaining = 1.0 - (double) step / (mSteps - 1);
+ return mFinalSparsity + (mInitialSparsity - mFinalSparsity) * remaining * remaining * remaining;
+}
+
+unsigned int MagnitudePruning::GetSteps(){
+ return mSteps;
+}
+
+/**
+* If false the output layer is not pruned. The output layer is
+* usually small and its weights are the most important ones.
+*
+**/
+void MagnitudePruning::SetPruneOutputLayer(bool value){
+ mPruneOutputLayer = value;
+}
+
+bool MagnitudePruning::IsPruningOutputLayer(){
+ return mPruneOutputLayer;
+}
+
+/**
+* It prunes every layer of the network to the given sparsity.
+*
+* @param sparsity fraction of the weights of every layer set to zero
+* @return it returns true if it is all right, otherwise false
+**/
+bool MagnitudePruning::Prune(Network& net, double sparsity){
+ unsigned int layers = mPruneOutputLayer ? net.Size() : net.Size() - 1;
+ for(unsigned int i=0; i<layers && i<net.Size(); i++){
+  if(net[i].Prune(sparsity) == false) return false;
+ }
+ return true;
+}
+
+/**
+* It runs the schedule: at every step the network is pruned to the
+* sparsity of the step and then fine-tuned with the online learning.
+* The pruned weights stay zero during the fine-tuning.
+*
+* @param cyclesPerStep epochs of fine-tuning after every pruning step
+* @return it returns true if it is all right, otherwise false
+**/
+bool MagnitudePruning::StartPruning(Network* net, BackpropagationLearning& learning, Dataset& inputDataset, Dataset& targetDataset, unsigned int cyclesPerStep, bool print){
+ for(unsigned int step=0; step<mSteps; step++){
+  double sparsity = ReturnScheduledSparsity(step);
+  if(Prune(*net, sparsity) == false) return false;
+  learning.StartOnlineLearning(net, inputDataset, targetDataset, cyclesPerStep, false);
+  if(print){
+   std::cout << "Pruning step " << step + 1 << "/" << mSteps << " sparsity: " << sparsity
+             << " MSE: " << net->ComputeMeanSquaredError(inputDataset, targetDataset) << std::endl;
+  }
+ }
+ return true;
+}
+
+/**
+* It returns the fraction of the weights of the network that are zero.
+*
+**/
+double MagnitudePruning::ReturnSparsity(Network& net){
+ double zeros = 0;
+ double weights = 0;
+ for(unsigned int i=0; i<net.Size(); i++){
+  double size = net[i].GetWeightMatrix().size();
+  zeros += net[i].ReturnSparsity() * size;
+  weights += size;
+ }
+ return weights > 0 ? zeros / weights : 0.0;
+}
+
+} //namespace
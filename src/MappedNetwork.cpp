@@ -0,0 +1,164 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "MappedNetwork.h"
+#include "Dataset.h"
+#include "Trace.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace neuroc{
+
+MappedNetwork::MappedNetwork(){
+}
+
+/**
+* It maps a model file and it prepares the views of the layers. The
+* previous model is closed also if the new one cannot be opened.
+*
+* @param filePath the path of a file written by Network::SaveAsBinary()
+* @param verifyChecksum if true the checksum of the file is verified, this reads the whole file
+* @return it returns true if it is all right, otherwise false
+**/
+bool MappedNetwork::Open(const std::string& filePath, bool verifyChecksum){
+ Close();
+ ModelFormat::MappedFile file;
+ if(file.Open(filePath) == false) return false;
+ if(ModelFormat::CheckFile(file.GetData(), file.Size(), verifyChecksum) == false){
+  std::cerr << "Neuroc Error: MappedNetwork the file " << filePath << " is not valid" << std::endl;
+  return false;
+ }
+
+ const ModelFormat::FileHeader& header = *reinterpret_cast<const ModelFormat::FileHeader*>(file.GetData());
+ const ModelFormat::LayerRecord* records = ModelFormat::ReturnLayerRecords(file.GetData());
+ std::vector<MappedLayer> layers_vector(header.numberOfLayers);
+ for(unsigned int i=0; i<header.numberOfLayers; i++){
+  const ModelFormat::LayerRecord& record = records[i];
+  MappedLayer& layer = layers_vector[i];
+  layer.transfer = TransferFunctions::InPlace::ReturnFunction(ModelFormat::ReturnTransferFunction(record.transferFunction));
+  //The ids are the positions in the tables of ModelFormat: DotProduct is 0, Sum is 0 and Product is 1
+  if(record.weightFunction != 0 || record.mode == ModelFormat::BINARIZED || layer.transfer == nullptr){
+   std::cerr << "Neuroc Error: MappedNetwork the layer " << i << " cannot be computed on the mapped weights" << std::endl;
+   return false;
+  }
+  layer.inputSize = record.inputSize;
+  layer.outputSize = record.outputSize;
+  layer.weights = ModelFormat::ReturnBlock(file.GetData(), record.weightOffset);
+  layer.bias = ModelFormat::ReturnBlock(file.GetData(), record.biasOffset);
+  layer.productJoin = (record.joinFunction == 1);
+  layer.value = Eigen::VectorXd::Zero(record.outputSize);
+ }
+ mFile = std::move(file);
+ mLayersVector = std::move(layers_vector);
+ return true;
+}
+
+/**
+* It releases the mapping of the file
+*
+**/
+void MappedNetwork::Close(){
+ mLayersVector.clear();
+ mFile.Close();
+}
+
+/**
+* It computes the output of the network. The weights are read from the
+* mapped file and the computation does not allocate memory.
+*
+* @param inputVector the input of the network
+* @return it returns a reference to the output of the last layer
+**/
+const Eigen::VectorXd& MappedNetwork::Compute(const Eigen::VectorXd& inputVector){
+ NEUROC_TRACE_SCOPE("MappedNetwork::Compute");
+ if(mLayersVector.size() == 0) throw std::domain_error("Error: MappedNetwork no model is open");
+ if(inputVector.size() != mLayersVector[0].inputSize) throw std::domain_error("Error: MappedNetwork the input vector has a wrong size");
+
+ const Eigen::VectorXd* layer_input = &inputVector;
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  MappedLayer& layer = mLayersVector[i];
+  Eigen::Map<const Eigen::MatrixXd, Eigen::Aligned64> weight_matrix(layer.weights, layer.outputSize, layer.inputSize);
+  Eigen::Map<const Eigen::VectorXd, Eigen::Aligned64> bias_vector(layer.bias, layer.outputSize);
+  layer.value.noalias() = weight_matrix * (*layer_input);
+  if(layer.productJoin) layer.value.array() *= bias_vector.array();
+  else layer.value += bias_vector;
+  layer.transfer(layer.value);
+  layer_input = &layer.value;
+ }
+ return *layer_input;
+}
+
+/**
+* It computes the Mean Squared Error of the network given an input dataset and a target dataset
+*
+* @return it returns the Mean Squared Error
+**/
+double MappedNetwork::ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset){
+ double MSE = 0;
+ double dataset_size = inputDataset.ReturnNumberOfElements();
+ if(dataset_size != targetDataset.ReturnNumberOfElements()){
+  std::cerr << "Error: The input dataset and the target dataset have different dimensions." << std::endl;
+  return 0;
+ }
+ for(unsigned int i=0; i<dataset_size; i++){
+  MSE += (targetDataset[i] - Compute(inputDataset[i])).squaredNorm();
+ }
+ return MSE / dataset_size;
+}
+
+/**
+* It returns the number of layers
+*
+**/
+unsigned int MappedNetwork::Size(){
+ return mLayersVector.size();
+}
+
+/**
+* It returns the memory allocated by the network in the heap, the
+* mapped file is not included (see ReturnMappedBytes())
+*
+* @return it returns the number of bytes
+**/
+std::size_t MappedNetwork::ReturnMemoryFootprint(){
+ std::size_t total_bytes = sizeof(MappedNetwork);
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  total_bytes += sizeof(MappedLayer) + mLayersVector[i].value.size() * sizeof(double);
+ }
+ return total_bytes;
+}
+
+/**
+* It returns the size of the mapped file
+*
+* @return it returns the number of bytes
+**/
+std::size_t MappedNetwork::ReturnMappedBytes(){
+ return mFile.Size();
+}
+
+void MappedNetwork::Print(){
+ std::cout << "Mapped bytes ..... " << mFile.Size() << std::endl;
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const MappedLayer& layer = mLayersVector[i];
+  std::cout << "Layer[" << i << "] " << layer.inputSize << "x" << layer.outputSize << (layer.productJoin ? " product" : " sum") << std::endl;
+ }
+}
+
+} //namespace
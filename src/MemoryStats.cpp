@@ -0,0 +1,107 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "MemoryStats.h"
+#include <atomic>
+
+namespace neuroc{
+
+namespace MemoryStats{
+
+namespace {
+
+std::atomic<bool> gCountingEnabled(false);
+
+//The counters are written from inside malloc, the initial-exec model
+//guarantees that accessing them never allocates.
+thread_local AllocationCounters tCounters __attribute__((tls_model("initial-exec"))) = {0, 0, 0, 0};
+
+} //namespace
+
+/**
+* It returns true if the allocation hooks are linked in the executable
+*
+**/
+bool IsCountingEnabled(){
+ return gCountingEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+* It is called by the allocation hooks when they are loaded
+*
+**/
+void EnableCounting(){
+ gCountingEnabled.store(true, std::memory_order_relaxed);
+}
+
+void RecordAllocation(std::size_t bytes){
+ tCounters.allocations++;
+ tCounters.allocatedBytes += bytes;
+}
+
+void RecordDeallocation(std::size_t bytes){
+ tCounters.deallocations++;
+ tCounters.freedBytes += bytes;
+}
+
+/**
+* It returns the counters of the calling thread
+*
+**/
+AllocationCounters GetThreadCounters(){
+ return tCounters;
+}
+
+AllocationScope::AllocationScope(){
+ Restart();
+}
+
+/**
+* It starts a new measure from the current point
+*
+**/
+void AllocationScope::Restart(){
+ mStart = GetThreadCounters();
+}
+
+/**
+* It returns the allocations made by the thread from the start of the measure
+*
+**/
+AllocationCounters AllocationScope::Elapsed() const{
+ AllocationCounters now = GetThreadCounters();
+ AllocationCounters elapsed;
+ elapsed.allocations = now.allocations - mStart.allocations;
+ elapsed.deallocations = now.deallocations - mStart.deallocations;
+ elapsed.allocatedBytes = now.allocatedBytes - mStart.allocatedBytes;
+ elapsed.freedBytes = now.freedBytes - mStart.freedBytes;
+ return elapsed;
+}
+
+unsigned long long AllocationScope::Allocations() const{
+ return Elapsed().allocations;
+}
+
+unsigned long long AllocationScope::AllocatedBytes() const{
+ return Elapsed().allocatedBytes;
+}
+
+} //namespace
+
+} //namespace
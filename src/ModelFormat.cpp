@@ -0,0 +1,306 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "ModelFormat.h"
+#include "DenseLayer.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include "TransferFunctions.h"
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace neuroc{
+
+namespace ModelFormat{
+
+namespace {
+
+typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+typedef Eigen::VectorXd (*TransferFunction)(Eigen::VectorXd);
+
+//The position of a function in these tables is its id in the files,
+//new functions have to be added at the end
+const WeightFunction kWeightFunctions[] = {
+ &WeightFunctions::DotProduct, &WeightFunctions::EuclideanDistance, &WeightFunctions::AbsoluteDistance
+};
+const JoinFunction kJoinFunctions[] = {
+ &JoinFunctions::Sum, &JoinFunctions::Product
+};
+const TransferFunction kTransferFunctions[] = {
+ &TransferFunctions::Linear, &TransferFunctions::PositiveLinear, &TransferFunctions::SaturatedLinear,
+ &TransferFunctions::Sigmoid, &TransferFunctions::FastSigmoid, &TransferFunctions::SigmoidDerivative,
+ &TransferFunctions::Tanh, &TransferFunctions::TanhDerivative, &TransferFunctions::RadialBasis,
+ &TransferFunctions::MultiQuadratic, &TransferFunctions::HardLimit, &TransferFunctions::HardLimitDerivative,
+ &TransferFunctions::Softmax, &TransferFunctions::SoftmaxDerivative
+};
+const uint32_t kNumberOfWeightFunctions = sizeof(kWeightFunctions) / sizeof(kWeightFunctions[0]);
+const uint32_t kNumberOfJoinFunctions = sizeof(kJoinFunctions) / sizeof(kJoinFunctions[0]);
+const uint32_t kNumberOfTransferFunctions = sizeof(kTransferFunctions) / sizeof(kTransferFunctions[0]);
+
+/**
+* It finds the id of the function in the table
+*
+* @return it returns false if the function is not in the table
+**/
+template<typename FunctionPointer, typename Function>
+bool ReturnId(const Function& function, const FunctionPointer* table, uint32_t tableSize, uint32_t& id){
+ const FunctionPointer* target = function.template target<FunctionPointer>();
+ if(target == nullptr) return false;
+ for(uint32_t i=0; i<tableSize; i++){
+  if(*target == table[i]){
+   id = i;
+   return true;
+  }
+ }
+ return false;
+}
+
+/**
+* It checks that the block of the given number of doubles is aligned
+* and inside the file. The comparisons avoid the overflow of the sums.
+*
+**/
+bool CheckBlock(uint64_t offset, uint64_t numberOfValues, std::size_t fileSize){
+ if(offset % kAlignment != 0 || offset > fileSize) return false;
+ return numberOfValues <= (fileSize - offset) / sizeof(double);
+}
+
+} //namespace
+
+Checksum::Checksum(){
+ for(unsigned int i=0; i<4; i++) mLanes[i] = 14695981039346656037ULL + i; //FNV offset basis
+ mWords = 0;
+}
+
+/**
+* It adds the words to the checksum. The lane of a word is given by its
+* position from the first word, so the result does not depend on how the
+* words are split between the calls.
+*
+**/
+void Checksum::Update(const uint64_t* words, std::size_t numberOfWords){
+ const uint64_t prime = 1099511628211ULL; //FNV prime
+ std::size_t i = 0;
+ while(i < numberOfWords && (mWords + i) % 4 != 0){
+  uint64_t& lane = mLanes[(mWords + i) % 4];
+  lane = (lane ^ words[i]) * prime;
+  i++;
+ }
+ for(; i+4 <= numberOfWords; i+=4){
+  mLanes[0] = (mLanes[0] ^ words[i]) * prime;
+  mLanes[1] = (mLanes[1] ^ words[i+1]) * prime;
+  mLanes[2] = (mLanes[2] ^ words[i+2]) * prime;
+  mLanes[3] = (mLanes[3] ^ words[i+3]) * prime;
+ }
+ for(; i<numberOfWords; i++){
+  uint64_t& lane = mLanes[(mWords + i) % 4];
+  lane = (lane ^ words[i]) * prime;
+ }
+ mWords += numberOfWords;
+}
+
+uint64_t Checksum::Return() const {
+ const uint64_t prime = 1099511628211ULL;
+ uint64_t value = 14695981039346656037ULL;
+ for(unsigned int i=0; i<4; i++) value = (value ^ mLanes[i]) * prime;
+ return (value ^ mWords) * prime;
+}
+
+MappedFile::MappedFile() : mData(nullptr), mSize(0) {
+}
+
+MappedFile::MappedFile(MappedFile&& rMappedFile) noexcept : mData(rMappedFile.mData), mSize(rMappedFile.mSize) {
+ rMappedFile.mData = nullptr;
+ rMappedFile.mSize = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rMappedFile) noexcept {
+ if(this != &rMappedFile){
+  Close();
+  mData = rMappedFile.mData;
+  mSize = rMappedFile.mSize;
+  rMappedFile.mData = nullptr;
+  rMappedFile.mSize = 0;
+ }
+ return *this;
+}
+
+MappedFile::~MappedFile(){
+ Close();
+}
+
+/**
+* It maps the whole file in memory in read-only mode. The mapping stays
+* valid after the file is closed, and until Close() is called.
+*
+* @param filePath the path of the file
+* @return it returns true if it is all right, otherwise false
+**/
+bool MappedFile::Open(const std::string& filePath){
+ Close();
+ int descriptor = open(filePath.c_str(), O_RDONLY);
+ if(descriptor < 0){
+  std::cerr << "Neuroc Error: ModelFormat cannot open the file " << filePath << std::endl;
+  return false;
+ }
+ struct stat file_stat;
+ if(fstat(descriptor, &file_stat) != 0 || file_stat.st_size <= 0){
+  std::cerr << "Neuroc Error: ModelFormat the file " << filePath << " is empty" << std::endl;
+  close(descriptor);
+  return false;
+ }
+ void* address = mmap(nullptr, (std::size_t) file_stat.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+ close(descriptor);
+ if(address == MAP_FAILED){
+  std::cerr << "Neuroc Error: ModelFormat cannot map the file " << filePath << std::endl;
+  return false;
+ }
+ mData = static_cast<const char*>(address);
+ mSize = (std::size_t) file_stat.st_size;
+ return true;
+}
+
+void MappedFile::Close(){
+ if(mData != nullptr) munmap(const_cast<char*>(mData), mSize);
+ mData = nullptr;
+ mSize = 0;
+}
+
+/**
+* It finds the ids of the functions of the layer
+*
+* @param layer the layer
+* @param record where the ids are written
+* @return it returns false if one of the functions is not a function of the library
+**/
+bool ReturnFunctionIds(DenseLayer& layer, LayerRecord& record){
+ return ReturnId(layer.GetWeightFunction(), kWeightFunctions, kNumberOfWeightFunctions, record.weightFunction) &&
+        ReturnId(layer.GetJoinFunction(), kJoinFunctions, kNumberOfJoinFunctions, record.joinFunction) &&
+        ReturnId(layer.GetTransferFunction(), kTransferFunctions, kNumberOfTransferFunctions, record.transferFunction) &&
+        ReturnId(layer.GetDerivativeFunction(), kTransferFunctions, kNumberOfTransferFunctions, record.derivativeFunction);
+}
+
+std::function<Eigen::VectorXd(Eigen::MatrixXd, Eigen::VectorXd)> ReturnWeightFunction(uint32_t id){
+ return kWeightFunctions[id];
+}
+
+std::function<Eigen::VectorXd(Eigen::VectorXd, Eigen::VectorXd)> ReturnJoinFunction(uint32_t id){
+ return kJoinFunctions[id];
+}
+
+std::function<Eigen::VectorXd(Eigen::VectorXd)> ReturnTransferFunction(uint32_t id){
+ return kTransferFunctions[id];
+}
+
+/**
+* It checks the header and the layer records of a model file in memory:
+* the version, the data type, the byte order, the function ids, the chain
+* of the layers and the position of the blocks. The checksum is verified
+* only if requested, because it reads the whole file.
+*
+* @param data the content of the file, aligned to 64 bytes
+* @param size the size of the file in bytes
+* @param verifyChecksum if true the checksum is verified
+* @return it returns true if the file can be read, otherwise false
+**/
+bool CheckFile(const char* data, std::size_t size, bool verifyChecksum){
+ if(size < sizeof(FileHeader) || reinterpret_cast<std::uintptr_t>(data) % kAlignment != 0){
+  std::cerr << "Neuroc Error: ModelFormat the file is too short" << std::endl;
+  return false;
+ }
+ const FileHeader& header = *reinterpret_cast<const FileHeader*>(data);
+ if(std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0){
+  std::cerr << "Neuroc Error: ModelFormat the file is not a neuroc model" << std::endl;
+  return false;
+ }
+ if(header.byteOrder != kByteOrder){
+  std::cerr << "Neuroc Error: ModelFormat the file has been written with a different byte order" << std::endl;
+  return false;
+ }
+ if(header.version != kVersion){
+  std::cerr << "Neuroc Error: ModelFormat the version " << header.version << " is not supported, the supported version is " << kVersion << std::endl;
+  return false;
+ }
+ if(header.headerSize != sizeof(FileHeader) || header.dataType != FLOAT64 || header.alignment != kAlignment){
+  std::cerr << "Neuroc Error: ModelFormat the header of the file is not valid" << std::endl;
+  return false;
+ }
+ if(header.fileSize != size || header.numberOfLayers == 0 || header.numberOfLayers > (size - sizeof(FileHeader)) / sizeof(LayerRecord)){
+  std::cerr << "Neuroc Error: ModelFormat the file is truncated or the number of layers is not valid" << std::endl;
+  return false;
+ }
+ const LayerRecord* records = ReturnLayerRecords(data);
+ for(uint32_t i=0; i<header.numberOfLayers; i++){
+  const LayerRecord& record = records[i];
+  bool valid = record.inputSize > 0 && record.outputSize > 0 && record.mode <= SPARSE &&
+               record.weightFunction < kNumberOfWeightFunctions && record.joinFunction < kNumberOfJoinFunctions &&
+               record.transferFunction < kNumberOfTransferFunctions && record.derivativeFunction < kNumberOfTransferFunctions &&
+               (i == 0 || record.inputSize == records[i-1].outputSize) &&
+               CheckBlock(record.weightOffset, (uint64_t) record.inputSize * record.outputSize, size) &&
+               CheckBlock(record.biasOffset, record.outputSize, size);
+  if(valid == false){
+   std::cerr << "Neuroc Error: ModelFormat the record of the layer " << i << " is not valid" << std::endl;
+   return false;
+  }
+ }
+ if(header.extraSize > 0 && (header.extraOffset % kAlignment != 0 || header.extraOffset > size || header.extraSize > size - header.extraOffset)){
+  std::cerr << "Neuroc Error: ModelFormat the extra block is not valid" << std::endl;
+  return false;
+ }
+ if(verifyChecksum){
+  if((size - sizeof(FileHeader)) % sizeof(uint64_t) != 0){
+   std::cerr << "Neuroc Error: ModelFormat the size of the file is not valid" << std::endl;
+   return false;
+  }
+  Checksum checksum;
+  checksum.Update(reinterpret_cast<const uint64_t*>(data + sizeof(FileHeader)), (size - sizeof(FileHeader)) / sizeof(uint64_t));
+  if(checksum.Return() != header.checksum){
+   std::cerr << "Neuroc Error: ModelFormat the checksum does not match, the file is corrupted" << std::endl;
+   return false;
+  }
+ }
+ return true;
+}
+
+const LayerRecord* ReturnLayerRecords(const char* data){
+ return reinterpret_cast<const LayerRecord*>(data + sizeof(FileHeader));
+}
+
+const double* ReturnBlock(const char* data, uint64_t offset){
+ return reinterpret_cast<const double*>(data + offset);
+}
+
+/**
+* It returns a copy of the extra block of a checked file, it is empty if the file has none
+*
+**/
+std::string ReturnExtraBlock(const char* data){
+ const FileHeader& header = *reinterpret_cast<const FileHeader*>(data);
+ if(header.extraSize == 0) return std::string();
+ return std::string(data + header.extraOffset, header.extraSize);
+}
+
+} //namespace ModelFormat
+
+} //namespace neuroc
@@ -18,10 +18,82 @@
 */
 
 #include "Network.h"
+#include "Trace.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include "ModelFormat.h"
 #include <chrono>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
 
 namespace neuroc{
 
+namespace {
+
+/**
+* It returns the statements that apply the transfer function of a layer
+* to the vector with the given name, the expressions are the ones of the
+* in place functions so that the generated code computes the same values.
+*
+* @param function the in place version of the transfer function
+* @param name the name of the vector in the generated code
+* @param code the string where the statements are appended
+* @return it returns false if the function is not one of the library
+**/
+bool AppendTransferCode(TransferFunctions::InPlace::Function function, const std::string& name, std::string& code){
+ namespace InPlace = TransferFunctions::InPlace;
+ const std::string assign = " " + name + " = ";
+ const std::string array = name + ".array()";
+ if(function == &InPlace::Linear) return true;
+ else if(function == &InPlace::PositiveLinear) code += assign + name + ".cwiseAbs();\n";
+ else if(function == &InPlace::SaturatedLinear) code += assign + name + ".cwiseMin(1.0).cwiseMax(-1.0);\n";
+ else if(function == &InPlace::Sigmoid){
+  code += assign + "(1.0 + (-" + array + ").exp()).inverse().matrix();\n";
+  code += assign + array + ".isNaN().select(0.0, " + array + ").matrix();\n";
+ }
+ else if(function == &InPlace::FastSigmoid) code += assign + "(" + array + " / (1.0 + " + array + ".abs())).matrix();\n";
+ else if(function == &InPlace::SigmoidDerivative){
+  code += assign + "(-" + array + ").exp().matrix();\n";
+  code += assign + "(" + array + " / (1.0 + " + array + ").square()).matrix();\n";
+  code += assign + array + ".isNaN().select(0.0, " + array + ").matrix();\n";
+ }
+ else if(function == &InPlace::Tanh) code += assign + array + ".tanh().matrix();\n";
+ else if(function == &InPlace::TanhDerivative){
+  code += assign + "(1.0 - " + array + ".tanh().square()).matrix();\n";
+  code += assign + array + ".isNaN().select(0.0, " + array + ").matrix();\n";
+ }
+ else if(function == &InPlace::RadialBasis) code += assign + "(-" + array + ".square()).exp().matrix();\n";
+ else if(function == &InPlace::MultiQuadratic) code += assign + "(1.0 + " + array + ".square()).sqrt().matrix();\n";
+ else if(function == &InPlace::HardLimit) code += assign + "(" + array + " > 0.0).cast<double>().matrix();\n";
+ else if(function == &InPlace::HardLimitDerivative) code += assign + "(" + array + ".abs() <= 1.0).cast<double>().matrix();\n";
+ else if(function == &InPlace::Softmax){
+  code += assign + "(" + array + " - " + name + ".maxCoeff()).exp().matrix();\n";
+  code += " " + name + " /= " + name + ".sum();\n";
+ }
+ else if(function == &InPlace::SoftmaxDerivative) return true;
+ else return false;
+ return true;
+}
+
+/**
+* It writes the values as the initializer of a static array, with the
+* digits needed to read back the same doubles.
+*
+**/
+void WriteArray(std::ofstream& file_stream, const std::string& name, const double* values, std::size_t size){
+ file_stream << "alignas(64) static const double " << name << "[" << size << "] = {";
+ for(std::size_t i=0; i<size; i++){
+  if(i % 4 == 0) file_stream << "\n ";
+  file_stream << values[i] << (i+1 < size ? ", " : "");
+ }
+ file_stream << "\n};\n\n";
+}
+
+} //namespace
+
 /**
 * Default constructor
 *
@@ -41,6 +113,16 @@ Network::Network(const Network &rNetwork)
 mLayersVector = rNetwork.mLayersVector;
 }
 
+/**
+* Move constructor, the layers are taken without copying them
+*
+* @param rNetwork rvalue reference to an existing Network
+*/
+Network::Network(Network &&rNetwork) noexcept
+{
+mLayersVector = std::move(rNetwork.mLayersVector);
+}
+
 
 /**
 * Class constructor. It permits to create directly a multiple hidden layer network
@@ -66,13 +148,25 @@ mLayersVector.clear();
 *
 * @param rLayer reference to an existing Layer
 */
-Network Network::operator=(const Network &rNetwork)
+Network& Network::operator=(const Network &rNetwork)
 {  		
 if (this == &rNetwork) return *this;  // check for self-assignment 
 mLayersVector = rNetwork.mLayersVector;
 return *this;
 }
 
+/**
+* Overload of the move assignment operator
+*
+* @param rNetwork rvalue reference to an existing Network
+*/
+Network& Network::operator=(Network &&rNetwork) noexcept
+{
+if (this == &rNetwork) return *this;  // check for self-assignment
+mLayersVector = std::move(rNetwork.mLayersVector);
+return *this;
+}
+
 /**
 * Operator overload [] it is used to return the smart pointer reference to the Layer stored inside the Network
 * It is possible to access the methods of the single Layer using the deferencing operator ->
@@ -95,14 +189,61 @@ unsigned int Network::Size(){
 return mLayersVector.size();
 }
 
+/**
+* It adds a copy of the layer at the end of the network
+*
+* @param layer
+*/
+void Network::AddLayer(const DenseLayer& layer){
+mLayersVector.push_back(layer);
+}
+
+/**
+* It moves the layer at the end of the network, without copying the weights
+*
+* @param layer
+*/
+void Network::AddLayer(DenseLayer&& layer){
+mLayersVector.push_back(std::move(layer));
+}
+
+/**
+* It reserves the memory for the given number of layers, the layers
+* added later are not moved when the network grows.
+*
+* @param numberOfLayers
+*/
+void Network::ReserveLayers(unsigned int numberOfLayers){
+mLayersVector.reserve(numberOfLayers);
+}
+
+/**
+* It removes neurons from a layer of the network together with the
+* matching inputs of the next layer, the network becomes smaller.
+*
+* @param layerIndex the layer of the neurons
+* @param neurons indices of the neurons to remove
+* @return it returns true if it is all right, otherwise false
+*/
+bool Network::RemoveNeurons(unsigned int layerIndex, const std::vector<unsigned int>& neurons){
+ if(layerIndex >= mLayersVector.size()){
+  std::cerr << "Neuroc Error: Network the layer " << layerIndex << " does not exist" << std::endl;
+  return false;
+ }
+ if(mLayersVector[layerIndex].RemoveNeurons(neurons) == false) return false;
+ if(layerIndex + 1 < mLayersVector.size()) return mLayersVector[layerIndex+1].RemoveInputs(neurons);
+ return true;
+}
+
 /**
 * Compute all the neurons of the layer and return a vector containing the values of these neurons
 *
-* @return it returns the vector containing the double, in case of problems it returns an empty vector and print an error
+* @return it returns a reference to the vector of the output layer, in case of problems it returns an empty vector and print an error
 **/
-Eigen::VectorXd Network::Compute(Eigen::VectorXd InputVector) {
+const Eigen::VectorXd& Network::Compute(const Eigen::VectorXd& InputVector) {
 
-Eigen::VectorXd void_vector;
+NEUROC_TRACE_SCOPE("Network::Compute");
+static const Eigen::VectorXd void_vector;
 
 if(mLayersVector.size()==0){
 std::cerr << "Neuroc Error: Network Computation is not possible if the network is empty" << std::endl;
@@ -113,23 +254,28 @@ std::cerr << "Neuroc Error: Network Computation is not possible if the input vec
 return void_vector;
 }
 
-//Compute all the Layers
+//Compute all the Layers, the output of each layer
+//is given by reference as input to the next one
+const Eigen::VectorXd* layer_input = &InputVector;
 for (unsigned int i=0; i<mLayersVector.size(); i++ ) {
- InputVector = mLayersVector[i].Compute(InputVector);
+ layer_input = &mLayersVector[i].Compute(*layer_input);
 }
 
 //Return the result of the Output Layer
-return mLayersVector[mLayersVector.size()-1].GetOutputVector();
+return *layer_input;
 }
 
 /**
-* Compute all the neurons of the layer and return a vector containing the values of these neurons
+* Compute the output and the derivative of all the layers. The output of each
+* layer is given as input to the next one, the weighted input of a layer is
+* computed once for both the values.
 *
-* @return it returns the vector containing the double, in case of problems it returns an empty vector and print an error
+* @return it returns a reference to the derivative vector of the output layer, in case of problems it returns an empty vector and print an error
 **/
-Eigen::VectorXd Network::ComputeDerivative(Eigen::VectorXd InputVector) {
+const Eigen::VectorXd& Network::ComputeDerivative(const Eigen::VectorXd& InputVector) {
 
-Eigen::VectorXd void_vector;
+NEUROC_TRACE_SCOPE("Network::ComputeDerivative");
+static const Eigen::VectorXd void_vector;
 
 if(mLayersVector.size()==0){
 std::cerr << "Neuroc Error: Network Computation is not possible if the network is empty" << std::endl;
@@ -140,13 +286,15 @@ std::cerr << "Neuroc Error: Network Computation is not possible if the input vec
 return void_vector;
 }
 
-//Compute all the Layers
+//Compute all the Layers, the output of each layer
+//is given by reference as input to the next one
+const Eigen::VectorXd* layer_input = &InputVector;
 for (unsigned int i=0; i<mLayersVector.size(); i++ ) {
- InputVector = mLayersVector[i].ComputeDerivative(InputVector);
+ layer_input = &mLayersVector[i].ComputeWithDerivative(*layer_input);
 }
 
-//Return the result of the Output Layer
-return mLayersVector[mLayersVector.size()-1].GetDerivativeVector();
+//Return the derivative of the Output Layer
+return mLayersVector.back().GetDerivativeVector();
 }
 
 /**
@@ -154,7 +302,7 @@ return mLayersVector[mLayersVector.size()-1].GetDerivativeVector();
 *
 * @return it returns the Mean Squared Error
 **/
-double Network::ComputeMeanSquaredError(neuroc::Dataset inputDataset, neuroc::Dataset targetDataset){
+double Network::ComputeMeanSquaredError(neuroc::Dataset& inputDataset, neuroc::Dataset& targetDataset){
  double MSE = 0; //Mean Squared Error
  double dataset_size = inputDataset.ReturnNumberOfElements();
  double target_size = targetDataset.ReturnNumberOfElements();
@@ -165,11 +313,10 @@ double Network::ComputeMeanSquaredError(neuroc::Dataset inputDataset, neuroc::Da
  }
 
  for(unsigned int i=0; i<dataset_size; i++){
-  Eigen::VectorXd output_evector = Compute(inputDataset.GetData(i));
-  //This difference is the distance between the output vector and the target
-  Eigen::VectorXd distance_evector = targetDataset.GetData(i) - output_evector;
-  //Adding to the performance counter the norm of the distance vector
-  MSE += distance_evector.squaredNorm(); 
+  const Eigen::VectorXd& output_evector = Compute(inputDataset[i]);
+  //Adding to the performance counter the norm of the distance
+  //between the output vector and the target
+  MSE += (targetDataset[i] - output_evector).squaredNorm();
  }
 
  MSE = MSE / dataset_size;
@@ -181,7 +328,7 @@ double Network::ComputeMeanSquaredError(neuroc::Dataset inputDataset, neuroc::Da
 *
 * @return it returns the Mean Squared Error
 **/
-double Network::Test(neuroc::Dataset inputDataset, neuroc::Dataset targetDataset){
+double Network::Test(neuroc::Dataset& inputDataset, neuroc::Dataset& targetDataset){
 
  double MSE = 0; //Mean Squared Error
  double dataset_size = inputDataset.ReturnNumberOfElements();
@@ -245,6 +392,292 @@ return total_number;
 }
 
 
+/**
+* It saves the network in a binary file (see ModelFormat). The file stores
+* the topology, the ids of the functions and the mode of every layer, and
+* the weights and the bias in blocks aligned to 64 bytes, so that the file
+* can be mapped by MappedNetwork without copying the weights. The weights of
+* the binarized layers are the shadow weights, the sparse layers keep their
+* mask, the factorized and clustered layers are saved with their dense
+* weights. Only the functions of the library can be saved. The optional
+* extra block is stored after the weights and it is covered by the checksum,
+* it can be read with ModelFormat::ReturnExtraBlock().
+*
+* @param filePath the path of the file
+* @param extraBlock bytes stored with the network, for example the state of the training
+* @return it returns true if it is all right, otherwise false
+**/
+bool Network::SaveAsBinary(const std::string& filePath, const std::string& extraBlock){
+ if(mLayersVector.size() == 0){
+  std::cerr << "Neuroc Error: SaveAsBinary the network is empty" << std::endl;
+  return false;
+ }
+
+ //Position of the blocks, every block starts at a multiple of the alignment
+ auto aligned_bytes = [](uint64_t bytes){ return (bytes + ModelFormat::kAlignment - 1) / ModelFormat::kAlignment * ModelFormat::kAlignment; };
+ std::vector<ModelFormat::LayerRecord> records(mLayersVector.size(), ModelFormat::LayerRecord());
+ uint64_t offset = sizeof(ModelFormat::FileHeader) + aligned_bytes(sizeof(ModelFormat::LayerRecord) * records.size());
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  ModelFormat::LayerRecord& record = records[i];
+  if(ModelFormat::ReturnFunctionIds(mLayersVector[i], record) == false){
+   std::cerr << "Neuroc Error: SaveAsBinary the layer " << i << " uses functions that are not part of the library" << std::endl;
+   return false;
+  }
+  record.inputSize = mLayersVector[i].ReturnNumberOfInputs();
+  record.outputSize = mLayersVector[i].ReturnNumberOfNeurons();
+  record.mode = mLayersVector[i].IsBinarized() ? ModelFormat::BINARIZED : (mLayersVector[i].IsSparse() ? ModelFormat::SPARSE : ModelFormat::DENSE);
+  record.weightOffset = offset;
+  offset += aligned_bytes(sizeof(double) * record.inputSize * record.outputSize);
+  record.biasOffset = offset;
+  offset += aligned_bytes(sizeof(double) * record.outputSize);
+ }
+ const uint64_t extra_offset = offset;
+ offset += aligned_bytes(extraBlock.size());
+
+ std::ofstream file_stream(filePath, std::ios::binary | std::ios::trunc);
+ if(!file_stream){
+  std::cerr << "Neuroc Error: SaveAsBinary cannot open the file " << filePath << std::endl;
+  return false;
+ }
+ //The header is written again at the end with the checksum of the rest of the file
+ ModelFormat::FileHeader header = ModelFormat::FileHeader();
+ std::memcpy(header.magic, ModelFormat::kMagic, sizeof(header.magic));
+ header.version = ModelFormat::kVersion;
+ header.headerSize = sizeof(ModelFormat::FileHeader);
+ header.dataType = ModelFormat::FLOAT64;
+ header.numberOfLayers = records.size();
+ header.byteOrder = ModelFormat::kByteOrder;
+ header.alignment = ModelFormat::kAlignment;
+ header.fileSize = offset;
+ header.extraOffset = extraBlock.empty() ? 0 : extra_offset;
+ header.extraSize = extraBlock.size();
+ file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+ ModelFormat::Checksum checksum;
+ const uint64_t padding[ModelFormat::kAlignment / sizeof(uint64_t)] = {};
+ auto write_block = [&](const void* data, uint64_t bytes){
+  file_stream.write(static_cast<const char*>(data), bytes);
+  checksum.Update(static_cast<const uint64_t*>(data), bytes / sizeof(uint64_t));
+  uint64_t padding_bytes = aligned_bytes(bytes) - bytes;
+  file_stream.write(reinterpret_cast<const char*>(padding), padding_bytes);
+  checksum.Update(padding, padding_bytes / sizeof(uint64_t));
+ };
+ write_block(records.data(), sizeof(ModelFormat::LayerRecord) * records.size());
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const Eigen::MatrixXd& weight_matrix = mLayersVector[i].GetWeightMatrix();
+  const Eigen::VectorXd& bias_vector = mLayersVector[i].GetBiasVector();
+  write_block(weight_matrix.data(), sizeof(double) * weight_matrix.size());
+  write_block(bias_vector.data(), sizeof(double) * bias_vector.size());
+ }
+ if(extraBlock.empty() == false){
+  //The checksum reads 8-byte words, the block is padded before writing it
+  std::vector<uint64_t> extra_words(aligned_bytes(extraBlock.size()) / sizeof(uint64_t), 0);
+  std::memcpy(extra_words.data(), extraBlock.data(), extraBlock.size());
+  write_block(extra_words.data(), sizeof(uint64_t) * extra_words.size());
+ }
+ header.checksum = checksum.Return();
+ file_stream.seekp(0);
+ file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+ file_stream.close();
+ if(!file_stream){
+  std::cerr << "Neuroc Error: SaveAsBinary cannot write the file " << filePath << std::endl;
+  return false;
+ }
+ return true;
+}
+
+/**
+* It loads a network saved with SaveAsBinary(), the layers of the network
+* are replaced. The file is checked before any change, the network is not
+* modified if the file is not valid or the checksum does not match.
+*
+* @param filePath the path of the file
+* @return it returns true if it is all right, otherwise false
+**/
+bool Network::LoadFromBinary(const std::string& filePath){
+ ModelFormat::MappedFile file;
+ if(file.Open(filePath) == false) return false;
+ if(ModelFormat::CheckFile(file.GetData(), file.Size(), true) == false){
+  std::cerr << "Neuroc Error: LoadFromBinary the file " << filePath << " is not valid" << std::endl;
+  return false;
+ }
+ const ModelFormat::FileHeader& header = *reinterpret_cast<const ModelFormat::FileHeader*>(file.GetData());
+ const ModelFormat::LayerRecord* records = ModelFormat::ReturnLayerRecords(file.GetData());
+ std::vector<DenseLayer> layers_vector;
+ layers_vector.reserve(header.numberOfLayers);
+ for(unsigned int i=0; i<header.numberOfLayers; i++){
+  const ModelFormat::LayerRecord& record = records[i];
+  layers_vector.emplace_back(record.inputSize, record.outputSize,
+                             ModelFormat::ReturnWeightFunction(record.weightFunction),
+                             ModelFormat::ReturnJoinFunction(record.joinFunction),
+                             ModelFormat::ReturnTransferFunction(record.transferFunction),
+                             ModelFormat::ReturnTransferFunction(record.derivativeFunction));
+  DenseLayer& layer = layers_vector.back();
+  layer.SetWeightMatrix(Eigen::Map<const Eigen::MatrixXd>(ModelFormat::ReturnBlock(file.GetData(), record.weightOffset), record.outputSize, record.inputSize));
+  layer.SetBiasVector(Eigen::Map<const Eigen::VectorXd>(ModelFormat::ReturnBlock(file.GetData(), record.biasOffset), record.outputSize));
+  if(record.mode == ModelFormat::BINARIZED) layer.SetBinarized(true);
+  else if(record.mode == ModelFormat::SPARSE) layer.SetSparse(true);
+ }
+ mLayersVector = std::move(layers_vector);
+ return true;
+}
+
+/**
+* It writes a self-contained C++ header that computes the network with
+* fixed-size Eigen types. The weights are embedded as static arrays, the
+* dimensions of every layer are template arguments and the transfer
+* functions are written inline, so the compiler can unroll the products
+* and the Predict() function does not allocate memory nor call through
+* std::function. The effective weights are exported, so the binarized,
+* sparse, factorized and clustered layers are written as dense matrices.
+* Only the layers with the DotProduct weight function, the Sum or Product
+* join function and a transfer function of the library can be exported.
+* The output can differ from Compute() in the last bits, because the
+* fixed-size products can sum the terms in a different order.
+*
+* @param path the path of the header to write
+* @param modelName the namespace of the generated code, it must be a valid identifier
+* @return it returns true if it is all right, otherwise false
+**/
+bool Network::ExportCpp(const std::string& path, const std::string& modelName){
+ typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+ //Eigen refuses fixed-size objects larger than its stack allocation limit (128 KB)
+ const unsigned int max_vector_size = 16384;
+
+ if(mLayersVector.size() == 0){
+  std::cerr << "Neuroc Error: ExportCpp the network is empty" << std::endl;
+  return false;
+ }
+ bool valid_name = (modelName.empty() == false && std::isdigit((unsigned char) modelName[0]) == false);
+ for(unsigned int i=0; i<modelName.size(); i++) valid_name = valid_name && (std::isalnum((unsigned char) modelName[i]) || modelName[i] == '_');
+ if(valid_name == false){
+  std::cerr << "Neuroc Error: ExportCpp the model name '" << modelName << "' is not a valid identifier" << std::endl;
+  return false;
+ }
+
+ //The body of Predict() is prepared before opening the file, so
+ //that nothing is written if one of the layers cannot be exported
+ std::string code;
+ std::string input_name = "input";
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  DenseLayer& layer = mLayersVector[i];
+  const WeightFunction* weight_target = layer.GetWeightFunction().target<WeightFunction>();
+  const JoinFunction* join_target = layer.GetJoinFunction().target<JoinFunction>();
+  bool dot_product = (weight_target != nullptr && *weight_target == &WeightFunctions::DotProduct);
+  bool sum_join = (join_target != nullptr && *join_target == &JoinFunctions::Sum);
+  bool product_join = (join_target != nullptr && *join_target == &JoinFunctions::Product);
+  const std::string rows = std::to_string(layer.ReturnNumberOfNeurons());
+  const std::string cols = std::to_string(layer.ReturnNumberOfInputs());
+  const std::string index = std::to_string(i);
+  const std::string name = "layer" + index;
+  std::string transfer_code;
+  if(dot_product == false || (sum_join == false && product_join == false) ||
+     AppendTransferCode(TransferFunctions::InPlace::ReturnFunction(layer.GetTransferFunction()), name, transfer_code) == false){
+   std::cerr << "Neuroc Error: ExportCpp the layer " << i << " uses functions that cannot be exported" << std::endl;
+   return false;
+  }
+  if(layer.ReturnNumberOfNeurons() > max_vector_size || (i == 0 && layer.ReturnNumberOfInputs() > max_vector_size)){
+   std::cerr << "Neuroc Error: ExportCpp the layer " << i << " is too large for fixed-size vectors" << std::endl;
+   return false;
+  }
+  if(i > 0 && layer.ReturnNumberOfInputs() != mLayersVector[i-1].ReturnNumberOfNeurons()){
+   std::cerr << "Neuroc Error: ExportCpp the input of the layer " << i << " does not fit the output of the previous layer" << std::endl;
+   return false;
+  }
+  const Eigen::MatrixXd& weight_matrix = layer.GetEffectiveWeightMatrix();
+  if(weight_matrix.allFinite() == false || layer.GetBiasVector().allFinite() == false){
+   std::cerr << "Neuroc Error: ExportCpp the layer " << i << " has weights that are not finite" << std::endl;
+   return false;
+  }
+  code += " const Eigen::Map<const Eigen::Matrix<double, " + rows + ", " + cols + ">, Eigen::Aligned> weight" + index + "(kWeights" + index + ");\n";
+  code += " const Eigen::Map<const Eigen::Matrix<double, " + rows + ", 1>, Eigen::Aligned> bias" + index + "(kBias" + index + ");\n";
+  code += " Eigen::Matrix<double, " + rows + ", 1> " + name + ";\n";
+  code += " " + name + ".noalias() = weight" + index + " * " + input_name + ";\n";
+  if(sum_join) code += " " + name + " += bias" + index + ";\n";
+  else code += " " + name + ".array() *= bias" + index + ".array();\n";
+  code += transfer_code;
+  input_name = name;
+ }
+ code += " return " + input_name + ";\n";
+
+ std::ofstream file_stream(path);
+ if(!file_stream){
+  std::cerr << "Neuroc Error: ExportCpp cannot open the file " << path << std::endl;
+  return false;
+ }
+ std::string guard = modelName + "_H";
+ for(unsigned int i=0; i<guard.size(); i++) guard[i] = std::toupper((unsigned char) guard[i]);
+ file_stream << std::setprecision(std::numeric_limits<double>::max_digits10);
+ file_stream << "/*\n * Generated by neuroc Network::ExportCpp(), do not edit.\n"
+             << " * Topology: " << mLayersVector[0].ReturnNumberOfInputs();
+ for(unsigned int i=0; i<mLayersVector.size(); i++) file_stream << "-" << mLayersVector[i].ReturnNumberOfNeurons();
+ file_stream << "\n */\n\n#ifndef " << guard << "\n#define " << guard << "\n\n#include <Eigen/Dense>\n\n"
+             << "namespace " << modelName << "{\n\n"
+             << "static const int kInputSize = " << mLayersVector[0].ReturnNumberOfInputs() << ";\n"
+             << "static const int kOutputSize = " << mLayersVector.back().ReturnNumberOfNeurons() << ";\n\n"
+             << "typedef Eigen::Matrix<double, kInputSize, 1> InputVector;\n"
+             << "typedef Eigen::Matrix<double, kOutputSize, 1> OutputVector;\n\n";
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const Eigen::MatrixXd& weight_matrix = mLayersVector[i].GetEffectiveWeightMatrix();
+  const Eigen::VectorXd& bias_vector = mLayersVector[i].GetBiasVector();
+  file_stream << "//Layer " << i << ", " << weight_matrix.rows() << " x " << weight_matrix.cols() << " weights in column major order\n";
+  WriteArray(file_stream, "kWeights" + std::to_string(i), weight_matrix.data(), weight_matrix.size());
+  WriteArray(file_stream, "kBias" + std::to_string(i), bias_vector.data(), bias_vector.size());
+ }
+ file_stream << "/**\n* It computes the output of the network\n**/\n"
+             << "inline OutputVector Predict(const InputVector& input){\n" << code << "}\n\n"
+             << "} //namespace\n\n#endif // " << guard << "\n";
+ file_stream.close();
+ if(!file_stream){
+  std::cerr << "Neuroc Error: ExportCpp cannot write the file " << path << std::endl;
+  return false;
+ }
+ return true;
+}
+
+/**
+* It returns a snapshot of the profiling counters of all the layers,
+* together with the learning phase times summed over all the threads.
+* The counters are updated only if the library is compiled with NEUROC_PROFILE.
+*
+* @return it returns the profile of the network
+**/
+NetworkProfile Network::GetProfile() {
+NetworkProfile profile;
+for (unsigned int i = 0; i < mLayersVector.size(); i++) {
+profile.layers.push_back(mLayersVector[i].GetProfile());
+}
+profile.phases = Profiler::GetPhaseProfile();
+return profile;
+}
+
+/**
+* It sets to zero the profiling counters of the layers and of the learning phases.
+*
+**/
+void Network::ResetProfile() {
+for (unsigned int i = 0; i < mLayersVector.size(); i++) {
+mLayersVector[i].ResetProfile();
+}
+Profiler::ResetPhaseProfile();
+}
+
+
+/**
+* It returns the memory used by all the layers of the Network
+*
+* @return it returns the number of bytes
+**/
+std::size_t Network::ReturnMemoryFootprint() {
+std::size_t total_bytes = sizeof(Network);
+for (unsigned int i = 0; i < mLayersVector.size(); i++) {
+total_bytes += mLayersVector[i].ReturnMemoryFootprint();
+}
+return total_bytes;
+}
+
+
 /**
 * Print information about all the neurons contained inside the Layer
 *
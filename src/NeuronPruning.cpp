@@ -0,0 +1,197 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "NeuronPruning.h"
+#include "JoinFunctions.h"
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace neuroc{
+
+/**
+* Class constructor. The default score is the weight norm
+* and the bias compensation is enabled.
+*
+**/
+NeuronPruning::NeuronPruning(){
+ mScore = WEIGHT_NORM;
+ mBiasCompensation = true;
+}
+
+NeuronPruning::~NeuronPruning(){
+}
+
+void NeuronPruning::SetScore(Score score){
+ mScore = score;
+}
+
+NeuronPruning::Score NeuronPruning::GetScore(){
+ return mScore;
+}
+
+/**
+* If true the mean output of the removed neurons, measured on the
+* calibration dataset, is moved into the bias of the next layer.
+*
+**/
+void NeuronPruning::SetBiasCompensation(bool value){
+ mBiasCompensation = value;
+}
+
+bool NeuronPruning::IsCompensatingBias(){
+ return mBiasCompensation;
+}
+
+/**
+* It computes the mean and the variance of the output of
+* every layer of the network on the calibration dataset.
+*
+**/
+void NeuronPruning::ComputeStatistics(Network& net, Dataset& calibrationDataset){
+ mMeanVectors.assign(net.Size(), Eigen::VectorXd());
+ mVarianceVectors.assign(net.Size(), Eigen::VectorXd());
+ unsigned int samples = calibrationDataset.ReturnNumberOfElements();
+ if(samples == 0) return;
+ std::vector<Eigen::VectorXd> sum_vectors(net.Size());
+ std::vector<Eigen::VectorXd> square_vectors(net.Size());
+ for(unsigned int i=0; i<net.Size(); i++){
+  sum_vectors[i] = Eigen::VectorXd::Zero(net[i].GetWeightMatrix().rows());
+  square_vectors[i] = Eigen::VectorXd::Zero(net[i].GetWeightMatrix().rows());
+ }
+ for(unsigned int s=0; s<samples; s++){
+  net.Compute(calibrationDataset[s]);
+  for(unsigned int i=0; i<net.Size(); i++){
+   const Eigen::VectorXd& output_vector = net[i].GetOutputVector();
+   sum_vectors[i] += output_vector;
+   square_vectors[i].array() += output_vector.array().square();
+  }
+ }
+ for(unsigned int i=0; i<net.Size(); i++){
+  mMeanVectors[i] = sum_vectors[i] / samples;
+  mVarianceVectors[i] = (square_vectors[i] / samples - mMeanVectors[i].cwiseAbs2()).cwiseMax(0.0);
+ }
+}
+
+/**
+* It returns the scores of the neurons of a layer from the
+* statistics computed on the calibration dataset.
+*
+**/
+Eigen::VectorXd NeuronPruning::ReturnScores(Network& net, unsigned int layerIndex){
+ if(mScore == ACTIVATION_VARIANCE) return mVarianceVectors[layerIndex];
+ Eigen::VectorXd score_vector = net[layerIndex].GetWeightMatrix().rowwise().norm();
+ if(layerIndex + 1 < net.Size()) score_vector.array() *= net[layerIndex+1].GetWeightMatrix().colwise().norm().transpose().array();
+ return score_vector;
+}
+
+/**
+* It returns the score of every neuron of a layer, the neurons
+* with the lowest scores are the first to be removed.
+*
+* @param layerIndex the layer of the neurons
+* @param calibrationDataset inputs used to measure the activations
+* @return it returns a vector with a score for every neuron of the layer
+**/
+Eigen::VectorXd NeuronPruning::ReturnScores(Network& net, unsigned int layerIndex, Dataset& calibrationDataset){
+ if(layerIndex >= net.Size()) throw std::domain_error("Error: NeuronPruning the layer does not exist");
+ if(mScore == ACTIVATION_VARIANCE && calibrationDataset.ReturnNumberOfElements() == 0) throw std::domain_error("Error: NeuronPruning the activation variance needs a calibration dataset");
+ ComputeStatistics(net, calibrationDataset);
+ return ReturnScores(net, layerIndex);
+}
+
+/**
+* It removes the given fraction of the neurons of every hidden layer,
+* the ones with the lowest scores. At least one neuron is kept.
+* The statistics are measured once on the calibration dataset, it can
+* be empty if the score is the weight norm and the bias is not compensated.
+*
+* @param fraction fraction of the neurons to remove, in [0, 1)
+* @param calibrationDataset inputs used to measure the activations
+* @return it returns true if it is all right, otherwise false
+**/
+bool NeuronPruning::Prune(Network& net, double fraction, Dataset& calibrationDataset){
+ if(fraction < 0.0 || fraction >= 1.0){
+  std::cerr << "Neuroc Error: NeuronPruning the fraction must be in [0, 1)" << std::endl;
+  return false;
+ }
+ if(mScore == ACTIVATION_VARIANCE && calibrationDataset.ReturnNumberOfElements() == 0){
+  std::cerr << "Neuroc Error: NeuronPruning the activation variance needs a calibration dataset" << std::endl;
+  return false;
+ }
+ ComputeStatistics(net, calibrationDataset);
+
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+ for(unsigned int i=0; i+1<net.Size(); i++){
+  Eigen::VectorXd score_vector = ReturnScores(net, i);
+  unsigned int neurons = score_vector.size();
+  unsigned int removed = std::min((unsigned int) (fraction * neurons), neurons - 1);
+  if(removed == 0) continue;
+  std::vector<unsigned int> indices(neurons);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::nth_element(indices.begin(), indices.begin() + (removed - 1), indices.end(),
+                   [&score_vector](unsigned int a, unsigned int b){ return score_vector[a] < score_vector[b]; });
+  indices.resize(removed);
+
+  //The next layer receives the mean output of the removed neurons through its bias
+  const JoinFunction* join_target = net[i+1].GetJoinFunction().target<JoinFunction>();
+  bool sum_join = (join_target != nullptr && *join_target == &JoinFunctions::Sum);
+  if(mBiasCompensation && sum_join && mMeanVectors[i].size() > 0){
+   Eigen::VectorXd bias_vector = net[i+1].GetBiasVector();
+   const Eigen::MatrixXd& next_matrix = net[i+1].GetWeightMatrix();
+   for(unsigned int n=0; n<indices.size(); n++) bias_vector += next_matrix.col(indices[n]) * mMeanVectors[i][indices[n]];
+   net[i+1].SetBiasVector(bias_vector);
+  }
+  if(net.RemoveNeurons(i, indices) == false) return false;
+ }
+ return true;
+}
+
+/**
+* It prunes the network using the input dataset as calibration dataset,
+* then the smaller network is fine-tuned with the online learning.
+*
+* @param fraction fraction of the neurons of every hidden layer to remove
+* @param cycles epochs of fine-tuning, zero to skip it
+* @return it returns true if it is all right, otherwise false
+**/
+bool NeuronPruning::StartPruning(Network* net, BackpropagationLearning& learning, double fraction, Dataset& inputDataset, Dataset& targetDataset, unsigned int cycles, bool print){
+ std::size_t parameters = ReturnNumberOfParameters(*net);
+ if(Prune(*net, fraction, inputDataset) == false) return false;
+ if(print){
+  std::cout << "Neuron pruning parameters: " << parameters << " -> " << ReturnNumberOfParameters(*net)
+            << " MSE: " << net->ComputeMeanSquaredError(inputDataset, targetDataset) << std::endl;
+ }
+ if(cycles > 0) learning.StartOnlineLearning(net, inputDataset, targetDataset, cycles, false);
+ if(print && cycles > 0) std::cout << "Fine-tuning MSE: " << net->ComputeMeanSquaredError(inputDataset, targetDataset) << std::endl;
+ return true;
+}
+
+/**
+* It returns the number of weights and bias of the network
+*
+**/
+std::size_t NeuronPruning::ReturnNumberOfParameters(Network& net){
+ std::size_t parameters = 0;
+ for(unsigned int i=0; i<net.Size(); i++) parameters += net[i].GetWeightMatrix().size() + net[i].GetBiasVector().size();
+ return parameters;
+}
+
+} //namespace
@@ -0,0 +1,195 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+namespace neuroc{
+
+namespace {
+
+/**
+* Accumulator owned by a single thread. Only the owner writes it,
+* so the relaxed load/store pairs compile to plain moves, the atomics
+* are there only to make the concurrent reads well defined.
+**/
+struct PhaseAccumulator {
+ std::atomic<unsigned long long> steps;
+ std::atomic<unsigned long long> forwardNs;
+ std::atomic<unsigned long long> backpropNs;
+ std::atomic<unsigned long long> updateNs;
+};
+
+void Add(std::atomic<unsigned long long>& counter, unsigned long long value){
+ counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+std::mutex gRegistryMutex;
+std::vector<PhaseAccumulator*> gAccumulators;
+PhaseProfile gRetiredProfile; //counters of the threads already terminated
+
+/**
+* It registers the accumulator of the thread when it is first used
+* and moves its counters in the retired profile when the thread ends.
+**/
+struct ThreadRegistration {
+ PhaseAccumulator accumulator;
+
+ ThreadRegistration(){
+  accumulator.steps = 0;
+  accumulator.forwardNs = 0;
+  accumulator.backpropNs = 0;
+  accumulator.updateNs = 0;
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  gAccumulators.push_back(&accumulator);
+ }
+
+ ~ThreadRegistration(){
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  gRetiredProfile.steps += accumulator.steps.load(std::memory_order_relaxed);
+  gRetiredProfile.forwardNs += accumulator.forwardNs.load(std::memory_order_relaxed);
+  gRetiredProfile.backpropNs += accumulator.backpropNs.load(std::memory_order_relaxed);
+  gRetiredProfile.updateNs += accumulator.updateNs.load(std::memory_order_relaxed);
+  gAccumulators.erase(std::remove(gAccumulators.begin(), gAccumulators.end(), &accumulator), gAccumulators.end());
+ }
+};
+
+thread_local ThreadRegistration tRegistration;
+
+} //namespace
+
+
+namespace Profiler{
+
+bool IsEnabled(){
+#ifdef NEUROC_PROFILE
+ return true;
+#else
+ return false;
+#endif
+}
+
+/**
+* It adds the times of a learning step to the accumulator of the calling thread
+*
+**/
+void AddPhaseTimes(unsigned long long forwardNs, unsigned long long backpropNs, unsigned long long updateNs){
+ PhaseAccumulator& accumulator = tRegistration.accumulator;
+ Add(accumulator.steps, 1);
+ Add(accumulator.forwardNs, forwardNs);
+ Add(accumulator.backpropNs, backpropNs);
+ Add(accumulator.updateNs, updateNs);
+}
+
+/**
+* It returns the sum of the phase times recorded by all the threads
+*
+**/
+PhaseProfile GetPhaseProfile(){
+ std::lock_guard<std::mutex> lock(gRegistryMutex);
+ PhaseProfile profile = gRetiredProfile;
+ for(unsigned int i=0; i<gAccumulators.size(); i++){
+  profile.steps += gAccumulators[i]->steps.load(std::memory_order_relaxed);
+  profile.forwardNs += gAccumulators[i]->forwardNs.load(std::memory_order_relaxed);
+  profile.backpropNs += gAccumulators[i]->backpropNs.load(std::memory_order_relaxed);
+  profile.updateNs += gAccumulators[i]->updateNs.load(std::memory_order_relaxed);
+ }
+ return profile;
+}
+
+/**
+* It sets to zero the phase times of all the threads.
+* It should be called when no learning is running.
+**/
+void ResetPhaseProfile(){
+ std::lock_guard<std::mutex> lock(gRegistryMutex);
+ gRetiredProfile = PhaseProfile();
+ for(unsigned int i=0; i<gAccumulators.size(); i++){
+  gAccumulators[i]->steps.store(0, std::memory_order_relaxed);
+  gAccumulators[i]->forwardNs.store(0, std::memory_order_relaxed);
+  gAccumulators[i]->backpropNs.store(0, std::memory_order_relaxed);
+  gAccumulators[i]->updateNs.store(0, std::memory_order_relaxed);
+ }
+}
+
+} //namespace
+
+
+/**
+* It returns the profile as a JSON document
+*
+**/
+std::string NetworkProfile::ToJSON() const{
+ std::ostringstream ss;
+ ss << "{\n \"enabled\": " << (Profiler::IsEnabled() ? "true" : "false") << ",\n";
+ ss << " \"layers\": [\n";
+ for(unsigned int i=0; i<layers.size(); i++){
+  const LayerProfile& l = layers[i];
+  ss << "  {\"index\": " << i << ", \"calls\": " << l.calls << ", \"derivative_calls\": " << l.derivativeCalls
+     << ", \"weight_ns\": " << l.weightNs << ", \"join_ns\": " << l.joinNs
+     << ", \"transfer_ns\": " << l.transferNs << ", \"derivative_ns\": " << l.derivativeNs
+     << ", \"flops\": " << l.flops << ", \"bytes\": " << l.bytes << "}";
+  if(i != layers.size()-1) ss << ",";
+  ss << "\n";
+ }
+ ss << " ],\n";
+ ss << " \"phases\": {\"steps\": " << phases.steps << ", \"forward_ns\": " << phases.forwardNs
+    << ", \"backprop_ns\": " << phases.backpropNs << ", \"update_ns\": " << phases.updateNs << "}\n";
+ ss << "}\n";
+ return ss.str();
+}
+
+/**
+* It saves the profile as a JSON file
+*
+* @param filePath the path to the output file
+**/
+bool NetworkProfile::SaveAsJSON(std::string filePath) const{
+ std::ofstream file_stream(filePath);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return false;
+ }
+ file_stream << ToJSON();
+ file_stream.close();
+ return true;
+}
+
+/**
+* It prints a summary of the profile
+*
+**/
+void NetworkProfile::Print() const{
+ if(Profiler::IsEnabled() == false) std::cout << "Profiling disabled, compile the library with NEUROC_PROFILE" << std::endl;
+ for(unsigned int i=0; i<layers.size(); i++){
+  const LayerProfile& l = layers[i];
+  std::cout << "Layer[" << i << "] calls: " << l.calls << " weight: " << l.weightNs / 1e6 << "ms join: " << l.joinNs / 1e6
+            << "ms transfer: " << l.transferNs / 1e6 << "ms derivative: " << l.derivativeNs / 1e6 << "ms MFLOP: " << l.flops / 1e6
+            << " MB: " << l.bytes / 1e6 << std::endl;
+ }
+ std::cout << "Steps: " << phases.steps << " forward: " << phases.forwardNs / 1e6 << "ms backprop: " << phases.backpropNs / 1e6
+           << "ms update: " << phases.updateNs / 1e6 << "ms" << std::endl;
+}
+
+} //namespace
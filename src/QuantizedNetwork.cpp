@@ -0,0 +1,350 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "QuantizedNetwork.h"
+#include "Network.h"
+#include "Dataset.h"
+#include "DenseLayer.h"
+#include "Trace.h"
+#include "WeightFunctions.h"
+#include "JoinFunctions.h"
+#include "TransferFunctions.h"
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <stdexcept>
+
+//The AVX2 kernel is compiled for the x86 processors with g++ and it is
+//selected at runtime, the library does not need to be built with -mavx2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEUROC_QUANTIZED_AVX2
+#include <immintrin.h>
+#endif
+
+namespace neuroc{
+
+namespace {
+
+//Bytes of int8 processed by an iteration of the kernels
+const unsigned int kSimdWidth = 32;
+
+typedef int32_t (*DotFunction)(const int8_t*, const int8_t*, std::size_t);
+
+int32_t DotScalar(const int8_t* weights, const int8_t* input, std::size_t size){
+ int32_t accumulator = 0;
+ for(std::size_t i=0; i<size; i++) accumulator += (int32_t) weights[i] * (int32_t) input[i];
+ return accumulator;
+}
+
+#ifdef NEUROC_QUANTIZED_AVX2
+/**
+* The int8 values are extended to int16 and multiplied in pairs by
+* madd, that sums them in int32 without saturating.
+* The size must be a multiple of kSimdWidth.
+**/
+__attribute__((target("avx2")))
+int32_t DotAVX2(const int8_t* weights, const int8_t* input, std::size_t size){
+ __m256i accumulator_low = _mm256_setzero_si256();
+ __m256i accumulator_high = _mm256_setzero_si256();
+ for(std::size_t i=0; i<size; i+=kSimdWidth){
+  __m256i weights_low = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(weights + i)));
+  __m256i weights_high = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(weights + i + 16)));
+  __m256i input_low = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(input + i)));
+  __m256i input_high = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(input + i + 16)));
+  accumulator_low = _mm256_add_epi32(accumulator_low, _mm256_madd_epi16(weights_low, input_low));
+  accumulator_high = _mm256_add_epi32(accumulator_high, _mm256_madd_epi16(weights_high, input_high));
+ }
+ __m256i accumulator = _mm256_add_epi32(accumulator_low, accumulator_high);
+ __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(accumulator), _mm256_extracti128_si256(accumulator, 1));
+ sum = _mm_hadd_epi32(sum, sum);
+ sum = _mm_hadd_epi32(sum, sum);
+ return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+DotFunction SelectDot(){
+ #ifdef NEUROC_QUANTIZED_AVX2
+ __builtin_cpu_init();
+ if(__builtin_cpu_supports("avx2")) return &DotAVX2;
+ #endif
+ return &DotScalar;
+}
+
+const DotFunction kDot = SelectDot();
+
+/**
+* It returns the scale and the zero point mapping [minValue, maxValue]
+* on [-128, 127]. The range always contains zero, that is represented
+* exactly.
+**/
+void ReturnQuantizationParameters(double minValue, double maxValue, double& scale, int32_t& zeroPoint){
+ minValue = std::min(minValue, 0.0);
+ maxValue = std::max(maxValue, 0.0);
+ scale = (maxValue - minValue) / 255.0;
+ if(scale == 0) scale = 1.0;
+ zeroPoint = (int32_t) std::lround(-128.0 - minValue / scale);
+ zeroPoint = std::max(-128, std::min(127, zeroPoint));
+}
+
+inline int8_t QuantizeValue(double value, double inverseScale, int32_t zeroPoint){
+ double quantized = std::nearbyint(value * inverseScale) + zeroPoint;
+ if(quantized < -128.0) quantized = -128.0;
+ if(quantized > 127.0) quantized = 127.0;
+ return (int8_t) quantized;
+}
+
+} //namespace
+
+
+QuantizedNetwork::QuantizedNetwork(){
+}
+
+/**
+* It returns the transfer function of the layer between the ones that
+* can be applied on a single value.
+*
+* @return it returns false if the function is not part of the library
+**/
+bool QuantizedNetwork::ReturnTransfer(DenseLayer& layer, Transfer& transfer){
+ TransferFunctions::InPlace::Function function = TransferFunctions::InPlace::ReturnFunction(layer.GetTransferFunction());
+ if(function == &TransferFunctions::InPlace::Linear) transfer = LINEAR;
+ else if(function == &TransferFunctions::InPlace::PositiveLinear) transfer = POSITIVE_LINEAR;
+ else if(function == &TransferFunctions::InPlace::SaturatedLinear) transfer = SATURATED_LINEAR;
+ else if(function == &TransferFunctions::InPlace::Sigmoid) transfer = SIGMOID;
+ else if(function == &TransferFunctions::InPlace::FastSigmoid) transfer = FAST_SIGMOID;
+ else if(function == &TransferFunctions::InPlace::SigmoidDerivative) transfer = SIGMOID_DERIVATIVE;
+ else if(function == &TransferFunctions::InPlace::Tanh) transfer = TANH;
+ else if(function == &TransferFunctions::InPlace::TanhDerivative) transfer = TANH_DERIVATIVE;
+ else if(function == &TransferFunctions::InPlace::RadialBasis) transfer = RADIAL_BASIS;
+ else if(function == &TransferFunctions::InPlace::MultiQuadratic) transfer = MULTI_QUADRATIC;
+ else if(function == &TransferFunctions::InPlace::HardLimit) transfer = HARD_LIMIT;
+ else return false;
+ return true;
+}
+
+/**
+* It builds the int8 network from a trained network. The calibration
+* dataset is passed through the network to find the range of the input
+* of every layer, it should contain some samples representative of the
+* data used in the inference.
+*
+* @param net the trained network, it is not modified
+* @param calibrationDataset the input samples used to measure the ranges
+* @return it returns true if it is all right, otherwise false
+**/
+bool QuantizedNetwork::Quantize(Network& net, Dataset& calibrationDataset){
+ typedef Eigen::VectorXd (*WeightFunction)(Eigen::MatrixXd, Eigen::VectorXd);
+ typedef Eigen::VectorXd (*JoinFunction)(Eigen::VectorXd, Eigen::VectorXd);
+
+ if(net.Size() == 0){
+  std::cerr << "Neuroc Error: QuantizedNetwork the network is empty" << std::endl;
+  return false;
+ }
+ if(calibrationDataset.ReturnNumberOfElements() == 0){
+  std::cerr << "Neuroc Error: QuantizedNetwork the calibration dataset is empty" << std::endl;
+  return false;
+ }
+ if(calibrationDataset[0].size() != net[0].GetWeightMatrix().cols()){
+  std::cerr << "Neuroc Error: QuantizedNetwork the calibration samples do not fit the input of the network" << std::endl;
+  return false;
+ }
+
+ std::vector<QuantizedLayer> layers_vector(net.Size());
+ for(unsigned int i=0; i<net.Size(); i++){
+  const WeightFunction* weight_target = net[i].GetWeightFunction().target<WeightFunction>();
+  const JoinFunction* join_target = net[i].GetJoinFunction().target<JoinFunction>();
+  bool dot_product = (weight_target != nullptr && *weight_target == &WeightFunctions::DotProduct);
+  bool sum_join = (join_target != nullptr && *join_target == &JoinFunctions::Sum);
+  bool product_join = (join_target != nullptr && *join_target == &JoinFunctions::Product);
+  if(dot_product == false || (sum_join == false && product_join == false) || ReturnTransfer(net[i], layers_vector[i].transfer) == false){
+   std::cerr << "Neuroc Error: QuantizedNetwork the layer " << i << " uses functions that cannot be quantized" << std::endl;
+   return false;
+  }
+  layers_vector[i].productJoin = product_join;
+ }
+
+ //Range of the input of every layer on the calibration samples
+ std::vector<double> min_vector(net.Size(), std::numeric_limits<double>::max());
+ std::vector<double> max_vector(net.Size(), std::numeric_limits<double>::lowest());
+ Eigen::VectorXd value_vector;
+ for(unsigned int s=0; s<calibrationDataset.ReturnNumberOfElements(); s++){
+  value_vector = calibrationDataset[s];
+  for(unsigned int i=0; i<net.Size(); i++){
+   min_vector[i] = std::min(min_vector[i], value_vector.minCoeff());
+   max_vector[i] = std::max(max_vector[i], value_vector.maxCoeff());
+   value_vector = net[i].Compute(value_vector);
+  }
+ }
+
+ for(unsigned int i=0; i<net.Size(); i++){
+  QuantizedLayer& layer = layers_vector[i];
+  //The binarized layers compute with the binarized weights, not with the shadow weights
+  const Eigen::MatrixXd& weight_matrix = net[i].GetEffectiveWeightMatrix();
+  layer.inputSize = weight_matrix.cols();
+  layer.outputSize = weight_matrix.rows();
+  layer.stride = ((layer.inputSize + kSimdWidth - 1) / kSimdWidth) * kSimdWidth;
+  layer.bias = net[i].GetBiasVector();
+  ReturnQuantizationParameters(min_vector[i], max_vector[i], layer.inputScale, layer.inputZeroPoint);
+  //The padding of the rows and of the input is zero, it does not change the products
+  layer.weights.assign((std::size_t) layer.outputSize * layer.stride, 0);
+  layer.inputBuffer.assign(layer.stride, 0);
+  layer.weightScale.resize(layer.outputSize);
+  layer.weightZeroPoint.resize(layer.outputSize);
+  layer.offset.resize(layer.outputSize);
+  layer.outputScale.resize(layer.outputSize);
+
+  for(unsigned int row=0; row<layer.outputSize; row++){
+   ReturnQuantizationParameters(weight_matrix.row(row).minCoeff(), weight_matrix.row(row).maxCoeff(), layer.weightScale[row], layer.weightZeroPoint[row]);
+   double inverse_scale = 1.0 / layer.weightScale[row];
+   int32_t row_sum = 0;
+   for(unsigned int col=0; col<layer.inputSize; col++){
+    int8_t weight = QuantizeValue(weight_matrix(row, col), inverse_scale, layer.weightZeroPoint[row]);
+    layer.weights[(std::size_t) row * layer.stride + col] = weight;
+    row_sum += weight;
+   }
+   //sum((qw - zw) * (qx - zx)) = sum(qw * qx) - zw * sum(qx) - zx * sum(qw) + n * zw * zx
+   layer.offset[row] = (int32_t) layer.inputSize * layer.weightZeroPoint[row] * layer.inputZeroPoint - layer.inputZeroPoint * row_sum;
+   layer.outputScale[row] = layer.weightScale[row] * layer.inputScale;
+  }
+ }
+
+ mLayersVector = std::move(layers_vector);
+ mOutputVector = Eigen::VectorXd::Zero(mLayersVector.back().outputSize);
+ return true;
+}
+
+/**
+* It computes the output of the network. The input is quantized, every
+* layer works on int8 values and the output of the last layer is
+* returned in double precision. It does not allocate memory.
+*
+* @param inputVector
+* @return it returns a reference to the output of the network
+**/
+const Eigen::VectorXd& QuantizedNetwork::Compute(const Eigen::VectorXd& inputVector){
+ NEUROC_TRACE_SCOPE("QuantizedNetwork::Compute");
+ if(mLayersVector.size() == 0) throw std::domain_error("Error: QuantizedNetwork the network was not quantized");
+ if(inputVector.size() != mLayersVector[0].inputSize) throw std::domain_error("Error: QuantizedNetwork the input vector has a wrong size");
+
+ QuantizedLayer& first_layer = mLayersVector[0];
+ double inverse_scale = 1.0 / first_layer.inputScale;
+ for(unsigned int i=0; i<first_layer.inputSize; i++){
+  first_layer.inputBuffer[i] = QuantizeValue(inputVector[i], inverse_scale, first_layer.inputZeroPoint);
+ }
+
+ for(unsigned int l=0; l<mLayersVector.size(); l++){
+  QuantizedLayer& layer = mLayersVector[l];
+  QuantizedLayer* next_layer = (l+1 < mLayersVector.size()) ? &mLayersVector[l+1] : nullptr;
+  double next_inverse_scale = next_layer ? 1.0 / next_layer->inputScale : 0.0;
+
+  int32_t input_sum = 0;
+  for(unsigned int i=0; i<layer.inputSize; i++) input_sum += layer.inputBuffer[i];
+
+  for(unsigned int row=0; row<layer.outputSize; row++){
+   int32_t accumulator = kDot(&layer.weights[(std::size_t) row * layer.stride], layer.inputBuffer.data(), layer.stride);
+   accumulator += layer.offset[row] - layer.weightZeroPoint[row] * input_sum;
+
+   //Requantization, bias and transfer function on the single value
+   double value = layer.outputScale[row] * accumulator;
+   if(layer.productJoin) value *= layer.bias[row];
+   else value += layer.bias[row];
+   switch(layer.transfer){
+    case LINEAR: break;
+    case POSITIVE_LINEAR: value = std::abs(value); break;
+    case SATURATED_LINEAR: value = std::max(-1.0, std::min(1.0, value)); break;
+    case SIGMOID: value = 1.0 / (1.0 + std::exp(-value)); break;
+    case FAST_SIGMOID: value = value / (1.0 + std::abs(value)); break;
+    case SIGMOID_DERIVATIVE: { double e = std::exp(-value); value = e / ((1.0 + e) * (1.0 + e)); if(std::isnan(value)) value = 0.0; break; }
+    case TANH: value = std::tanh(value); break;
+    case TANH_DERIVATIVE: { double t = std::tanh(value); value = 1.0 - t * t; break; }
+    case RADIAL_BASIS: value = std::exp(-value * value); break;
+    case MULTI_QUADRATIC: value = std::sqrt(1.0 + value * value); break;
+    case HARD_LIMIT: value = (value > 0.0) ? 1.0 : 0.0; break;
+   }
+
+   if(next_layer) next_layer->inputBuffer[row] = QuantizeValue(value, next_inverse_scale, next_layer->inputZeroPoint);
+   else mOutputVector[row] = value;
+  }
+ }
+ return mOutputVector;
+}
+
+/**
+* It returns the mean squared error of the network on a dataset
+*
+* @param inputDataset
+* @param targetDataset
+**/
+double QuantizedNetwork::ComputeMeanSquaredError(Dataset& inputDataset, Dataset& targetDataset){
+ double MSE = 0;
+ double dataset_size = inputDataset.ReturnNumberOfElements();
+ if(dataset_size != targetDataset.ReturnNumberOfElements()){
+  std::cerr << "Error: The input dataset and the target dataset have different dimensions." << std::endl;
+  return 0;
+ }
+ for(unsigned int i=0; i<dataset_size; i++){
+  MSE += (targetDataset[i] - Compute(inputDataset[i])).squaredNorm();
+ }
+ return MSE / dataset_size;
+}
+
+/**
+* It returns the number of layers
+*
+**/
+unsigned int QuantizedNetwork::Size(){
+ return mLayersVector.size();
+}
+
+/**
+* It returns the memory used by the quantized weights, the quantization
+* parameters and the buffers of the network
+*
+* @return it returns the number of bytes
+**/
+std::size_t QuantizedNetwork::ReturnMemoryFootprint(){
+ std::size_t total_bytes = sizeof(QuantizedNetwork) + mOutputVector.size() * sizeof(double);
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const QuantizedLayer& layer = mLayersVector[i];
+  total_bytes += sizeof(QuantizedLayer);
+  total_bytes += layer.weights.size() + layer.inputBuffer.size();
+  total_bytes += (layer.weightScale.size() + layer.outputScale.size() + layer.bias.size()) * sizeof(double);
+  total_bytes += (layer.weightZeroPoint.size() + layer.offset.size()) * sizeof(int32_t);
+ }
+ return total_bytes;
+}
+
+/**
+* It returns true if the int8 products use the AVX2 instructions
+*
+**/
+bool QuantizedNetwork::IsUsingSIMD(){
+ return kDot != &DotScalar;
+}
+
+void QuantizedNetwork::Print(){
+ std::cout << "SIMD ..... " << (IsUsingSIMD() ? "AVX2" : "none") << std::endl;
+ for(unsigned int i=0; i<mLayersVector.size(); i++){
+  const QuantizedLayer& layer = mLayersVector[i];
+  std::cout << "Layer[" << i << "] " << layer.inputSize << "x" << layer.outputSize
+            << " input scale " << layer.inputScale << " zero point " << layer.inputZeroPoint << std::endl;
+ }
+}
+
+} //namespace
@@ -0,0 +1,289 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "SampleOrder.h"
+#include <algorithm> //upper_bound
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace neuroc{
+
+namespace {
+
+/**
+* It returns an integer in [0, range) without the bias of the modulo.
+* The mt19937_64 sequence is fixed by the standard, so the orders are
+* the same on every platform.
+**/
+uint64_t UniformInteger(std::mt19937_64& generator, uint64_t range){
+ const uint64_t limit = generator.max() - (generator.max() % range);
+ uint64_t value;
+ do { value = generator(); } while(value >= limit);
+ return value % range;
+}
+
+/**
+* It returns a real number in [0, 1) with 53 random bits
+**/
+double UniformReal(std::mt19937_64& generator){
+ return (generator() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+* \struct OrderHeader
+* \brief The fixed part of a serialized order
+*/
+struct OrderHeader {
+ uint32_t mode;
+ uint32_t prepared;
+ uint64_t seed;
+ double uniformMix;
+ uint32_t preparedEpoch;
+ uint32_t datasetSize; //size of the arrays, zero if they are not saved
+};
+
+} //namespace
+
+/**
+* Class constructor, the samples are visited in the file order
+*
+**/
+SampleOrder::SampleOrder(){
+ mMode = FILE_ORDER;
+ mSeed = 0;
+ mUniformMix = 0.5;
+ Reset();
+}
+
+void SampleOrder::SetFileOrder(){
+ mMode = FILE_ORDER;
+ Reset();
+}
+
+/**
+* Every epoch visits a permutation of the samples
+*
+* @param seed the seed of the permutations
+**/
+void SampleOrder::SetShuffle(uint64_t seed){
+ mMode = SHUFFLE;
+ mSeed = seed;
+ Reset();
+}
+
+/**
+* Every epoch, after the first, draws the samples with a probability
+* proportional to their last loss
+*
+* @param seed the seed of the draws
+* @param uniformMix the fraction of the uniform probability in the mixture,
+* in (0, 1], it bounds the weights to 1/uniformMix
+**/
+void SampleOrder::SetImportanceSampling(uint64_t seed, double uniformMix){
+ mMode = IMPORTANCE_SAMPLING;
+ mSeed = seed;
+ if(uniformMix <= 0.0 || uniformMix > 1.0){
+  std::cerr << "Neuroc Error: SampleOrder the uniform mix must be in (0, 1], it is set to 0.5" << std::endl;
+  uniformMix = 0.5;
+ }
+ mUniformMix = uniformMix;
+ Reset();
+}
+
+SampleOrder::Mode SampleOrder::GetMode() const{
+ return mMode;
+}
+
+uint64_t SampleOrder::GetSeed() const{
+ return mSeed;
+}
+
+double SampleOrder::GetUniformMix() const{
+ return mUniformMix;
+}
+
+/**
+* It forgets the prepared epoch and the losses, a new training starts
+*
+**/
+void SampleOrder::Reset(){
+ mPrepared = false;
+ mPreparedEpoch = 0;
+ mIndices.clear();
+ mWeights.clear();
+ mLosses.clear();
+ mCumulative.clear();
+ mVisited = 0;
+}
+
+/**
+* It computes the order of an epoch. The buffers are allocated by the
+* first epoch only.
+*
+* @param epoch the epoch
+* @param datasetSize the number of samples
+**/
+void SampleOrder::Prepare(unsigned int epoch, unsigned int datasetSize){
+ if(mPrepared && mPreparedEpoch == epoch && (mIndices.empty() || mIndices.size() == datasetSize)) return;
+ mPrepared = true;
+ mPreparedEpoch = epoch;
+ if(mMode == FILE_ORDER){
+  mIndices.clear();
+  mWeights.clear();
+  return;
+ }
+ if(mMode == SHUFFLE || mLosses.size() != datasetSize || mVisited < datasetSize){
+  //Until all the samples have a loss the epochs are shuffled
+  if(mMode == IMPORTANCE_SAMPLING && mLosses.size() != datasetSize){
+   mLosses.assign(datasetSize, -1.0); //a negative loss is not known
+   mVisited = 0;
+  }
+  Shuffle(epoch, datasetSize);
+  mWeights.clear();
+  return;
+ }
+
+ //Importance sampling: p = (1 - mix) * loss / sum + mix / N
+ double sum = 0.0;
+ for(unsigned int i=0; i<datasetSize; i++) sum += mLosses[i];
+ const double size = datasetSize;
+ mCumulative.resize(datasetSize);
+ double cumulative = 0.0;
+ for(unsigned int i=0; i<datasetSize; i++){
+  double probability = mUniformMix / size;
+  if(sum > 0.0) probability += (1.0 - mUniformMix) * mLosses[i] / sum;
+  else probability += (1.0 - mUniformMix) / size;
+  cumulative += probability;
+  mCumulative[i] = cumulative;
+ }
+ std::mt19937_64 generator(ReturnEpochSeed(epoch));
+ mIndices.resize(datasetSize);
+ mWeights.resize(datasetSize);
+ for(unsigned int position=0; position<datasetSize; position++){
+  double draw = UniformReal(generator) * cumulative;
+  unsigned int index = std::upper_bound(mCumulative.begin(), mCumulative.end(), draw) - mCumulative.begin();
+  if(index >= datasetSize) index = datasetSize - 1;
+  double probability = (mCumulative[index] - (index > 0 ? mCumulative[index-1] : 0.0)) / cumulative;
+  mIndices[position] = index;
+  mWeights[position] = 1.0 / (size * probability);
+ }
+}
+
+/**
+* It stores the loss of a sample, used by the importance sampling of the next epochs
+*
+**/
+void SampleOrder::UpdateLoss(unsigned int index, double loss){
+ if(mMode != IMPORTANCE_SAMPLING || index >= mLosses.size()) return;
+ if(mLosses[index] < 0.0) mVisited++;
+ mLosses[index] = (loss > 0.0) ? loss : 0.0;
+}
+
+/**
+* It returns the state of the order, saved in the checkpoints. The
+* prepared epoch and the losses are saved only by the importance sampling,
+* the other orders are computed again from the seed.
+*
+**/
+std::string SampleOrder::Serialize() const{
+ OrderHeader header = OrderHeader();
+ header.mode = mMode;
+ header.seed = mSeed;
+ header.uniformMix = mUniformMix;
+ std::string block;
+ if(mMode == IMPORTANCE_SAMPLING && mPrepared){
+  header.prepared = 1;
+  header.preparedEpoch = mPreparedEpoch;
+  header.datasetSize = mLosses.size();
+ }
+ block.append(reinterpret_cast<const char*>(&header), sizeof(OrderHeader));
+ if(header.datasetSize > 0){
+  std::vector<unsigned int> indices(mIndices);
+  std::vector<double> weights(mWeights);
+  indices.resize(header.datasetSize, 0);
+  weights.resize(header.datasetSize, 0.0);
+  //An empty weight vector means a shuffled epoch, saved as zero weights
+  if(mWeights.empty()) std::fill(weights.begin(), weights.end(), 0.0);
+  std::vector<uint32_t> indices32(indices.begin(), indices.end());
+  block.append(reinterpret_cast<const char*>(indices32.data()), sizeof(uint32_t) * indices32.size());
+  block.append(reinterpret_cast<const char*>(weights.data()), sizeof(double) * weights.size());
+  block.append(reinterpret_cast<const char*>(mLosses.data()), sizeof(double) * mLosses.size());
+ }
+ return block;
+}
+
+/**
+* It restores a state returned by Serialize()
+*
+* @return it returns false if the data is not valid
+**/
+bool SampleOrder::Deserialize(const char* data, std::size_t size){
+ OrderHeader header;
+ if(size < sizeof(OrderHeader)) return false;
+ std::memcpy(&header, data, sizeof(OrderHeader));
+ const std::size_t arrays = (std::size_t) header.datasetSize * (sizeof(uint32_t) + 2 * sizeof(double));
+ if(header.mode > IMPORTANCE_SAMPLING || size != sizeof(OrderHeader) + arrays) return false;
+ if(header.mode == IMPORTANCE_SAMPLING && (header.uniformMix <= 0.0 || header.uniformMix > 1.0)) return false;
+ mMode = static_cast<Mode>(header.mode);
+ mSeed = header.seed;
+ mUniformMix = header.uniformMix;
+ Reset();
+ if(header.prepared == 0 || header.datasetSize == 0) return true;
+ const unsigned int dataset_size = header.datasetSize;
+ const char* arrays_data = data + sizeof(OrderHeader);
+ std::vector<uint32_t> indices32(dataset_size);
+ std::memcpy(indices32.data(), arrays_data, sizeof(uint32_t) * dataset_size);
+ mIndices.assign(indices32.begin(), indices32.end());
+ for(unsigned int index : mIndices) if(index >= dataset_size) return false;
+ mWeights.resize(dataset_size);
+ std::memcpy(mWeights.data(), arrays_data + sizeof(uint32_t) * dataset_size, sizeof(double) * dataset_size);
+ if(mWeights[0] == 0.0) mWeights.clear();
+ mLosses.resize(dataset_size);
+ std::memcpy(mLosses.data(), arrays_data + (sizeof(uint32_t) + sizeof(double)) * dataset_size, sizeof(double) * dataset_size);
+ mVisited = 0;
+ for(double loss : mLosses) if(loss >= 0.0) mVisited++;
+ mPrepared = true;
+ mPreparedEpoch = header.preparedEpoch;
+ return true;
+}
+
+/**
+* It returns the seed of the generator of an epoch
+*
+**/
+uint64_t SampleOrder::ReturnEpochSeed(unsigned int epoch) const{
+ return mSeed ^ (0x9E3779B97F4A7C15ULL * (epoch + 1));
+}
+
+/**
+* It draws the permutation of an epoch (Fisher-Yates)
+*
+**/
+void SampleOrder::Shuffle(unsigned int epoch, unsigned int datasetSize){
+ std::mt19937_64 generator(ReturnEpochSeed(epoch));
+ mIndices.resize(datasetSize);
+ for(unsigned int i=0; i<datasetSize; i++) mIndices[i] = i;
+ for(unsigned int i=datasetSize; i>1; i--){
+  unsigned int j = UniformInteger(generator, i);
+  std::swap(mIndices[i-1], mIndices[j]);
+ }
+}
+
+} //namespace
@@ -0,0 +1,182 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "Trace.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace neuroc{
+
+namespace Trace{
+
+std::atomic<bool> gEnabled(false);
+
+namespace {
+
+struct Event {
+ const char* name;
+ unsigned long long startNs;
+ unsigned long long endNs;
+};
+
+/**
+* Ring buffer written only by its own thread. The head counts all the
+* events ever written, the slot of an event is head modulo the capacity.
+**/
+struct ThreadBuffer {
+ unsigned int threadId;
+ std::vector<Event> events;
+ std::atomic<unsigned long long> head;
+};
+
+std::mutex gRegistryMutex;
+//The buffers are owned by the registry, so they can be exported
+//also after the end of the threads that wrote them.
+std::vector<std::shared_ptr<ThreadBuffer> > gBuffers;
+unsigned int gBufferSize = 65536;
+unsigned long long gOriginNs = 0;
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+
+ThreadBuffer* RegisterThread(){
+ std::lock_guard<std::mutex> lock(gRegistryMutex);
+ std::shared_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+ buffer->threadId = gBuffers.size() + 1;
+ buffer->events.resize(gBufferSize);
+ buffer->head.store(0, std::memory_order_relaxed);
+ gBuffers.push_back(buffer);
+ return buffer.get();
+}
+
+} //namespace
+
+
+/**
+* It starts recording the spans.
+*
+**/
+void Enable(){
+ {
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  if(gOriginNs == 0) gOriginNs = Profiler::Now();
+ }
+ gEnabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+* It stops recording the spans, the recorded ones are kept.
+*
+**/
+void Disable(){
+ gEnabled.store(false, std::memory_order_relaxed);
+}
+
+/**
+* It deletes all the recorded spans.
+* It should be called when no thread is recording.
+**/
+void Clear(){
+ std::lock_guard<std::mutex> lock(gRegistryMutex);
+ for(unsigned int i=0; i<gBuffers.size(); i++) gBuffers[i]->head.store(0, std::memory_order_relaxed);
+ gOriginNs = gEnabled.load(std::memory_order_relaxed) ? Profiler::Now() : 0;
+}
+
+/**
+* It sets the number of spans kept by each thread.
+* It is applied to the threads that start recording after the call.
+*
+* @param eventsPerThread the capacity of the ring buffers
+**/
+void SetBufferSize(unsigned int eventsPerThread){
+ if(eventsPerThread == 0) return;
+ std::lock_guard<std::mutex> lock(gRegistryMutex);
+ gBufferSize = eventsPerThread;
+}
+
+/**
+* It records a span in the buffer of the calling thread
+*
+* @param name the name of the span, it must be a string literal
+* @param startNs the beginning of the span
+* @param endNs the end of the span
+**/
+void Record(const char* name, unsigned long long startNs, unsigned long long endNs){
+ if(tBuffer == nullptr) tBuffer = RegisterThread();
+ unsigned long long head = tBuffer->head.load(std::memory_order_relaxed);
+ Event& event = tBuffer->events[head % tBuffer->events.size()];
+ event.name = name;
+ event.startNs = startNs;
+ event.endNs = endNs;
+ tBuffer->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+* It returns the recorded spans in the Chrome trace format.
+* The times are in microseconds from the call of Enable().
+*
+**/
+std::string ToJSON(){
+ std::lock_guard<std::mutex> lock(gRegistryMutex);
+ std::ostringstream ss;
+ ss << std::fixed << std::setprecision(3);
+ ss << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+ ss << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"neuroc\"}}";
+ for(unsigned int b=0; b<gBuffers.size(); b++){
+  ThreadBuffer& buffer = *gBuffers[b];
+  ss << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer.threadId
+     << ", \"args\": {\"name\": \"thread " << buffer.threadId << "\"}}";
+  unsigned long long head = buffer.head.load(std::memory_order_acquire);
+  unsigned long long capacity = buffer.events.size();
+  unsigned long long first = (head > capacity) ? head - capacity : 0;
+  for(unsigned long long i=first; i<head; i++){
+   const Event& event = buffer.events[i % capacity];
+   if(event.startNs < gOriginNs) continue;
+   ss << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"neuroc\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer.threadId
+      << ", \"ts\": " << (event.startNs - gOriginNs) / 1000.0
+      << ", \"dur\": " << (event.endNs - event.startNs) / 1000.0 << "}";
+  }
+ }
+ ss << "\n]}\n";
+ return ss.str();
+}
+
+/**
+* It saves the recorded spans as a Chrome trace JSON file
+*
+* @param filePath the path to the output file
+**/
+bool SaveAsJSON(std::string filePath){
+ std::ofstream file_stream(filePath);
+ if(!file_stream) {
+  std::cerr<<"Error: Cannot open the output file."<<std::endl;
+  return false;
+ }
+ file_stream << ToJSON();
+ file_stream.close();
+ return true;
+}
+
+} //namespace
+
+} //namespace
@@ -0,0 +1,270 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "TrainingWorkspace.h"
+#include "Network.h"
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace neuroc{
+
+namespace {
+
+//Every block starts on a cache line
+const std::size_t kBlockDoubles = 64 / sizeof(double);
+const std::size_t kHugePageBytes = 2 * 1024 * 1024;
+
+std::size_t RoundToBlock(std::size_t numberOfDoubles){
+ return ((numberOfDoubles + kBlockDoubles - 1) / kBlockDoubles) * kBlockDoubles;
+}
+
+} //namespace
+
+
+/**
+* Class constructor. The buffer is mapped by the first call of Reserve().
+*
+* @param hugePages if true the buffer is backed by huge pages when the system allows it
+**/
+TrainingWorkspace::TrainingWorkspace(bool hugePages){
+ mBuffer = nullptr;
+ mCapacity = 0;
+ mOffset = 0;
+ mPeak = 0;
+ mMappedBytes = 0;
+ mMaxBatchSize = 0;
+ mHugePagesRequested = hugePages;
+ mHugePages = false;
+}
+
+TrainingWorkspace::~TrainingWorkspace(){
+ Release();
+}
+
+void TrainingWorkspace::Release(){
+ if(mBuffer != nullptr) munmap(mBuffer, mMappedBytes);
+ mBuffer = nullptr;
+ mCapacity = 0;
+ mOffset = 0;
+ mMappedBytes = 0;
+ mHugePages = false;
+}
+
+/**
+* It returns the number of doubles used by a learning step of the network
+* with the given batch size: activations, derivatives and deltas of every
+* layer, plus the gradients of the weights and of the bias. The layers in
+* the mixed precision mode need also the single precision inputs, outputs,
+* deltas and gradients.
+*
+* @param net the network to train
+* @param batchSize number of samples of a step
+**/
+std::size_t TrainingWorkspace::ReturnRequiredSize(Network& net, unsigned int batchSize){
+ std::size_t total = 0;
+ for(unsigned int i=0; i<net.Size(); i++){
+  std::size_t inputs = net[i].ReturnNumberOfInputs();
+  std::size_t outputs = net[i].ReturnNumberOfNeurons();
+  total += 3 * RoundToBlock(outputs * batchSize);
+  total += RoundToBlock(outputs * inputs);
+  total += RoundToBlock(outputs);
+  if(net[i].IsMixedPrecision()){
+   total += 2 * RoundToBlock((inputs * batchSize + 1) / 2);
+   total += 2 * RoundToBlock((outputs * batchSize + 1) / 2);
+   total += RoundToBlock((outputs * inputs + 1) / 2);
+  }
+ }
+ return total;
+}
+
+/**
+* It makes the workspace large enough for a step of the network with
+* batches up to maxBatchSize samples. If the buffer is already large
+* enough nothing is done, otherwise it is mapped again and the matrices
+* given by the arena are no longer valid.
+*
+* @param net the network to train
+* @param maxBatchSize the largest batch used in a step
+* @return it returns true if it is all right, otherwise false
+**/
+bool TrainingWorkspace::Reserve(Network& net, unsigned int maxBatchSize){
+ if(maxBatchSize == 0) maxBatchSize = 1;
+ if(maxBatchSize < mMaxBatchSize) maxBatchSize = mMaxBatchSize;
+ if(Reserve(ReturnRequiredSize(net, maxBatchSize)) == false) return false;
+ mMaxBatchSize = maxBatchSize;
+ return true;
+}
+
+/**
+* It makes the buffer large enough for the given number of doubles.
+*
+* @param numberOfDoubles the capacity required
+* @return it returns true if it is all right, otherwise false
+**/
+bool TrainingWorkspace::Reserve(std::size_t numberOfDoubles){
+ if(numberOfDoubles <= mCapacity) return true;
+ Release();
+
+ std::size_t bytes = RoundToBlock(numberOfDoubles) * sizeof(double);
+ void* buffer = MAP_FAILED;
+ if(mHugePagesRequested){
+  bytes = ((bytes + kHugePageBytes - 1) / kHugePageBytes) * kHugePageBytes;
+  #ifdef MAP_HUGETLB
+  //Explicit huge pages, they are available only if the system reserved them
+  buffer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if(buffer != MAP_FAILED) mHugePages = true;
+  #endif
+ }
+ if(buffer == MAP_FAILED){
+  buffer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(buffer == MAP_FAILED){
+   std::cerr << "Neuroc Error: TrainingWorkspace cannot map " << bytes << " bytes" << std::endl;
+   return false;
+  }
+  #ifdef MADV_HUGEPAGE
+  //Otherwise the transparent huge pages are asked
+  if(mHugePagesRequested && madvise(buffer, bytes, MADV_HUGEPAGE) == 0) mHugePages = true;
+  #endif
+ }
+
+ mBuffer = static_cast<double*>(buffer);
+ mMappedBytes = bytes;
+ mCapacity = bytes / sizeof(double);
+ mOffset = 0;
+ return true;
+}
+
+/**
+* It gives back to the arena all the matrices and vectors taken since
+* the previous call. The memory is not released.
+*
+**/
+void TrainingWorkspace::Reset(){
+ mOffset = 0;
+}
+
+/**
+* It takes a matrix from the arena. The values are not initialized.
+*
+* @param rows
+* @param cols
+* @return it returns a map on the memory of the arena
+**/
+TrainingWorkspace::MatrixMap TrainingWorkspace::AllocateMatrix(unsigned int rows, unsigned int cols){
+ std::size_t size = RoundToBlock((std::size_t) rows * cols);
+ if(mOffset + size > mCapacity) throw std::domain_error("Error: TrainingWorkspace capacity exceeded, call Reserve() with the network and the batch size.");
+ double* data = mBuffer + mOffset;
+ mOffset += size;
+ if(mOffset > mPeak) mPeak = mOffset;
+ return MatrixMap(data, rows, cols);
+}
+
+/**
+* It takes a vector from the arena. The values are not initialized.
+*
+* @param size
+* @return it returns a map on the memory of the arena
+**/
+TrainingWorkspace::VectorMap TrainingWorkspace::AllocateVector(unsigned int size){
+ std::size_t block = RoundToBlock(size);
+ if(mOffset + block > mCapacity) throw std::domain_error("Error: TrainingWorkspace capacity exceeded, call Reserve() with the network and the batch size.");
+ double* data = mBuffer + mOffset;
+ mOffset += block;
+ if(mOffset > mPeak) mPeak = mOffset;
+ return VectorMap(data, size);
+}
+
+/**
+* It takes a single precision matrix from the arena, used by the mixed
+* precision learning. The values are not initialized.
+*
+* @param rows
+* @param cols
+* @return it returns a map on the memory of the arena
+**/
+TrainingWorkspace::FloatMatrixMap TrainingWorkspace::AllocateFloatMatrix(unsigned int rows, unsigned int cols){
+ std::size_t size = RoundToBlock(((std::size_t) rows * cols + 1) / 2);
+ if(mOffset + size > mCapacity) throw std::domain_error("Error: TrainingWorkspace capacity exceeded, call Reserve() with the network and the batch size.");
+ float* data = reinterpret_cast<float*>(mBuffer + mOffset);
+ mOffset += size;
+ if(mOffset > mPeak) mPeak = mOffset;
+ return FloatMatrixMap(data, rows, cols);
+}
+
+/**
+* It sets the use of huge pages. It is applied the next time the buffer is mapped.
+*
+* @param value
+**/
+void TrainingWorkspace::SetHugePages(bool value){
+ mHugePagesRequested = value;
+}
+
+/**
+* It returns true if the buffer is backed by explicit huge pages or if
+* the transparent huge pages were enabled for it.
+*
+**/
+bool TrainingWorkspace::IsUsingHugePages(){
+ return mHugePages;
+}
+
+/**
+* It returns the largest batch size the workspace was reserved for
+*
+**/
+unsigned int TrainingWorkspace::GetMaxBatchSize(){
+ return mMaxBatchSize;
+}
+
+/**
+* It returns the number of doubles in the buffer
+*
+**/
+std::size_t TrainingWorkspace::ReturnCapacity(){
+ return mCapacity;
+}
+
+/**
+* It returns the number of doubles taken since the last Reset()
+*
+**/
+std::size_t TrainingWorkspace::ReturnUsed(){
+ return mOffset;
+}
+
+/**
+* It returns the largest number of doubles taken between two Reset()
+*
+**/
+std::size_t TrainingWorkspace::ReturnPeakUsage(){
+ return mPeak;
+}
+
+/**
+* It returns the memory mapped by the workspace
+*
+* @return it returns the number of bytes
+**/
+std::size_t TrainingWorkspace::ReturnMemoryFootprint(){
+ return sizeof(TrainingWorkspace) + mMappedBytes;
+}
+
+} //namespace
@@ -29,9 +29,7 @@ return inputVector;
 * @return the output of the function
 */
 Eigen::VectorXd PositiveLinear(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  if(inputVector[i]<0.0) inputVector[i]=-inputVector[i];
- }
+ InPlace::PositiveLinear(inputVector);
  return inputVector;
 }
 
@@ -44,10 +42,7 @@ Eigen::VectorXd PositiveLinear(Eigen::VectorXd inputVector) {
 * @return the output of the function
 */
 Eigen::VectorXd SaturatedLinear(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  if(inputVector[i] > 1) inputVector[i] = 1;
-  else if (inputVector[i] < -1) inputVector[i] = -1;
- }
+ InPlace::SaturatedLinear(inputVector);
  return inputVector;	
 }
 
@@ -58,12 +53,7 @@ Eigen::VectorXd SaturatedLinear(Eigen::VectorXd inputVector) {
 * @return the output of the function
 */
 Eigen::VectorXd Sigmoid(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  double divisor = 1.0 + std::exp(-inputVector[i]);
-  double result =  1.0 / divisor;
-  if( std::isnan(result) == true ) inputVector[i] = 0; //protection against large negative number
-  else inputVector[i] = result;
- }
+ InPlace::Sigmoid(inputVector);
  return inputVector;
 }
 
@@ -77,37 +67,22 @@ Eigen::VectorXd Sigmoid(Eigen::VectorXd inputVector) {
 * @return the output of the function
 */
 Eigen::VectorXd FastSigmoid(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  inputVector[i] = inputVector[i] / (1.0 + std::abs(inputVector[i]));
- }
+ InPlace::FastSigmoid(inputVector);
  return inputVector;
 }
 
 Eigen::VectorXd SigmoidDerivative(Eigen::VectorXd inputVector) {
-//dy/dx = f(x)' = f(x) * (1 - f(x))
-//double result = (1.0 / (1.0 + std::exp(-input))) * (1.0 - (1.0 / (1.0 + std::exp(-input))));
-//if( std::isnan(result) == true ) return 0; //protection against large negative number
- for(int i=0; i<inputVector.size(); i++){
-  double result = (std::exp(-inputVector[i]))/ std::pow( (1+std::exp(-inputVector[i])), 2);
-  if( std::isnan(result) == true ) inputVector[i] = 0; //protection against large negative number
-  else inputVector[i] = result;
- }
+ InPlace::SigmoidDerivative(inputVector);
  return inputVector;
 }
 
 Eigen::VectorXd Tanh(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  inputVector[i] = tanh(inputVector[i]);
- }
+ InPlace::Tanh(inputVector);
  return inputVector;
 }	
 
 Eigen::VectorXd TanhDerivative(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  double result = (1.0-std::tanh(inputVector[i])) * (1.0+std::tanh(inputVector[i]));
-  if( std::isnan(result) == true ) inputVector[i] = 0; //protection against large negative number
-  else inputVector[i] = result;
- }
+ InPlace::TanhDerivative(inputVector);
  return inputVector; 
 }
 
@@ -117,9 +92,7 @@ Eigen::VectorXd TanhDerivative(Eigen::VectorXd inputVector) {
 * @return the output of the function
 */
 Eigen::VectorXd RadialBasis(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){		
-  inputVector[i] = exp( -std::pow(inputVector[i], 2) );
- }
+ InPlace::RadialBasis(inputVector);
  return inputVector;
 }
 
@@ -129,10 +102,7 @@ Eigen::VectorXd RadialBasis(Eigen::VectorXd inputVector) {
 * @return the output of the function
 */
 Eigen::VectorXd MultiQuadratic(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  double t1 = 1 + std::pow(inputVector[i], 2);		
-  inputVector[i] = std::sqrt(t1);
- }
+ InPlace::MultiQuadratic(inputVector);
  return inputVector;
 }
 
@@ -145,16 +115,142 @@ Eigen::VectorXd MultiQuadratic(Eigen::VectorXd inputVector) {
 * @return the output of the function
 */
 Eigen::VectorXd HardLimit(Eigen::VectorXd inputVector) {
- for(int i=0; i<inputVector.size(); i++){
-  if(inputVector[i] > 0) inputVector[i] = 1;
-  else inputVector[i] = 0;
- }
+ InPlace::HardLimit(inputVector);
  return inputVector;	
 }
 
+/**
+* Straight-through estimator of the HardLimit derivative, used to train
+* binarized layers. The true derivative is zero almost everywhere, the
+* estimator lets the error pass where the input is in [-1, +1].
+* @param input value
+* @return the output of the function
+*/
+Eigen::VectorXd HardLimitDerivative(Eigen::VectorXd inputVector) {
+ InPlace::HardLimitDerivative(inputVector);
+ return inputVector;
+}
+
+/**
+* It normalizes the exponentials of the values, the outputs are
+* positive and their sum is one. It is the output layer of a
+* classifier trained with the CrossEntropy loss.
+* @param input value
+* @return the output of the function
+*/
+Eigen::VectorXd Softmax(Eigen::VectorXd inputVector) {
+ InPlace::Softmax(inputVector);
+ return inputVector;
+}
+
+/**
+* The Jacobian of the softmax is not diagonal, so it cannot be a
+* derivative vector. This function returns the weighted input, that
+* is the logits, which are used by the CrossEntropy loss to compute
+* the loss and the gradient (see LossFunctions).
+* @param input value
+* @return the output of the function
+*/
+Eigen::VectorXd SoftmaxDerivative(Eigen::VectorXd inputVector) {
+ return inputVector;
+}
+
+
+namespace InPlace{
+
+void Linear(Eigen::Ref<Eigen::VectorXd> vector) {
+}
+
+void PositiveLinear(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = vector.cwiseAbs();
+}
+
+void SaturatedLinear(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = vector.cwiseMin(1.0).cwiseMax(-1.0);
+}
+
+void Sigmoid(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (1.0 + (-vector.array()).exp()).inverse().matrix();
+ vector = vector.array().isNaN().select(0.0, vector.array()).matrix(); //protection against large negative number
+}
+
+void FastSigmoid(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (vector.array() / (1.0 + vector.array().abs())).matrix();
+}
+
+void SigmoidDerivative(Eigen::Ref<Eigen::VectorXd> vector) {
+ //dy/dx = f(x)' = f(x) * (1 - f(x)) = exp(-x) / (1 + exp(-x))^2
+ vector = (-vector.array()).exp().matrix();
+ vector = (vector.array() / (1.0 + vector.array()).square()).matrix();
+ vector = vector.array().isNaN().select(0.0, vector.array()).matrix(); //protection against large negative number
+}
 
+void Tanh(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = vector.array().tanh().matrix();
+}
+
+void TanhDerivative(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (1.0 - vector.array().tanh().square()).matrix();
+ vector = vector.array().isNaN().select(0.0, vector.array()).matrix();
+}
 
+void RadialBasis(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (-vector.array().square()).exp().matrix();
 }
+
+void MultiQuadratic(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (1.0 + vector.array().square()).sqrt().matrix();
 }
 
+void HardLimit(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (vector.array() > 0.0).cast<double>().matrix();
+}
+
+void HardLimitDerivative(Eigen::Ref<Eigen::VectorXd> vector) {
+ vector = (vector.array().abs() <= 1.0).cast<double>().matrix();
+}
+
+void Softmax(Eigen::Ref<Eigen::VectorXd> vector) {
+ //The maximum is subtracted so that the exponentials do not overflow
+ if(vector.size() == 0) return;
+ const double max_value = vector.maxCoeff();
+ vector = (vector.array() - max_value).exp().matrix();
+ vector /= vector.sum();
+}
+
+void SoftmaxDerivative(Eigen::Ref<Eigen::VectorXd>) {
+}
+
+/**
+* It returns the in place version of one of the transfer functions
+* of this namespace.
+*
+* @param transferFunction the function assigned to the layer
+* @return the in place function, or nullptr if the function is not one of this namespace
+*/
+Function ReturnFunction(const std::function<Eigen::VectorXd(Eigen::VectorXd)>& transferFunction) {
+ typedef Eigen::VectorXd (*VectorFunction)(Eigen::VectorXd);
+ const VectorFunction* target = transferFunction.target<VectorFunction>();
+ if(target == nullptr) return nullptr;
+ if(*target == &TransferFunctions::Linear) return &Linear;
+ if(*target == &TransferFunctions::PositiveLinear) return &PositiveLinear;
+ if(*target == &TransferFunctions::SaturatedLinear) return &SaturatedLinear;
+ if(*target == &TransferFunctions::Sigmoid) return &Sigmoid;
+ if(*target == &TransferFunctions::FastSigmoid) return &FastSigmoid;
+ if(*target == &TransferFunctions::SigmoidDerivative) return &SigmoidDerivative;
+ if(*target == &TransferFunctions::Tanh) return &Tanh;
+ if(*target == &TransferFunctions::TanhDerivative) return &TanhDerivative;
+ if(*target == &TransferFunctions::RadialBasis) return &RadialBasis;
+ if(*target == &TransferFunctions::MultiQuadratic) return &MultiQuadratic;
+ if(*target == &TransferFunctions::HardLimit) return &HardLimit;
+ if(*target == &TransferFunctions::HardLimitDerivative) return &HardLimitDerivative;
+ if(*target == &TransferFunctions::Softmax) return &Softmax;
+ if(*target == &TransferFunctions::SoftmaxDerivative) return &SoftmaxDerivative;
+ return nullptr;
+}
+
+}
+
+}
+}
 
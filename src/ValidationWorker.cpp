@@ -0,0 +1,132 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "ValidationWorker.h"
+#include "Trace.h"
+
+namespace neuroc{
+
+namespace {
+
+const std::size_t kMaxPending = 2;
+
+} //namespace
+
+/**
+* Class constructor, in the asynchronous mode the background thread is started here
+*
+**/
+ValidationWorker::ValidationWorker(Dataset& inputDataset, Dataset& targetDataset, bool asynchronous)
+ : mInputDataset(inputDataset), mTargetDataset(targetDataset){
+ mAsynchronous = asynchronous;
+ mValidating = false;
+ mStopping = false;
+ if(mAsynchronous) mThread = std::thread(&ValidationWorker::Run, this);
+}
+
+/**
+* Class destructor, the waiting snapshots are validated before stopping the thread
+*
+**/
+ValidationWorker::~ValidationWorker(){
+ if(mAsynchronous == false) return;
+ {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStopping = true;
+ }
+ mCondition.notify_all();
+ mThread.join();
+}
+
+/**
+* It gives a snapshot to the validation. The copy of the network shares
+* the weights and it costs the copy of the layer buffers only. The binarized,
+* sparse, factorized and clustered layers also copy their own matrices, the
+* copy costs as much as the model.
+*
+* @param snapshot the network to validate
+* @param epoch the number of epochs trained by the snapshot
+**/
+void ValidationWorker::Submit(const Network& snapshot, unsigned int epoch){
+ NEUROC_TRACE_SCOPE("ValidationWorker::Submit");
+ Result job;
+ job.epoch = epoch;
+ job.error = 0.0;
+ job.snapshot = snapshot;
+ if(mAsynchronous == false){
+  job.error = job.snapshot.ComputeMeanSquaredError(mInputDataset, mTargetDataset);
+  mDone.push_back(std::move(job));
+  return;
+ }
+ std::unique_lock<std::mutex> lock(mMutex);
+ mCondition.wait(lock, [this](){ return mPending.size() < kMaxPending; });
+ mPending.push_back(std::move(job));
+ lock.unlock();
+ mCondition.notify_all();
+}
+
+/**
+* It returns the oldest validated snapshot, without waiting
+*
+* @param result the validation error and the snapshot
+* @return it returns false if no snapshot was validated since the previous call
+**/
+bool ValidationWorker::ReturnResult(Result& result){
+ std::lock_guard<std::mutex> lock(mMutex);
+ if(mDone.empty()) return false;
+ result = std::move(mDone.front());
+ mDone.pop_front();
+ return true;
+}
+
+/**
+* It waits until the submitted snapshots are validated
+*
+**/
+void ValidationWorker::Wait(){
+ std::unique_lock<std::mutex> lock(mMutex);
+ mCondition.wait(lock, [this](){ return mPending.empty() && mValidating == false; });
+}
+
+/**
+* The loop of the background thread
+*
+**/
+void ValidationWorker::Run(){
+ std::unique_lock<std::mutex> lock(mMutex);
+ while(true){
+  mCondition.wait(lock, [this](){ return mPending.empty() == false || mStopping; });
+  if(mPending.empty()) return;
+  Result job = std::move(mPending.front());
+  mPending.pop_front();
+  mValidating = true;
+  lock.unlock();
+  mCondition.notify_all(); //a place in the queue is free
+  {
+   NEUROC_TRACE_SCOPE("ValidationWorker::Validate");
+   job.error = job.snapshot.ComputeMeanSquaredError(mInputDataset, mTargetDataset);
+  }
+  lock.lock();
+  mDone.push_back(std::move(job));
+  mValidating = false;
+  mCondition.notify_all();
+ }
+}
+
+} //namespace
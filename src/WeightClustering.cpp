@@ -0,0 +1,155 @@
+/*
+ * neuroc - c++11 Artificial Neural Networks library
+ * Copyright (C) 2015  Massimiliano Patacchiola
+ * Author: Massimiliano Patacchiola
+ * email:
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+*/
+
+#include "WeightClustering.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace neuroc{
+
+WeightClustering::WeightClustering(){
+ mIterations = 20;
+}
+
+WeightClustering::~WeightClustering(){
+}
+
+/**
+* It sets the maximum number of iterations of the k-means,
+* it stops before if the clusters do not change
+*
+**/
+void WeightClustering::SetIterations(unsigned int iterations){
+ mIterations = iterations;
+}
+
+unsigned int WeightClustering::GetIterations(){
+ return mIterations;
+}
+
+/**
+* It clusters the weights of every layer of the network
+*
+* @param bits the number of bits of an index, from 1 to 8, the layers have 2^bits centroids
+* @return it returns true if it is all right, otherwise false
+**/
+bool WeightClustering::Cluster(Network& net, unsigned int bits){
+ if(bits == 0 || bits > 8){
+  std::cerr << "Neuroc Error: WeightClustering the bits of the indices must be between 1 and 8" << std::endl;
+  return false;
+ }
+ for(unsigned int i=0; i<net.Size(); i++){
+  if(Cluster(net[i], 1u << bits, mIterations) == false) return false;
+ }
+ return true;
+}
+
+/**
+* It clusters the weights of a layer with the k-means. The weights are sorted
+* once, so that a cluster is a range of the sorted weights between the middle
+* points of the centroids and its mean is found with the prefix sums, the cost
+* of an iteration does not depend on the number of weights.
+*
+* @param clusters the number of centroids, from 1 to 256
+* @param iterations the maximum number of iterations
+* @return it returns true if it is all right, otherwise false
+**/
+bool WeightClustering::Cluster(DenseLayer& layer, unsigned int clusters, unsigned int iterations){
+ if(clusters == 0 || clusters > 256){
+  std::cerr << "Neuroc Error: WeightClustering the number of clusters must be between 1 and 256" << std::endl;
+  return false;
+ }
+ layer.RemoveCodebook();
+ const Eigen::MatrixXd& weight_matrix = layer.GetWeightMatrix();
+ std::vector<double> sorted_weights(weight_matrix.data(), weight_matrix.data() + weight_matrix.size());
+ std::sort(sorted_weights.begin(), sorted_weights.end());
+ std::vector<double> prefix_sums(sorted_weights.size() + 1, 0.0);
+ for(std::size_t i=0; i<sorted_weights.size(); i++) prefix_sums[i+1] = prefix_sums[i] + sorted_weights[i];
+
+ //Linear initialization, it keeps centroids also for the few large weights
+ Eigen::VectorXd centroid_vector = Eigen::VectorXd::Zero(clusters);
+ if(sorted_weights.size() > 0) centroid_vector = Eigen::VectorXd::LinSpaced(clusters, sorted_weights.front(), sorted_weights.back());
+ std::vector<std::size_t> ends(clusters, 0);
+ for(unsigned int iteration=0; iteration<iterations; iteration++){
+  bool changed = false;
+  std::size_t begin = 0;
+  for(unsigned int c=0; c<clusters; c++){
+   std::size_t end = sorted_weights.size();
+   if(c+1 < clusters){
+    double boundary = 0.5 * (centroid_vector[c] + centroid_vector[c+1]);
+    end = std::lower_bound(sorted_weights.begin() + begin, sorted_weights.end(), boundary) - sorted_weights.begin();
+   }
+   changed |= (end != ends[c]);
+   ends[c] = end;
+   //An empty cluster keeps its centroid
+   if(end > begin) centroid_vector[c] = (prefix_sums[end] - prefix_sums[begin]) / (end - begin);
+   begin = end;
+  }
+  if(changed == false) break;
+ }
+
+ //Every weight takes the index of the range where it falls
+ std::vector<double> boundaries(clusters - 1);
+ for(unsigned int c=0; c+1<clusters; c++) boundaries[c] = 0.5 * (centroid_vector[c] + centroid_vector[c+1]);
+ DenseLayer::IndexMatrix index_matrix(weight_matrix.rows(), weight_matrix.cols());
+ for(unsigned int col=0; col<weight_matrix.cols(); col++){
+  for(unsigned int row=0; row<weight_matrix.rows(); row++){
+   index_matrix(row, col) = std::upper_bound(boundaries.begin(), boundaries.end(), weight_matrix(row, col)) - boundaries.begin();
+  }
+ }
+ return layer.SetCodebook(centroid_vector, index_matrix);
+}
+
+/**
+* It returns the memory of the weights of the network with the indices
+* packed in 4 bits (up to 16 centroids) or 8 bits and the codebooks, the
+* layers that are not clustered are counted in double precision
+*
+* @return it returns the number of bytes
+**/
+std::size_t WeightClustering::ReturnClusteredWeightBytes(Network& net){
+ std::size_t bytes = 0;
+ for(unsigned int i=0; i<net.Size(); i++){
+  if(net[i].IsClustered() == false){
+   bytes += net[i].GetWeightMatrix().size() * sizeof(double);
+   continue;
+  }
+  std::size_t inputs = net[i].ReturnNumberOfInputs();
+  std::size_t row_bytes = (net[i].GetCentroidVector().size() <= 16) ? (inputs + 1) / 2 : inputs;
+  bytes += net[i].ReturnNumberOfNeurons() * row_bytes + net[i].GetCentroidVector().size() * sizeof(double);
+ }
+ return bytes;
+}
+
+/**
+* It prints the number of centroids and the size of the weights of every layer
+*
+**/
+void WeightClustering::Print(Network& net){
+ for(unsigned int i=0; i<net.Size(); i++){
+  std::cout << "Layer " << i << " " << net[i].ReturnNumberOfInputs() << "x" << net[i].ReturnNumberOfNeurons()
+            << " centroids: " << (net[i].IsClustered() ? std::to_string(net[i].GetCentroidVector().size()) : std::string("none")) << std::endl;
+ }
+ std::size_t dense_bytes = 0;
+ for(unsigned int i=0; i<net.Size(); i++) dense_bytes += net[i].GetWeightMatrix().size() * sizeof(double);
+ std::cout << "Weights: " << dense_bytes << " bytes -> " << ReturnClusteredWeightBytes(net) << " bytes" << std::endl;
+}
+
+} //namespace